@@ -0,0 +1,56 @@
+#include "AstArena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace c_hat {
+namespace ast {
+
+namespace {
+thread_local AstArena *currentArena = nullptr;
+}
+
+AstArena::AstArena(size_t blockSize) : blockSize_(blockSize) {}
+
+void *AstArena::allocate(size_t size, size_t alignment) {
+  auto address = reinterpret_cast<std::uintptr_t>(cursor_);
+  size_t padding = (alignment - address % alignment) % alignment;
+
+  if (!cursor_ || padding + size > static_cast<size_t>(end_ - cursor_)) {
+    grow(size + alignment);
+    address = reinterpret_cast<std::uintptr_t>(cursor_);
+    padding = (alignment - address % alignment) % alignment;
+  }
+
+  std::byte *result = cursor_ + padding;
+  cursor_ = result + size;
+  allocationCount_++;
+  bytesUsed_ += size;
+  return result;
+}
+
+size_t AstArena::getBytesReserved() const {
+  size_t total = 0;
+  for (const auto &block : blocks_) {
+    total += block.size;
+  }
+  return total;
+}
+
+void AstArena::grow(size_t minSize) {
+  // 超过默认块大小的单次分配按实际大小申请内存块
+  size_t size = std::max(blockSize_, minSize);
+  blocks_.push_back(Block{std::make_unique<std::byte[]>(size), size});
+  cursor_ = blocks_.back().data.get();
+  end_ = cursor_ + size;
+}
+
+AstArena *AstArena::current() { return currentArena; }
+
+AstArena::Scope::Scope(AstArena *arena) : previous_(currentArena) {
+  currentArena = arena;
+}
+
+AstArena::Scope::~Scope() { currentArena = previous_; }
+
+} // namespace ast
+} // namespace c_hat
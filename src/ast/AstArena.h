@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace c_hat {
+namespace ast {
+
+// AST 内存池（bump allocator）
+// 一个 Program 的所有节点都从同一个内存池顺序分配，节点 delete 时不归还内存，
+// 整棵树析构完成后由内存池一次性释放全部内存块。
+class AstArena {
+public:
+  static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+  explicit AstArena(size_t blockSize = DefaultBlockSize);
+
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+
+  // 分配一块内存（不会单独释放）
+  void *allocate(size_t size, size_t alignment);
+
+  // 已分配的次数（即节点数量）
+  size_t getAllocationCount() const { return allocationCount_; }
+
+  // 已使用的字节数
+  size_t getBytesUsed() const { return bytesUsed_; }
+
+  // 已申请的内存块总字节数
+  size_t getBytesReserved() const;
+
+  // 当前线程的活动内存池（nullptr 表示节点走普通堆分配）
+  static AstArena *current();
+
+  // RAII：在作用域内将内存池设为当前线程的活动内存池
+  class Scope {
+  public:
+    explicit Scope(AstArena *arena);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    AstArena *previous_;
+  };
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  // 申请新的内存块，保证至少能容纳 minSize 字节
+  void grow(size_t minSize);
+
+  std::vector<Block> blocks_;
+  std::byte *cursor_ = nullptr;
+  std::byte *end_ = nullptr;
+  size_t blockSize_;
+  size_t allocationCount_ = 0;
+  size_t bytesUsed_ = 0;
+};
+
+} // namespace ast
+} // namespace c_hat
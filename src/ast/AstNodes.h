@@ -1,6 +1,7 @@
 #pragma once
 
 // 基础类型
+#include "AstArena.h"
 #include "Node.h"
 #include "NodeType.h"
 
@@ -0,0 +1,1425 @@
+#include "AstSerializer.h"
+#include "AstNodes.h"
+#include "ByteStream.h"
+#include <stdexcept>
+
+namespace c_hat {
+namespace ast {
+
+namespace {
+
+// 序列化格式（整数均为小端序，字符串为 u32 长度加字节）：
+//   u32 格式版本 u32 顶层声明数 各声明
+// 节点：u8 标签 字段；Declaration 和 Statement 的子类在字段后写出属性。
+// 函数体：u8 BodyTag，其后为 u32 长度加独立编码的函数体节点，或 u32 长度
+// 加 LazyBody::writeTokens 写出的词法单元。
+enum class NodeTag : uint8_t {
+  Null,
+  // 表达式
+  BinaryExpr,
+  UnaryExpr,
+  Literal,
+  Identifier,
+  CallExpr,
+  MemberExpr,
+  SubscriptExpr,
+  ThisExpr,
+  SelfExpr,
+  SuperExpr,
+  NewExpr,
+  DeleteExpr,
+  FoldExpr,
+  ExpansionExpr,
+  ArrayInitExpr,
+  StructInitExpr,
+  TupleExpr,
+  LambdaExpr,
+  ReflectionExpr,
+  BuiltinVarExpr,
+  // 声明
+  VariableDecl,
+  TupleDestructuringDecl,
+  FunctionDecl,
+  ClassDecl,
+  InterfaceDecl,
+  StructDecl,
+  EnumDecl,
+  NamespaceDecl,
+  ModuleDecl,
+  ImportDecl,
+  ExportDecl,
+  ExtensionDecl,
+  GetterDecl,
+  SetterDecl,
+  TypeAliasDecl,
+  ExternDecl,
+  ConceptDecl,
+  AttributeDecl,
+  // 语句
+  VariableStmt,
+  TupleDestructuringStmt,
+  ExprStmt,
+  CompoundStmt,
+  IfStmt,
+  MatchStmt,
+  ForStmt,
+  WhileStmt,
+  DoWhileStmt,
+  BreakStmt,
+  ContinueStmt,
+  ReturnStmt,
+  GotoStmt,
+  LabelStmt,
+  ThrowStmt,
+  TryStmt,
+  CatchStmt,
+  DeferStmt,
+  YieldStmt,
+  ComptimeStmt,
+  // 类型
+  PrimitiveType,
+  NamedType,
+  ArrayType,
+  RectangularArrayType,
+  SliceType,
+  RectangularSliceType,
+  PointerType,
+  ReferenceType,
+  FunctionType,
+  GenericType,
+  ReadonlyType,
+  TupleType,
+  NullableType,
+  // 其他
+  Parameter,
+  EnumMember,
+  MatchArm,
+  Pattern,
+  TemplateParameter,
+  WhereClause,
+  RequiresClause,
+  RequiresExpression,
+  Requirement,
+};
+
+// 函数体的编码方式
+enum class BodyTag : uint8_t {
+  None,
+  // 函数体节点
+  Encoded,
+  // 略读时跳过的函数体的词法单元
+  Tokens,
+};
+
+// 遇到没有对应标签的节点类
+struct UnsupportedNode {};
+
+template <typename Enum> uint8_t enumByte(Enum value) {
+  return static_cast<uint8_t>(value);
+}
+
+class AstWriter {
+public:
+  explicit AstWriter(ByteWriter &out) : out_(out) {}
+
+  template <typename T>
+  void nodes(const std::vector<std::unique_ptr<T>> &list) {
+    out_.u32(static_cast<uint32_t>(list.size()));
+    for (const auto &item : list) {
+      node(item.get());
+    }
+  }
+
+  void node(Node *node) {
+    if (!node) {
+      tag(NodeTag::Null);
+      return;
+    }
+
+    switch (node->getType()) {
+    case NodeType::BinaryExpr: {
+      auto &n = static_cast<BinaryExpr &>(*node);
+      tag(NodeTag::BinaryExpr);
+      this->node(n.left.get());
+      out_.u8(enumByte(n.op));
+      this->node(n.right.get());
+      break;
+    }
+    case NodeType::UnaryExpr: {
+      auto &n = static_cast<UnaryExpr &>(*node);
+      tag(NodeTag::UnaryExpr);
+      out_.u8(enumByte(n.op));
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::Literal: {
+      auto &n = static_cast<Literal &>(*node);
+      tag(NodeTag::Literal);
+      out_.u8(enumByte(n.type));
+      out_.str(n.value);
+      break;
+    }
+    case NodeType::Identifier: {
+      auto &n = static_cast<Identifier &>(*node);
+      tag(NodeTag::Identifier);
+      out_.str(n.name);
+      nodes(n.templateArgs);
+      break;
+    }
+    case NodeType::CallExpr: {
+      auto &n = static_cast<CallExpr &>(*node);
+      tag(NodeTag::CallExpr);
+      this->node(n.callee.get());
+      nodes(n.args);
+      break;
+    }
+    case NodeType::MemberExpr: {
+      auto &n = static_cast<MemberExpr &>(*node);
+      tag(NodeTag::MemberExpr);
+      this->node(n.object.get());
+      out_.str(n.member);
+      out_.u8(n.isPointerMember);
+      out_.str(n.structName);
+      out_.u32(n.memberIndex);
+      break;
+    }
+    case NodeType::SubscriptExpr: {
+      auto &n = static_cast<SubscriptExpr &>(*node);
+      tag(NodeTag::SubscriptExpr);
+      this->node(n.object.get());
+      this->node(n.index.get());
+      break;
+    }
+    case NodeType::ThisExpr:
+      tag(NodeTag::ThisExpr);
+      break;
+    case NodeType::SelfExpr:
+      tag(NodeTag::SelfExpr);
+      break;
+    case NodeType::SuperExpr:
+      tag(NodeTag::SuperExpr);
+      break;
+    case NodeType::NewExpr: {
+      auto &n = static_cast<NewExpr &>(*node);
+      tag(NodeTag::NewExpr);
+      this->node(n.type.get());
+      nodes(n.args);
+      break;
+    }
+    case NodeType::DeleteExpr: {
+      auto &n = static_cast<DeleteExpr &>(*node);
+      tag(NodeTag::DeleteExpr);
+      this->node(n.expr.get());
+      out_.u8(n.isArray);
+      out_.str(n.typeName);
+      break;
+    }
+    case NodeType::FoldExpr: {
+      auto &n = static_cast<FoldExpr &>(*node);
+      tag(NodeTag::FoldExpr);
+      out_.u8(enumByte(n.foldType));
+      this->node(n.expr.get());
+      out_.str(n.op);
+      this->node(n.right.get());
+      break;
+    }
+    case NodeType::ExpansionExpr: {
+      auto &n = static_cast<ExpansionExpr &>(*node);
+      tag(NodeTag::ExpansionExpr);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::ArrayInitExpr: {
+      auto &n = static_cast<ArrayInitExpr &>(*node);
+      tag(NodeTag::ArrayInitExpr);
+      nodes(n.elements);
+      break;
+    }
+    case NodeType::StructInitExpr: {
+      auto &n = static_cast<StructInitExpr &>(*node);
+      tag(NodeTag::StructInitExpr);
+      this->node(n.type.get());
+      out_.u32(static_cast<uint32_t>(n.fields.size()));
+      for (auto &field : n.fields) {
+        out_.str(field.first);
+        this->node(field.second.get());
+      }
+      break;
+    }
+    case NodeType::TupleExpr: {
+      auto &n = static_cast<TupleExpr &>(*node);
+      tag(NodeTag::TupleExpr);
+      nodes(n.elements);
+      break;
+    }
+    case NodeType::LambdaExpr: {
+      auto &n = static_cast<LambdaExpr &>(*node);
+      tag(NodeTag::LambdaExpr);
+      nodes(n.params);
+      this->node(n.body.get());
+      out_.u32(static_cast<uint32_t>(n.captures.size()));
+      for (const auto &capture : n.captures) {
+        out_.str(capture.name);
+        out_.u8(capture.byRef);
+        out_.u8(capture.isMove);
+      }
+      break;
+    }
+    case NodeType::ReflectionExpr: {
+      auto &n = static_cast<ReflectionExpr &>(*node);
+      tag(NodeTag::ReflectionExpr);
+      out_.u8(enumByte(n.kind));
+      if (n.kind == ReflectionExpr::TargetKind::Type) {
+        this->node(n.type.get());
+      } else {
+        this->node(n.expression.get());
+      }
+      break;
+    }
+    case NodeType::BuiltinVarExpr: {
+      auto &n = static_cast<BuiltinVarExpr &>(*node);
+      tag(NodeTag::BuiltinVarExpr);
+      out_.str(n.name);
+      break;
+    }
+
+    case NodeType::VariableDecl: {
+      auto &n = static_cast<VariableDecl &>(*node);
+      tag(NodeTag::VariableDecl);
+      out_.str(n.specifiers);
+      out_.u8(n.isLate);
+      out_.u8(enumByte(n.kind));
+      this->node(n.type.get());
+      out_.str(n.name);
+      this->node(n.initializer.get());
+      out_.u8(n.isConst);
+      out_.u8(n.isStatic);
+      break;
+    }
+    case NodeType::TupleDestructuringDecl: {
+      // TupleDestructuringStmt 的 getType() 同样返回该值
+      if (auto *stmt = dynamic_cast<TupleDestructuringStmt *>(node)) {
+        tag(NodeTag::TupleDestructuringStmt);
+        this->node(stmt->declaration.get());
+        break;
+      }
+      auto &n = static_cast<TupleDestructuringDecl &>(*node);
+      tag(NodeTag::TupleDestructuringDecl);
+      out_.str(n.specifiers);
+      out_.u8(n.isLate);
+      out_.u8(enumByte(n.kind));
+      out_.strings(n.names);
+      this->node(n.initializer.get());
+      break;
+    }
+    case NodeType::FunctionDecl: {
+      auto &n = static_cast<FunctionDecl &>(*node);
+      tag(NodeTag::FunctionDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      nodes(n.templateParams);
+      nodes(n.params);
+      this->node(n.returnType.get());
+      this->node(n.whereClause.get());
+      this->node(n.requiresClause.get());
+      functionBody(n);
+      this->node(n.arrowExpr.get());
+      out_.u8(n.isImmutable);
+      this->node(n.superCall.get());
+      out_.u8(n.isVariadic);
+      out_.u8(n.isStatic);
+      break;
+    }
+    case NodeType::ClassDecl: {
+      auto &n = static_cast<ClassDecl &>(*node);
+      tag(NodeTag::ClassDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      nodes(n.templateParams);
+      out_.str(n.baseClass);
+      out_.strings(n.baseClasses);
+      out_.strings(n.interfaces);
+      nodes(n.members);
+      break;
+    }
+    case NodeType::InterfaceDecl: {
+      auto &n = static_cast<InterfaceDecl &>(*node);
+      tag(NodeTag::InterfaceDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      out_.strings(n.baseInterfaces);
+      nodes(n.members);
+      break;
+    }
+    case NodeType::StructDecl: {
+      auto &n = static_cast<StructDecl &>(*node);
+      tag(NodeTag::StructDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      nodes(n.members);
+      break;
+    }
+    case NodeType::EnumDecl: {
+      auto &n = static_cast<EnumDecl &>(*node);
+      tag(NodeTag::EnumDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      nodes(n.members);
+      break;
+    }
+    case NodeType::NamespaceDecl: {
+      auto &n = static_cast<NamespaceDecl &>(*node);
+      tag(NodeTag::NamespaceDecl);
+      out_.str(n.name);
+      nodes(n.members);
+      break;
+    }
+    case NodeType::ModuleDecl: {
+      auto &n = static_cast<ModuleDecl &>(*node);
+      tag(NodeTag::ModuleDecl);
+      out_.strings(n.modulePath);
+      break;
+    }
+    case NodeType::ImportDecl: {
+      auto &n = static_cast<ImportDecl &>(*node);
+      tag(NodeTag::ImportDecl);
+      out_.str(n.specifiers);
+      out_.strings(n.modulePath);
+      out_.str(n.alias);
+      break;
+    }
+    case NodeType::ExportDecl: {
+      auto &n = static_cast<ExportDecl &>(*node);
+      tag(NodeTag::ExportDecl);
+      out_.str(n.specifiers);
+      this->node(n.decl.get());
+      break;
+    }
+    case NodeType::ExtensionDecl: {
+      auto &n = static_cast<ExtensionDecl &>(*node);
+      tag(NodeTag::ExtensionDecl);
+      this->node(n.extendedType.get());
+      nodes(n.members);
+      break;
+    }
+    case NodeType::GetterDecl: {
+      auto &n = static_cast<GetterDecl &>(*node);
+      tag(NodeTag::GetterDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      this->node(n.returnType.get());
+      this->node(n.body.get());
+      this->node(n.arrowExpr.get());
+      break;
+    }
+    case NodeType::SetterDecl: {
+      auto &n = static_cast<SetterDecl &>(*node);
+      tag(NodeTag::SetterDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      this->node(n.param.get());
+      this->node(n.body.get());
+      this->node(n.arrowExpr.get());
+      break;
+    }
+    case NodeType::TypeAliasDecl: {
+      auto &n = static_cast<TypeAliasDecl &>(*node);
+      tag(NodeTag::TypeAliasDecl);
+      out_.str(n.specifiers);
+      out_.str(n.name);
+      this->node(n.type.get());
+      out_.u8(n.isTypeSet);
+      break;
+    }
+    case NodeType::ExternDecl: {
+      auto &n = static_cast<ExternDecl &>(*node);
+      tag(NodeTag::ExternDecl);
+      out_.str(n.abi);
+      nodes(n.declarations);
+      break;
+    }
+    case NodeType::ConceptDecl: {
+      auto &n = static_cast<ConceptDecl &>(*node);
+      tag(NodeTag::ConceptDecl);
+      out_.str(n.name);
+      nodes(n.templateParams);
+      nodes(n.constraints);
+      break;
+    }
+    case NodeType::AttributeDecl: {
+      auto &n = static_cast<AttributeDecl &>(*node);
+      tag(NodeTag::AttributeDecl);
+      out_.str(n.name);
+      out_.u32(static_cast<uint32_t>(n.fields.size()));
+      for (const auto &field : n.fields) {
+        out_.str(field->name);
+        this->node(field->type.get());
+        this->node(field->defaultValue.get());
+      }
+      break;
+    }
+
+    case NodeType::Statement: {
+      // 只有 VariableStmt 的 getType() 返回 Statement
+      auto *stmt = dynamic_cast<VariableStmt *>(node);
+      if (!stmt) {
+        throw UnsupportedNode{};
+      }
+      tag(NodeTag::VariableStmt);
+      this->node(stmt->declaration.get());
+      break;
+    }
+    case NodeType::ExprStmt: {
+      auto &n = static_cast<ExprStmt &>(*node);
+      tag(NodeTag::ExprStmt);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::CompoundStmt: {
+      auto &n = static_cast<CompoundStmt &>(*node);
+      tag(NodeTag::CompoundStmt);
+      nodes(n.statements);
+      break;
+    }
+    case NodeType::IfStmt: {
+      auto &n = static_cast<IfStmt &>(*node);
+      tag(NodeTag::IfStmt);
+      this->node(n.condition.get());
+      this->node(n.thenBranch.get());
+      this->node(n.elseBranch.get());
+      break;
+    }
+    case NodeType::MatchStmt: {
+      auto &n = static_cast<MatchStmt &>(*node);
+      tag(NodeTag::MatchStmt);
+      this->node(n.expr.get());
+      nodes(n.arms);
+      break;
+    }
+    case NodeType::ForStmt: {
+      auto &n = static_cast<ForStmt &>(*node);
+      tag(NodeTag::ForStmt);
+      this->node(n.init.get());
+      this->node(n.condition.get());
+      this->node(n.update.get());
+      this->node(n.body.get());
+      out_.u8(n.isForeach);
+      this->node(n.indexVar.get());
+      break;
+    }
+    case NodeType::WhileStmt: {
+      auto &n = static_cast<WhileStmt &>(*node);
+      tag(NodeTag::WhileStmt);
+      this->node(n.condition.get());
+      this->node(n.body.get());
+      break;
+    }
+    case NodeType::DoWhileStmt: {
+      auto &n = static_cast<DoWhileStmt &>(*node);
+      tag(NodeTag::DoWhileStmt);
+      this->node(n.body.get());
+      this->node(n.condition.get());
+      break;
+    }
+    case NodeType::BreakStmt:
+      tag(NodeTag::BreakStmt);
+      break;
+    case NodeType::ContinueStmt:
+      tag(NodeTag::ContinueStmt);
+      break;
+    case NodeType::ReturnStmt: {
+      auto &n = static_cast<ReturnStmt &>(*node);
+      tag(NodeTag::ReturnStmt);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::GotoStmt: {
+      auto &n = static_cast<GotoStmt &>(*node);
+      tag(NodeTag::GotoStmt);
+      out_.str(n.label);
+      break;
+    }
+    case NodeType::LabelStmt: {
+      auto &n = static_cast<LabelStmt &>(*node);
+      tag(NodeTag::LabelStmt);
+      out_.str(n.label);
+      break;
+    }
+    case NodeType::ThrowStmt: {
+      auto &n = static_cast<ThrowStmt &>(*node);
+      tag(NodeTag::ThrowStmt);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::TryStmt: {
+      auto &n = static_cast<TryStmt &>(*node);
+      tag(NodeTag::TryStmt);
+      this->node(n.tryBlock.get());
+      nodes(n.catchStmts);
+      break;
+    }
+    case NodeType::CatchStmt: {
+      auto &n = static_cast<CatchStmt &>(*node);
+      tag(NodeTag::CatchStmt);
+      this->node(n.param.get());
+      this->node(n.body.get());
+      break;
+    }
+    case NodeType::DeferStmt: {
+      auto &n = static_cast<DeferStmt &>(*node);
+      tag(NodeTag::DeferStmt);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::YieldStmt: {
+      auto &n = static_cast<YieldStmt &>(*node);
+      tag(NodeTag::YieldStmt);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::ComptimeStmt: {
+      auto &n = static_cast<ComptimeStmt &>(*node);
+      tag(NodeTag::ComptimeStmt);
+      this->node(n.stmt.get());
+      break;
+    }
+
+    case NodeType::PrimitiveType: {
+      auto &n = static_cast<PrimitiveType &>(*node);
+      tag(NodeTag::PrimitiveType);
+      out_.u8(enumByte(n.kind));
+      break;
+    }
+    case NodeType::NamedType: {
+      auto &n = static_cast<NamedType &>(*node);
+      tag(NodeTag::NamedType);
+      out_.str(n.name);
+      break;
+    }
+    case NodeType::ArrayType: {
+      auto &n = static_cast<ArrayType &>(*node);
+      tag(NodeTag::ArrayType);
+      this->node(n.baseType.get());
+      this->node(n.size.get());
+      break;
+    }
+    case NodeType::RectangularArrayType: {
+      auto &n = static_cast<RectangularArrayType &>(*node);
+      tag(NodeTag::RectangularArrayType);
+      this->node(n.baseType.get());
+      nodes(n.sizes);
+      break;
+    }
+    case NodeType::SliceType: {
+      auto &n = static_cast<SliceType &>(*node);
+      tag(NodeTag::SliceType);
+      this->node(n.baseType.get());
+      break;
+    }
+    case NodeType::RectangularSliceType: {
+      auto &n = static_cast<RectangularSliceType &>(*node);
+      tag(NodeTag::RectangularSliceType);
+      this->node(n.baseType.get());
+      out_.u32(static_cast<uint32_t>(n.rank));
+      break;
+    }
+    case NodeType::PointerType: {
+      auto &n = static_cast<PointerType &>(*node);
+      tag(NodeTag::PointerType);
+      this->node(n.baseType.get());
+      out_.u8(n.isNullable);
+      break;
+    }
+    case NodeType::ReferenceType: {
+      auto &n = static_cast<ReferenceType &>(*node);
+      tag(NodeTag::ReferenceType);
+      this->node(n.baseType.get());
+      break;
+    }
+    case NodeType::FunctionType: {
+      auto &n = static_cast<FunctionType &>(*node);
+      tag(NodeTag::FunctionType);
+      nodes(n.parameterTypes);
+      this->node(n.returnType.get());
+      break;
+    }
+    case NodeType::GenericType: {
+      auto &n = static_cast<GenericType &>(*node);
+      tag(NodeTag::GenericType);
+      out_.str(n.name);
+      nodes(n.arguments);
+      break;
+    }
+    case NodeType::ReadonlyType: {
+      auto &n = static_cast<ReadonlyType &>(*node);
+      tag(NodeTag::ReadonlyType);
+      this->node(n.baseType.get());
+      break;
+    }
+    case NodeType::TupleType: {
+      auto &n = static_cast<TupleType &>(*node);
+      tag(NodeTag::TupleType);
+      nodes(n.elementTypes);
+      break;
+    }
+    case NodeType::NullableType: {
+      auto &n = static_cast<NullableType &>(*node);
+      tag(NodeTag::NullableType);
+      this->node(n.baseType.get());
+      break;
+    }
+
+    case NodeType::Parameter: {
+      auto &n = static_cast<Parameter &>(*node);
+      tag(NodeTag::Parameter);
+      out_.str(n.name);
+      this->node(n.type.get());
+      this->node(n.defaultValue.get());
+      out_.u8(n.isVariadic);
+      out_.u8(n.isSelf);
+      out_.u8(n.isSelfImmutable);
+      break;
+    }
+    case NodeType::EnumMember: {
+      auto &n = static_cast<EnumMember &>(*node);
+      tag(NodeTag::EnumMember);
+      out_.str(n.name);
+      this->node(n.value.get());
+      break;
+    }
+    case NodeType::MatchArm: {
+      auto &n = static_cast<MatchArm &>(*node);
+      tag(NodeTag::MatchArm);
+      this->node(n.pattern.get());
+      this->node(n.guard.get());
+      this->node(n.body.get());
+      break;
+    }
+    case NodeType::Pattern: {
+      auto &n = static_cast<Pattern &>(*node);
+      tag(NodeTag::Pattern);
+      out_.u8(n.isDefault);
+      break;
+    }
+    case NodeType::TemplateParameter: {
+      auto &n = static_cast<TemplateParameter &>(*node);
+      tag(NodeTag::TemplateParameter);
+      out_.str(n.name);
+      this->node(n.constraint.get());
+      out_.u8(n.isVariadic);
+      break;
+    }
+    case NodeType::WhereClause: {
+      auto &n = static_cast<WhereClause &>(*node);
+      tag(NodeTag::WhereClause);
+      out_.u32(static_cast<uint32_t>(n.constraints.size()));
+      for (auto &constraint : n.constraints) {
+        out_.str(constraint.typeParam);
+        this->node(constraint.constraint.get());
+      }
+      break;
+    }
+    case NodeType::RequiresClause: {
+      auto &n = static_cast<RequiresClause &>(*node);
+      tag(NodeTag::RequiresClause);
+      this->node(n.expr.get());
+      break;
+    }
+    case NodeType::RequiresExpression: {
+      auto &n = static_cast<RequiresExpression &>(*node);
+      tag(NodeTag::RequiresExpression);
+      nodes(n.params);
+      nodes(n.requirements);
+      break;
+    }
+    case NodeType::Requirement: {
+      auto &n = static_cast<Requirement &>(*node);
+      tag(NodeTag::Requirement);
+      out_.u8(enumByte(n.type));
+      this->node(n.expr.get());
+      this->node(n.typeSpec.get());
+      break;
+    }
+
+    default:
+      throw UnsupportedNode{};
+    }
+
+    if (auto *decl = dynamic_cast<Declaration *>(node)) {
+      attributes(decl->attributes);
+    } else if (auto *stmt = dynamic_cast<Statement *>(node)) {
+      attributes(stmt->attributes);
+    }
+  }
+
+private:
+  void tag(NodeTag value) { out_.u8(enumByte(value)); }
+
+  void attributes(
+      const std::vector<std::unique_ptr<AttributeApplication>> &list) {
+    out_.u32(static_cast<uint32_t>(list.size()));
+    for (const auto &attribute : list) {
+      out_.str(attribute->name);
+      out_.u32(static_cast<uint32_t>(attribute->arguments.size()));
+      for (const auto &argument : attribute->arguments) {
+        out_.str(argument->name);
+        node(argument->value.get());
+      }
+    }
+  }
+
+  // 函数体单独编码，读取时可以整块跳过
+  // 略读时跳过的函数体直接写出词法单元，读回后仍然延迟解析
+  void functionBody(const FunctionDecl &decl) {
+    std::unique_ptr<Node> parsed;
+    Node *body = decl.body.get();
+    if (!body && decl.lazyBody) {
+      ByteWriter tokens;
+      if (decl.lazyBody->writeTokens(tokens)) {
+        out_.u8(enumByte(BodyTag::Tokens));
+        out_.str(tokens.data());
+        return;
+      }
+      // 无法写出词法单元的函数体（如反序列化得到的）解析后写出，
+      // 程序中仍保持未解析
+      parsed = decl.lazyBody->parse();
+      body = parsed.get();
+    }
+    if (!body) {
+      out_.u8(enumByte(BodyTag::None));
+      return;
+    }
+    ByteWriter encoded;
+    AstWriter(encoded).node(body);
+    out_.u8(enumByte(BodyTag::Encoded));
+    out_.str(encoded.data());
+  }
+
+  ByteWriter &out_;
+};
+
+class AstReader {
+public:
+  AstReader(std::string_view data, std::shared_ptr<const void> owner,
+            std::weak_ptr<AstArena> arena,
+            AstSerializer::SkimmedBodyReader readSkimmedBody)
+      : in_(data), owner_(std::move(owner)), arena_(std::move(arena)),
+        readSkimmedBody_(std::move(readSkimmedBody)) {}
+
+  ByteReader &input() { return in_; }
+
+  // 读取节点并检查它是 T 的实例
+  template <typename T> std::unique_ptr<T> node() {
+    auto result = anyNode();
+    if (!result) {
+      return nullptr;
+    }
+    auto *typed = dynamic_cast<T *>(result.get());
+    if (!typed) {
+      throw MalformedData();
+    }
+    result.release();
+    return std::unique_ptr<T>(typed);
+  }
+
+  template <typename T> std::vector<std::unique_ptr<T>> nodes() {
+    uint32_t count = in_.count();
+    std::vector<std::unique_ptr<T>> list;
+    list.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      list.push_back(node<T>());
+    }
+    return list;
+  }
+
+  std::unique_ptr<Node> anyNode();
+
+private:
+  std::unique_ptr<Node> readNode(NodeTag tag);
+  std::vector<std::unique_ptr<AttributeApplication>> attributes();
+  std::unique_ptr<LazyBody> functionBody();
+
+  ByteReader in_;
+  std::shared_ptr<const void> owner_;
+  std::weak_ptr<AstArena> arena_;
+  AstSerializer::SkimmedBodyReader readSkimmedBody_;
+};
+
+// 反序列化时跳过的函数体，首次需要时才解码
+class SerializedBody : public LazyBody {
+public:
+  SerializedBody(std::string_view data, std::shared_ptr<const void> owner,
+                 std::weak_ptr<AstArena> arena,
+                 AstSerializer::SkimmedBodyReader readSkimmedBody)
+      : data(data), owner(std::move(owner)), arena(std::move(arena)),
+        readSkimmedBody(std::move(readSkimmedBody)) {}
+
+  std::unique_ptr<Node> parse() override {
+    // 节点分配在函数所属程序的内存池中（内存池已释放时走普通堆）
+    auto lockedArena = arena.lock();
+    AstArena::Scope arenaScope(lockedArena.get());
+    try {
+      AstReader reader(data, owner, arena, readSkimmedBody);
+      auto body = reader.anyNode();
+      if (!reader.input().atEnd()) {
+        throw MalformedData();
+      }
+      return body;
+    } catch (const MalformedData &) {
+      throw std::runtime_error("Malformed serialized function body");
+    }
+  }
+
+private:
+  std::string_view data;
+  std::shared_ptr<const void> owner;
+  std::weak_ptr<AstArena> arena;
+  AstSerializer::SkimmedBodyReader readSkimmedBody;
+};
+
+std::unique_ptr<Node> AstReader::anyNode() {
+  auto tag = in_.enumValue(NodeTag::Requirement);
+  if (tag == NodeTag::Null) {
+    return nullptr;
+  }
+  auto result = readNode(tag);
+  if (auto *decl = dynamic_cast<Declaration *>(result.get())) {
+    decl->attributes = attributes();
+  } else if (auto *stmt = dynamic_cast<Statement *>(result.get())) {
+    stmt->attributes = attributes();
+  }
+  return result;
+}
+
+std::vector<std::unique_ptr<AttributeApplication>> AstReader::attributes() {
+  uint32_t count = in_.count();
+  std::vector<std::unique_ptr<AttributeApplication>> list;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto attribute = std::make_unique<AttributeApplication>(in_.str());
+    uint32_t argumentCount = in_.count();
+    for (uint32_t j = 0; j < argumentCount; ++j) {
+      auto name = in_.str();
+      auto value = node<Expression>();
+      attribute->addArgument(
+          std::make_unique<AttributeArgument>(name, std::move(value)));
+    }
+    list.push_back(std::move(attribute));
+  }
+  return list;
+}
+
+std::unique_ptr<LazyBody> AstReader::functionBody() {
+  auto tag = in_.enumValue(BodyTag::Tokens);
+  if (tag == BodyTag::None) {
+    return nullptr;
+  }
+  auto data = in_.view(in_.u32());
+  if (tag == BodyTag::Encoded) {
+    return std::make_unique<SerializedBody>(data, owner_, arena_,
+                                            readSkimmedBody_);
+  }
+  // 词法单元形式的函数体只能由语法分析器读回
+  if (!readSkimmedBody_) {
+    throw MalformedData();
+  }
+  auto body = readSkimmedBody_(data, owner_, arena_);
+  if (!body) {
+    throw MalformedData();
+  }
+  return body;
+}
+
+std::unique_ptr<Node> AstReader::readNode(NodeTag tag) {
+  switch (tag) {
+  case NodeTag::BinaryExpr: {
+    auto left = node<Expression>();
+    auto op = in_.enumValue(BinaryExpr::Op::Range);
+    auto right = node<Expression>();
+    return std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+  }
+  case NodeTag::UnaryExpr: {
+    auto op = in_.enumValue(UnaryExpr::Op::PostDecrement);
+    auto expr = node<Expression>();
+    return std::make_unique<UnaryExpr>(op, std::move(expr));
+  }
+  case NodeTag::Literal: {
+    auto type = in_.enumValue(Literal::Type::Null);
+    auto value = in_.str();
+    return std::make_unique<Literal>(type, value);
+  }
+  case NodeTag::Identifier: {
+    auto name = in_.str();
+    auto templateArgs = nodes<Node>();
+    return std::make_unique<Identifier>(name, std::move(templateArgs));
+  }
+  case NodeTag::CallExpr: {
+    auto callee = node<Expression>();
+    auto args = nodes<Expression>();
+    return std::make_unique<CallExpr>(std::move(callee), std::move(args));
+  }
+  case NodeTag::MemberExpr: {
+    auto object = node<Expression>();
+    auto member = in_.str();
+    bool isPointerMember = in_.boolean();
+    auto result = std::make_unique<MemberExpr>(std::move(object), member,
+                                               isPointerMember);
+    result->structName = in_.str();
+    result->memberIndex = in_.u32();
+    return result;
+  }
+  case NodeTag::SubscriptExpr: {
+    auto object = node<Expression>();
+    auto index = node<Expression>();
+    return std::make_unique<SubscriptExpr>(std::move(object),
+                                           std::move(index));
+  }
+  case NodeTag::ThisExpr:
+    return std::make_unique<ThisExpr>();
+  case NodeTag::SelfExpr:
+    return std::make_unique<SelfExpr>();
+  case NodeTag::SuperExpr:
+    return std::make_unique<SuperExpr>();
+  case NodeTag::NewExpr: {
+    auto type = node<Node>();
+    auto args = nodes<Expression>();
+    return std::make_unique<NewExpr>(std::move(type), std::move(args));
+  }
+  case NodeTag::DeleteExpr: {
+    auto expr = node<Expression>();
+    bool isArray = in_.boolean();
+    auto result = std::make_unique<DeleteExpr>(std::move(expr), isArray);
+    result->typeName = in_.str();
+    return result;
+  }
+  case NodeTag::FoldExpr: {
+    auto foldType = in_.enumValue(FoldExpr::FoldType::Binary);
+    auto expr = node<Expression>();
+    auto op = in_.str();
+    auto right = node<Expression>();
+    return std::make_unique<FoldExpr>(foldType, std::move(expr), op,
+                                      std::move(right));
+  }
+  case NodeTag::ExpansionExpr:
+    return std::make_unique<ExpansionExpr>(node<Expression>());
+  case NodeTag::ArrayInitExpr:
+    return std::make_unique<ArrayInitExpr>(nodes<Expression>());
+  case NodeTag::StructInitExpr: {
+    auto type = node<Type>();
+    uint32_t count = in_.count();
+    std::vector<std::pair<std::string, std::unique_ptr<Expression>>> fields;
+    for (uint32_t i = 0; i < count; ++i) {
+      auto name = in_.str();
+      fields.emplace_back(std::move(name), node<Expression>());
+    }
+    return std::make_unique<StructInitExpr>(std::move(type),
+                                            std::move(fields));
+  }
+  case NodeTag::TupleExpr:
+    return std::make_unique<TupleExpr>(nodes<Expression>());
+  case NodeTag::LambdaExpr: {
+    auto params = nodes<Parameter>();
+    auto body = node<Statement>();
+    uint32_t count = in_.count();
+    std::vector<Capture> captures;
+    for (uint32_t i = 0; i < count; ++i) {
+      auto name = in_.str();
+      bool byRef = in_.boolean();
+      bool isMove = in_.boolean();
+      captures.emplace_back(name, byRef, isMove);
+    }
+    return std::make_unique<LambdaExpr>(std::move(params), std::move(body),
+                                        std::move(captures));
+  }
+  case NodeTag::ReflectionExpr: {
+    auto kind = in_.enumValue(ReflectionExpr::TargetKind::Typeof);
+    if (kind == ReflectionExpr::TargetKind::Type) {
+      return std::make_unique<ReflectionExpr>(node<Type>());
+    }
+    return std::make_unique<ReflectionExpr>(node<Expression>());
+  }
+  case NodeTag::BuiltinVarExpr:
+    return std::make_unique<BuiltinVarExpr>(in_.str());
+
+  case NodeTag::VariableDecl: {
+    auto specifiers = in_.str();
+    bool isLate = in_.boolean();
+    auto kind = in_.enumValue(VariableKind::Explicit);
+    auto type = node<Node>();
+    auto name = in_.str();
+    auto initializer = node<Expression>();
+    bool isConst = in_.boolean();
+    bool isStatic = in_.boolean();
+    return std::make_unique<VariableDecl>(specifiers, isLate, kind,
+                                          std::move(type), name,
+                                          std::move(initializer), isConst,
+                                          isStatic);
+  }
+  case NodeTag::TupleDestructuringDecl: {
+    auto specifiers = in_.str();
+    bool isLate = in_.boolean();
+    auto kind = in_.enumValue(VariableKind::Explicit);
+    auto names = in_.strings();
+    auto initializer = node<Expression>();
+    return std::make_unique<TupleDestructuringDecl>(
+        specifiers, isLate, kind, std::move(names), std::move(initializer));
+  }
+  case NodeTag::FunctionDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto templateParams = nodes<Node>();
+    auto params = nodes<Node>();
+    auto returnType = node<Node>();
+    auto whereClause = node<Node>();
+    auto requiresClause = node<Node>();
+    auto lazyBody = functionBody();
+    auto arrowExpr = node<Expression>();
+    bool isImmutable = in_.boolean();
+    auto superCall = node<Expression>();
+    bool isVariadic = in_.boolean();
+    bool isStatic = in_.boolean();
+    auto result = std::make_unique<FunctionDecl>(
+        specifiers, name, std::move(templateParams), std::move(params),
+        std::move(returnType), std::move(whereClause),
+        std::move(requiresClause), nullptr, std::move(arrowExpr), isImmutable,
+        std::move(superCall), isVariadic, isStatic);
+    result->lazyBody = std::move(lazyBody);
+    return result;
+  }
+  case NodeTag::ClassDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto templateParams = nodes<Node>();
+    auto baseClass = in_.str();
+    auto baseClasses = in_.strings();
+    auto interfaces = in_.strings();
+    auto members = nodes<Node>();
+    return std::make_unique<ClassDecl>(
+        specifiers, name, std::move(templateParams), baseClass,
+        std::move(baseClasses), std::move(interfaces), std::move(members));
+  }
+  case NodeTag::InterfaceDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto baseInterfaces = in_.strings();
+    auto members = nodes<Node>();
+    return std::make_unique<InterfaceDecl>(
+        specifiers, name, std::move(baseInterfaces), std::move(members));
+  }
+  case NodeTag::StructDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto members = nodes<Node>();
+    return std::make_unique<StructDecl>(specifiers, name, std::move(members));
+  }
+  case NodeTag::EnumDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto members = nodes<EnumMember>();
+    return std::make_unique<EnumDecl>(specifiers, name, std::move(members));
+  }
+  case NodeTag::NamespaceDecl: {
+    auto name = in_.str();
+    auto members = nodes<Node>();
+    return std::make_unique<NamespaceDecl>(name, std::move(members));
+  }
+  case NodeTag::ModuleDecl:
+    return std::make_unique<ModuleDecl>(in_.strings());
+  case NodeTag::ImportDecl: {
+    auto specifiers = in_.str();
+    auto modulePath = in_.strings();
+    auto alias = in_.str();
+    return std::make_unique<ImportDecl>(specifiers, std::move(modulePath),
+                                        std::move(alias));
+  }
+  case NodeTag::ExportDecl: {
+    auto specifiers = in_.str();
+    auto decl = node<Declaration>();
+    return std::make_unique<ExportDecl>(specifiers, std::move(decl));
+  }
+  case NodeTag::ExtensionDecl: {
+    auto extendedType = node<Type>();
+    auto members = nodes<Node>();
+    return std::make_unique<ExtensionDecl>(std::move(extendedType),
+                                           std::move(members));
+  }
+  case NodeTag::GetterDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto returnType = node<Node>();
+    auto body = node<Node>();
+    auto arrowExpr = node<Expression>();
+    return std::make_unique<GetterDecl>(specifiers, name,
+                                        std::move(returnType),
+                                        std::move(body), std::move(arrowExpr));
+  }
+  case NodeTag::SetterDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto param = node<Parameter>();
+    auto body = node<Node>();
+    auto arrowExpr = node<Expression>();
+    return std::make_unique<SetterDecl>(specifiers, name, std::move(param),
+                                        std::move(body), std::move(arrowExpr));
+  }
+  case NodeTag::TypeAliasDecl: {
+    auto specifiers = in_.str();
+    auto name = in_.str();
+    auto type = node<Type>();
+    bool isTypeSet = in_.boolean();
+    return std::make_unique<TypeAliasDecl>(specifiers, name, std::move(type),
+                                           isTypeSet);
+  }
+  case NodeTag::ExternDecl: {
+    auto abi = in_.str();
+    auto declarations = nodes<Declaration>();
+    return std::make_unique<ExternDecl>(std::move(abi),
+                                        std::move(declarations));
+  }
+  case NodeTag::ConceptDecl: {
+    auto name = in_.str();
+    auto templateParams = nodes<Node>();
+    auto constraints = nodes<Node>();
+    return std::make_unique<ConceptDecl>(name, std::move(templateParams),
+                                         std::move(constraints));
+  }
+  case NodeTag::AttributeDecl: {
+    auto result = std::make_unique<AttributeDecl>(in_.str());
+    uint32_t count = in_.count();
+    for (uint32_t i = 0; i < count; ++i) {
+      auto name = in_.str();
+      auto type = node<Type>();
+      auto defaultValue = node<Expression>();
+      result->addField(std::make_unique<AttributeField>(
+          name, std::move(type), std::move(defaultValue)));
+    }
+    return result;
+  }
+
+  case NodeTag::VariableStmt:
+    return std::make_unique<VariableStmt>(node<VariableDecl>());
+  case NodeTag::TupleDestructuringStmt:
+    return std::make_unique<TupleDestructuringStmt>(
+        node<TupleDestructuringDecl>());
+  case NodeTag::ExprStmt:
+    return std::make_unique<ExprStmt>(node<Expression>());
+  case NodeTag::CompoundStmt:
+    return std::make_unique<CompoundStmt>(nodes<Node>());
+  case NodeTag::IfStmt: {
+    auto condition = node<Expression>();
+    auto thenBranch = node<Statement>();
+    auto elseBranch = node<Statement>();
+    return std::make_unique<IfStmt>(std::move(condition),
+                                    std::move(thenBranch),
+                                    std::move(elseBranch));
+  }
+  case NodeTag::MatchStmt: {
+    auto expr = node<Expression>();
+    auto arms = nodes<MatchArm>();
+    return std::make_unique<MatchStmt>(std::move(expr), std::move(arms));
+  }
+  case NodeTag::ForStmt: {
+    auto init = node<Node>();
+    auto condition = node<Expression>();
+    auto update = node<Expression>();
+    auto body = node<Statement>();
+    auto result = std::make_unique<ForStmt>(std::move(init),
+                                            std::move(condition),
+                                            std::move(update), std::move(body));
+    result->isForeach = in_.boolean();
+    result->indexVar = node<Node>();
+    return result;
+  }
+  case NodeTag::WhileStmt: {
+    auto condition = node<Expression>();
+    auto body = node<Statement>();
+    return std::make_unique<WhileStmt>(std::move(condition), std::move(body));
+  }
+  case NodeTag::DoWhileStmt: {
+    auto body = node<Statement>();
+    auto condition = node<Expression>();
+    return std::make_unique<DoWhileStmt>(std::move(body),
+                                         std::move(condition));
+  }
+  case NodeTag::BreakStmt:
+    return std::make_unique<BreakStmt>();
+  case NodeTag::ContinueStmt:
+    return std::make_unique<ContinueStmt>();
+  case NodeTag::ReturnStmt:
+    return std::make_unique<ReturnStmt>(node<Expression>());
+  case NodeTag::GotoStmt:
+    return std::make_unique<GotoStmt>(in_.str());
+  case NodeTag::LabelStmt:
+    return std::make_unique<LabelStmt>(in_.str());
+  case NodeTag::ThrowStmt:
+    return std::make_unique<ThrowStmt>(node<Expression>());
+  case NodeTag::TryStmt: {
+    auto tryBlock = node<Statement>();
+    auto catchStmts = nodes<CatchStmt>();
+    return std::make_unique<TryStmt>(std::move(tryBlock),
+                                     std::move(catchStmts));
+  }
+  case NodeTag::CatchStmt: {
+    auto param = node<Parameter>();
+    auto body = node<Statement>();
+    return std::make_unique<CatchStmt>(std::move(param), std::move(body));
+  }
+  case NodeTag::DeferStmt:
+    return std::make_unique<DeferStmt>(node<Expression>());
+  case NodeTag::YieldStmt:
+    return std::make_unique<YieldStmt>(node<Expression>());
+  case NodeTag::ComptimeStmt:
+    return std::make_unique<ComptimeStmt>(node<Statement>());
+
+  case NodeTag::PrimitiveType:
+    return std::make_unique<PrimitiveType>(
+        in_.enumValue(PrimitiveType::Kind::Char));
+  case NodeTag::NamedType:
+    return std::make_unique<NamedType>(in_.str());
+  case NodeTag::ArrayType: {
+    auto baseType = node<Type>();
+    auto size = node<Expression>();
+    return std::make_unique<ArrayType>(std::move(baseType), std::move(size));
+  }
+  case NodeTag::RectangularArrayType: {
+    auto baseType = node<Type>();
+    auto sizes = nodes<Expression>();
+    return std::make_unique<RectangularArrayType>(std::move(baseType),
+                                                  std::move(sizes));
+  }
+  case NodeTag::SliceType:
+    return std::make_unique<SliceType>(node<Type>());
+  case NodeTag::RectangularSliceType: {
+    auto baseType = node<Type>();
+    auto rank = static_cast<int>(in_.u32());
+    return std::make_unique<RectangularSliceType>(std::move(baseType), rank);
+  }
+  case NodeTag::PointerType: {
+    auto baseType = node<Type>();
+    bool isNullable = in_.boolean();
+    return std::make_unique<PointerType>(std::move(baseType), isNullable);
+  }
+  case NodeTag::ReferenceType:
+    return std::make_unique<ReferenceType>(node<Type>());
+  case NodeTag::FunctionType: {
+    auto parameterTypes = nodes<Type>();
+    auto returnType = node<Type>();
+    return std::make_unique<FunctionType>(std::move(parameterTypes),
+                                          std::move(returnType));
+  }
+  case NodeTag::GenericType: {
+    auto name = in_.str();
+    auto arguments = nodes<Node>();
+    return std::make_unique<GenericType>(name, std::move(arguments));
+  }
+  case NodeTag::ReadonlyType:
+    return std::make_unique<ReadonlyType>(node<Type>());
+  case NodeTag::TupleType:
+    return std::make_unique<TupleType>(nodes<Type>());
+  case NodeTag::NullableType:
+    return std::make_unique<NullableType>(node<Type>());
+
+  case NodeTag::Parameter: {
+    auto name = in_.str();
+    auto type = node<Type>();
+    auto defaultValue = node<Expression>();
+    bool isVariadic = in_.boolean();
+    bool isSelf = in_.boolean();
+    bool isSelfImmutable = in_.boolean();
+    return std::make_unique<Parameter>(name, std::move(type),
+                                       std::move(defaultValue), isVariadic,
+                                       isSelf, isSelfImmutable);
+  }
+  case NodeTag::EnumMember: {
+    auto name = in_.str();
+    auto value = node<Expression>();
+    return std::make_unique<EnumMember>(name, std::move(value));
+  }
+  case NodeTag::MatchArm: {
+    auto pattern = node<Pattern>();
+    auto guard = node<Expression>();
+    auto body = node<Statement>();
+    return std::make_unique<MatchArm>(std::move(pattern), std::move(guard),
+                                      std::move(body));
+  }
+  case NodeTag::Pattern: {
+    auto result = std::make_unique<Pattern>();
+    result->isDefault = in_.boolean();
+    return result;
+  }
+  case NodeTag::TemplateParameter: {
+    auto name = in_.str();
+    auto constraint = node<Node>();
+    bool isVariadic = in_.boolean();
+    return std::make_unique<TemplateParameter>(name, std::move(constraint),
+                                               isVariadic);
+  }
+  case NodeTag::WhereClause: {
+    uint32_t count = in_.count();
+    std::vector<WhereClause::Constraint> constraints;
+    for (uint32_t i = 0; i < count; ++i) {
+      auto typeParam = in_.str();
+      constraints.push_back({std::move(typeParam), node<Type>()});
+    }
+    return std::make_unique<WhereClause>(std::move(constraints));
+  }
+  case NodeTag::RequiresClause:
+    return std::make_unique<RequiresClause>(node<RequiresExpression>());
+  case NodeTag::RequiresExpression: {
+    auto params = nodes<Node>();
+    auto requirements = nodes<Requirement>();
+    return std::make_unique<RequiresExpression>(std::move(params),
+                                                std::move(requirements));
+  }
+  case NodeTag::Requirement: {
+    auto type = in_.enumValue(Requirement::RequirementType::Typename);
+    auto expr = node<Expression>();
+    auto typeSpec = node<Type>();
+    return std::make_unique<Requirement>(type, std::move(expr),
+                                         std::move(typeSpec));
+  }
+
+  case NodeTag::Null:
+    break;
+  }
+  throw MalformedData();
+}
+
+} // namespace
+
+std::string AstSerializer::serialize(const Program &program) {
+  try {
+    ByteWriter out;
+    out.u32(SchemaVersion);
+    AstWriter(out).nodes(program.declarations);
+    return std::move(out.data());
+  } catch (const UnsupportedNode &) {
+    return "";
+  }
+}
+
+std::unique_ptr<Program>
+AstSerializer::deserialize(std::string_view data,
+                           std::shared_ptr<const void> owner,
+                           const SkimmedBodyReader &readSkimmedBody) {
+  auto arena = std::make_shared<AstArena>();
+  std::vector<std::unique_ptr<Declaration>> declarations;
+  try {
+    AstArena::Scope arenaScope(arena.get());
+    AstReader reader(data, std::move(owner), arena, readSkimmedBody);
+    if (reader.input().u32() != SchemaVersion) {
+      return nullptr;
+    }
+    declarations = reader.nodes<Declaration>();
+    if (!reader.input().atEnd()) {
+      return nullptr;
+    }
+  } catch (const MalformedData &) {
+    return nullptr;
+  }
+
+  // Program 本身走普通堆分配，它持有内存池，不能位于内存池中
+  return std::make_unique<Program>(std::move(declarations), std::move(arena));
+}
+
+} // namespace ast
+} // namespace c_hat
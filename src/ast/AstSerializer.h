@@ -0,0 +1,46 @@
+#pragma once
+
+#include "others/Program.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace c_hat {
+namespace ast {
+
+class LazyBody;
+
+// AST 二进制序列化
+// 每个具体节点类对应一个标签，节点写作标签加字段，子节点递归写出，
+// 空指针写作空标签。NodeType 中没有具体节点类的抽象类型（Expression、
+// ClassType 等）不会出现在树中；getType() 相同的 VariableStmt 和
+// TupleDestructuringStmt 各有独立的标签。
+class AstSerializer {
+public:
+  // 格式版本，节点类或字段变化时递增，旧数据随之失效
+  static constexpr uint32_t SchemaVersion = 2;
+
+  // 读回 LazyBody::writeTokens 写出的函数体，tokens 在 owner 存活期间有效；
+  // 数据损坏时抛出 MalformedData
+  using SkimmedBodyReader = std::function<std::unique_ptr<LazyBody>(
+      std::string_view tokens, std::shared_ptr<const void> owner,
+      std::weak_ptr<AstArena> arena)>;
+
+  // 序列化整个程序
+  // 函数体作为带长度前缀的数据块写出，略读时跳过的函数体写出词法单元，
+  // 不在这里解析。包含无法序列化的节点时返回空字符串。
+  static std::string serialize(const Program &program);
+
+  // 从二进制数据恢复程序，数据损坏或版本不匹配时返回 nullptr
+  // 函数体在首次 materializeBody() 时才解码，owner 持有 data 指向的
+  // 内存，保证它在此之前一直有效。未给出 readSkimmedBody 时，
+  // 含有词法单元形式函数体的数据视为损坏。
+  static std::unique_ptr<Program>
+  deserialize(std::string_view data, std::shared_ptr<const void> owner,
+              const SkimmedBodyReader &readSkimmedBody = nullptr);
+};
+
+} // namespace ast
+} // namespace c_hat
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace c_hat {
+namespace ast {
+
+// 二进制数据损坏（截断、越界或取值非法）
+class MalformedData : public std::runtime_error {
+public:
+  MalformedData() : std::runtime_error("Malformed binary data") {}
+};
+
+// 二进制写入器，整数均为小端序，字符串为 u32 长度加字节
+class ByteWriter {
+public:
+  void u8(uint8_t value) { data_.push_back(static_cast<char>(value)); }
+
+  void u32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      u8(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+
+  void u64(uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      u8(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+
+  void str(std::string_view value) {
+    u32(static_cast<uint32_t>(value.size()));
+    data_.append(value);
+  }
+
+  void strings(const std::vector<std::string> &values) {
+    u32(static_cast<uint32_t>(values.size()));
+    for (const auto &value : values) {
+      str(value);
+    }
+  }
+
+  void bytes(std::string_view value) { data_.append(value); }
+
+  void append(const ByteWriter &other) { data_ += other.data_; }
+
+  size_t size() const { return data_.size(); }
+
+  std::string &data() { return data_; }
+
+private:
+  std::string data_;
+};
+
+// 二进制读取器，越界读取抛出 MalformedData
+class ByteReader {
+public:
+  explicit ByteReader(std::string_view data) : data_(data) {}
+
+  uint8_t u8() {
+    need(1);
+    return static_cast<uint8_t>(data_[position_++]);
+  }
+
+  uint32_t u32() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<uint32_t>(u8()) << (i * 8);
+    }
+    return value;
+  }
+
+  uint64_t u64() {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(u8()) << (i * 8);
+    }
+    return value;
+  }
+
+  bool boolean() { return u8() != 0; }
+
+  // 读取取值不超过 max 的枚举
+  template <typename Enum> Enum enumValue(Enum max) {
+    uint8_t value = u8();
+    if (value > static_cast<uint8_t>(max)) {
+      throw MalformedData();
+    }
+    return static_cast<Enum>(value);
+  }
+
+  std::string str() { return std::string(view(u32())); }
+
+  std::vector<std::string> strings() {
+    uint32_t count = this->count();
+    std::vector<std::string> values;
+    for (uint32_t i = 0; i < count; ++i) {
+      values.push_back(str());
+    }
+    return values;
+  }
+
+  // 读取 size 字节的视图，视图指向原始数据
+  std::string_view view(size_t size) {
+    need(size);
+    auto value = data_.substr(position_, size);
+    position_ += size;
+    return value;
+  }
+
+  // 读取数量字段，每个元素至少占一个字节，超出剩余数据即为损坏
+  uint32_t count() {
+    uint32_t value = u32();
+    need(value);
+    return value;
+  }
+
+  bool atEnd() const { return position_ == data_.size(); }
+
+  // 已读取的字节数
+  size_t position() const { return position_; }
+
+private:
+  void need(size_t size) const {
+    if (data_.size() - position_ < size) {
+      throw MalformedData();
+    }
+  }
+
+  std::string_view data_;
+  size_t position_ = 0;
+};
+
+} // namespace ast
+} // namespace c_hat
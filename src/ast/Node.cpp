@@ -0,0 +1,36 @@
+#include "Node.h"
+#include "AstArena.h"
+#include <new>
+
+namespace c_hat {
+namespace ast {
+
+namespace {
+// 每个节点前的分配头，记录节点所属的内存池（nullptr 表示普通堆分配）
+struct alignas(std::max_align_t) AllocationHeader {
+  AstArena *arena;
+};
+} // namespace
+
+void *Node::operator new(std::size_t size) {
+  std::size_t total = sizeof(AllocationHeader) + size;
+  AstArena *arena = AstArena::current();
+  void *raw = arena ? arena->allocate(total, alignof(AllocationHeader))
+                    : ::operator new(total);
+  auto *header = new (raw) AllocationHeader{arena};
+  return header + 1;
+}
+
+void Node::operator delete(void *ptr, std::size_t) noexcept {
+  if (!ptr) {
+    return;
+  }
+  auto *header = static_cast<AllocationHeader *>(ptr) - 1;
+  // 内存池中的节点不单独释放，随内存池整体释放
+  if (!header->arena) {
+    ::operator delete(header);
+  }
+}
+
+} // namespace ast
+} // namespace c_hat
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "NodeType.h"
+#include <cstddef>
 #include <string>
 
 namespace c_hat {
@@ -13,6 +14,10 @@ public:
 
   virtual NodeType getType() const = 0;
   virtual std::string toString() const = 0;
+
+  // 节点分配：当前线程有活动的 AstArena 时从内存池分配，否则走普通堆
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size) noexcept;
 };
 
 } // namespace ast
@@ -4,6 +4,14 @@
 namespace c_hat {
 namespace ast {
 
+Node *FunctionDecl::materializeBody() {
+  if (!body && lazyBody) {
+    body = lazyBody->parse();
+    lazyBody.reset();
+  }
+  return body.get();
+}
+
 std::string FunctionDecl::toString() const {
   std::string paramsStr = "";
   for (size_t i = 0; i < params.size(); i++) {
@@ -22,6 +30,8 @@ std::string FunctionDecl::toString() const {
   std::string bodyStr = "";
   if (body) {
     bodyStr = std::format(", {}", body->toString());
+  } else if (lazyBody) {
+    bodyStr = ", <lazy body>";
   }
   if (arrowExpr) {
     bodyStr = std::format(", => {}", arrowExpr->toString());
@@ -9,6 +9,21 @@
 namespace c_hat {
 namespace ast {
 
+class ByteWriter;
+
+// 延迟解析的函数体
+// 略读模式下语法分析器只记录函数体的词法单元范围，首次需要时才解析
+class LazyBody {
+public:
+    virtual ~LazyBody() = default;
+
+    // 解析函数体
+    virtual std::unique_ptr<Node> parse() = 0;
+
+    // 不解析，直接写出函数体的词法单元（用于 AST 缓存），不支持时返回 false
+    virtual bool writeTokens(ByteWriter&) const { return false; }
+};
+
 // 函数声明
 class FunctionDecl : public Declaration {
 public:
@@ -32,6 +47,15 @@ public:
     
     NodeType getType() const override { return NodeType::FunctionDecl; }
     std::string toString() const override;
+
+    // 是否有函数体（包括尚未解析的函数体）
+    bool hasBody() const { return body || lazyBody; }
+
+    // 函数体是否尚未解析
+    bool hasLazyBody() const { return lazyBody != nullptr; }
+
+    // 解析略读时跳过的函数体，返回函数体（没有函数体时返回 nullptr）
+    Node *materializeBody();
     
     std::string specifiers;
     std::string name;
@@ -41,6 +65,8 @@ public:
     std::unique_ptr<Node> whereClause;
     std::unique_ptr<Node> requiresClause;
     std::unique_ptr<Node> body;
+    // 略读模式下跳过的函数体，解析后移入 body
+    std::unique_ptr<LazyBody> lazyBody;
     std::unique_ptr<Expression> arrowExpr;
     bool isImmutable;
     std::unique_ptr<Expression> superCall;
@@ -1,22 +1,34 @@
 #pragma once
 
+#include "../AstArena.h"
 #include "../Node.h"
 #include "../declarations/Declaration.h"
 #include <vector>
 #include <memory>
 
 namespace c_hat {
+namespace lexer {
+class SourceBuffer;
+} // namespace lexer
+
 namespace ast {
 
 // 程序节点
 class Program : public Node {
 public:
-    Program(std::vector<std::unique_ptr<Declaration>> declarations)
-        : declarations(std::move(declarations)) {}
+    Program(std::vector<std::unique_ptr<Declaration>> declarations,
+            std::shared_ptr<AstArena> arena = nullptr)
+        : arena(std::move(arena)), declarations(std::move(declarations)) {}
     
     NodeType getType() const override { return NodeType::Program; }
     std::string toString() const override;
     
+    // 节点所在的内存池（必须声明在 declarations 之前，保证最后析构）
+    std::shared_ptr<AstArena> arena;
+
+    // 程序的源码缓冲区，保持文件映射在整个编译期间有效
+    std::shared_ptr<const lexer::SourceBuffer> source;
+
     std::vector<std::unique_ptr<Declaration>> declarations;
 };
 
@@ -66,6 +66,8 @@ std::string CodeGenerator::generateVariableDecl(
 
 std::string CodeGenerator::generateFunctionDecl(
     std::unique_ptr<ast::FunctionDecl> funcDecl) {
+  // 略读时跳过的函数体在生成代码前解析
+  funcDecl->materializeBody();
   std::string code = indent();
   // TODO: 生成函数修饰符
   // TODO: 生成返回类型
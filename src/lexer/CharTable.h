@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace c_hat {
+namespace lexer {
+
+// 字符分类标志
+enum CharClass : uint8_t {
+  CharAlpha = 1 << 0,      // ASCII 字母
+  CharDigit = 1 << 1,      // 十进制数字
+  CharUnderscore = 1 << 2, // 下划线
+  CharSpace = 1 << 3,      // 空白（与 C 区域设置下的 isspace 一致）
+};
+
+// 256 项字符分类表，以 unsigned char 为下标，非 ASCII 字节不属于任何分类
+inline constexpr std::array<uint8_t, 256> CharClassTable = [] {
+  std::array<uint8_t, 256> table{};
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] |= CharAlpha;
+  }
+  for (int c = 'A'; c <= 'Z'; ++c) {
+    table[c] |= CharAlpha;
+  }
+  for (int c = '0'; c <= '9'; ++c) {
+    table[c] |= CharDigit;
+  }
+  table['_'] |= CharUnderscore;
+  for (char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+    table[static_cast<unsigned char>(c)] |= CharSpace;
+  }
+  return table;
+}();
+
+constexpr uint8_t charClass(char c) {
+  return CharClassTable[static_cast<unsigned char>(c)];
+}
+
+constexpr bool isAlphaChar(char c) { return charClass(c) & CharAlpha; }
+
+constexpr bool isDigitChar(char c) { return charClass(c) & CharDigit; }
+
+constexpr bool isSpaceChar(char c) { return charClass(c) & CharSpace; }
+
+// 标识符首字符：字母或下划线
+constexpr bool isIdentifierStart(char c) {
+  return charClass(c) & (CharAlpha | CharUnderscore);
+}
+
+// 标识符后续字符：字母、数字或下划线
+constexpr bool isIdentifierContinue(char c) {
+  return charClass(c) & (CharAlpha | CharDigit | CharUnderscore);
+}
+
+} // namespace lexer
+} // namespace c_hat
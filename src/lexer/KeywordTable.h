@@ -0,0 +1,191 @@
+#pragma once
+
+#include "TokenType.h"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace c_hat {
+namespace lexer {
+
+// 关键字表项
+struct KeywordEntry {
+  std::string_view text;
+  TokenType type;
+};
+
+// 关键字表（包含 int32、uint64 等类型别名）
+inline constexpr KeywordEntry Keywords[] = {
+    {"func", TokenType::Func},
+    {"class", TokenType::Class},
+    {"struct", TokenType::Struct},
+    {"enum", TokenType::Enum},
+    {"union", TokenType::Union},
+    {"interface", TokenType::Interface},
+    {"module", TokenType::Module},
+    {"import", TokenType::Import},
+    {"export", TokenType::Export},
+    {"extension", TokenType::Extension},
+    {"get", TokenType::Get},
+    {"set", TokenType::Set},
+    {"public", TokenType::Public},
+    {"private", TokenType::Private},
+    {"protected", TokenType::Protected},
+    {"internal", TokenType::Internal},
+    {"static", TokenType::Static},
+    {"const", TokenType::Const},
+    {"virtual", TokenType::Virtual},
+    {"override", TokenType::Override},
+    {"final", TokenType::Final},
+    {"abstract", TokenType::Abstract},
+    {"inline", TokenType::Inline},
+    {"using", TokenType::Using},
+    {"try", TokenType::Try},
+    {"catch", TokenType::Catch},
+    {"throw", TokenType::Throw},
+    {"defer", TokenType::Defer},
+    {"await", TokenType::Await},
+    {"yield", TokenType::Yield},
+    {"comptime", TokenType::Comptime},
+    {"late", TokenType::Late},
+    {"var", TokenType::Var},
+    {"let", TokenType::Let},
+    {"void", TokenType::Void},
+    {"bool", TokenType::Bool},
+    {"byte", TokenType::Byte},
+    {"sbyte", TokenType::SByte},
+    {"short", TokenType::Short},
+    {"ushort", TokenType::UShort},
+    {"int", TokenType::Int},
+    {"int32", TokenType::Int},
+    {"uint", TokenType::UInt},
+    {"uint32", TokenType::UInt},
+    {"long", TokenType::Long},
+    {"int64", TokenType::Long},
+    {"ulong", TokenType::ULong},
+    {"uint64", TokenType::ULong},
+    {"float", TokenType::Float},
+    {"double", TokenType::Double},
+    {"fp16", TokenType::Fp16},
+    {"bf16", TokenType::Bf16},
+    {"char", TokenType::Char},
+    {"true", TokenType::True},
+    {"false", TokenType::False},
+    {"null", TokenType::Null},
+    {"self", TokenType::Self},
+    {"base", TokenType::Base},
+    {"super", TokenType::Super},
+    {"new", TokenType::New},
+    {"delete", TokenType::Delete},
+    {"if", TokenType::If},
+    {"else", TokenType::Else},
+    {"match", TokenType::Match},
+    {"case", TokenType::Case},
+    {"default", TokenType::Default},
+    {"for", TokenType::For},
+    {"foreach", TokenType::Foreach},
+    {"while", TokenType::While},
+    {"do", TokenType::Do},
+    {"break", TokenType::Break},
+    {"continue", TokenType::Continue},
+    {"return", TokenType::Return},
+    {"goto", TokenType::Goto},
+    {"as", TokenType::As},
+    {"where", TokenType::Where},
+    {"requires", TokenType::Requires},
+    {"concept", TokenType::Concept},
+    {"implicit", TokenType::Implicit},
+    {"operator", TokenType::Operator},
+    {"mutable", TokenType::Mutable},
+    {"sizeof", TokenType::Sizeof},
+    {"typeof", TokenType::Typeof},
+    {"extern", TokenType::Extern},
+    {"literalview", TokenType::LiteralView},
+    {"namespace", TokenType::Namespace},
+    {"attribute", TokenType::Attribute},
+};
+
+namespace detail {
+
+// 完美哈希槽位数（2 的幂），槽位中保存关键字在 Keywords 中的下标
+inline constexpr size_t KeywordSlotCount = 1024;
+inline constexpr uint8_t EmptyKeywordSlot = 0xFF;
+
+static_assert(std::size(Keywords) < EmptyKeywordSlot);
+
+// 带种子的 FNV-1a 哈希
+constexpr uint32_t hashKeyword(std::string_view text, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+constexpr size_t keywordSlot(std::string_view text, uint32_t seed) {
+  return hashKeyword(text, seed) & (KeywordSlotCount - 1);
+}
+
+constexpr bool isPerfectSeed(uint32_t seed) {
+  std::array<bool, KeywordSlotCount> used{};
+  for (const auto &keyword : Keywords) {
+    size_t slot = keywordSlot(keyword.text, seed);
+    if (used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  return true;
+}
+
+// 编译期搜索使所有关键字互不冲突的种子
+consteval uint32_t findPerfectSeed() {
+  uint32_t seed = 0;
+  while (!isPerfectSeed(seed)) {
+    ++seed;
+  }
+  return seed;
+}
+
+inline constexpr uint32_t KeywordSeed = findPerfectSeed();
+
+inline constexpr std::array<uint8_t, KeywordSlotCount> KeywordSlots = [] {
+  std::array<uint8_t, KeywordSlotCount> slots{};
+  slots.fill(EmptyKeywordSlot);
+  for (size_t i = 0; i < std::size(Keywords); ++i) {
+    size_t slot = keywordSlot(Keywords[i].text, KeywordSeed);
+    slots[slot] = static_cast<uint8_t>(i);
+  }
+  return slots;
+}();
+
+inline constexpr size_t MaxKeywordLength = [] {
+  size_t length = 0;
+  for (const auto &keyword : Keywords) {
+    length = keyword.text.size() > length ? keyword.text.size() : length;
+  }
+  return length;
+}();
+
+} // namespace detail
+
+// 查找关键字：一次哈希、一次比较；不是关键字时返回 TokenType::Identifier
+constexpr TokenType lookupKeyword(std::string_view text) {
+  if (text.size() > detail::MaxKeywordLength) {
+    return TokenType::Identifier;
+  }
+  uint8_t index =
+      detail::KeywordSlots[detail::keywordSlot(text, detail::KeywordSeed)];
+  if (index != detail::EmptyKeywordSlot && Keywords[index].text == text) {
+    return Keywords[index].type;
+  }
+  return TokenType::Identifier;
+}
+
+static_assert(lookupKeyword("func") == TokenType::Func);
+static_assert(lookupKeyword("uint64") == TokenType::ULong);
+static_assert(lookupKeyword("function") == TokenType::Identifier);
+
+} // namespace lexer
+} // namespace c_hat
@@ -1,100 +1,20 @@
 #include "Lexer.h"
-#include <cctype>
-#include <unordered_map>
+#include "CharTable.h"
+#include "KeywordTable.h"
+#include "SimdScan.h"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace c_hat {
 namespace lexer {
 
-// 关键字映射
-static std::unordered_map<std::string, TokenType> keywordMap = {
-    {"func", TokenType::Func},
-    {"class", TokenType::Class},
-    {"struct", TokenType::Struct},
-    {"enum", TokenType::Enum},
-    {"union", TokenType::Union},
-    {"interface", TokenType::Interface},
-    {"module", TokenType::Module},
-    {"import", TokenType::Import},
-    {"export", TokenType::Export},
-    {"extension", TokenType::Extension},
-    {"get", TokenType::Get},
-    {"set", TokenType::Set},
-    {"public", TokenType::Public},
-    {"private", TokenType::Private},
-    {"protected", TokenType::Protected},
-    {"internal", TokenType::Internal},
-    {"static", TokenType::Static},
-    {"const", TokenType::Const},
-    {"virtual", TokenType::Virtual},
-    {"override", TokenType::Override},
-    {"final", TokenType::Final},
-    {"abstract", TokenType::Abstract},
-    {"inline", TokenType::Inline},
-    {"using", TokenType::Using},
-    {"try", TokenType::Try},
-    {"catch", TokenType::Catch},
-    {"throw", TokenType::Throw},
-    {"defer", TokenType::Defer},
-    {"await", TokenType::Await},
-    {"yield", TokenType::Yield},
-    {"comptime", TokenType::Comptime},
-    {"late", TokenType::Late},
-    {"var", TokenType::Var},
-    {"let", TokenType::Let},
-    {"void", TokenType::Void},
-    {"bool", TokenType::Bool},
-    {"byte", TokenType::Byte},
-    {"sbyte", TokenType::SByte},
-    {"short", TokenType::Short},
-    {"ushort", TokenType::UShort},
-    {"int", TokenType::Int},
-    {"int32", TokenType::Int},
-    {"uint", TokenType::UInt},
-    {"uint32", TokenType::UInt},
-    {"long", TokenType::Long},
-    {"int64", TokenType::Long},
-    {"ulong", TokenType::ULong},
-    {"uint64", TokenType::ULong},
-    {"float", TokenType::Float},
-    {"double", TokenType::Double},
-    {"fp16", TokenType::Fp16},
-    {"bf16", TokenType::Bf16},
-    {"char", TokenType::Char},
-    {"true", TokenType::True},
-    {"false", TokenType::False},
-    {"null", TokenType::Null},
-    {"self", TokenType::Self},
-    {"base", TokenType::Base},
-    {"super", TokenType::Super},
-    {"new", TokenType::New},
-    {"delete", TokenType::Delete},
-    {"if", TokenType::If},
-    {"else", TokenType::Else},
-    {"match", TokenType::Match},
-    {"case", TokenType::Case},
-    {"default", TokenType::Default},
-    {"for", TokenType::For},
-    {"foreach", TokenType::Foreach},
-    {"while", TokenType::While},
-    {"do", TokenType::Do},
-    {"break", TokenType::Break},
-    {"continue", TokenType::Continue},
-    {"return", TokenType::Return},
-    {"goto", TokenType::Goto},
-    {"as", TokenType::As},
-    {"where", TokenType::Where},
-    {"requires", TokenType::Requires},
-    {"concept", TokenType::Concept},
-    {"implicit", TokenType::Implicit},
-    {"operator", TokenType::Operator},
-    {"mutable", TokenType::Mutable},
-    {"sizeof", TokenType::Sizeof},
-    {"typeof", TokenType::Typeof},
-    {"extern", TokenType::Extern},
-    {"literalview", TokenType::LiteralView},
-    {"namespace", TokenType::Namespace},
-    {"attribute", TokenType::Attribute}};
-
 // Token 转字符串
 std::string Token::toString() const {
   std::string typeStr;
@@ -541,22 +461,97 @@ std::string Token::toString() const {
     typeStr = "Unknown";
     break;
   }
-  return typeStr + "(\"" + value + "\")";
+  return typeStr + "(\"" + std::string(value) + "\")";
 }
 
 // Lexer 构造函数
 Lexer::Lexer(std::string source)
-    : source(std::move(source)), position(0), line(1), column(1) {}
+    : Lexer(SourceBuffer::fromString(std::move(source))) {}
+
+Lexer::Lexer(std::shared_ptr<const SourceBuffer> buffer)
+    : buffer(std::move(buffer)), source(this->buffer->getText()), position(0),
+      line(1), column(1) {}
+
+Lexer::Lexer(ChunkedInput input)
+    : position(0), line(1), column(1), inputFd(input.fd),
+      chunkSize(input.chunkSize > 0 ? input.chunkSize
+                                    : ChunkedInput::DefaultChunkSize),
+      inputExhausted(false) {}
+
+namespace {
+
+// 词法单元结束后最多再查看的字符数（如 "<<=" 和 "1.5" 的判断）
+// 离窗口末尾更近的词法单元可能被截断，需要补充输入后重新扫描
+constexpr size_t LookaheadMargin = 8;
+
+long readInput(int fd, char *data, size_t size) {
+#ifdef _WIN32
+  return _read(fd, data, static_cast<unsigned>(size));
+#else
+  return static_cast<long>(::read(fd, data, size));
+#endif
+}
+
+} // namespace
 
 // 获取下一个词法单元
 std::optional<Token> Lexer::nextToken() {
-  // 检查是否有回溯的 token
-  if (!ungetTokens.empty()) {
-    Token token = ungetTokens.back();
-    ungetTokens.pop_back();
-    return token;
+  if (inputFd < 0) {
+    return scanToken();
+  }
+
+  // 分块模式：词法单元（连同前面的空白和注释）若扫到了窗口末尾附近，
+  // 可能被截断，回到起点补充输入后重新扫描
+  refillWindow();
+  while (true) {
+    size_t start = position;
+    int startLine = line;
+    int startColumn = column;
+    auto token = scanToken();
+    if (inputExhausted || position + LookaheadMargin < source.length()) {
+      return token;
+    }
+    position = start;
+    line = startLine;
+    column = startColumn;
+    readChunk();
+  }
+}
+
+void Lexer::refillWindow() {
+  // 已扫描的部分超过一块时丢弃，之前返回的 Token 随之失效
+  if (position >= chunkSize) {
+    window.erase(0, position);
+    position = 0;
+    source = window;
+  }
+  while (!inputExhausted && window.length() - position < chunkSize) {
+    readChunk();
+  }
+}
+
+bool Lexer::readChunk() {
+  size_t oldSize = window.length();
+  window.resize(oldSize + chunkSize);
+  long count;
+  do {
+    count = readInput(inputFd, window.data() + oldSize, chunkSize);
+  } while (count < 0 && errno == EINTR);
+  if (count < 0) {
+    window.resize(oldSize);
+    throw std::runtime_error("Failed to read source input");
+  }
+  window.resize(oldSize + static_cast<size_t>(count));
+  source = window;
+  if (count == 0) {
+    inputExhausted = true;
+    return false;
   }
+  return true;
+}
 
+// 在当前窗口中扫描一个词法单元
+std::optional<Token> Lexer::scanToken() {
   // 跳过空白
   skipWhitespace();
 
@@ -568,12 +563,12 @@ std::optional<Token> Lexer::nextToken() {
   char c = currentChar();
 
   // 处理标识符和关键字
-  if (std::isalpha(c) || c == '_') {
+  if (isIdentifierStart(c)) {
     return processIdentifier();
   }
 
   // 处理数字字面量
-  if (std::isdigit(c)) {
+  if (isDigitChar(c)) {
     return processNumber();
   }
 
@@ -596,40 +591,25 @@ std::optional<Token> Lexer::nextToken() {
   return processOperator();
 }
 
-// 回溯一个词法单元
-void Lexer::ungetToken(const Token &token) { ungetTokens.push_back(token); }
-
 // 跳过空白字符
 void Lexer::skipWhitespace() {
   while (!isEOF()) {
     char c = currentChar();
-    if (std::isspace(c)) {
-      if (c == '\n') {
-        line++;
-        column = 1;
-      } else {
-        column++;
-      }
-      advance();
+    if (c == ' ' && !isSpaceChar(peekChar())) {
+      // 最常见的单个空格直接前进
+      position++;
+      column++;
+    } else if (isSpaceChar(c)) {
+      // 整段空白一次跳过
+      advanceTo(simd::skipWhitespace(source.data(), position, source.length()));
     } else if (c == '/' && peekChar() == '/') {
-      // 跳过行注释
-      advance(2);
-      while (!isEOF() && currentChar() != '\n') {
-        advance();
-      }
+      // 跳过行注释（列号在随后的换行处重置）
+      position = simd::findByte(source.data(), position + 2, source.length(),
+                                '\n');
     } else if (c == '/' && peekChar() == '*') {
       // 跳过多行注释
       advance(2);
-      int startLine = line;
-      while (!isEOF() && !(currentChar() == '*' && peekChar() == '/')) {
-        if (currentChar() == '\n') {
-          line++;
-          column = 1;
-        } else {
-          column++;
-        }
-        advance();
-      }
+      advanceTo(findBlockCommentEnd(position));
       if (!isEOF()) {
         advance(2);
         column += 2;
@@ -644,41 +624,41 @@ void Lexer::skipWhitespace() {
 std::optional<Token> Lexer::processIdentifier() {
   int startLine = line;
   int startColumn = column;
-  std::string identifier;
+  size_t start = position;
 
-  while (!isEOF()) {
-    char c = currentChar();
-    if (std::isalnum(c) || c == '_') {
-      identifier += c;
-      advance();
-      column++;
-    } else {
-      break;
-    }
+  // 标识符不含换行，直接扫描到结尾再一次性更新列号
+  while (position < source.length() &&
+         isIdentifierContinue(source[position])) {
+    position++;
   }
+  column += static_cast<int>(position - start);
 
-  auto it = keywordMap.find(identifier);
-  if (it != keywordMap.end()) {
-    return Token(it->second, identifier, startLine, startColumn);
+  std::string_view identifier = sourceFrom(start);
+  TokenType keyword = checkKeyword(identifier);
+  if (keyword != TokenType::Identifier) {
+    return Token(keyword, identifier, startLine, startColumn);
   }
 
+  // 标识符在词法阶段驻留，后续各阶段以 NameId 比较和查找
+  NameId nameId = NameInterner::global().intern(identifier);
   if (identifier.size() >= 3 && identifier[0] == '_' && identifier[1] == '_') {
-    return Token(TokenType::BuiltinVar, identifier, startLine, startColumn);
+    return Token(TokenType::BuiltinVar, identifier, startLine, startColumn,
+                 nameId);
   }
 
-  return Token(TokenType::Identifier, identifier, startLine, startColumn);
+  return Token(TokenType::Identifier, identifier, startLine, startColumn,
+               nameId);
 }
 
 // 处理数字字面量
 std::optional<Token> Lexer::processNumber() {
   int startLine = line;
   int startColumn = column;
-  std::string number;
+  size_t start = position;
   bool isFloat = false;
 
   // 处理整数部分
-  while (!isEOF() && std::isdigit(currentChar())) {
-    number += currentChar();
+  while (!isEOF() && isDigitChar(currentChar())) {
     advance();
     column++;
   }
@@ -686,12 +666,10 @@ std::optional<Token> Lexer::processNumber() {
   // 处理小数部分
   if (!isEOF() && currentChar() == '.') {
     isFloat = true;
-    number += '.';
     advance();
     column++;
 
-    while (!isEOF() && std::isdigit(currentChar())) {
-      number += currentChar();
+    while (!isEOF() && isDigitChar(currentChar())) {
       advance();
       column++;
     }
@@ -700,27 +678,23 @@ std::optional<Token> Lexer::processNumber() {
   // 处理指数部分
   if (!isEOF() && (currentChar() == 'e' || currentChar() == 'E')) {
     isFloat = true;
-    number += currentChar();
     advance();
     column++;
 
     if (!isEOF() && (currentChar() == '+' || currentChar() == '-')) {
-      number += currentChar();
       advance();
       column++;
     }
 
-    while (!isEOF() && std::isdigit(currentChar())) {
-      number += currentChar();
+    while (!isEOF() && isDigitChar(currentChar())) {
       advance();
       column++;
     }
   }
 
   // 处理后缀
-  if (!isEOF() && std::isalpha(currentChar())) {
+  if (!isEOF() && isAlphaChar(currentChar())) {
     char suffix = currentChar();
-    number += suffix;
     advance();
     column++;
     isFloat =
@@ -728,9 +702,11 @@ std::optional<Token> Lexer::processNumber() {
   }
 
   if (isFloat) {
-    return Token(TokenType::FloatingLiteral, number, startLine, startColumn);
+    return Token(TokenType::FloatingLiteral, sourceFrom(start), startLine,
+                 startColumn);
   } else {
-    return Token(TokenType::IntegerLiteral, number, startLine, startColumn);
+    return Token(TokenType::IntegerLiteral, sourceFrom(start), startLine,
+                 startColumn);
   }
 }
 
@@ -738,32 +714,29 @@ std::optional<Token> Lexer::processNumber() {
 std::optional<Token> Lexer::processCharacter() {
   int startLine = line;
   int startColumn = column;
-  std::string literal = "'";
+  size_t start = position;
   advance();
   column++;
 
   // 处理转义字符
   if (!isEOF() && currentChar() == '\\') {
-    literal += '\\';
     advance();
     column++;
 
     if (!isEOF()) {
-      literal += currentChar();
       advance();
       column++;
     }
   } else if (!isEOF() && currentChar() != '\'') {
-    literal += currentChar();
     advance();
     column++;
   }
 
   if (!isEOF() && currentChar() == '\'') {
-    literal += "'";
     advance();
     column++;
-    return Token(TokenType::CharacterLiteral, literal, startLine, startColumn);
+    return Token(TokenType::CharacterLiteral, sourceFrom(start), startLine,
+                 startColumn);
   } else {
     // 错误：未闭合的字符字面量
     return std::nullopt;
@@ -774,34 +747,31 @@ std::optional<Token> Lexer::processCharacter() {
 std::optional<Token> Lexer::processString() {
   int startLine = line;
   int startColumn = column;
-  std::string literal = "\"";
+  size_t start = position;
   advance();
   column++;
 
-  while (!isEOF() && currentChar() != '"') {
-    // 处理转义字符
-    if (currentChar() == '\\') {
-      literal += '\\';
-      advance();
-      column++;
-
-      if (!isEOF()) {
-        literal += currentChar();
-        advance();
-        column++;
-      }
-    } else {
-      literal += currentChar();
-      advance();
-      column++;
+  while (true) {
+    // 批量跳到下一个引号或反斜杠（字符串内的换行只计入列号）
+    size_t next = simd::findEitherByte(source.data(), position,
+                                       source.length(), '"', '\\');
+    column += static_cast<int>(next - position);
+    position = next;
+    if (isEOF() || currentChar() == '"') {
+      break;
     }
+
+    // 处理转义字符：跳过反斜杠及其后一个字符
+    size_t escapeLength = std::min<size_t>(2, source.length() - position);
+    position += escapeLength;
+    column += static_cast<int>(escapeLength);
   }
 
   if (!isEOF() && currentChar() == '"') {
-    literal += '"';
     advance();
     column++;
-    return Token(TokenType::StringLiteral, literal, startLine, startColumn);
+    return Token(TokenType::StringLiteral, sourceFrom(start), startLine,
+                 startColumn);
   } else {
     // 错误：未闭合的字符串字面量
     return std::nullopt;
@@ -815,41 +785,28 @@ std::optional<Token> Lexer::processComment() {
 
   if (peekChar() == '/') {
     // 行注释
-    std::string comment = "//";
+    size_t start = position;
     advance(2);
     column += 2;
+    advanceTo(
+        simd::findByte(source.data(), position, source.length(), '\n'));
 
-    while (!isEOF() && currentChar() != '\n') {
-      comment += currentChar();
-      advance();
-      column++;
-    }
-
-    return Token(TokenType::LineComment, comment, startLine, startColumn);
+    return Token(TokenType::LineComment, sourceFrom(start), startLine,
+                 startColumn);
   } else if (peekChar() == '*') {
     // 块注释
-    std::string comment = "/*";
+    size_t start = position;
     advance(2);
     column += 2;
-
-    while (!isEOF() && !(currentChar() == '*' && peekChar() == '/')) {
-      if (currentChar() == '\n') {
-        line++;
-        column = 1;
-      } else {
-        column++;
-      }
-      comment += currentChar();
-      advance();
-    }
+    advanceTo(findBlockCommentEnd(position));
 
     if (!isEOF()) {
-      comment += "*/";
       advance(2);
       column += 2;
     }
 
-    return Token(TokenType::BlockComment, comment, startLine, startColumn);
+    return Token(TokenType::BlockComment, sourceFrom(start), startLine,
+                 startColumn);
   } else {
     advance();
     column++;
@@ -1123,7 +1080,7 @@ std::optional<Token> Lexer::processOperator() {
     // 未知字符
     advance();
     column++;
-    return Token(TokenType::Identifier, std::string(1, c), startLine,
+    return Token(TokenType::Identifier, sourceFrom(position - 1), startLine,
                  startColumn);
   }
   }
@@ -1169,21 +1126,46 @@ std::string Lexer::peekChars(int count) const {
   return result;
 }
 
-// 检查是否到达文件末尾
-bool Lexer::isEOF() const { return position >= source.length(); }
+// 前进到 end，按跨过的换行更新行号和列号
+void Lexer::advanceTo(size_t end) {
+  auto newlines = simd::countNewlines(source.data(), position, end);
+  if (newlines.count > 0) {
+    line += static_cast<int>(newlines.count);
+    column = static_cast<int>(end - newlines.lastNewline);
+  } else {
+    column += static_cast<int>(end - position);
+  }
+  position = end;
+}
 
-// 保存词法分析器状态
-Lexer::LexerState Lexer::saveState() {
-  return LexerState{position, line, column, ungetTokens};
+// 查找块注释结束符 "*/" 中 '*' 的下标，未闭合时返回源码长度
+size_t Lexer::findBlockCommentEnd(size_t from) const {
+  size_t size = source.length();
+  size_t pos = from;
+  while (true) {
+    pos = simd::findByte(source.data(), pos, size, '*');
+    if (pos + 1 >= size) {
+      return size;
+    }
+    if (source[pos + 1] == '/') {
+      return pos;
+    }
+    pos++;
+  }
 }
 
-// 恢复词法分析器状态
-void Lexer::restoreState(const LexerState &state) {
-  position = state.position;
-  line = state.line;
-  column = state.column;
-  ungetTokens = state.ungetTokens;
+// 检查是否为关键字（编译期完美哈希）
+TokenType Lexer::checkKeyword(std::string_view identifier) const {
+  return lookupKeyword(identifier);
 }
 
+// 获取从 start 到当前位置的源码视图
+std::string_view Lexer::sourceFrom(size_t start) const {
+  return source.substr(start, position - start);
+}
+
+// 检查是否到达文件末尾
+bool Lexer::isEOF() const { return position >= source.length(); }
+
 } // namespace lexer
 } // namespace c_hat
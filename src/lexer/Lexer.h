@@ -1,31 +1,51 @@
 #pragma once
 
+#include "NameInterner.h"
+#include "SourceBuffer.h"
 #include "TokenType.h"
+#include <cstddef>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace c_hat {
 namespace lexer {
 
 // 词法单元
+// value 是指向词法分析器源码缓冲区的视图，复制 Token 不会复制文本；
+// 标识符额外携带驻留编号 nameId。
 class Token {
 public:
-  Token(TokenType type, std::string value, int line, int column)
-      : type(type), value(std::move(value)), line(line), column(column) {}
+  Token(TokenType type, std::string_view value, int line, int column,
+        NameId nameId = InvalidNameId)
+      : type(type), value(value), line(line), column(column), nameId(nameId) {}
 
   TokenType getType() const { return type; }
-  const std::string &getValue() const { return value; }
+  std::string_view getValue() const { return value; }
   int getLine() const { return line; }
   int getColumn() const { return column; }
+  NameId getNameId() const { return nameId; }
 
   std::string toString() const;
 
 private:
   TokenType type;
-  std::string value;
+  std::string_view value;
   int line;
   int column;
+  NameId nameId;
+};
+
+// 分块读取的输入
+// 用于数百 MB 的生成源码：词法分析器只保留一个滑动窗口，在词法单元边界
+// 丢弃已扫描的部分并从文件描述符补充，内存占用与输入大小无关。
+struct ChunkedInput {
+  static constexpr size_t DefaultChunkSize = 256 * 1024;
+
+  int fd;
+  size_t chunkSize = DefaultChunkSize;
 };
 
 // 词法分析器
@@ -33,24 +53,36 @@ class Lexer {
 public:
   Lexer(std::string source);
 
+  // 直接扫描源码缓冲区（如内存映射的文件），不复制文本
+  explicit Lexer(std::shared_ptr<const SourceBuffer> buffer);
+
+  // 分块读取文件描述符，文件描述符由调用方负责关闭
+  // 该模式下 Token 的文本只在下一次调用 nextToken 之前有效
+  explicit Lexer(ChunkedInput input);
+
+  // 词法单元引用的源码缓冲区，分块模式下为空
+  const std::shared_ptr<const SourceBuffer> &getSourceBuffer() const {
+    return buffer;
+  }
+
+  // Token 持有指向 source 的视图，词法分析器不可复制或移动
+  Lexer(const Lexer &) = delete;
+  Lexer &operator=(const Lexer &) = delete;
+
   // 获取下一个词法单元
+  // 词法分析器只向前扫描一遍，回溯由语法分析器在预切分的词法单元上完成
   std::optional<Token> nextToken();
 
-  // 回溯一个词法单元
-  void ungetToken(const Token &token);
+private:
+  // 在当前窗口中扫描一个词法单元
+  std::optional<Token> scanToken();
 
-  // 保存和恢复词法分析器状态
-  struct LexerState {
-    size_t position;
-    int line;
-    int column;
-    std::vector<Token> ungetTokens;
-  };
+  // 分块模式：丢弃已扫描的部分，把窗口中未扫描的输入补足一块
+  void refillWindow();
 
-  LexerState saveState();
-  void restoreState(const LexerState &state);
+  // 分块模式：再读入一块输入，到达输入末尾时返回 false
+  bool readChunk();
 
-private:
   // 跳过空白字符
   void skipWhitespace();
 
@@ -73,7 +105,16 @@ private:
   std::optional<Token> processOperator();
 
   // 检查是否为关键字
-  TokenType checkKeyword(const std::string &identifier) const;
+  TokenType checkKeyword(std::string_view identifier) const;
+
+  // 获取从 start 到当前位置的源码视图
+  std::string_view sourceFrom(size_t start) const;
+
+  // 前进到 end，按跨过的换行更新行号和列号
+  void advanceTo(size_t end);
+
+  // 查找块注释结束符 "*/" 的位置，未闭合时返回源码长度
+  size_t findBlockCommentEnd(size_t from) const;
 
   // 当前位置
   char currentChar() const;
@@ -93,11 +134,18 @@ private:
   // 检查是否到达文件末尾
   bool isEOF() const;
 
-  std::string source;
+  std::shared_ptr<const SourceBuffer> buffer;
+  std::string_view source;
   size_t position;
   int line;
   int column;
-  std::vector<Token> ungetTokens;
+
+  // 分块模式的输入，inputFd < 0 表示整块扫描 buffer
+  int inputFd = -1;
+  size_t chunkSize = 0;
+  bool inputExhausted = true;
+  // 分块模式下的滑动窗口，source 是它的视图
+  std::string window;
 };
 
 } // namespace lexer
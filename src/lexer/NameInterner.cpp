@@ -0,0 +1,86 @@
+#include "NameInterner.h"
+#include <functional>
+#include <mutex>
+
+namespace c_hat {
+namespace lexer {
+
+NameInterner &NameInterner::global() {
+  static NameInterner instance;
+  return instance;
+}
+
+NameInterner::Shard &NameInterner::shardFor(std::string_view name) {
+  return shards_[std::hash<std::string_view>{}(name) % ShardCount];
+}
+
+const NameInterner::Shard &
+NameInterner::shardFor(std::string_view name) const {
+  return shards_[std::hash<std::string_view>{}(name) % ShardCount];
+}
+
+NameId NameInterner::intern(std::string_view name) {
+  Shard &shard = shardFor(name);
+  {
+    // 绝大多数名称已经驻留，只需共享锁
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.ids.find(name);
+    if (it != shard.ids.end()) {
+      return it->second;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  // 释放共享锁后其他线程可能已经驻留了同一个名称
+  auto it = shard.ids.find(name);
+  if (it != shard.ids.end()) {
+    return it->second;
+  }
+
+  size_t shardIndex = static_cast<size_t>(&shard - shards_.data());
+  NameId id = static_cast<NameId>(shard.names.size() * ShardCount +
+                                  shardIndex + 1);
+  shard.names.emplace_back(name);
+  shard.ids.emplace(shard.names.back(), id);
+  return id;
+}
+
+NameId NameInterner::lookup(std::string_view name) const {
+  const Shard &shard = shardFor(name);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  auto it = shard.ids.find(name);
+  return it != shard.ids.end() ? it->second : InvalidNameId;
+}
+
+std::string_view NameInterner::getName(NameId id) const {
+  if (id == InvalidNameId) {
+    return {};
+  }
+  const Shard &shard = shards_[(id - 1) % ShardCount];
+  size_t index = (id - 1) / ShardCount;
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  if (index >= shard.names.size()) {
+    return {};
+  }
+  return shard.names[index];
+}
+
+size_t NameInterner::size() const {
+  size_t count = 0;
+  for (const auto &shard : shards_) {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    count += shard.names.size();
+  }
+  return count;
+}
+
+void NameInterner::reset() {
+  for (auto &shard : shards_) {
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.ids.clear();
+    shard.names.clear();
+  }
+}
+
+} // namespace lexer
+} // namespace c_hat
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace c_hat {
+namespace lexer {
+
+// 驻留名称编号（0 表示无效名称）
+using NameId = uint32_t;
+
+constexpr NameId InvalidNameId = 0;
+
+// 名称驻留表
+// 词法分析器为每个标识符分配编号，符号表、扩展注册表等以编号为键，
+// 同一个名称在整个编译流程中只计算一次字符串哈希。
+// 驻留表可以被多个线程同时使用（并行加载模块时各线程同时词法分析和
+// 构造符号）：名称按哈希分到若干分片，每个分片有独立的读写锁，
+// 编号的低位记录分片，查找名称只锁一个分片。
+//
+// 全局驻留表随进程存在，长期运行的编译服务器、监视模式和语言服务器
+// 见过的名称都会留在表中。名称数量超过 ResetThreshold 时由这些模式
+// 丢弃全部分析结果后调用 reset() 清空，之后重新分配编号。
+class NameInterner {
+public:
+  static constexpr size_t ShardCount = 16;
+
+  // 长期运行的模式清空驻留表的名称数量阈值
+  static constexpr size_t ResetThreshold = size_t{1} << 18;
+
+  // 全局驻留表（整个编译流程共享）
+  static NameInterner &global();
+
+  // 驻留名称，返回其编号（已存在时返回原编号）
+  NameId intern(std::string_view name);
+
+  // 查找已驻留名称的编号，未驻留时返回 InvalidNameId
+  NameId lookup(std::string_view name) const;
+
+  // 获取编号对应的名称
+  std::string_view getName(NameId id) const;
+
+  // 已驻留的名称数量
+  size_t size() const;
+
+  // 清空驻留表，已分配的编号全部失效。
+  // 只能在没有词法单元、符号和语法树仍在使用旧编号时调用，
+  // 也不能与其他线程的驻留和查找同时进行。
+  void reset();
+
+private:
+  struct Shard {
+    mutable std::shared_mutex mutex;
+
+    // 名称存储（deque 保证扩容时已有元素地址不变，键视图始终有效）
+    std::deque<std::string> names;
+
+    std::unordered_map<std::string_view, NameId> ids;
+  };
+
+  Shard &shardFor(std::string_view name);
+  const Shard &shardFor(std::string_view name) const;
+
+  std::array<Shard, ShardCount> shards_;
+};
+
+} // namespace lexer
+} // namespace c_hat
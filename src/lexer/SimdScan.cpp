@@ -0,0 +1,158 @@
+#include "SimdScan.h"
+#include "CharTable.h"
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define C_HAT_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define C_HAT_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace c_hat {
+namespace lexer {
+namespace simd {
+
+namespace {
+
+#if defined(C_HAT_SIMD_AVX2)
+
+constexpr size_t BlockSize = 32;
+using Mask = uint32_t;
+
+inline __m256i loadBlock(const char *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+inline Mask equalMask(__m256i block, char byte) {
+  return static_cast<Mask>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(byte))));
+}
+
+// 空白：' ' 或 '\t'..'\r'（9..13）
+inline Mask whitespaceMask(__m256i block) {
+  __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8(9));
+  __m256i inRange = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+  return static_cast<Mask>(_mm256_movemask_epi8(inRange)) |
+         equalMask(block, ' ');
+}
+
+#elif defined(C_HAT_SIMD_SSE2)
+
+constexpr size_t BlockSize = 16;
+using Mask = uint32_t;
+
+inline __m128i loadBlock(const char *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+inline Mask equalMask(__m128i block, char byte) {
+  return static_cast<Mask>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(byte))));
+}
+
+// 空白：' ' 或 '\t'..'\r'（9..13）
+inline Mask whitespaceMask(__m128i block) {
+  __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(9));
+  __m128i inRange =
+      _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+  return static_cast<Mask>(_mm_movemask_epi8(inRange)) | equalMask(block, ' ');
+}
+
+#endif
+
+#if defined(C_HAT_SIMD_AVX2) || defined(C_HAT_SIMD_SSE2)
+constexpr Mask FullMask = BlockSize == 32 ? ~Mask(0) : Mask(0xFFFF);
+#endif
+
+} // namespace
+
+size_t skipWhitespace(const char *data, size_t pos, size_t size) {
+#if defined(C_HAT_SIMD_AVX2) || defined(C_HAT_SIMD_SSE2)
+  while (pos + BlockSize <= size) {
+    Mask nonSpace = ~whitespaceMask(loadBlock(data + pos)) & FullMask;
+    if (nonSpace) {
+      return pos + std::countr_zero(nonSpace);
+    }
+    pos += BlockSize;
+  }
+#endif
+  while (pos < size && isSpaceChar(data[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+size_t findByte(const char *data, size_t pos, size_t size, char byte) {
+#if defined(C_HAT_SIMD_AVX2) || defined(C_HAT_SIMD_SSE2)
+  while (pos + BlockSize <= size) {
+    Mask found = equalMask(loadBlock(data + pos), byte);
+    if (found) {
+      return pos + std::countr_zero(found);
+    }
+    pos += BlockSize;
+  }
+#endif
+  while (pos < size && data[pos] != byte) {
+    pos++;
+  }
+  return pos;
+}
+
+size_t findEitherByte(const char *data, size_t pos, size_t size, char first,
+                      char second) {
+#if defined(C_HAT_SIMD_AVX2) || defined(C_HAT_SIMD_SSE2)
+  while (pos + BlockSize <= size) {
+    auto block = loadBlock(data + pos);
+    Mask found = equalMask(block, first) | equalMask(block, second);
+    if (found) {
+      return pos + std::countr_zero(found);
+    }
+    pos += BlockSize;
+  }
+#endif
+  while (pos < size && data[pos] != first && data[pos] != second) {
+    pos++;
+  }
+  return pos;
+}
+
+NewlineCount countNewlines(const char *data, size_t begin, size_t end) {
+  NewlineCount result{0, 0};
+  size_t pos = begin;
+#if defined(C_HAT_SIMD_AVX2) || defined(C_HAT_SIMD_SSE2)
+  while (pos + BlockSize <= end) {
+    Mask newlines = equalMask(loadBlock(data + pos), '\n');
+    if (newlines) {
+      result.count += std::popcount(newlines);
+      result.lastNewline = pos + std::bit_width(newlines) - 1;
+    }
+    pos += BlockSize;
+  }
+#endif
+  for (; pos < end; ++pos) {
+    if (data[pos] == '\n') {
+      result.count++;
+      result.lastNewline = pos;
+    }
+  }
+  return result;
+}
+
+const char *kernelName() {
+#if defined(C_HAT_SIMD_AVX2)
+  return "avx2";
+#elif defined(C_HAT_SIMD_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+} // namespace simd
+} // namespace lexer
+} // namespace c_hat
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace c_hat {
+namespace lexer {
+namespace simd {
+
+// 词法分析的批量扫描内核
+// 每次处理 16（SSE2）或 32（AVX2）字节，不支持的平台退回逐字节扫描。
+// 所有函数在 [pos, size) 范围内查找，找不到时返回 size。
+
+// 返回第一个非空白字符的下标
+size_t skipWhitespace(const char *data, size_t pos, size_t size);
+
+// 返回第一个等于 byte 的字符的下标
+size_t findByte(const char *data, size_t pos, size_t size, char byte);
+
+// 返回第一个等于 first 或 second 的字符的下标
+size_t findEitherByte(const char *data, size_t pos, size_t size, char first,
+                      char second);
+
+// [begin, end) 内的换行统计
+struct NewlineCount {
+  size_t count;       // 换行符个数
+  size_t lastNewline; // 最后一个换行符的下标（count 为 0 时无意义）
+};
+
+NewlineCount countNewlines(const char *data, size_t begin, size_t end);
+
+// 当前编译使用的内核名称（"avx2"、"sse2" 或 "scalar"）
+const char *kernelName();
+
+} // namespace simd
+} // namespace lexer
+} // namespace c_hat
@@ -0,0 +1,147 @@
+#include "SourceBuffer.h"
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define C_HAT_HAS_MMAP 1
+#endif
+
+namespace c_hat {
+namespace lexer {
+
+std::shared_ptr<const SourceBuffer>
+SourceBuffer::fromFile(const std::filesystem::path &path) {
+  std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+  buffer->name_ = path.string();
+  // 空文件、管道等无法映射的文件走整块读取
+  if (!buffer->map(path) && !buffer->read(path)) {
+    return nullptr;
+  }
+  return buffer;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromString(std::string text,
+                                                             std::string name) {
+  std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+  buffer->name_ = std::move(name);
+  buffer->storage_ = std::move(text);
+  buffer->data_ = buffer->storage_.data();
+  buffer->size_ = buffer->storage_.size();
+  return buffer;
+}
+
+SourceBuffer::~SourceBuffer() {
+  if (!mapping_) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(mapping_);
+#elif defined(C_HAT_HAS_MMAP)
+  munmap(mapping_, size_);
+#endif
+}
+
+#if defined(_WIN32)
+bool SourceBuffer::map(const std::filesystem::path &path) {
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                       : nullptr;
+  // 视图建立后即可关闭句柄，映射随视图一直有效到 UnmapViewOfFile
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+  if (!view) {
+    return false;
+  }
+
+  mapping_ = view;
+  data_ = static_cast<const char *>(view);
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+  return true;
+}
+#elif defined(C_HAT_HAS_MMAP)
+bool SourceBuffer::map(const std::filesystem::path &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // 映射建立后即可关闭文件描述符
+  close(fd);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  // 词法分析器顺序扫描源码
+  madvise(view, size, MADV_SEQUENTIAL);
+
+  mapping_ = view;
+  data_ = static_cast<const char *>(view);
+  size_ = size;
+  return true;
+}
+#else
+bool SourceBuffer::map(const std::filesystem::path &) { return false; }
+#endif
+
+bool SourceBuffer::read(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::error_code ec;
+  auto fileSize = std::filesystem::file_size(path, ec);
+  if (!ec && fileSize > 0) {
+    storage_.resize(static_cast<size_t>(fileSize));
+    file.read(storage_.data(), static_cast<std::streamsize>(storage_.size()));
+    storage_.resize(static_cast<size_t>(file.gcount()));
+  } else {
+    // 大小未知的文件（如管道）按流读取
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    storage_ = std::move(stream).str();
+  }
+
+  data_ = storage_.data();
+  size_ = storage_.size();
+  return true;
+}
+
+} // namespace lexer
+} // namespace c_hat
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace c_hat {
+namespace lexer {
+
+// 源码缓冲区
+// 文件优先以只读内存映射打开，无法映射时退化为一次性整块读取。
+// 词法单元直接引用缓冲区中的文本，Program 持有缓冲区使映射在整个编译期间
+// 保持有效，诊断信息也可以零拷贝地回看源码。
+class SourceBuffer {
+public:
+  // 打开源码文件，无法打开时返回 nullptr
+  static std::shared_ptr<const SourceBuffer>
+  fromFile(const std::filesystem::path &path);
+
+  // 以内存中的字符串作为源码
+  static std::shared_ptr<const SourceBuffer>
+  fromString(std::string text, std::string name = "<memory>");
+
+  ~SourceBuffer();
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  // 源码文本
+  std::string_view getText() const { return std::string_view(data_, size_); }
+
+  // 源码字节数
+  size_t getSize() const { return size_; }
+
+  // 文件路径（内存源码为构造时给定的名称）
+  const std::string &getName() const { return name_; }
+
+  // 文本是否来自内存映射
+  bool isMapped() const { return mapping_ != nullptr; }
+
+private:
+  SourceBuffer() = default;
+
+  // 以只读方式映射整个文件，成功时设置 mapping_、data_ 和 size_
+  bool map(const std::filesystem::path &path);
+
+  // 一次性读入整个文件到 storage_
+  bool read(const std::filesystem::path &path);
+
+  std::string name_;
+  // 未映射时持有的文本
+  std::string storage_;
+  // 映射的起始地址（nullptr 表示未映射）
+  void *mapping_ = nullptr;
+  const char *data_ = "";
+  size_t size_ = 0;
+};
+
+} // namespace lexer
+} // namespace c_hat
@@ -0,0 +1,273 @@
+#include "HotReloadSession.h"
+#include <iostream>
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace c_hat::llvm_codegen {
+
+namespace {
+
+std::string printType(llvm::Type *type) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  type->print(os);
+  return os.str();
+}
+
+size_t hashBody(const llvm::Function &function) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  function.print(os);
+  return llvm::hash_value(os.str());
+}
+
+// 需要保留存储的全局变量：有定义、可变，且不是 llvm.global_ctors 这类
+// 由 LLVM 特殊处理的变量
+bool isMutableGlobal(const llvm::GlobalVariable &global) {
+  return !global.isDeclaration() && !global.isConstant() &&
+         global.getName().substr(0, 5) != "llvm.";
+}
+
+const auto StubFlags =
+    llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+
+} // namespace
+
+// 会话独占一个 LLJIT：各版本的代码都留在主 JITDylib 中，不能和其他
+// 生成器共享的 JIT 一起随生成器析构而移除
+struct HotReloadSession::JITState {
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  std::unique_ptr<llvm::orc::IndirectStubsManager> stubs;
+
+  JITState() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto jitOrErr = llvm::orc::LLJITBuilder().create();
+    if (!jitOrErr) {
+      std::cerr << "JIT creation failed: "
+                << llvm::toString(jitOrErr.takeError()) << std::endl;
+      return;
+    }
+    jit = std::move(*jitOrErr);
+
+    auto stubsBuilder = llvm::orc::createLocalIndirectStubsManagerBuilder(
+        jit->getTargetTriple());
+    if (!stubsBuilder) {
+      std::cerr << "Hot reload is not supported on "
+                << jit->getTargetTriple().str() << std::endl;
+      jit.reset();
+      return;
+    }
+    stubs = stubsBuilder();
+  }
+
+  llvm::orc::JITDylib &dylib() { return jit->getMainJITDylib(); }
+};
+
+HotReloadSession::HotReloadSession() : jit(std::make_unique<JITState>()) {}
+
+HotReloadSession::~HotReloadSession() = default;
+
+bool HotReloadSession::isValid() const { return jit->jit != nullptr; }
+
+void HotReloadSession::addExternalSymbol(const std::string &name,
+                                         void *address) {
+  if (!isValid()) {
+    std::cerr << "JIT not initialized" << std::endl;
+    return;
+  }
+
+  llvm::orc::SymbolMap symbols;
+  symbols[jit->jit->mangleAndIntern(name)] =
+      llvm::orc::ExecutorSymbolDef(llvm::orc::ExecutorAddr::fromPtr(address),
+                                   llvm::JITSymbolFlags::Exported);
+  if (auto err =
+          jit->dylib().define(llvm::orc::absoluteSymbols(std::move(symbols)))) {
+    llvm::consumeError(std::move(err));
+    std::cerr << "Failed to add external symbol: " << name << std::endl;
+  }
+}
+
+bool HotReloadSession::load(llvm::orc::ThreadSafeModule module,
+                            std::vector<std::string> &updated) {
+  if (!isValid()) {
+    std::cerr << "JIT not initialized" << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // 版本号在加载失败时也递增，失败版本留下的符号不会和下一版本冲突
+  std::string suffix = ".v" + std::to_string(version_++);
+  std::map<std::string, FunctionVersion> changed;
+  std::map<std::string, std::string> newGlobals;
+
+  bool compatible = module.withModuleDo([&](llvm::Module &m) {
+    // 先检查全部定义，类型变化时整个版本都不加载
+    for (auto &function : m) {
+      if (function.isDeclaration()) {
+        continue;
+      }
+      std::string name = function.getName().str();
+      FunctionVersion current{printType(function.getFunctionType()),
+                              hashBody(function)};
+      auto it = functions_.find(name);
+      if (it == functions_.end()) {
+        changed[name] = current;
+        continue;
+      }
+      if (it->second.type != current.type) {
+        std::cerr << "Cannot hot reload: the type of function " << name
+                  << " changed, restart to apply" << std::endl;
+        return false;
+      }
+      if (it->second.bodyHash != current.bodyHash) {
+        changed[name] = current;
+      }
+    }
+    for (auto &global : m.globals()) {
+      if (!isMutableGlobal(global)) {
+        continue;
+      }
+      std::string name = global.getName().str();
+      std::string type = printType(global.getValueType());
+      auto it = globals_.find(name);
+      if (it == globals_.end()) {
+        newGlobals[name] = type;
+      } else if (it->second != type) {
+        std::cerr << "Cannot hot reload: the type of global " << name
+                  << " changed, restart to apply" << std::endl;
+        return false;
+      }
+    }
+    if (changed.empty()) {
+      return true;
+    }
+
+    // 没有变化的函数只留下声明，链接到已有的桩；变化了的函数改名为
+    // 带版本号的符号，模块中对它的引用改为经过桩的同名声明
+    std::vector<llvm::Function *> definitions;
+    for (auto &function : m) {
+      if (!function.isDeclaration()) {
+        definitions.push_back(&function);
+      }
+    }
+    for (auto *function : definitions) {
+      std::string name = function->getName().str();
+      if (!changed.count(name)) {
+        function->deleteBody();
+        continue;
+      }
+      function->setName(name + suffix);
+      function->setLinkage(llvm::GlobalValue::ExternalLinkage);
+      function->setVisibility(llvm::GlobalValue::DefaultVisibility);
+      auto *declaration =
+          llvm::Function::Create(function->getFunctionType(),
+                                 llvm::Function::ExternalLinkage, name, m);
+      declaration->copyAttributesFrom(function);
+      function->replaceAllUsesWith(declaration);
+    }
+
+    // 可变全局变量保留第一次定义的存储，之后的版本只引用它
+    for (auto &global : m.globals()) {
+      if (!isMutableGlobal(global)) {
+        continue;
+      }
+      if (newGlobals.count(global.getName().str())) {
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        global.setVisibility(llvm::GlobalValue::DefaultVisibility);
+      } else {
+        global.setInitializer(nullptr);
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      }
+    }
+    return true;
+  });
+  if (!compatible) {
+    return false;
+  }
+  if (changed.empty()) {
+    return true;
+  }
+
+  // 新函数先建立桩并定义同名符号，模块中的引用在编译时才能解析；
+  // 桩在新代码编译后才指向它
+  llvm::orc::SymbolMap stubSymbols;
+  for (const auto &[name, function] : changed) {
+    // 之前加载失败的版本可能已经建立了桩
+    if (jit->stubs->findStub(name, false).getAddress()) {
+      continue;
+    }
+    if (auto err = jit->stubs->createStub(name, llvm::orc::ExecutorAddr(),
+                                          StubFlags)) {
+      std::cerr << "Failed to create stub for " << name << ": "
+                << llvm::toString(std::move(err)) << std::endl;
+      return false;
+    }
+    auto stub = jit->stubs->findStub(name, false);
+    stubSymbols[jit->jit->mangleAndIntern(name)] =
+        llvm::orc::ExecutorSymbolDef(stub.getAddress(), StubFlags);
+  }
+  if (!stubSymbols.empty()) {
+    if (auto err = jit->dylib().define(
+            llvm::orc::absoluteSymbols(std::move(stubSymbols)))) {
+      std::cerr << "Failed to define stubs: " << llvm::toString(std::move(err))
+                << std::endl;
+      return false;
+    }
+  }
+
+  if (auto err = jit->jit->addIRModule(jit->dylib(), std::move(module))) {
+    std::cerr << "Failed to add module to JIT: "
+              << llvm::toString(std::move(err)) << std::endl;
+    return false;
+  }
+
+  for (const auto &[name, function] : changed) {
+    auto address = jit->jit->lookup(jit->dylib(), name + suffix);
+    if (!address) {
+      std::cerr << "Failed to compile " << name << ": "
+                << llvm::toString(address.takeError()) << std::endl;
+      return false;
+    }
+    if (auto err = jit->stubs->updatePointer(name, *address)) {
+      std::cerr << "Failed to update stub for " << name << ": "
+                << llvm::toString(std::move(err)) << std::endl;
+      return false;
+    }
+    functions_[name] = function;
+    updated.push_back(name);
+  }
+  for (auto &[name, type] : newGlobals) {
+    globals_[name] = std::move(type);
+  }
+  return true;
+}
+
+int HotReloadSession::run(const std::string &entryPoint) {
+  if (!isValid()) {
+    std::cerr << "JIT not initialized" << std::endl;
+    return -1;
+  }
+
+  llvm::orc::ExecutorAddr address;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    address = jit->stubs->findStub(entryPoint, false).getAddress();
+  }
+  if (!address) {
+    std::cerr << "Failed to find entry point: " << entryPoint << std::endl;
+    return -1;
+  }
+
+  auto *entry = address.toPtr<int (*)()>();
+  return entry();
+}
+
+} // namespace c_hat::llvm_codegen
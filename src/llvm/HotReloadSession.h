@@ -0,0 +1,56 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace c_hat::llvm_codegen {
+
+// 热重载会话
+// 同一个程序的多个版本先后加载到一个 JIT 中。每个函数有一个间接桩，
+// 所有调用（包括已经在运行的代码中的调用）都经过桩跳转，新版本只编译
+// 内容变化了的函数并把桩指向新代码，没有变化的函数沿用已编译的代码，
+// 可变的全局变量沿用第一次定义的存储，程序状态在重载后保留。
+// 旧版本的代码不释放，仍在执行旧代码的调用返回后自然进入新代码。
+class HotReloadSession {
+public:
+  HotReloadSession();
+  ~HotReloadSession();
+
+  HotReloadSession(const HotReloadSession &) = delete;
+  HotReloadSession &operator=(const HotReloadSession &) = delete;
+
+  // JIT 创建失败时返回 false
+  bool isValid() const;
+
+  // 添加外部函数符号（用于调用 C 库函数）
+  void addExternalSymbol(const std::string &name, void *address);
+
+  // 加载程序的一个版本，updated 中返回重新编译的函数
+  // 函数或全局变量的类型变化时无法替换已编译的代码，不加载并返回 false
+  bool load(llvm::orc::ThreadSafeModule module,
+            std::vector<std::string> &updated);
+
+  // 通过桩调用入口函数，可以在其他线程加载新版本的同时运行
+  int run(const std::string &entryPoint = "main");
+
+private:
+  struct JITState;
+  std::unique_ptr<JITState> jit;
+
+  // 已加载的函数：函数类型和函数体的哈希
+  struct FunctionVersion {
+    std::string type;
+    size_t bodyHash = 0;
+  };
+  std::map<std::string, FunctionVersion> functions_;
+  // 已定义的可变全局变量及其类型
+  std::map<std::string, std::string> globals_;
+  unsigned version_ = 0;
+  std::mutex mutex_;
+};
+
+} // namespace c_hat::llvm_codegen
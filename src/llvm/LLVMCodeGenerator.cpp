@@ -13,6 +13,10 @@ LLVMCodeGenerator::LLVMCodeGenerator(const std::string &moduleName)
     : generator_(moduleName) {}
 
 void LLVMCodeGenerator::generate(std::unique_ptr<ast::Program> program) {
+  if (program->arena) {
+    astArenas_.push_back(program->arena);
+  }
+
   // 先添加内置类型 literalview 到 structTypes_
   structTypes_["literalview"] =
       static_cast<llvm::StructType *>(getLiteralViewType());
@@ -438,6 +442,9 @@ llvm::Value *LLVMCodeGenerator::generateTupleDestructuringDecl(
 
 llvm::Value *LLVMCodeGenerator::generateFunctionDecl(
     std::unique_ptr<ast::FunctionDecl> funcDecl) {
+  // 略读时跳过的函数体在生成代码前解析
+  funcDecl->materializeBody();
+
   llvm::Type *returnType = nullptr;
   if (funcDecl->returnType) {
     if (auto *typeNode =
@@ -565,7 +572,7 @@ llvm::Value *LLVMCodeGenerator::generateFunctionDecl(
 }
 
 void LLVMCodeGenerator::createFunctionPrototype(ast::FunctionDecl *funcDecl) {
-
+  // 原型只需要签名，略读时跳过的函数体留到生成函数体时再解析
   std::cerr << "Debug: createFunctionPrototype - function name: "
             << funcDecl->name << std::endl;
 
@@ -685,7 +692,7 @@ void LLVMCodeGenerator::createFunctionPrototype(ast::FunctionDecl *funcDecl) {
 
   // 只在函数有函数体时才设置 personality routine
   // 函数声明不应该有 personality routine
-  if (funcDecl->body) {
+  if (funcDecl->hasBody()) {
     // 暂时移除个性函数的设置，因为系统中没有安装 LLVM
   }
 
@@ -696,6 +703,7 @@ void LLVMCodeGenerator::createFunctionPrototype(ast::FunctionDecl *funcDecl) {
 
 llvm::Value *LLVMCodeGenerator::generateFunctionBody(
     std::unique_ptr<ast::FunctionDecl> funcDecl) {
+  funcDecl->materializeBody();
   // 为了支持重载，生成带参数类型的函数名
   std::string uniqueFuncName;
   // 添加命名空间路径
@@ -987,6 +995,7 @@ llvm::Value *LLVMCodeGenerator::generateStructDecl(
 llvm::Value *LLVMCodeGenerator::generateClassMemberFunction(
     std::unique_ptr<ast::FunctionDecl> funcDecl, const std::string &className,
     bool isConstructor, bool isDestructor) {
+  funcDecl->materializeBody();
   llvm::StructType *classType = structTypes_[className];
   llvm::PointerType *thisType = classType->getPointerTo();
 
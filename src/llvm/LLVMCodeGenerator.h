@@ -51,6 +51,9 @@ public:
     generator_.addExternalSymbol(name, address);
   }
 
+  // 取出生成的模块，之后不能再使用代码生成器
+  llvm::orc::ThreadSafeModule takeModule() { return generator_.takeModule(); }
+
   // 循环优化
   void optimizeLoops();
   bool isLoopInvariant(llvm::Instruction *inst, llvm::BasicBlock *loopHeader);
@@ -61,6 +64,10 @@ public:
 private:
   LLVMIRGenerator generator_;
 
+  // 生成过程中会转移并保留部分 AST 节点（如 catchStmts_），
+  // 需要让节点所在的内存池活得比这些成员更久
+  std::vector<std::shared_ptr<ast::AstArena>> astArenas_;
+
   bool currentFunctionHasTry_ = false;
   llvm::GlobalVariable *currentJmpBuf_ = nullptr;
   llvm::StructType *jmpBufType_ = nullptr;
@@ -1,5 +1,7 @@
 #include "LLVMIRGenerator.h"
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/IR/LegacyPassManager.h>
@@ -23,44 +25,119 @@
 
 namespace c_hat::llvm_codegen {
 
-struct LLVMIRGenerator::JITState {
-  std::unique_ptr<llvm::orc::LLJIT> jit;
-  std::string errorMessage;
+namespace {
 
-  JITState() {
-    auto jitBuilder = llvm::orc::LLJITBuilder();
-    auto jitOrErr = jitBuilder.create();
+// 进程内共享的 LLJIT，首次使用时创建，创建失败时返回 nullptr
+// 编译服务器处理多个请求、同一进程中多次运行程序时不再重复创建 JIT
+std::shared_ptr<llvm::orc::LLJIT> sharedJIT(std::string &errorMessage) {
+  static std::mutex mutex;
+  static std::shared_ptr<llvm::orc::LLJIT> jit;
+  static std::string creationError;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!jit && creationError.empty()) {
+    auto jitOrErr = llvm::orc::LLJITBuilder().create();
     if (jitOrErr) {
       jit = std::move(*jitOrErr);
     } else {
       llvm::handleAllErrors(
           jitOrErr.takeError(), [&](const llvm::ErrorInfoBase &ei) {
-            errorMessage = ei.message();
-            std::cerr << "JIT creation failed: " << errorMessage << std::endl;
+            creationError = ei.message();
+            std::cerr << "JIT creation failed: " << creationError << std::endl;
           });
     }
   }
+  errorMessage = creationError;
+  return jit;
+}
+
+// 本线程缓存的宿主目标机器，多次生成目标文件时不再重复创建
+// TargetMachine 不能在线程间共享，并行编译的每个线程各有一个
+llvm::TargetMachine *hostTargetMachine() {
+  thread_local std::unique_ptr<llvm::TargetMachine> targetMachine;
+  if (!targetMachine) {
+    std::string error;
+    auto targetTriple = llvm::sys::getDefaultTargetTriple();
+    auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+
+    if (!target) {
+      std::cerr << "Error looking up target: " << error << std::endl;
+      return nullptr;
+    }
 
-  bool isValid() const { return jit != nullptr; }
+    llvm::TargetOptions opt;
+    auto RM = std::optional<llvm::Reloc::Model>();
+    targetMachine.reset(
+        target->createTargetMachine(targetTriple, "generic", "", opt, RM));
+  }
+  return targetMachine.get();
+}
+
+} // namespace
+
+// 每个生成器在共享的 LLJIT 中有自己的 JITDylib，生成器析构时移除，
+// 不同程序的同名符号互不冲突
+struct LLVMIRGenerator::JITState {
+  std::shared_ptr<llvm::orc::LLJIT> jit;
+  llvm::orc::JITDylib *dylib = nullptr;
+  std::string errorMessage;
+
+  JITState() {
+    jit = sharedJIT(errorMessage);
+    if (!jit) {
+      return;
+    }
+
+    static std::atomic<unsigned> nextDylib = 0;
+    auto dylibOrErr =
+        jit->createJITDylib("c_hat_" + std::to_string(nextDylib++));
+    if (!dylibOrErr) {
+      errorMessage = llvm::toString(dylibOrErr.takeError());
+      std::cerr << "JIT creation failed: " << errorMessage << std::endl;
+      return;
+    }
+    dylib = &*dylibOrErr;
+    // 主 JITDylib 能解析的符号（进程中的符号等）在新的 JITDylib 中同样可见
+    dylib->addToLinkOrder(jit->getMainJITDylib());
+  }
+
+  ~JITState() {
+    if (dylib) {
+      if (auto err = jit->getExecutionSession().removeJITDylib(*dylib)) {
+        llvm::consumeError(std::move(err));
+      }
+    }
+  }
+
+  bool isValid() const { return dylib != nullptr; }
 };
 
 LLVMIRGenerator::LLVMIRGenerator(const std::string &moduleName)
     : context(std::make_unique<llvm::LLVMContext>()),
       builder(std::make_unique<llvm::IRBuilder<>>(*context)),
       module(std::make_unique<llvm::Module>(moduleName, *context)) {
-  // 初始化 LLVM 目标（必须在创建 JIT 之前）
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmPrinters();
-  llvm::InitializeAllAsmParsers();
-
-  // 初始化 JIT（必须在初始化 native target 之后）
-  llvm::InitializeNativeTarget();
-  llvm::InitializeNativeTargetAsmPrinter();
-  llvm::InitializeNativeTargetAsmParser();
-
-  // 创建 JIT
-  jit = std::make_unique<JITState>();
+  // 目标注册表是进程全局的，多个翻译单元并行编译时只初始化一次；
+  // 每个生成器有自己的 LLVMContext，之后互不干扰
+  static std::once_flag targetsInitialized;
+  std::call_once(targetsInitialized, [] {
+    // 初始化 LLVM 目标（必须在创建 JIT 之前）
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+
+    // 初始化 JIT（必须在初始化 native target 之后）
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+  });
+}
+
+bool LLVMIRGenerator::ensureJIT() {
+  if (!jit) {
+    jit = std::make_unique<JITState>();
+  }
+  return jit->isValid();
 }
 
 LLVMIRGenerator::~LLVMIRGenerator() = default;
@@ -91,60 +168,22 @@ bool LLVMIRGenerator::writeIRToFile(const std::string &filename) {
 }
 
 bool LLVMIRGenerator::emitObjectFile(const std::string &filename) {
-  std::string error;
-  auto targetTriple = llvm::sys::getDefaultTargetTriple();
-  auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
-
-  if (!target) {
-    std::cerr << "Error looking up target: " << error << std::endl;
-    return false;
-  }
-
-  llvm::TargetOptions opt;
-  auto RM = std::optional<llvm::Reloc::Model>();
-  auto targetMachine =
-      target->createTargetMachine(targetTriple, "generic", "", opt, RM);
-
-  module->setDataLayout(targetMachine->createDataLayout());
-  module->setTargetTriple(targetTriple);
-
-  std::error_code ec;
-  llvm::raw_fd_ostream dest(filename, ec, llvm::sys::fs::OF_None);
-
-  if (ec) {
-    std::cerr << "Error opening output file: " << ec.message() << std::endl;
-    return false;
-  }
-
-  llvm::legacy::PassManager pass;
-  auto fileType = llvm::CodeGenFileType::ObjectFile;
-
-  if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
-    std::cerr << "TargetMachine can't emit file of this type" << std::endl;
-    return false;
-  }
-
-  pass.run(*module);
-  return true;
+  return emitFile(filename, llvm::CodeGenFileType::ObjectFile);
 }
 
 bool LLVMIRGenerator::emitAssemblyFile(const std::string &filename) {
-  std::string error;
-  auto targetTriple = llvm::sys::getDefaultTargetTriple();
-  auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+  return emitFile(filename, llvm::CodeGenFileType::AssemblyFile);
+}
 
-  if (!target) {
-    std::cerr << "Error looking up target: " << error << std::endl;
+bool LLVMIRGenerator::emitFile(const std::string &filename,
+                               llvm::CodeGenFileType fileType) {
+  auto *targetMachine = hostTargetMachine();
+  if (!targetMachine) {
     return false;
   }
 
-  llvm::TargetOptions opt;
-  auto RM = std::optional<llvm::Reloc::Model>();
-  auto targetMachine =
-      target->createTargetMachine(targetTriple, "generic", "", opt, RM);
-
   module->setDataLayout(targetMachine->createDataLayout());
-  module->setTargetTriple(targetTriple);
+  module->setTargetTriple(targetMachine->getTargetTriple().str());
 
   std::error_code ec;
   llvm::raw_fd_ostream dest(filename, ec, llvm::sys::fs::OF_None);
@@ -155,7 +194,6 @@ bool LLVMIRGenerator::emitAssemblyFile(const std::string &filename) {
   }
 
   llvm::legacy::PassManager pass;
-  auto fileType = llvm::CodeGenFileType::AssemblyFile;
 
   if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
     std::cerr << "TargetMachine can't emit file of this type" << std::endl;
@@ -168,41 +206,40 @@ bool LLVMIRGenerator::emitAssemblyFile(const std::string &filename) {
 
 void LLVMIRGenerator::addExternalSymbol(const std::string &name,
                                         void *address) {
-  if (!jit || !jit->isValid()) {
+  if (!ensureJIT()) {
     std::cerr << "JIT not initialized" << std::endl;
     return;
   }
 
-  auto &mainDylib = jit->jit->getMainJITDylib();
-
   llvm::orc::SymbolMap symbols;
   symbols[jit->jit->mangleAndIntern(name)] =
       llvm::orc::ExecutorSymbolDef(llvm::orc::ExecutorAddr::fromPtr(address),
                                    llvm::JITSymbolFlags::Exported);
 
   if (auto err =
-          mainDylib.define(llvm::orc::absoluteSymbols(std::move(symbols)))) {
+          jit->dylib->define(llvm::orc::absoluteSymbols(std::move(symbols)))) {
     llvm::consumeError(std::move(err));
     std::cerr << "Failed to add external symbol: " << name << std::endl;
   }
 }
 
+llvm::orc::ThreadSafeModule LLVMIRGenerator::takeModule() {
+  return llvm::orc::ThreadSafeModule(std::move(module), std::move(context));
+}
+
 int LLVMIRGenerator::runJIT(const std::string &entryPoint) {
-  if (!jit || !jit->isValid()) {
+  if (!ensureJIT()) {
     std::cerr << "JIT not initialized" << std::endl;
     return -1;
   }
 
-  auto tsModule =
-      llvm::orc::ThreadSafeModule(std::move(module), std::move(context));
-
-  if (auto err = jit->jit->addIRModule(std::move(tsModule))) {
+  if (auto err = jit->jit->addIRModule(*jit->dylib, takeModule())) {
     std::cerr << "Failed to add module to JIT: ";
     llvm::consumeError(std::move(err));
     return -1;
   }
 
-  auto mainSymbol = jit->jit->lookup(entryPoint);
+  auto mainSymbol = jit->jit->lookup(*jit->dylib, entryPoint);
   if (!mainSymbol) {
     std::cerr << "Failed to find entry point: " << entryPoint << std::endl;
     llvm::consumeError(mainSymbol.takeError());
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
@@ -31,13 +32,16 @@ public:
   // 生成汇编文件
   bool emitAssemblyFile(const std::string &filename);
 
-  // JIT 执行
+  // JIT 执行（JIT 在首次添加符号或运行时创建，只生成目标文件时不创建）
   bool hasJIT() const { return jit != nullptr; }
   int runJIT(const std::string &entryPoint = "main");
   
   // 添加外部函数符号（用于调用 C 库函数）
   void addExternalSymbol(const std::string &name, void *address);
 
+  // 取出模块连同它的 LLVMContext（交给热重载会话等），之后不能再使用生成器
+  llvm::orc::ThreadSafeModule takeModule();
+
 private:
   std::unique_ptr<llvm::LLVMContext> context;
   std::unique_ptr<llvm::IRBuilder<>> builder;
@@ -46,6 +50,12 @@ private:
   // JIT 相关
   struct JITState;
   std::unique_ptr<JITState> jit;
+
+  // 创建 JIT（已创建时直接返回），JIT 不可用时返回 false
+  bool ensureJIT();
+
+  // 用本线程缓存的目标机器生成目标文件或汇编文件
+  bool emitFile(const std::string &filename, llvm::CodeGenFileType fileType);
 };
 
 } // namespace c_hat::llvm_codegen
@@ -0,0 +1,980 @@
+#include "Document.h"
+#include "../ast/AstNodes.h"
+#include "../lexer/Lexer.h"
+#include "../parser/Parser.h"
+#include "../semantic/SemanticAnalyzer.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <map>
+#include <set>
+#include <unordered_set>
+
+namespace c_hat {
+namespace lsp {
+
+using lexer::TokenType;
+
+// 声明块中的诊断，偏移相对于声明块的开头，声明块移动时不需要更新
+struct Document::ChunkDiagnostic {
+  size_t offset = 0;
+  size_t length = 0;
+  std::string message;
+};
+
+// 一个顶层声明（有语法错误时可能是几个声明或声明的一部分）
+struct Document::Chunk {
+  size_t begin = 0;
+  size_t end = 0;
+  size_t textHash = 0;
+  // 签名的哈希：函数为函数体之前的词法单元，其他声明为全部词法单元
+  size_t signatureHash = 0;
+  // 文本变化后尚未重新解析和分析
+  bool dirty = true;
+  std::unique_ptr<ast::Program> program;
+  // 是否是带函数体的顶层函数（签名不变时只需重新分析函数体）
+  bool isFunction = false;
+  // 是否含有作用于整个文档的声明（导入、扩展等），修改后重新分析全部
+  // 函数体
+  bool isGlobal = false;
+  // 声明的顶层名称
+  std::vector<std::string> names;
+  // 出现的全部标识符，以及签名中出现的标识符
+  std::unordered_set<std::string> references;
+  std::unordered_set<std::string> signatureReferences;
+  std::vector<ChunkDiagnostic> parseDiagnostics;
+  // 收集签名和分析类成员时的诊断
+  std::vector<ChunkDiagnostic> signatureDiagnostics;
+  std::vector<ChunkDiagnostic> bodyDiagnostics;
+};
+
+namespace {
+
+struct SourceToken {
+  TokenType type;
+  // 相对于扫描文本开头的偏移
+  size_t offset;
+  size_t length;
+};
+
+// 定位到声明块中某个位置的消息
+struct LocatedMessage {
+  size_t offset = 0;
+  size_t length = 0;
+  std::string message;
+};
+
+// 逐个取出词法单元及其在文本中的位置，跳过无法识别的字符
+// 运算符的值是字面量而不是源码的视图，从上一个词法单元之后查找
+class TokenScanner {
+public:
+  explicit TokenScanner(std::string text)
+      : lexer_(std::move(text)), source_(lexer_.getSourceBuffer()->getText()) {
+  }
+
+  // 文本结束时返回空
+  std::optional<SourceToken> next() {
+    while (true) {
+      auto token = lexer_.nextToken();
+      if (!token) {
+        continue;
+      }
+      if (token->getType() == TokenType::EndOfFile) {
+        return std::nullopt;
+      }
+      std::string_view value = token->getValue();
+      std::less_equal<const char *> lessEqual;
+      size_t offset;
+      if (lessEqual(source_.data(), value.data()) &&
+          lessEqual(value.data(), source_.data() + source_.size())) {
+        offset = static_cast<size_t>(value.data() - source_.data());
+      } else {
+        offset = std::min(source_.find(value, cursor_), source_.size());
+      }
+      cursor_ = offset + value.size();
+      return SourceToken{token->getType(), offset, value.size()};
+    }
+  }
+
+private:
+  lexer::Lexer lexer_;
+  std::string_view source_;
+  size_t cursor_ = 0;
+};
+
+// 词法分析器跳过注释，取出的只有代码的词法单元
+std::vector<SourceToken> scanTokens(std::string_view text) {
+  TokenScanner scanner{std::string(text)};
+  std::vector<SourceToken> tokens;
+  while (auto token = scanner.next()) {
+    tokens.push_back(*token);
+  }
+  return tokens;
+}
+
+std::string_view tokenText(std::string_view text, const SourceToken &token) {
+  return text.substr(token.offset, token.length);
+}
+
+std::string_view trim(std::string_view text) {
+  size_t begin = text.find_first_not_of(" \t\r\n");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  size_t end = text.find_last_not_of(" \t\r\n");
+  return text.substr(begin, end - begin + 1);
+}
+
+// 第一个深度为 0 的 '{' 在 tokens 中的下标，没有时返回 tokens.size()
+size_t findBodyStart(const std::vector<SourceToken> &tokens) {
+  int depth = 0;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    switch (tokens[i].type) {
+    case TokenType::LBrace:
+      if (depth == 0) {
+        return i;
+      }
+      ++depth;
+      break;
+    case TokenType::LParen:
+    case TokenType::LBracket:
+      ++depth;
+      break;
+    case TokenType::RParen:
+    case TokenType::RBracket:
+    case TokenType::RBrace:
+      if (depth > 0) {
+        --depth;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return tokens.size();
+}
+
+// 词法上是否像一个带函数体的函数：函数体之前有 func，且没有深度为 0
+// 的 '='（排除 var f = func() {...}）
+bool looksLikeFunction(const std::vector<SourceToken> &tokens,
+                       size_t bodyStart) {
+  if (bodyStart == tokens.size()) {
+    return false;
+  }
+  bool sawFunc = false;
+  int depth = 0;
+  for (size_t i = 0; i < bodyStart; ++i) {
+    switch (tokens[i].type) {
+    case TokenType::Func:
+      sawFunc = true;
+      break;
+    case TokenType::LParen:
+    case TokenType::LBracket:
+      ++depth;
+      break;
+    case TokenType::RParen:
+    case TokenType::RBracket:
+      if (depth > 0) {
+        --depth;
+      }
+      break;
+    case TokenType::Assign:
+      if (depth == 0) {
+        return false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return sawFunc;
+}
+
+bool isPrimitiveType(TokenType type) {
+  return type >= TokenType::Void && type <= TokenType::Char;
+}
+
+// tokens[i] 处的标识符是否是声明的名称（按前后的词法单元判断）
+bool isDeclarationSite(const std::vector<SourceToken> &tokens, size_t i) {
+  TokenType previous = i > 0 ? tokens[i - 1].type : TokenType::EndOfFile;
+  TokenType next =
+      i + 1 < tokens.size() ? tokens[i + 1].type : TokenType::EndOfFile;
+  switch (previous) {
+  case TokenType::Var:
+  case TokenType::Let:
+  case TokenType::Const:
+  case TokenType::Late:
+  case TokenType::Func:
+  case TokenType::Class:
+  case TokenType::Struct:
+  case TokenType::Enum:
+  case TokenType::Union:
+  case TokenType::Interface:
+  case TokenType::Concept:
+  case TokenType::Namespace:
+  case TokenType::Attribute:
+  case TokenType::TypeAlias:
+    return true;
+  default:
+    break;
+  }
+  // 参数：(x: int, y: int)
+  if (next == TokenType::Colon &&
+      (previous == TokenType::LParen || previous == TokenType::Comma)) {
+    return true;
+  }
+  // 类型名之后的名称：int x = 0、Point p;、(int a, int b)
+  if (previous == TokenType::Identifier || isPrimitiveType(previous)) {
+    return next == TokenType::Assign || next == TokenType::Semicolon ||
+           next == TokenType::Comma || next == TokenType::RParen ||
+           next == TokenType::LParen;
+  }
+  // 复合类型之后的名称：int* p = ...、byte^ s = ...、int[4] a;、Vec<int> v;
+  if (previous == TokenType::Multiply || previous == TokenType::Xor ||
+      previous == TokenType::RBracket || previous == TokenType::Gt ||
+      previous == TokenType::Question || previous == TokenType::And) {
+    return next == TokenType::Assign || next == TokenType::Semicolon;
+  }
+  return false;
+}
+
+// 语义分析器的诊断没有位置：取消息中引号内或最后一个 ": " 之后的名称，
+// 定位到声明块中第一个同名的标识符，找不到时定位到声明块的开头
+LocatedMessage locateSemanticError(std::string_view text,
+                                   const std::string &message) {
+  std::vector<std::string> candidates;
+  for (char quote : {'\'', '"'}) {
+    size_t open = message.find(quote);
+    size_t close = open == std::string::npos
+                       ? std::string::npos
+                       : message.find(quote, open + 1);
+    if (close != std::string::npos) {
+      candidates.push_back(message.substr(open + 1, close - open - 1));
+    }
+  }
+  size_t colon = message.rfind(": ");
+  if (colon != std::string::npos) {
+    std::string word;
+    for (size_t i = colon + 2; i < message.size(); ++i) {
+      char c = message[i];
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+        break;
+      }
+      word += c;
+    }
+    candidates.push_back(word);
+  }
+
+  auto tokens = scanTokens(text);
+  for (const auto &candidate : candidates) {
+    for (const auto &token : tokens) {
+      if (token.type == TokenType::Identifier &&
+          tokenText(text, token) == candidate) {
+        return {token.offset, token.length, message};
+      }
+    }
+  }
+  if (!tokens.empty()) {
+    return {tokens.front().offset, tokens.front().length, message};
+  }
+  return {0, 0, message};
+}
+
+// 语法错误的消息以 " at line L, column C" 结尾（相对于声明块），换算为
+// 偏移并从消息中去掉
+LocatedMessage locateParseError(std::string_view text,
+                                const std::string &message) {
+  static constexpr std::string_view Marker = " at line ";
+  size_t marker = message.rfind(Marker);
+  if (marker == std::string::npos) {
+    return locateSemanticError(text, message);
+  }
+  const char *cursor = message.data() + marker + Marker.size();
+  const char *end = message.data() + message.size();
+  int line = 0;
+  int column = 0;
+  auto lineResult = std::from_chars(cursor, end, line);
+  static constexpr std::string_view ColumnMarker = ", column ";
+  if (lineResult.ec != std::errc() ||
+      std::string_view(lineResult.ptr, end - lineResult.ptr)
+              .substr(0, ColumnMarker.size()) != ColumnMarker ||
+      std::from_chars(lineResult.ptr + ColumnMarker.size(), end, column).ec !=
+          std::errc()) {
+    return locateSemanticError(text, message);
+  }
+
+  size_t offset = 0;
+  for (int i = 1; i < line && offset < text.size(); ++i) {
+    size_t newline = text.find('\n', offset);
+    offset = newline == std::string_view::npos ? text.size() : newline + 1;
+  }
+  offset = std::min(offset + static_cast<size_t>(std::max(column - 1, 0)),
+                    text.size());
+  size_t length = offset < text.size() ? 1 : 0;
+  for (const auto &token : scanTokens(text)) {
+    if (token.offset == offset) {
+      length = token.length;
+      break;
+    }
+  }
+  return {offset, length, message.substr(0, marker)};
+}
+
+// 只含空白和注释的文本（声明之前的部分）中的注释，返回各注释的开始
+// 位置和去掉注释标记后的内容
+std::vector<std::pair<size_t, std::string_view>>
+findComments(std::string_view trivia) {
+  std::vector<std::pair<size_t, std::string_view>> comments;
+  size_t position = 0;
+  while ((position = trivia.find('/', position)) != std::string_view::npos) {
+    if (trivia.substr(position, 2) == "//") {
+      size_t end = std::min(trivia.find('\n', position), trivia.size());
+      comments.emplace_back(
+          position, trim(trivia.substr(position + 2, end - position - 2)));
+      position = end;
+    } else if (trivia.substr(position, 2) == "/*") {
+      size_t end = std::min(trivia.find("*/", position + 2), trivia.size());
+      comments.emplace_back(
+          position, trim(trivia.substr(position + 2, end - position - 2)));
+      position = std::min(end + 2, trivia.size());
+    } else {
+      ++position;
+    }
+  }
+  return comments;
+}
+
+// UTF-8 序列首字节对应的序列长度
+size_t utf8Length(unsigned char lead) {
+  if (lead >= 0xF0) {
+    return 4;
+  }
+  if (lead >= 0xE0) {
+    return 3;
+  }
+  if (lead >= 0xC0) {
+    return 2;
+  }
+  return 1;
+}
+
+} // namespace
+
+Document::Document(std::string text, semantic::ModuleGraph *moduleGraph)
+    : text_(std::move(text)), moduleGraph_(moduleGraph) {
+  updateLineStarts();
+  resplit(0, text_.size(), 0);
+}
+
+Document::~Document() = default;
+
+void Document::edit(const std::optional<Range> &range,
+                    std::string_view newText) {
+  size_t begin = range ? offsetAt(range->start) : 0;
+  size_t end = range ? offsetAt(range->end) : text_.size();
+  if (end < begin) {
+    std::swap(begin, end);
+  }
+  text_.replace(begin, end - begin, newText);
+  updateLineStarts();
+  // 声明块的位置在更新前不再可靠
+  declarations_.clear();
+
+  // 从前一个声明开始切分：编辑处的 ';' 可能并入前一个以 '}' 结束的声明
+  size_t first = chunks_.empty() ? 0 : chunkIndexAt(begin);
+  if (first > 0) {
+    --first;
+  }
+  resplit(first, begin + newText.size(),
+          static_cast<ptrdiff_t>(newText.size()) -
+              static_cast<ptrdiff_t>(end - begin));
+}
+
+void Document::updateLineStarts() {
+  lineStarts_.assign(1, 0);
+  for (size_t i = text_.find('\n'); i != std::string::npos;
+       i = text_.find('\n', i + 1)) {
+    lineStarts_.push_back(i + 1);
+  }
+}
+
+void Document::resplit(size_t first, size_t editEnd, ptrdiff_t delta) {
+  size_t from = first < chunks_.size() ? chunks_[first]->begin : 0;
+  std::vector<size_t> ends;
+  // 被替换的旧声明块是 [first, replaceEnd)
+  size_t replaceEnd = chunks_.size();
+
+  // 按顶层声明切分：深度为 0 的 ';' 结束声明；没有深度为 0 的 '=' 时，
+  // 回到深度 0 的 '}' 也结束声明（紧随的 ';' 归入该声明）。
+  // 先只扫描编辑处之后的一段文本，边界没有重合时加倍扫描范围
+  size_t window = editEnd - from + 64 * 1024;
+  while (true) {
+    size_t length = std::min(window, text_.size() - from);
+    bool complete = from + length == text_.size();
+    ends.clear();
+
+    TokenScanner scanner{text_.substr(from, length)};
+    int depth = 0;
+    bool sawAssign = false;
+    bool closed = false;
+    bool pending = false;
+    size_t lastEnd = 0;
+    bool synced = false;
+
+    // 记录一个声明的结束位置，返回新边界是否与编辑处之后的旧边界重合
+    auto finish = [&](size_t end) {
+      ends.push_back(from + end);
+      depth = 0;
+      sawAssign = false;
+      closed = false;
+      pending = false;
+      if (from + end < editEnd) {
+        return false;
+      }
+      ptrdiff_t oldEnd = static_cast<ptrdiff_t>(from + end) - delta;
+      auto it = std::lower_bound(
+          chunks_.begin() + first, chunks_.end(), oldEnd,
+          [](const std::unique_ptr<Chunk> &chunk, ptrdiff_t value) {
+            return static_cast<ptrdiff_t>(chunk->end) < value;
+          });
+      if (it == chunks_.end() || static_cast<ptrdiff_t>((*it)->end) != oldEnd) {
+        return false;
+      }
+      replaceEnd = static_cast<size_t>(it - chunks_.begin()) + 1;
+      return true;
+    };
+
+    while (!synced) {
+      auto token = scanner.next();
+      if (!token) {
+        break;
+      }
+      TokenType type = token->type;
+      size_t end = token->offset + token->length;
+      if (closed) {
+        if (type == TokenType::Semicolon) {
+          synced = finish(end);
+          continue;
+        }
+        if ((synced = finish(lastEnd))) {
+          break;
+        }
+      }
+      pending = true;
+      switch (type) {
+      case TokenType::LParen:
+      case TokenType::LBracket:
+      case TokenType::LBrace:
+        ++depth;
+        break;
+      case TokenType::RParen:
+      case TokenType::RBracket:
+        if (depth > 0) {
+          --depth;
+        }
+        break;
+      case TokenType::RBrace:
+        if (depth > 0) {
+          --depth;
+        }
+        if (depth == 0 && !sawAssign) {
+          closed = true;
+        }
+        break;
+      case TokenType::Assign:
+        if (depth == 0) {
+          sawAssign = true;
+        }
+        break;
+      case TokenType::Semicolon:
+        if (depth == 0) {
+          lastEnd = end;
+          synced = finish(end);
+          continue;
+        }
+        break;
+      default:
+        break;
+      }
+      lastEnd = end;
+    }
+    if (synced) {
+      break;
+    }
+    // 扫描范围末尾的词法单元可能被截断，只有扫描到文本末尾时才能确定
+    // 剩余的边界
+    if (!complete) {
+      window *= 2;
+      continue;
+    }
+    // 末尾的注释和空白并入最后一个声明
+    if (pending || ends.empty()) {
+      ends.push_back(text_.size());
+    } else {
+      ends.back() = text_.size();
+    }
+    break;
+  }
+
+  // 文本没有变化的旧声明块（例如编辑处之前重新切分的声明）直接复用
+  std::unordered_multimap<size_t, size_t> oldByHash;
+  for (size_t i = first; i < replaceEnd; ++i) {
+    oldByHash.emplace(chunks_[i]->textHash, i);
+  }
+  std::vector<std::unique_ptr<Chunk>> created;
+  size_t begin = from;
+  for (size_t end : ends) {
+    std::string_view text(text_.data() + begin, end - begin);
+    size_t hash = std::hash<std::string_view>{}(text);
+    std::unique_ptr<Chunk> chunk;
+    auto [match, matchEnd] = oldByHash.equal_range(hash);
+    for (; match != matchEnd; ++match) {
+      auto &old = chunks_[match->second];
+      if (old && old->end - old->begin == text.size()) {
+        chunk = std::move(old);
+        oldByHash.erase(match);
+        break;
+      }
+    }
+    if (!chunk) {
+      chunk = std::make_unique<Chunk>();
+      chunk->textHash = hash;
+    }
+    chunk->begin = begin;
+    chunk->end = end;
+    created.push_back(std::move(chunk));
+    begin = end;
+  }
+
+  // 分析过的旧声明块留到下一次更新，用来比较签名
+  for (size_t i = first; i < replaceEnd; ++i) {
+    if (chunks_[i] && !chunks_[i]->dirty) {
+      replaced_.push_back(std::move(chunks_[i]));
+    }
+  }
+  for (size_t i = replaceEnd; i < chunks_.size(); ++i) {
+    chunks_[i]->begin += delta;
+    chunks_[i]->end += delta;
+  }
+  chunks_.erase(chunks_.begin() + first, chunks_.begin() + replaceEnd);
+  chunks_.insert(chunks_.begin() + first,
+                 std::make_move_iterator(created.begin()),
+                 std::make_move_iterator(created.end()));
+}
+
+void Document::parseChunk(Chunk &chunk) {
+  std::string_view text = chunkText(chunk);
+  chunk.program.reset();
+  chunk.isFunction = false;
+  chunk.isGlobal = false;
+  chunk.names.clear();
+  chunk.references.clear();
+  chunk.signatureReferences.clear();
+  chunk.parseDiagnostics.clear();
+  chunk.signatureDiagnostics.clear();
+  chunk.bodyDiagnostics.clear();
+
+  auto tokens = scanTokens(text);
+  size_t bodyStart = findBodyStart(tokens);
+
+  try {
+    parser::Parser parser{std::string(text)};
+    chunk.program = parser.parseProgram();
+  } catch (const std::exception &e) {
+    auto located = locateParseError(text, e.what());
+    chunk.parseDiagnostics.push_back(
+        {located.offset, located.length, std::move(located.message)});
+  }
+
+  if (chunk.program) {
+    for (auto &decl : chunk.program->declarations) {
+      if (auto *d = dynamic_cast<ast::FunctionDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::ClassDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::StructDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::EnumDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::InterfaceDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::TypeAliasDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::VariableDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::ConceptDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else if (auto *d = dynamic_cast<ast::AttributeDecl *>(decl.get())) {
+        chunk.names.push_back(d->name);
+      } else {
+        // 导入、模块、扩展、外部声明、命名空间等影响整个文档的名称解析
+        chunk.isGlobal = true;
+      }
+    }
+    auto *function =
+        chunk.program->declarations.size() == 1
+            ? dynamic_cast<ast::FunctionDecl *>(
+                  chunk.program->declarations.front().get())
+            : nullptr;
+    chunk.isFunction = function && function->hasBody();
+  } else if (looksLikeFunction(tokens, bodyStart)) {
+    // 函数体中的语法错误不影响签名，符号表中原有的签名仍然有效
+    chunk.isFunction = true;
+    for (size_t i = 0; i + 1 < bodyStart; ++i) {
+      if (tokens[i].type == TokenType::Func &&
+          tokens[i + 1].type == TokenType::Identifier) {
+        chunk.names.emplace_back(tokenText(text, tokens[i + 1]));
+        break;
+      }
+    }
+  }
+
+  size_t signatureEnd = chunk.isFunction ? bodyStart : tokens.size();
+  std::string signature;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    std::string_view value = tokenText(text, tokens[i]);
+    if (tokens[i].type == TokenType::Identifier) {
+      chunk.references.emplace(value);
+    }
+    if (i < signatureEnd) {
+      signature.append(value);
+      signature += '\x1f';
+      if (tokens[i].type == TokenType::Identifier) {
+        chunk.signatureReferences.emplace(value);
+      }
+    }
+  }
+  chunk.signatureHash = std::hash<std::string>{}(signature);
+}
+
+void Document::analyzeChunk(
+    Chunk &chunk, std::vector<ChunkDiagnostic> &diagnostics,
+    const std::function<void(ast::Declaration *)> &step) {
+  if (!chunk.program) {
+    return;
+  }
+  std::string_view text = chunkText(chunk);
+  auto report = [&](const std::string &message) {
+    auto located = locateSemanticError(text, message);
+    diagnostics.push_back(
+        {located.offset, located.length, std::move(located.message)});
+  };
+  analyzer_->setDiagnosticHandler(report);
+  for (auto &decl : chunk.program->declarations) {
+    try {
+      step(decl.get());
+    } catch (const std::exception &e) {
+      report(e.what());
+    }
+  }
+  analyzer_->setDiagnosticHandler(nullptr);
+}
+
+UpdateStats Document::update() {
+  UpdateStats stats;
+  stats.declarations = chunks_.size();
+
+  std::vector<Chunk *> changed;
+  for (auto &chunk : chunks_) {
+    if (chunk->dirty) {
+      parseChunk(*chunk);
+      changed.push_back(chunk.get());
+    }
+  }
+  stats.reparsed = changed.size();
+
+  // 被替换和新解析的声明都是函数且签名的多重集相同时，符号表中的签名
+  // 仍然有效，只需在原有的分析器中重新分析修改过的函数体
+  bool bodiesOnly = analyzer_ != nullptr;
+  std::multimap<size_t, const Chunk *> oldSignatures;
+  std::multiset<size_t> newSignatures;
+  for (const auto &old : replaced_) {
+    bodiesOnly = bodiesOnly && old->isFunction;
+    oldSignatures.emplace(old->signatureHash, old.get());
+  }
+  for (const auto *chunk : changed) {
+    bodiesOnly = bodiesOnly && chunk->isFunction;
+    newSignatures.insert(chunk->signatureHash);
+  }
+  if (bodiesOnly) {
+    std::multiset<size_t> before;
+    for (const auto &[hash, old] : oldSignatures) {
+      before.insert(hash);
+    }
+    bodiesOnly = before == newSignatures;
+  }
+
+  if (bodiesOnly) {
+    for (auto *chunk : changed) {
+      auto old = oldSignatures.find(chunk->signatureHash);
+      chunk->signatureDiagnostics = old->second->signatureDiagnostics;
+      oldSignatures.erase(old);
+      analyzeChunk(*chunk, chunk->bodyDiagnostics,
+                   [&](ast::Declaration *decl) {
+                     analyzer_->analyzeTopLevelBody(decl);
+                   });
+      ++stats.reanalyzed;
+    }
+  } else {
+    stats.signaturesChanged = true;
+
+    // 签名可能变化的名称：被替换和新解析的声明的名称，以及签名中引用了
+    // 这些名称的声明的名称
+    bool analyzeAll = analyzer_ == nullptr;
+    std::unordered_set<std::string> affected;
+    for (const auto &old : replaced_) {
+      analyzeAll = analyzeAll || old->isGlobal;
+      affected.insert(old->names.begin(), old->names.end());
+    }
+    for (const auto *chunk : changed) {
+      analyzeAll = analyzeAll || chunk->isGlobal;
+      affected.insert(chunk->names.begin(), chunk->names.end());
+    }
+    auto referencesAffected = [&](const std::unordered_set<std::string> &ids) {
+      for (const auto &name : affected) {
+        if (ids.count(name)) {
+          return true;
+        }
+      }
+      return false;
+    };
+    std::unordered_set<const Chunk *> propagated;
+    for (bool grew = !analyzeAll; grew;) {
+      grew = false;
+      for (const auto &chunk : chunks_) {
+        if (!propagated.count(chunk.get()) &&
+            referencesAffected(chunk->signatureReferences)) {
+          propagated.insert(chunk.get());
+          size_t before = affected.size();
+          affected.insert(chunk->names.begin(), chunk->names.end());
+          grew = grew || affected.size() != before;
+        }
+      }
+    }
+
+    // 新的分析器重新收集全部顶层签名
+    if (moduleGraph_) {
+      // 上次分析时缺少或出错的模块可能已经修正
+      moduleGraph_->dropFailedModules();
+      analyzer_ =
+          std::make_unique<semantic::SemanticAnalyzer>(*moduleGraph_, false);
+    } else {
+      analyzer_ = std::make_unique<semantic::SemanticAnalyzer>(
+          std::vector<std::string>(), false);
+    }
+    for (auto &chunk : chunks_) {
+      chunk->signatureDiagnostics.clear();
+      analyzeChunk(*chunk, chunk->signatureDiagnostics,
+                   [&](ast::Declaration *decl) {
+                     analyzer_->collectTopLevelDeclaration(decl);
+                   });
+    }
+    for (auto &chunk : chunks_) {
+      analyzeChunk(*chunk, chunk->signatureDiagnostics,
+                   [&](ast::Declaration *decl) {
+                     analyzer_->analyzeTopLevelMembers(decl);
+                   });
+    }
+    for (auto &chunk : chunks_) {
+      if (!analyzeAll && !chunk->dirty &&
+          !referencesAffected(chunk->references)) {
+        continue;
+      }
+      chunk->bodyDiagnostics.clear();
+      analyzeChunk(*chunk, chunk->bodyDiagnostics,
+                   [&](ast::Declaration *decl) {
+                     analyzer_->analyzeTopLevelBody(decl);
+                   });
+      ++stats.reanalyzed;
+    }
+  }
+
+  replaced_.clear();
+  declarations_.clear();
+  for (auto &chunk : chunks_) {
+    chunk->dirty = false;
+    for (const auto &name : chunk->names) {
+      declarations_[name].push_back(chunk.get());
+    }
+  }
+  return stats;
+}
+
+std::vector<Diagnostic> Document::getDiagnostics() const {
+  std::vector<Diagnostic> result;
+  for (const auto &chunk : chunks_) {
+    for (const auto *list :
+         {&chunk->parseDiagnostics, &chunk->signatureDiagnostics,
+          &chunk->bodyDiagnostics}) {
+      for (const auto &diagnostic : *list) {
+        size_t begin = chunk->begin + diagnostic.offset;
+        result.push_back({{positionAt(begin),
+                           positionAt(begin + diagnostic.length)},
+                          diagnostic.message});
+      }
+    }
+  }
+  return result;
+}
+
+std::optional<Document::DeclarationSite>
+Document::findDeclaration(Position position) const {
+  if (chunks_.empty()) {
+    return std::nullopt;
+  }
+  size_t offset = offsetAt(position);
+  const Chunk &chunk = *chunks_[chunkIndexAt(offset)];
+  std::string_view text = chunkText(chunk);
+  size_t relative = offset - chunk.begin;
+  auto tokens = scanTokens(text);
+  auto at = std::find_if(tokens.begin(), tokens.end(), [&](const auto &token) {
+    return token.type == TokenType::Identifier && token.offset <= relative &&
+           relative <= token.offset + token.length;
+  });
+  if (at == tokens.end()) {
+    return std::nullopt;
+  }
+  std::string_view name = tokenText(text, *at);
+
+  // 同一声明中前面最近的声明（局部变量、参数）
+  for (size_t i = static_cast<size_t>(at - tokens.begin()) + 1; i-- > 0;) {
+    if (tokens[i].type == TokenType::Identifier &&
+        tokenText(text, tokens[i]) == name && isDeclarationSite(tokens, i)) {
+      return DeclarationSite{&chunk, chunk.begin + tokens[i].offset,
+                         tokens[i].length};
+    }
+  }
+
+  // 顶层声明
+  auto it = declarations_.find(std::string(name));
+  if (it == declarations_.end()) {
+    return std::nullopt;
+  }
+  const Chunk *target = it->second.front();
+  std::string_view targetText = chunkText(*target);
+  auto targetTokens = scanTokens(targetText);
+  std::optional<DeclarationSite> firstUse;
+  for (size_t i = 0; i < targetTokens.size(); ++i) {
+    if (targetTokens[i].type != TokenType::Identifier ||
+        tokenText(targetText, targetTokens[i]) != name) {
+      continue;
+    }
+    DeclarationSite site{target, target->begin + targetTokens[i].offset,
+                     targetTokens[i].length};
+    if (isDeclarationSite(targetTokens, i)) {
+      return site;
+    }
+    if (!firstUse) {
+      firstUse = site;
+    }
+  }
+  return firstUse;
+}
+
+std::optional<std::string> Document::hover(Position position) const {
+  auto site = findDeclaration(position);
+  if (!site) {
+    return std::nullopt;
+  }
+  const Chunk &chunk = *site->chunk;
+  std::string_view text = chunkText(chunk);
+  size_t relative = site->offset - chunk.begin;
+  auto code = scanTokens(text);
+  size_t bodyStart = findBodyStart(code);
+  size_t signatureEnd =
+      bodyStart < code.size() ? code[bodyStart].offset : text.size();
+
+  std::string snippet;
+  std::string documentation;
+  if (relative < signatureEnd && !code.empty()) {
+    // 顶层声明：签名和声明前的注释
+    size_t begin = code.front().offset;
+    snippet = trim(text.substr(begin, signatureEnd - begin));
+    // 声明块开头与上一个声明同一行的注释属于上一个声明
+    bool skipSameLine = chunk.begin > 0 && text_[chunk.begin - 1] != '\n';
+    for (const auto &[offset, comment] :
+         findComments(text.substr(0, begin))) {
+      if (skipSameLine &&
+          text.substr(0, offset).find('\n') == std::string_view::npos) {
+        continue;
+      }
+      if (!documentation.empty()) {
+        documentation += '\n';
+      }
+      documentation += comment;
+    }
+  } else {
+    // 局部声明：声明所在的行
+    size_t lineBegin = text.rfind('\n', relative);
+    lineBegin = lineBegin == std::string_view::npos ? 0 : lineBegin + 1;
+    size_t lineEnd = text.find('\n', relative);
+    snippet = trim(text.substr(lineBegin, lineEnd == std::string_view::npos
+                                              ? std::string_view::npos
+                                              : lineEnd - lineBegin));
+  }
+
+  std::string markdown = "```c_hat\n" + snippet + "\n```";
+  if (!documentation.empty()) {
+    markdown += "\n\n" + documentation;
+  }
+  return markdown;
+}
+
+std::optional<Range> Document::definition(Position position) const {
+  auto site = findDeclaration(position);
+  if (!site) {
+    return std::nullopt;
+  }
+  return Range{positionAt(site->offset),
+               positionAt(site->offset + site->length)};
+}
+
+size_t Document::offsetAt(Position position) const {
+  if (position.line < 0) {
+    return 0;
+  }
+  if (static_cast<size_t>(position.line) >= lineStarts_.size()) {
+    return text_.size();
+  }
+  size_t offset = lineStarts_[position.line];
+  size_t lineEnd = static_cast<size_t>(position.line) + 1 < lineStarts_.size()
+                       ? lineStarts_[position.line + 1] - 1
+                       : text_.size();
+  // 列号按 UTF-16 码元计数，四字节的 UTF-8 序列占两个码元
+  for (int units = 0; units < position.character && offset < lineEnd;) {
+    size_t length = utf8Length(static_cast<unsigned char>(text_[offset]));
+    units += length == 4 ? 2 : 1;
+    offset = std::min(offset + length, lineEnd);
+  }
+  return offset;
+}
+
+Position Document::positionAt(size_t offset) const {
+  offset = std::min(offset, text_.size());
+  auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+  size_t line = static_cast<size_t>(it - lineStarts_.begin()) - 1;
+  int character = 0;
+  for (size_t i = lineStarts_[line]; i < offset;) {
+    size_t length = utf8Length(static_cast<unsigned char>(text_[i]));
+    character += length == 4 ? 2 : 1;
+    i += length;
+  }
+  return {static_cast<int>(line), character};
+}
+
+std::string_view Document::chunkText(const Chunk &chunk) const {
+  return std::string_view(text_).substr(chunk.begin, chunk.end - chunk.begin);
+}
+
+size_t Document::chunkIndexAt(size_t offset) const {
+  auto it = std::upper_bound(
+      chunks_.begin(), chunks_.end(), offset,
+      [](size_t value, const std::unique_ptr<Chunk> &chunk) {
+        return value < chunk->begin;
+      });
+  return it == chunks_.begin() ? 0
+                               : static_cast<size_t>(it - chunks_.begin()) - 1;
+}
+
+} // namespace lsp
+} // namespace c_hat
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace c_hat {
+namespace ast {
+class Declaration;
+} // namespace ast
+
+namespace semantic {
+class ModuleGraph;
+class SemanticAnalyzer;
+} // namespace semantic
+
+namespace lsp {
+
+// 文档中的位置：从 0 开始的行号和 UTF-16 列号（与语言服务器协议一致）
+struct Position {
+  int line = 0;
+  int character = 0;
+
+  bool operator==(const Position &) const = default;
+};
+
+struct Range {
+  Position start;
+  Position end;
+};
+
+struct Diagnostic {
+  Range range;
+  std::string message;
+};
+
+// 一次更新做了多少工作
+struct UpdateStats {
+  // 文档中的顶层声明数
+  size_t declarations = 0;
+  // 重新解析的顶层声明数
+  size_t reparsed = 0;
+  // 重新分析了函数体的顶层声明数
+  size_t reanalyzed = 0;
+  // 是否有声明的签名发生变化（需要重新收集全部顶层签名）
+  bool signaturesChanged = false;
+};
+
+// 语言服务器中打开的文档
+// 文本按顶层声明切分，相邻声明首尾相接（声明前的注释和空白归入该声明）。
+// 编辑只重新词法分析编辑处的声明，直到切分边界与原来的边界重合；文本
+// 没有变化的声明保留解析结果和诊断。分析时：
+//   - 只有函数体变化时，在原有的分析器中只重新分析这些函数体
+//   - 签名变化时，用新的分析器重新收集全部顶层签名和类成员（不分析
+//     顶层函数体），再只重新分析改动的声明和引用了签名变化的名称的
+//     声明的函数体
+// 名称的引用按词法判断（声明中出现的标识符），不做完整的名称解析。
+class Document {
+public:
+  // moduleGraph 为 nullptr 时不能解析导入的模块
+  Document(std::string text, semantic::ModuleGraph *moduleGraph);
+  ~Document();
+
+  Document(const Document &) = delete;
+  Document &operator=(const Document &) = delete;
+
+  const std::string &getText() const { return text_; }
+
+  // 用 newText 替换 range 处的文本，range 为空时替换全文
+  // 修改在下一次 update() 时分析
+  void edit(const std::optional<Range> &range, std::string_view newText);
+
+  // 分析上次更新以来修改过的声明
+  UpdateStats update();
+
+  std::vector<Diagnostic> getDiagnostics() const;
+
+  // 标识符的说明（Markdown），不是标识符或找不到声明时返回空
+  std::optional<std::string> hover(Position position) const;
+
+  // 标识符的声明位置，只查找本文档
+  std::optional<Range> definition(Position position) const;
+
+  size_t offsetAt(Position position) const;
+  Position positionAt(size_t offset) const;
+
+private:
+  struct Chunk;
+  struct ChunkDiagnostic;
+
+  std::string text_;
+  // 每行第一个字节的偏移
+  std::vector<size_t> lineStarts_;
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  // 上次更新以来被替换掉的声明，用于比较签名
+  std::vector<std::unique_ptr<Chunk>> replaced_;
+  // 顶层名称 -> 声明它的声明块
+  std::unordered_map<std::string, std::vector<const Chunk *>> declarations_;
+
+  semantic::ModuleGraph *moduleGraph_;
+  std::unique_ptr<semantic::SemanticAnalyzer> analyzer_;
+
+  void updateLineStarts();
+
+  // 从第 first 个声明开始重新切分，直到与原有边界重合
+  // editEnd 是编辑后新文本的结束位置，delta 是文本长度的变化
+  void resplit(size_t first, size_t editEnd, ptrdiff_t delta);
+
+  void parseChunk(Chunk &chunk);
+
+  // 对声明块中的每个声明调用 step，分析器报告的诊断记录到 diagnostics
+  void analyzeChunk(Chunk &chunk, std::vector<ChunkDiagnostic> &diagnostics,
+                    const std::function<void(ast::Declaration *)> &step);
+
+  std::string_view chunkText(const Chunk &chunk) const;
+  size_t chunkIndexAt(size_t offset) const;
+
+  // 找到位置处标识符的声明，返回声明所在的声明块和声明名称的偏移
+  struct DeclarationSite {
+    const Chunk *chunk = nullptr;
+    size_t offset = 0;
+    size_t length = 0;
+  };
+  std::optional<DeclarationSite> findDeclaration(Position position) const;
+};
+
+} // namespace lsp
+} // namespace c_hat
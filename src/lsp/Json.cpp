@@ -0,0 +1,401 @@
+#include "Json.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace c_hat {
+namespace lsp {
+
+namespace {
+
+const Json NullValue;
+
+// 递归下降的 JSON 解析器
+class JsonParser {
+public:
+  explicit JsonParser(std::string_view text) : text_(text) {}
+
+  Json parseDocument() {
+    Json value = parseValue(0);
+    skipWhitespace();
+    if (position_ != text_.size()) {
+      fail("unexpected trailing characters");
+    }
+    return value;
+  }
+
+private:
+  // 嵌套层数上限，防止恶意消息耗尽栈空间
+  static constexpr int MaxDepth = 512;
+
+  std::string_view text_;
+  size_t position_ = 0;
+
+  [[noreturn]] void fail(const std::string &message) const {
+    throw JsonError("Invalid JSON at offset " + std::to_string(position_) +
+                    ": " + message);
+  }
+
+  void skipWhitespace() {
+    while (position_ < text_.size() &&
+           (text_[position_] == ' ' || text_[position_] == '\t' ||
+            text_[position_] == '\n' || text_[position_] == '\r')) {
+      ++position_;
+    }
+  }
+
+  bool consume(std::string_view literal) {
+    if (text_.substr(position_, literal.size()) == literal) {
+      position_ += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    skipWhitespace();
+    if (position_ >= text_.size() || text_[position_] != c) {
+      fail(std::string("expected '") + c + "'");
+    }
+    ++position_;
+  }
+
+  Json parseValue(int depth) {
+    if (depth > MaxDepth) {
+      fail("nesting too deep");
+    }
+    skipWhitespace();
+    if (position_ >= text_.size()) {
+      fail("unexpected end of input");
+    }
+    char c = text_[position_];
+    if (c == '{') {
+      return parseObject(depth);
+    }
+    if (c == '[') {
+      return parseArray(depth);
+    }
+    if (c == '"') {
+      return parseString();
+    }
+    if (consume("true")) {
+      return true;
+    }
+    if (consume("false")) {
+      return false;
+    }
+    if (consume("null")) {
+      return nullptr;
+    }
+    return parseNumber();
+  }
+
+  Json parseObject(int depth) {
+    ++position_;
+    Json::Object object;
+    skipWhitespace();
+    if (position_ < text_.size() && text_[position_] == '}') {
+      ++position_;
+      return object;
+    }
+    while (true) {
+      skipWhitespace();
+      if (position_ >= text_.size() || text_[position_] != '"') {
+        fail("expected member name");
+      }
+      std::string key = parseString();
+      expect(':');
+      object[std::move(key)] = parseValue(depth + 1);
+      skipWhitespace();
+      if (position_ < text_.size() && text_[position_] == ',') {
+        ++position_;
+        continue;
+      }
+      expect('}');
+      return object;
+    }
+  }
+
+  Json parseArray(int depth) {
+    ++position_;
+    Json::Array array;
+    skipWhitespace();
+    if (position_ < text_.size() && text_[position_] == ']') {
+      ++position_;
+      return array;
+    }
+    while (true) {
+      array.push_back(parseValue(depth + 1));
+      skipWhitespace();
+      if (position_ < text_.size() && text_[position_] == ',') {
+        ++position_;
+        continue;
+      }
+      expect(']');
+      return array;
+    }
+  }
+
+  Json parseNumber() {
+    size_t start = position_;
+    while (position_ < text_.size() &&
+           std::string_view("+-0123456789.eE").find(text_[position_]) !=
+               std::string_view::npos) {
+      ++position_;
+    }
+    double value = 0;
+    auto [end, ec] =
+        std::from_chars(text_.data() + start, text_.data() + position_, value);
+    if (start == position_ || ec != std::errc() ||
+        end != text_.data() + position_) {
+      position_ = start;
+      fail("invalid value");
+    }
+    return value;
+  }
+
+  unsigned parseHex4() {
+    if (position_ + 4 > text_.size()) {
+      fail("truncated escape");
+    }
+    unsigned value = 0;
+    auto [end, ec] = std::from_chars(text_.data() + position_,
+                                     text_.data() + position_ + 4, value, 16);
+    if (ec != std::errc() || end != text_.data() + position_ + 4) {
+      fail("invalid escape");
+    }
+    position_ += 4;
+    return value;
+  }
+
+  static void appendUtf8(std::string &out, unsigned codePoint) {
+    if (codePoint < 0x80) {
+      out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+      out += static_cast<char>(0xC0 | (codePoint >> 6));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+      out += static_cast<char>(0xE0 | (codePoint >> 12));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (codePoint >> 18));
+      out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+
+  std::string parseString() {
+    ++position_;
+    std::string out;
+    while (true) {
+      if (position_ >= text_.size()) {
+        fail("unterminated string");
+      }
+      char c = text_[position_++];
+      if (c == '"') {
+        return out;
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (position_ >= text_.size()) {
+        fail("unterminated string");
+      }
+      char escape = text_[position_++];
+      switch (escape) {
+      case '"':
+      case '\\':
+      case '/':
+        out += escape;
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'u': {
+        unsigned codePoint = parseHex4();
+        // UTF-16 代理对
+        if (codePoint >= 0xD800 && codePoint < 0xDC00 && consume("\\u")) {
+          unsigned low = parseHex4();
+          if (low >= 0xDC00 && low < 0xE000) {
+            codePoint =
+                0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+          }
+        }
+        appendUtf8(out, codePoint);
+        break;
+      }
+      default:
+        fail("invalid escape");
+      }
+    }
+  }
+};
+
+void dumpString(std::string &out, const std::string &value) {
+  out += '"';
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escape[8];
+        std::snprintf(escape, sizeof(escape), "\\u%04x",
+                      static_cast<unsigned>(c));
+        out += escape;
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+void dumpValue(std::string &out, const Json &value) {
+  if (value.isNull()) {
+    out += "null";
+  } else if (value.isBool()) {
+    out += value.asBool() ? "true" : "false";
+  } else if (value.isNumber()) {
+    // 整数不带小数点输出，请求编号和位置都是整数
+    double number = value.asDouble();
+    char buffer[32];
+    std::to_chars_result result;
+    if (std::trunc(number) == number && std::fabs(number) < 9.0e15) {
+      result = std::to_chars(buffer, buffer + sizeof(buffer),
+                             static_cast<int64_t>(number));
+    } else if (std::isfinite(number)) {
+      result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    } else {
+      result = std::to_chars(buffer, buffer + sizeof(buffer), 0);
+    }
+    out.append(buffer, result.ptr);
+  } else if (value.isString()) {
+    dumpString(out, value.asString());
+  } else if (value.isArray()) {
+    out += '[';
+    bool first = true;
+    for (const auto &element : value.asArray()) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      dumpValue(out, element);
+    }
+    out += ']';
+  } else {
+    out += '{';
+    bool first = true;
+    for (const auto &[key, member] : value.asObject()) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      dumpString(out, key);
+      out += ':';
+      dumpValue(out, member);
+    }
+    out += '}';
+  }
+}
+
+} // namespace
+
+Json Json::parse(std::string_view text) {
+  return JsonParser(text).parseDocument();
+}
+
+std::string Json::dump() const {
+  std::string out;
+  dumpValue(out, *this);
+  return out;
+}
+
+bool Json::asBool(bool fallback) const {
+  const bool *value = std::get_if<bool>(&value_);
+  return value ? *value : fallback;
+}
+
+int64_t Json::asInt(int64_t fallback) const {
+  const double *value = std::get_if<double>(&value_);
+  return value ? static_cast<int64_t>(*value) : fallback;
+}
+
+double Json::asDouble(double fallback) const {
+  const double *value = std::get_if<double>(&value_);
+  return value ? *value : fallback;
+}
+
+const std::string &Json::asString() const {
+  static const std::string empty;
+  const std::string *value = std::get_if<std::string>(&value_);
+  return value ? *value : empty;
+}
+
+const Json::Array &Json::asArray() const {
+  static const Array empty;
+  const Array *value = std::get_if<Array>(&value_);
+  return value ? *value : empty;
+}
+
+const Json::Object &Json::asObject() const {
+  static const Object empty;
+  const Object *value = std::get_if<Object>(&value_);
+  return value ? *value : empty;
+}
+
+const Json &Json::operator[](std::string_view key) const {
+  const Object &object = asObject();
+  auto it = object.find(key);
+  return it != object.end() ? it->second : NullValue;
+}
+
+bool Json::contains(std::string_view key) const {
+  const Object &object = asObject();
+  return object.find(key) != object.end();
+}
+
+Json &Json::operator[](const std::string &key) {
+  if (!isObject()) {
+    value_ = Object();
+  }
+  return std::get<Object>(value_)[key];
+}
+
+void Json::push(Json value) {
+  if (!isArray()) {
+    value_ = Array();
+  }
+  std::get<Array>(value_).push_back(std::move(value));
+}
+
+} // namespace lsp
+} // namespace c_hat
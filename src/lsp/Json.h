@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace c_hat {
+namespace lsp {
+
+// 格式错误的 JSON 文本
+class JsonError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// JSON 值（语言服务器协议的消息）
+// 数字统一存为 double，协议中的行号、列号和请求编号都在精确范围内。
+// 访问不存在的成员或类型不符的值时返回空值，缺省字段无需逐个判断。
+class Json {
+public:
+  using Array = std::vector<Json>;
+  using Object = std::map<std::string, Json, std::less<>>;
+
+  Json() = default;
+  Json(std::nullptr_t) {}
+  Json(bool value) : value_(value) {}
+  Json(int value) : value_(static_cast<double>(value)) {}
+  Json(int64_t value) : value_(static_cast<double>(value)) {}
+  Json(size_t value) : value_(static_cast<double>(value)) {}
+  Json(double value) : value_(value) {}
+  Json(const char *value) : value_(std::string(value)) {}
+  Json(std::string value) : value_(std::move(value)) {}
+  Json(std::string_view value) : value_(std::string(value)) {}
+  Json(Array value) : value_(std::move(value)) {}
+  Json(Object value) : value_(std::move(value)) {}
+
+  // 解析 JSON 文本，格式错误时抛出 JsonError
+  static Json parse(std::string_view text);
+
+  // 紧凑格式的 JSON 文本
+  std::string dump() const;
+
+  bool isNull() const { return value_.index() == 0; }
+  bool isBool() const { return value_.index() == 1; }
+  bool isNumber() const { return value_.index() == 2; }
+  bool isString() const { return value_.index() == 3; }
+  bool isArray() const { return value_.index() == 4; }
+  bool isObject() const { return value_.index() == 5; }
+
+  bool asBool(bool fallback = false) const;
+  int64_t asInt(int64_t fallback = 0) const;
+  double asDouble(double fallback = 0) const;
+  const std::string &asString() const;
+  const Array &asArray() const;
+  const Object &asObject() const;
+
+  // 对象成员，不存在时返回空值
+  const Json &operator[](std::string_view key) const;
+  bool contains(std::string_view key) const;
+
+  // 设置对象成员，空值先变为对象
+  Json &operator[](const std::string &key);
+
+  // 数组末尾添加元素，空值先变为数组
+  void push(Json value);
+
+  bool operator==(const Json &other) const { return value_ == other.value_; }
+
+private:
+  std::variant<std::monostate, bool, double, std::string, Array, Object>
+      value_;
+};
+
+} // namespace lsp
+} // namespace c_hat
@@ -0,0 +1,327 @@
+#include "LanguageServer.h"
+#include "../semantic/ModuleGraph.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace c_hat {
+namespace lsp {
+
+namespace {
+
+// JSON-RPC 错误码
+constexpr int ParseError = -32700;
+constexpr int InvalidRequest = -32600;
+constexpr int MethodNotFound = -32601;
+constexpr int InvalidParams = -32602;
+
+Json toJson(Position position) {
+  Json json;
+  json["line"] = position.line;
+  json["character"] = position.character;
+  return json;
+}
+
+Json toJson(const Range &range) {
+  Json json;
+  json["start"] = toJson(range.start);
+  json["end"] = toJson(range.end);
+  return json;
+}
+
+Position toPosition(const Json &json) {
+  return {static_cast<int>(json["line"].asInt()),
+          static_cast<int>(json["character"].asInt())};
+}
+
+} // namespace
+
+LanguageServer::LanguageServer(std::istream &input, std::ostream &output,
+                               semantic::ModuleGraph *moduleGraph)
+    : input_(input), output_(output), moduleGraph_(moduleGraph) {}
+
+LanguageServer::~LanguageServer() = default;
+
+int LanguageServer::run() {
+  while (auto text = readMessage()) {
+    Json message;
+    try {
+      message = Json::parse(*text);
+    } catch (const JsonError &e) {
+      respondError(nullptr, ParseError, e.what());
+      continue;
+    }
+    if (!handleMessage(message)) {
+      return shutdownRequested_ ? 0 : 1;
+    }
+  }
+  return 1;
+}
+
+std::optional<std::string> LanguageServer::readMessage() {
+  // 头部各行以 \r\n 结尾，空行之后是消息内容
+  size_t length = 0;
+  bool hasLength = false;
+  std::string line;
+  while (std::getline(input_, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      if (!hasLength) {
+        continue;
+      }
+      std::string content(length, '\0');
+      if (!input_.read(content.data(), static_cast<std::streamsize>(length))) {
+        return std::nullopt;
+      }
+      return content;
+    }
+    static constexpr std::string_view Header = "Content-Length:";
+    if (line.size() > Header.size() &&
+        std::equal(Header.begin(), Header.end(), line.begin(),
+                   [](char a, char b) {
+                     return std::tolower(static_cast<unsigned char>(a)) ==
+                            std::tolower(static_cast<unsigned char>(b));
+                   })) {
+      try {
+        length = std::stoul(line.substr(Header.size()));
+        hasLength = true;
+      } catch (const std::exception &) {
+        hasLength = false;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+void LanguageServer::send(const Json &message) {
+  std::string content = message.dump();
+  output_ << "Content-Length: " << content.size() << "\r\n\r\n" << content;
+  output_.flush();
+}
+
+void LanguageServer::respond(const Json &id, Json result) {
+  Json response;
+  response["jsonrpc"] = "2.0";
+  response["id"] = id;
+  response["result"] = std::move(result);
+  send(response);
+}
+
+void LanguageServer::respondError(const Json &id, int code,
+                                  const std::string &message) {
+  Json error;
+  error["code"] = code;
+  error["message"] = message;
+  Json response;
+  response["jsonrpc"] = "2.0";
+  response["id"] = id;
+  response["error"] = std::move(error);
+  send(response);
+}
+
+bool LanguageServer::handleMessage(const Json &message) {
+  const std::string &method = message["method"].asString();
+  const Json &params = message["params"];
+  bool isRequest = message.contains("id");
+  const Json &id = message["id"];
+
+  if (method.empty()) {
+    // 客户端对服务器请求的响应，服务器不发请求，直接忽略
+    if (!message.contains("result") && !message.contains("error")) {
+      respondError(id, InvalidRequest, "Missing method");
+    }
+    return true;
+  }
+
+  if (method == "exit") {
+    return false;
+  }
+  if (shutdownRequested_ && isRequest) {
+    respondError(id, InvalidRequest, "Server is shutting down");
+    return true;
+  }
+
+  // 进程一直运行，见过的名称都留在驻留表中
+  if (lexer::NameInterner::global().size() > nameResetThreshold_) {
+    releaseInternedNames();
+  }
+
+  if (method == "initialize") {
+    respond(id, initialize());
+  } else if (method == "shutdown") {
+    shutdownRequested_ = true;
+    respond(id, nullptr);
+  } else if (method == "textDocument/didOpen") {
+    didOpen(params);
+  } else if (method == "textDocument/didChange") {
+    didChange(params);
+  } else if (method == "textDocument/didClose") {
+    didClose(params);
+  } else if (method == "textDocument/hover") {
+    if (!findDocument(params)) {
+      respondError(id, InvalidParams, "Unknown document");
+    } else {
+      respond(id, hover(params));
+    }
+  } else if (method == "textDocument/definition") {
+    if (!findDocument(params)) {
+      respondError(id, InvalidParams, "Unknown document");
+    } else {
+      respond(id, definition(params));
+    }
+  } else if (isRequest) {
+    respondError(id, MethodNotFound, "Method not found: " + method);
+  }
+  // 其他通知（initialized、$/cancelRequest 等）不需要处理
+  return true;
+}
+
+Json LanguageServer::initialize() {
+  Json sync;
+  sync["openClose"] = true;
+  // 2：增量同步，客户端只发送修改的范围
+  sync["change"] = 2;
+  Json capabilities;
+  capabilities["textDocumentSync"] = std::move(sync);
+  capabilities["hoverProvider"] = true;
+  capabilities["definitionProvider"] = true;
+
+  Json info;
+  info["name"] = "chc";
+  Json result;
+  result["capabilities"] = std::move(capabilities);
+  result["serverInfo"] = std::move(info);
+  return result;
+}
+
+Document *LanguageServer::findDocument(const Json &params) {
+  auto it = documents_.find(params["textDocument"]["uri"].asString());
+  return it != documents_.end() ? it->second.get() : nullptr;
+}
+
+void LanguageServer::updateDocument(const std::string &uri,
+                                    Document &document) {
+  auto start = std::chrono::steady_clock::now();
+  lastStats_ = document.update();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  // 日志写到错误输出，标准输出只用于协议消息
+  std::cerr << "Updated " << uri << " in " << elapsed.count() << " us ("
+            << lastStats_.reparsed << " of " << lastStats_.declarations
+            << " declarations reparsed, " << lastStats_.reanalyzed
+            << " reanalyzed)" << std::endl;
+
+  Json diagnostics = Json::Array();
+  for (const auto &diagnostic : document.getDiagnostics()) {
+    Json item;
+    item["range"] = toJson(diagnostic.range);
+    // 1：错误
+    item["severity"] = 1;
+    item["source"] = "chc";
+    item["message"] = diagnostic.message;
+    diagnostics.push(std::move(item));
+  }
+  Json params;
+  params["uri"] = uri;
+  params["diagnostics"] = std::move(diagnostics);
+  Json notification;
+  notification["jsonrpc"] = "2.0";
+  notification["method"] = "textDocument/publishDiagnostics";
+  notification["params"] = std::move(params);
+  send(notification);
+}
+
+void LanguageServer::releaseInternedNames() {
+  // 文档的语法树、分析器和模块图中的符号都使用旧的名称编号，
+  // 清空驻留表之前全部丢弃
+  std::vector<std::pair<std::string, std::string>> texts;
+  for (const auto &[uri, document] : documents_) {
+    texts.emplace_back(uri, document->getText());
+  }
+  documents_.clear();
+  if (moduleGraph_) {
+    moduleGraph_->clear();
+  }
+  lexer::NameInterner::global().reset();
+
+  // 文本没有变化，诊断与已发布的相同，不再重新发布
+  for (auto &[uri, text] : texts) {
+    auto &document = documents_[uri];
+    document = std::make_unique<Document>(std::move(text), moduleGraph_);
+    lastStats_ = document->update();
+  }
+}
+
+void LanguageServer::didOpen(const Json &params) {
+  const Json &textDocument = params["textDocument"];
+  const std::string &uri = textDocument["uri"].asString();
+  auto &document = documents_[uri];
+  document = std::make_unique<Document>(textDocument["text"].asString(),
+                                        moduleGraph_);
+  updateDocument(uri, *document);
+}
+
+void LanguageServer::didChange(const Json &params) {
+  Document *document = findDocument(params);
+  if (!document) {
+    return;
+  }
+  // 修改按顺序应用，每个修改的范围基于前一个修改之后的文本
+  for (const auto &change : params["contentChanges"].asArray()) {
+    std::optional<Range> range;
+    if (change.contains("range")) {
+      const Json &json = change["range"];
+      range = Range{toPosition(json["start"]), toPosition(json["end"])};
+    }
+    document->edit(range, change["text"].asString());
+  }
+  updateDocument(params["textDocument"]["uri"].asString(), *document);
+}
+
+void LanguageServer::didClose(const Json &params) {
+  const std::string &uri = params["textDocument"]["uri"].asString();
+  if (!documents_.erase(uri)) {
+    return;
+  }
+  // 清除已关闭文档的诊断
+  Json clear;
+  clear["uri"] = uri;
+  clear["diagnostics"] = Json::Array();
+  Json notification;
+  notification["jsonrpc"] = "2.0";
+  notification["method"] = "textDocument/publishDiagnostics";
+  notification["params"] = std::move(clear);
+  send(notification);
+}
+
+Json LanguageServer::hover(const Json &params) {
+  auto text = findDocument(params)->hover(toPosition(params["position"]));
+  if (!text) {
+    return nullptr;
+  }
+  Json contents;
+  contents["kind"] = "markdown";
+  contents["value"] = *text;
+  Json result;
+  result["contents"] = std::move(contents);
+  return result;
+}
+
+Json LanguageServer::definition(const Json &params) {
+  auto range = findDocument(params)->definition(toPosition(params["position"]));
+  if (!range) {
+    return nullptr;
+  }
+  Json location;
+  location["uri"] = params["textDocument"]["uri"];
+  location["range"] = toJson(*range);
+  return location;
+}
+
+} // namespace lsp
+} // namespace c_hat
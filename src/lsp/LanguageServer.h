@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Document.h"
+#include "Json.h"
+#include "../lexer/NameInterner.h"
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace c_hat {
+namespace lsp {
+
+// 语言服务器
+// 从输入流读取带 Content-Length 头的 JSON-RPC 消息，逐个处理后把响应和
+// 通知写到输出流（通常是标准输入和标准输出）。支持打开、增量修改和关闭
+// 文档，悬停提示和跳转到定义；每次修改后重新分析文档并发布诊断。
+class LanguageServer {
+public:
+  // moduleGraph 为 nullptr 时文档不能导入模块
+  LanguageServer(std::istream &input, std::ostream &output,
+                 semantic::ModuleGraph *moduleGraph);
+  ~LanguageServer();
+
+  LanguageServer(const LanguageServer &) = delete;
+  LanguageServer &operator=(const LanguageServer &) = delete;
+
+  // 处理消息直到收到 exit 或输入结束，返回进程的退出码
+  // （先收到 shutdown 时为 0，否则为 1）
+  int run();
+
+  // 处理一条消息，返回是否继续
+  bool handleMessage(const Json &message);
+
+  // 最近一次更新文档的统计（用于测试和日志）
+  const UpdateStats &getLastUpdateStats() const { return lastStats_; }
+
+  // 驻留的名称超过 threshold 个时，在处理下一条消息前丢弃全部分析结果、
+  // 清空名称驻留表并重新分析打开的文档（默认为
+  // NameInterner::ResetThreshold）
+  void setNameResetThreshold(size_t threshold) {
+    nameResetThreshold_ = threshold;
+  }
+
+private:
+  std::istream &input_;
+  std::ostream &output_;
+  semantic::ModuleGraph *moduleGraph_;
+  std::map<std::string, std::unique_ptr<Document>> documents_;
+  UpdateStats lastStats_;
+  bool shutdownRequested_ = false;
+  size_t nameResetThreshold_ = lexer::NameInterner::ResetThreshold;
+
+  // 读取一条消息，输入结束时返回空
+  std::optional<std::string> readMessage();
+  void send(const Json &message);
+  void respond(const Json &id, Json result);
+  void respondError(const Json &id, int code, const std::string &message);
+
+  Document *findDocument(const Json &params);
+  void updateDocument(const std::string &uri, Document &document);
+  // 清空名称驻留表，重新创建并分析打开的文档
+  void releaseInternedNames();
+
+  Json initialize();
+  void didOpen(const Json &params);
+  void didChange(const Json &params);
+  void didClose(const Json &params);
+  Json hover(const Json &params);
+  Json definition(const Json &params);
+};
+
+} // namespace lsp
+} // namespace c_hat
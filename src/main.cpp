@@ -1,21 +1,47 @@
 #include "lexer/Lexer.h"
+#include "lexer/NameInterner.h"
+#include "lexer/SourceBuffer.h"
+#include "lsp/LanguageServer.h"
 #include "parser/Parser.h"
+#include "semantic/AnalysisPipeline.h"
+#include "semantic/BuildDatabase.h"
+#include "semantic/FunctionSymbol.h"
 #include "semantic/SemanticAnalyzer.h"
+#include "semantic/ThreadPool.h"
+#include "server/CompileServer.h"
+#include "server/FileWatcher.h"
+#include "llvm/HotReloadSession.h"
 #include "llvm/LLVMCodeGenerator.h"
 #include <argparse/argparse.hpp>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <print>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
 #include <windows.h>
 #else
+#include <cerrno>
+#include <csignal>
+#include <cstring>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #ifdef USE_LLD
@@ -46,14 +72,715 @@ fs::path modulePathToFilePath(const std::vector<std::string> &modulePath,
   return filePath;
 }
 
+// 只读打开的文件描述符，离开作用域时关闭
+class InputFd {
+public:
+  explicit InputFd(const std::string &path) {
+#ifdef _WIN32
+    fd_ = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    fd_ = open(path.c_str(), O_RDONLY);
+#endif
+  }
+  ~InputFd() {
+    if (fd_ >= 0) {
+#ifdef _WIN32
+      _close(fd_);
+#else
+      close(fd_);
+#endif
+    }
+  }
+  InputFd(const InputFd &) = delete;
+  InputFd &operator=(const InputFd &) = delete;
+
+  int get() const { return fd_; }
+
+private:
+  int fd_;
+};
+
 extern "C" {
 int c_hat_printf(const char *format, ...);
 }
 
-int main(int argc, char *argv[]) {
+// 命令行选项
+struct DriverOptions {
+  std::string outputFile;
+  bool dumpAst = false;
+  bool dumpIR = false;
+  // 语义分析后输出各个缓存的统计
+  bool dumpStats = false;
+  bool emitLLVM = false;
+  bool emitObj = false;
+  bool emitAsm = false;
+  size_t jobs = 1;
+  // 标准库路径和 -M 指定的模块搜索路径
+  std::vector<std::string> modulePaths;
+  std::string moduleCacheDir;
+  bool noAstCache = false;
+  // 增量构建的构建目录，为空时全部重新编译
+  std::string buildDir;
+  std::vector<std::string> libraries;
+  std::string cLibPath;
+  std::string cLibFile;
+};
+
+// 按命令行选项配置导入模块的加载方式
+static void configureModuleGraph(c_hat::semantic::ModuleGraph &moduleGraph,
+                                 const DriverOptions &options) {
+  auto &loader = moduleGraph.getLoader();
+  loader.setInterfaceCacheDir(options.moduleCacheDir);
+  loader.setAstCacheEnabled(!options.noAstCache);
+  loader.setBuildDir(options.buildDir);
+  if (!options.moduleCacheDir.empty()) {
+    // AST 缓存放在单独的子目录中，由 AstCache 以 0700 权限创建
+    loader.setAstCacheDir(
+        (fs::path(options.moduleCacheDir) / "ast-cache").string());
+    loader.setModuleIndexFile(
+        (fs::path(options.moduleCacheDir) / "modules.chx").string());
+  }
+  moduleGraph.setJobs(options.jobs);
+}
+
+// 编译服务器在请求之间保留的状态
+// 模块搜索路径和缓存设置相同、读取过的模块源码都没有变化时，下一个请求
+// 直接使用已分析的模块（包括标准库）
+struct ServerCache {
+  std::vector<std::string> modulePaths;
+  std::string moduleCacheDir;
+  bool noAstCache = false;
+  std::shared_ptr<c_hat::semantic::ModuleGraph> moduleGraph;
+  // 当前请求的客户端是否仍然连接
+  std::function<bool()> clientConnected;
+};
+
+// 编译服务器在子进程中运行程序：程序崩溃、调用 exit() 或不结束都不会
+// 影响服务器，子进程沿用服务器中已经初始化的 JIT。客户端断开时结束
+// 子进程。返回程序的退出码，程序被信号结束时返回 128 加信号编号
+static int runIsolated(const std::function<int()> &run,
+                       const std::function<bool()> &clientConnected) {
+#ifdef _WIN32
+  return run();
+#else
+  std::cout.flush();
+  std::fflush(nullptr);
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    throw std::runtime_error("Could not start the program: " +
+                             std::string(std::strerror(errno)));
+  }
+  if (pid == 0) {
+    // 子进程不能回到服务器的请求循环中
+    int result = 1;
+    try {
+      result = run();
+    } catch (const std::exception &e) {
+      std::println("\n✗ Error: {}", e.what());
+    }
+    std::cout.flush();
+    std::fflush(nullptr);
+    ::_exit(result);
+  }
+
+  int status = 0;
+  while (::waitpid(pid, &status, WNOHANG) == 0) {
+    if (!clientConnected()) {
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, &status, 0);
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+#endif
+}
+
+// 取得导入模块使用的模块图，没有模块搜索路径时返回 nullptr
+// 编译服务器中尽量沿用上一个请求的模块图
+static std::shared_ptr<c_hat::semantic::ModuleGraph>
+acquireModuleGraph(const DriverOptions &options, ServerCache *cache) {
+  if (options.modulePaths.empty()) {
+    return nullptr;
+  }
+  if (cache && cache->moduleGraph &&
+      cache->modulePaths == options.modulePaths &&
+      cache->moduleCacheDir == options.moduleCacheDir &&
+      cache->noAstCache == options.noAstCache &&
+      cache->moduleGraph->getLoader().isUpToDate()) {
+    cache->moduleGraph->setJobs(options.jobs);
+    cache->moduleGraph->dropFailedModules();
+    return cache->moduleGraph;
+  }
+
+  auto moduleGraph = std::make_shared<c_hat::semantic::ModuleGraph>(
+      std::make_unique<c_hat::semantic::ModuleLoader>(options.modulePaths));
+  configureModuleGraph(*moduleGraph, options);
+  if (cache) {
+    cache->modulePaths = options.modulePaths;
+    cache->moduleCacheDir = options.moduleCacheDir;
+    cache->noAstCache = options.noAstCache;
+    cache->moduleGraph = moduleGraph;
+  }
+  return moduleGraph;
+}
+
+// 编译服务器和监视模式在两次构建之间调用：驻留的名称过多时丢弃保留的
+// 模块图（模块的符号和语法树使用旧的名称编号），然后清空名称驻留表
+static void releaseInternedNames(ServerCache &cache) {
+  auto &interner = c_hat::lexer::NameInterner::global();
+  if (interner.size() > c_hat::lexer::NameInterner::ResetThreshold) {
+    cache.moduleGraph.reset();
+    interner.reset();
+  }
+}
+
+// 读取项目清单：每行一个源文件（相对清单所在目录），# 之后为注释
+static std::vector<std::string>
+readProjectManifest(const std::string &manifestPath) {
+  std::ifstream manifest(manifestPath);
+  if (!manifest) {
+    throw std::runtime_error("Could not open project manifest: " +
+                             manifestPath);
+  }
+
+  fs::path baseDir = fs::path(manifestPath).parent_path();
+  std::vector<std::string> files;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    line = line.substr(0, line.find('#'));
+    auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+      continue;
+    }
+    auto last = line.find_last_not_of(" \t\r");
+    fs::path file = line.substr(first, last - first + 1);
+    files.push_back((file.is_absolute() ? file : baseDir / file).string());
+  }
+  return files;
+}
+
+// 各翻译单元输出文件的基本名，同名的源文件依次加序号区分
+static std::vector<std::string>
+outputBaseNames(const std::vector<std::string> &inputFiles) {
+  std::vector<std::string> baseNames;
+  std::unordered_map<std::string, int> counts;
+  for (const auto &inputFile : inputFiles) {
+    std::string stem = fs::path(inputFile).stem().string();
+    int count = counts[stem]++;
+    baseNames.push_back(count == 0 ? stem : std::format("{}_{}", stem, count));
+  }
+  return baseNames;
+}
+
+// 链接目标文件，生成可执行文件
+static bool linkExecutable(const std::vector<std::string> &objectFiles,
+                           const std::string &exeOutputFile,
+                           const DriverOptions &options) {
+  std::string outArg = std::format("/OUT:{}", exeOutputFile);
+
+  std::vector<std::string> argsStr;
+  argsStr.push_back("lld-link");
+  argsStr.push_back(outArg);
+  argsStr.push_back("/DEFAULTLIB:libcmt");
+  argsStr.push_back("/DEFAULTLIB:oldnames");
+
+  std::vector<std::string> libPaths = {
+      "C:/Program Files/Microsoft Visual "
+      "Studio/2022/Community/VC/Tools/MSVC/14.44.35207/lib/x64",
+      "C:/Program Files (x86)/Windows Kits/10/Lib/10.0.26100.0/ucrt/x64",
+      "C:/Program Files (x86)/Windows Kits/10/Lib/10.0.26100.0/um/x64"};
+
+  if (!options.cLibPath.empty()) {
+    libPaths.push_back(options.cLibPath);
+  }
+
+  for (const auto &path : libPaths) {
+    argsStr.push_back("/LIBPATH:" + path);
+  }
+
+  for (const auto &objectFile : objectFiles) {
+    argsStr.push_back(objectFile);
+  }
+
+  if (!options.cLibFile.empty()) {
+    argsStr.push_back(options.cLibFile);
+  }
+
+  for (const auto &lib : options.libraries) {
+    argsStr.push_back(lib);
+  }
+
+  std::println("\nLinking with LLD...");
+
+#ifdef USE_LLD
+  std::vector<const char *> args;
+  for (const auto &arg : argsStr) {
+    args.push_back(arg.c_str());
+  }
+
+  std::vector<lld::DriverDef> drivers = {{lld::WinLink, &lld::coff::link}};
+
+  lld::Result result =
+      lld::lldMain(llvm::ArrayRef<const char *>(args.data(), args.size()),
+                   llvm::outs(), llvm::errs(), drivers);
+
+  if (result.retCode == 0) {
+    std::println("\n✓ Executable generated: {}", exeOutputFile);
+    return true;
+  }
+  std::println("\n✗ Linking failed with code: {}", result.retCode);
+  return false;
+#else
+  std::string linkCommand = "link.exe";
+  linkCommand += " /OUT:" + exeOutputFile;
+  linkCommand += " /DEFAULTLIB:libcmt";
+  linkCommand += " /DEFAULTLIB:oldnames";
+
+  for (const auto &path : libPaths) {
+    linkCommand += " /LIBPATH:" + path;
+  }
+
+  for (const auto &objectFile : objectFiles) {
+    linkCommand += " " + objectFile;
+  }
+
+  if (!options.cLibFile.empty()) {
+    linkCommand += " " + options.cLibFile;
+  }
+
+  for (const auto &lib : options.libraries) {
+    linkCommand += " " + lib;
+  }
+
+  int linkResult = std::system(linkCommand.c_str());
+
+  if (linkResult == 0) {
+    std::println("\n✓ Executable generated: {}", exeOutputFile);
+    return true;
+  }
+  std::println("\n✗ Linking failed with code: {}", linkResult);
+  return false;
+#endif
+}
+
+// 把多个源文件作为独立的翻译单元编译
+// 解析、语义分析和代码生成都在 -j 个线程的线程池中进行，翻译单元共享
+// 一个模块图（导入的模块只分析一次），每个翻译单元有自己的 LLVMContext。
+// 全部目标文件生成后统一链接。
+// 指定了构建目录时增量构建：输出写入构建目录，源码和导入的模块接口都
+// 没有变化、输出文件也还在的翻译单元跳过分析和代码生成。
+static int compileProject(const std::vector<std::string> &inputFiles,
+                          const DriverOptions &options, ServerCache *cache) {
+  size_t count = inputFiles.size();
+  std::println("C hat Compiler (chc)");
+  std::println("Compiling {} files with {} jobs", count, options.jobs);
+
+  std::unique_ptr<c_hat::semantic::BuildDatabase> buildDatabase;
+  if (!options.buildDir.empty()) {
+    // 输出文件直接写入构建目录，第一次构建时先创建它
+    std::error_code ec;
+    fs::create_directories(options.buildDir, ec);
+    buildDatabase = std::make_unique<c_hat::semantic::BuildDatabase>(
+        fs::path(options.buildDir) / "build.chdb");
+  }
+  std::shared_ptr<c_hat::semantic::ModuleGraph> moduleGraph;
+  // 报告重新构建的模块和翻译单元，保存构建数据库
+  auto finish = [&](int exitCode) {
+    if (moduleGraph) {
+      // 编译服务器保留模块图，数据库随本次构建结束
+      moduleGraph->setBuildDatabase(nullptr);
+    }
+    if (buildDatabase) {
+      auto rebuilds = buildDatabase->getRebuilds();
+      std::println("\nRebuilt {} modules and translation units",
+                   rebuilds.size());
+      for (const auto &rebuild : rebuilds) {
+        std::println("  {}: {}", rebuild.name, rebuild.reason);
+      }
+      if (!buildDatabase->save()) {
+        std::println("Warning: Could not write build database: {}",
+                     buildDatabase->getFile().string());
+      }
+    }
+    return exitCode;
+  };
+
+  // 各线程只写自己翻译单元的那一项
+  std::vector<std::unique_ptr<c_hat::ast::Program>> programs(count);
+  std::vector<uint64_t> sourceHashes(count);
+  std::vector<std::string> errors(count);
+  std::mutex outputMutex;
+  auto reportErrors = [&] {
+    bool failed = false;
+    for (size_t i = 0; i < count; ++i) {
+      if (!errors[i].empty()) {
+        std::println("\n✗ {}: {}", inputFiles[i], errors[i]);
+        failed = true;
+      }
+    }
+    return failed;
+  };
+
+  c_hat::semantic::ThreadPool pool(options.jobs);
+
+  // 第一步：并行解析全部源文件
+  for (size_t i = 0; i < count; ++i) {
+    pool.submit([&, i] {
+      try {
+        auto source = c_hat::lexer::SourceBuffer::fromFile(inputFiles[i]);
+        if (!source) {
+          errors[i] = "Could not open file";
+          return;
+        }
+        sourceHashes[i] =
+            c_hat::semantic::hashSourceContent(source->getText());
+        c_hat::parser::Parser parser(source);
+        programs[i] = parser.parseProgram();
+        if (!programs[i]) {
+          errors[i] = "Failed to parse program";
+        }
+      } catch (const std::exception &e) {
+        errors[i] = e.what();
+      }
+    });
+  }
+  pool.wait();
+  if (reportErrors()) {
+    return finish(1);
+  }
+
+  if (options.dumpAst) {
+    for (size_t i = 0; i < count; ++i) {
+      std::println("\n=== Abstract Syntax Tree: {} ===", inputFiles[i]);
+      for (const auto &decl : programs[i]->declarations) {
+        std::println("  - {}", decl->toString());
+      }
+    }
+  }
+
+  // 第二步：一次预取全部翻译单元导入的模块
+  moduleGraph = acquireModuleGraph(options, cache);
+  if (moduleGraph) {
+    moduleGraph->setBuildDatabase(buildDatabase.get());
+    std::vector<const c_hat::ast::Program *> roots;
+    for (const auto &program : programs) {
+      roots.push_back(program.get());
+    }
+    moduleGraph->prefetch(roots);
+  }
+
+  // 第三步：并行分析各翻译单元并生成代码
+  bool link = !options.emitLLVM && !options.emitObj && !options.emitAsm;
+  auto baseNames = outputBaseNames(inputFiles);
+  if (buildDatabase) {
+    for (auto &baseName : baseNames) {
+      baseName = (fs::path(options.buildDir) / baseName).string();
+    }
+  }
+  std::vector<std::string> objectFiles(count);
+  std::atomic<size_t> mainCount = 0;
+  for (size_t i = 0; i < count; ++i) {
+    pool.submit([&, i] {
+      try {
+        std::vector<std::string> outputs;
+        if (options.emitLLVM) {
+          outputs.push_back(baseNames[i] + ".ll");
+        }
+        if (options.emitAsm) {
+          outputs.push_back(baseNames[i] + ".s");
+        }
+        if (options.emitObj || link) {
+          outputs.push_back(baseNames[i] + ".obj");
+          objectFiles[i] = outputs.back();
+        }
+
+        // 增量构建：记下翻译单元导入的模块的接口哈希，与上次构建比较
+        std::string unitName;
+        c_hat::semantic::BuildDatabase::Entry entry;
+        std::string reason;
+        if (buildDatabase) {
+          unitName = fs::weakly_canonical(inputFiles[i]).string();
+          entry.sourceHash = sourceHashes[i];
+          for (const auto &modulePath :
+               c_hat::semantic::ModuleGraph::scanImports(*programs[i])) {
+            std::string moduleName;
+            uint64_t interfaceHash = 0;
+            for (const auto &part : modulePath) {
+              moduleName += (moduleName.empty() ? "" : ".") + part;
+            }
+            try {
+              if (moduleGraph) {
+                interfaceHash =
+                    moduleGraph->import(nullptr, modulePath)->interfaceHash;
+              }
+            } catch (const std::exception &) {
+              // 导入错误留给语义分析报告
+              reason = "import of " + moduleName + " failed";
+            }
+            entry.imports.emplace_back(std::move(moduleName), interfaceHash);
+          }
+          if (reason.empty()) {
+            reason = buildDatabase->checkOutdated(unitName, entry);
+          }
+          for (const auto &output : outputs) {
+            if (reason.empty() && !fs::exists(output)) {
+              reason = "output " + output + " missing";
+            }
+          }
+
+          c_hat::semantic::BuildDatabase::Entry previous;
+          if (reason.empty() && buildDatabase->find(unitName, previous)) {
+            if (previous.hasMain) {
+              ++mainCount;
+            }
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::println("✓ Up to date: {}", inputFiles[i]);
+            return;
+          }
+        }
+
+        // main 函数只需出现在其中一个翻译单元中，链接前统一检查
+        auto analyzer =
+            moduleGraph
+                ? std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                      *moduleGraph, false)
+                : std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                      std::vector<std::string>(), false);
+        analyzer->analyze(*programs[i]);
+        if (analyzer->hasError()) {
+          errors[i] = "Semantic analysis failed";
+          return;
+        }
+        if (options.dumpStats) {
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::println("\n=== Statistics: {} ===", inputFiles[i]);
+          analyzer->dumpStats(std::cout);
+        }
+        if (auto mainSymbol =
+                analyzer->getSymbolTable().lookupSymbol("main")) {
+          if (dynamic_cast<c_hat::semantic::FunctionSymbol *>(
+                  mainSymbol.get())) {
+            entry.hasMain = true;
+            ++mainCount;
+          }
+        }
+
+        c_hat::llvm_codegen::LLVMCodeGenerator codeGen(
+            fs::path(baseNames[i]).filename().string());
+        codeGen.generate(std::move(programs[i]));
+        if (!codeGen.verifyIR()) {
+          errors[i] = "IR verification failed";
+          return;
+        }
+
+        if (options.dumpIR) {
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::println("\n=== LLVM IR: {} ===", inputFiles[i]);
+          codeGen.printIR();
+        }
+        if (options.emitLLVM && !codeGen.writeIRToFile(baseNames[i] + ".ll")) {
+          errors[i] = "Could not write LLVM IR";
+          return;
+        }
+        if (options.emitAsm &&
+            !codeGen.emitAssemblyFile(baseNames[i] + ".s")) {
+          errors[i] = "Could not write assembly file";
+          return;
+        }
+        if (!objectFiles[i].empty() &&
+            !codeGen.emitObjectFile(objectFiles[i])) {
+          errors[i] = "Could not write object file";
+          return;
+        }
+
+        if (buildDatabase) {
+          buildDatabase->record(unitName, std::move(entry));
+          buildDatabase->addRebuild(inputFiles[i], reason);
+        }
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::println("✓ Compiled: {}", inputFiles[i]);
+      } catch (const std::exception &e) {
+        errors[i] = e.what();
+      }
+    });
+  }
+  pool.wait();
+  if (reportErrors()) {
+    return finish(1);
+  }
+
+  if (!link) {
+    return finish(0);
+  }
+
+  if (mainCount != 1) {
+    std::println("\n✗ Error: {}", mainCount == 0
+                                       ? "No main function found"
+                                       : "Multiple main functions found");
+    return finish(1);
+  }
+  std::string exeOutputFile =
+      options.outputFile.empty()
+          ? (fs::path(inputFiles[0]).stem().string() + ".exe")
+          : options.outputFile;
+  return finish(linkExecutable(objectFiles, exeOutputFile, options) ? 0 : 1);
+}
+
+// 监视模式的一次构建：解析、分析输入文件并生成 IR，失败时返回空
+// 导入的模块沿用 cache 中的模块图，只有源码变化了的模块重新分析
+static std::optional<llvm::orc::ThreadSafeModule>
+buildForReload(const std::string &inputFile, const DriverOptions &options,
+               ServerCache &cache) {
+  auto source = c_hat::lexer::SourceBuffer::fromFile(inputFile);
+  if (!source) {
+    std::println("Error: Could not open file: {}", inputFile);
+    return std::nullopt;
+  }
+
+  std::unique_ptr<c_hat::ast::Program> program;
+  {
+    c_hat::parser::Parser parser(source);
+    program = parser.parseProgram();
+  }
+  if (!program) {
+    std::println("Error: Failed to parse program");
+    return std::nullopt;
+  }
+
+  auto moduleGraph = acquireModuleGraph(options, &cache);
+  auto analyzer =
+      moduleGraph ? std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                        *moduleGraph)
+                  : std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                        std::vector<std::string>());
+  if (moduleGraph) {
+    moduleGraph->prefetch(*program);
+  }
+  analyzer->analyze(*program);
+  if (analyzer->hasError()) {
+    std::println("\n✗ Semantic analysis failed!");
+    return std::nullopt;
+  }
+
+  c_hat::llvm_codegen::LLVMCodeGenerator codeGen("c_hat_module");
+  codeGen.generate(std::move(program));
+  if (!codeGen.verifyIR()) {
+    std::println("\n✗ IR verification failed!");
+    return std::nullopt;
+  }
+  if (options.dumpIR) {
+    std::println("\n=== LLVM IR ===");
+    codeGen.printIR();
+  }
+  return codeGen.takeModule();
+}
+
+// 监视模式（--watch --run）：在 JIT 中运行程序，输入文件或导入的模块
+// 源码修改后重新编译，只把内容变化了的函数编译进运行中的 JIT，调用经过
+// 桩转到新代码，程序的状态保留。程序已经结束时重新运行 main。
+// 一直运行到进程被中断。
+static int runWatch(const std::string &inputFile,
+                    const DriverOptions &options) {
+  std::println("C hat Compiler (chc)");
+  std::println("Watching: {}", inputFile);
+
+  c_hat::llvm_codegen::HotReloadSession session;
+  if (!session.isValid()) {
+    return 1;
+  }
+  session.addExternalSymbol("printf", (void *)&printf);
+
+  ServerCache cache;
+  c_hat::server::FileWatcher watcher;
+  watcher.setFiles({inputFile});
+
+  std::thread program;
+  std::atomic<bool> running = false;
+  bool loaded = false;
+  auto start = [&] {
+    if (program.joinable()) {
+      program.join();
+    }
+    running = true;
+    program = std::thread([&] {
+      int result = session.run("main");
+      std::println("\n✓ Program exited with code: {}", result);
+      running = false;
+    });
+  };
+
+  while (true) {
+    releaseInternedNames(cache);
+    std::optional<llvm::orc::ThreadSafeModule> module;
+    try {
+      module = buildForReload(inputFile, options, cache);
+    } catch (const std::exception &e) {
+      std::println("\n✗ Error: {}", e.what());
+    }
+
+    std::vector<std::string> updated;
+    if (module && session.load(std::move(*module), updated)) {
+      if (!loaded) {
+        loaded = true;
+        std::println("\n=== Running with JIT (watching for changes) ===");
+        start();
+      } else {
+        std::println("\n✓ Reloaded {} functions", updated.size());
+        for (const auto &name : updated) {
+          std::println("  {}", name);
+        }
+        if (!running) {
+          start();
+        }
+      }
+    }
+
+    // 导入的模块可能随本次修改增减，每次构建后更新监视的文件
+    std::vector<fs::path> files{inputFile};
+    if (cache.moduleGraph) {
+      for (auto &file : cache.moduleGraph->getLoader().getSourceFiles()) {
+        files.push_back(std::move(file));
+      }
+    }
+    watcher.setFiles(files);
+    for (const auto &file : watcher.wait()) {
+      std::println("\nChanged: {}", file.string());
+    }
+  }
+}
+
+// 语言服务器模式（--lsp）：在标准输入和标准输出上处理语言服务器协议
+// 的消息。标准输出只用于协议消息，其他输出都转到错误输出。
+static int runLanguageServer(const DriverOptions &options) {
+#ifdef _WIN32
+  // 协议按字节计算消息长度，不能转换换行符
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  std::ostream protocol(std::cout.rdbuf());
+  std::cout.rdbuf(std::cerr.rdbuf());
+
+  auto moduleGraph = acquireModuleGraph(options, nullptr);
+  c_hat::lsp::LanguageServer server(std::cin, protocol, moduleGraph.get());
+  int result = server.run();
+  std::cout.rdbuf(protocol.rdbuf());
+  return result;
+}
+
+// 执行一次编译，cache 为编译服务器保留的状态，直接运行时为 nullptr
+static int compilerMain(const std::vector<std::string> &args,
+                        ServerCache *cache) {
   argparse::ArgumentParser argParser("C hat Compiler (chc)");
 
-  argParser.add_argument("input-file").help("Input source file");
+  argParser.add_argument("input-files")
+      .help("Input source files; several files are compiled as separate "
+            "translation units and linked together")
+      .default_value(std::vector<std::string>())
+      .nargs(argparse::nargs_pattern::any);
+  argParser.add_argument("--project")
+      .help("Project manifest listing one source file per line")
+      .default_value(std::string(""));
   argParser.add_argument("-o", "--output")
       .help("Output file name")
       .default_value(std::string(""));
@@ -69,6 +796,11 @@ int main(int argc, char *argv[]) {
       .help("Dump the LLVM IR")
       .default_value(false)
       .implicit_value(true);
+  argParser.add_argument("--dump-stats")
+      .help("Print type relation, overload and generic instantiation cache "
+            "statistics after semantic analysis")
+      .default_value(false)
+      .implicit_value(true);
   argParser.add_argument("--emit-llvm")
       .help("Emit LLVM IR file")
       .default_value(false)
@@ -81,10 +813,31 @@ int main(int argc, char *argv[]) {
       .help("Emit assembly file")
       .default_value(false)
       .implicit_value(true);
+  argParser.add_argument("--pipeline")
+      .help("Overlap parsing and semantic analysis on two threads")
+      .default_value(false)
+      .implicit_value(true);
+  argParser.add_argument("-j", "--jobs")
+      .help("Number of threads for compiling the files of a multi-file or "
+            "--project build and for loading and analyzing imported modules "
+            "(0 = number of hardware threads)")
+      .default_value(0)
+      .scan<'i', int>();
   argParser.add_argument("--run")
       .help("Run the program directly using JIT (no linking required)")
       .default_value(false)
       .implicit_value(true);
+  argParser.add_argument("--watch")
+      .help("With --run: recompile when the input file or imported module "
+            "sources change and hot reload the changed functions into the "
+            "running program")
+      .default_value(false)
+      .implicit_value(true);
+  argParser.add_argument("--lsp")
+      .help("Run as a language server over stdin/stdout, publishing "
+            "diagnostics and answering hover and go-to-definition requests")
+      .default_value(false)
+      .implicit_value(true);
   argParser.add_argument("--stdlib-path")
       .help("Path to the standard library")
       .default_value(std::string(""));
@@ -92,6 +845,21 @@ int main(int argc, char *argv[]) {
       .help("Additional module search paths (can be specified multiple times)")
       .default_value(std::vector<std::string>())
       .append();
+  argParser.add_argument("--module-cache-dir")
+      .help("Directory for precompiled module interfaces (.chi), cached "
+            "module ASTs and the module search-path index; defaults to the "
+            "build directory; without one, imported modules are always "
+            "analyzed from source")
+      .default_value(std::string(""));
+  argParser.add_argument("--build-dir")
+      .help("Build incrementally: outputs and the build database go to this "
+            "directory, and only files whose source or imported module "
+            "interfaces changed are recompiled")
+      .default_value(std::string(""));
+  argParser.add_argument("--no-ast-cache")
+      .help("Always re-parse imported modules instead of loading cached ASTs")
+      .default_value(false)
+      .implicit_value(true);
   argParser.add_argument("-l", "--library")
       .help("Libraries to link")
       .default_value(std::vector<std::string>())
@@ -102,41 +870,138 @@ int main(int argc, char *argv[]) {
   argParser.add_argument("--c-lib-file")
       .help("C standard library file to link")
       .default_value(std::string(""));
+  // 以下三个选项在 main 中处理，这里只为出现在帮助中
+  argParser.add_argument("--server")
+      .help("Run as a compile server that keeps analyzed modules, target "
+            "machines and the JIT warm between requests")
+      .default_value(false)
+      .implicit_value(true);
+  argParser.add_argument("--client")
+      .help("Forward this compilation to a running compile server, "
+            "compiling locally when none is running")
+      .default_value(false)
+      .implicit_value(true);
+  argParser.add_argument("--socket")
+      .help("Unix socket of the compile server")
+      .default_value(std::string(""));
 
   try {
-    argParser.parse_args(argc, argv);
+    argParser.parse_args(args);
   } catch (const std::exception &err) {
     std::println("{}", err.what());
     std::println("{}", argParser.help().str());
     return 1;
   }
 
-  std::string inputFile = argParser.get<std::string>("input-file");
-  std::string outputFile = argParser.get<std::string>("-o");
-  bool dumpAst = argParser.get<bool>("--dump-ast");
+  std::vector<std::string> inputFiles =
+      argParser.get<std::vector<std::string>>("input-files");
+  std::string projectFile = argParser.get<std::string>("--project");
   bool dumpTokens = argParser.get<bool>("--dump-tokens");
-  bool dumpIR = argParser.get<bool>("--dump-ir");
-  bool emitLLVM = argParser.get<bool>("--emit-llvm");
-  bool emitObj = argParser.get<bool>("--emit-obj");
-  bool emitAsm = argParser.get<bool>("--emit-asm");
   bool runJIT = argParser.get<bool>("--run");
+  bool watch = argParser.get<bool>("--watch");
+  bool languageServer = argParser.get<bool>("--lsp");
+  bool pipeline = argParser.get<bool>("--pipeline");
+  int jobs = argParser.get<int>("--jobs");
   std::string stdlibPath = argParser.get<std::string>("--stdlib-path");
-  std::vector<std::string> modulePaths =
-      argParser.get<std::vector<std::string>>("--module-path");
-  std::vector<std::string> libraries =
-      argParser.get<std::vector<std::string>>("--library");
-  std::string cLibPath = argParser.get<std::string>("--c-lib-path");
-  std::string cLibFile = argParser.get<std::string>("--c-lib-file");
-
-  std::ifstream file(inputFile);
-  if (!file.is_open()) {
-    std::println("Error: Could not open file: {}", inputFile);
+
+  DriverOptions options;
+  options.outputFile = argParser.get<std::string>("-o");
+  options.dumpAst = argParser.get<bool>("--dump-ast");
+  options.dumpIR = argParser.get<bool>("--dump-ir");
+  options.dumpStats = argParser.get<bool>("--dump-stats");
+  options.emitLLVM = argParser.get<bool>("--emit-llvm");
+  options.emitObj = argParser.get<bool>("--emit-obj");
+  options.emitAsm = argParser.get<bool>("--emit-asm");
+  options.jobs = jobs > 0 ? static_cast<size_t>(jobs)
+                          : c_hat::semantic::ThreadPool::defaultThreadCount();
+  if (!stdlibPath.empty()) {
+    options.modulePaths.push_back(stdlibPath);
+  }
+  for (const auto &path :
+       argParser.get<std::vector<std::string>>("--module-path")) {
+    options.modulePaths.push_back(path);
+  }
+  options.moduleCacheDir = argParser.get<std::string>("--module-cache-dir");
+  options.noAstCache = argParser.get<bool>("--no-ast-cache");
+  options.buildDir = argParser.get<std::string>("--build-dir");
+  if (options.moduleCacheDir.empty()) {
+    // 增量构建时模块接口默认也放在构建目录中
+    options.moduleCacheDir = options.buildDir;
+  }
+  options.libraries = argParser.get<std::vector<std::string>>("--library");
+  options.cLibPath = argParser.get<std::string>("--c-lib-path");
+  options.cLibFile = argParser.get<std::string>("--c-lib-file");
+
+  if (!projectFile.empty()) {
+    try {
+      for (auto &file : readProjectManifest(projectFile)) {
+        inputFiles.push_back(std::move(file));
+      }
+    } catch (const std::exception &e) {
+      std::println("Error: {}", e.what());
+      return 1;
+    }
+  }
+
+  if (languageServer) {
+    // 文档由客户端通过协议打开，不需要输入文件
+    if (cache) {
+      std::println("Error: --lsp cannot be used through the compile server");
+      return 1;
+    }
+    return runLanguageServer(options);
+  }
+
+  if (inputFiles.empty()) {
+    std::println("Error: No input files");
+    std::println("{}", argParser.help().str());
     return 1;
   }
 
-  std::string source((std::istreambuf_iterator<char>(file)),
-                     std::istreambuf_iterator<char>());
-  file.close();
+  if (watch) {
+    if (!runJIT || inputFiles.size() != 1 || !options.buildDir.empty() ||
+        dumpTokens || pipeline) {
+      std::println("Error: --watch needs --run and a single input file, and "
+                   "cannot be used with --build-dir, --dump-tokens or "
+                   "--pipeline");
+      return 1;
+    }
+    if (cache) {
+      std::println("Error: --watch cannot be used through the compile server");
+      return 1;
+    }
+    return runWatch(inputFiles[0], options);
+  }
+
+  if (inputFiles.size() > 1 || !options.buildDir.empty()) {
+    if (runJIT || dumpTokens || pipeline) {
+      std::println("Error: --run, --dump-tokens and --pipeline take a single "
+                   "input file and cannot be used with --build-dir");
+      return 1;
+    }
+    if (!options.outputFile.empty() &&
+        (options.emitLLVM || options.emitObj || options.emitAsm)) {
+      std::println("Error: -o cannot be used with --emit-* when compiling "
+                   "multiple input files or with --build-dir");
+      return 1;
+    }
+    try {
+      return compileProject(inputFiles, options, cache);
+    } catch (const std::exception &e) {
+      std::println("\n✗ Error: {}", e.what());
+      return 1;
+    }
+  }
+
+  std::string inputFile = inputFiles[0];
+  const std::string &outputFile = options.outputFile;
+
+  // 源码以内存映射方式打开，词法单元直接引用映射的文本
+  auto source = c_hat::lexer::SourceBuffer::fromFile(inputFile);
+  if (!source) {
+    std::println("Error: Could not open file: {}", inputFile);
+    return 1;
+  }
 
   std::println("C hat Compiler (chc)");
   std::println("Compiling: {}", inputFile);
@@ -144,7 +1009,13 @@ int main(int argc, char *argv[]) {
   try {
     if (dumpTokens) {
       std::println("\n=== Tokens ===");
-      c_hat::lexer::Lexer lexer(source);
+      // 词法单元边输出边丢弃，分块读取输入，内存占用与文件大小无关
+      InputFd input(inputFile);
+      if (input.get() < 0) {
+        std::println("Error: Could not open file: {}", inputFile);
+        return 1;
+      }
+      c_hat::lexer::Lexer lexer(c_hat::lexer::ChunkedInput{input.get()});
       while (auto token = lexer.nextToken()) {
         std::println("  {}: {}", static_cast<int>(token->getType()),
                      token->getValue());
@@ -154,8 +1025,27 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    c_hat::parser::Parser parser(source);
-    auto program = parser.parseProgram();
+    auto moduleGraph = acquireModuleGraph(options, cache);
+    auto analyzer =
+        moduleGraph ? std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                          *moduleGraph)
+                    : std::make_unique<c_hat::semantic::SemanticAnalyzer>(
+                          std::vector<std::string>());
+    auto &semanticAnalyzer = *analyzer;
+
+    std::unique_ptr<c_hat::ast::Program> program;
+    {
+      // 语法分析器连同全部词法单元在解析结束后释放，不会保留到代码生成阶段
+      c_hat::parser::Parser parser(source);
+      if (pipeline) {
+        // 流水线模式：后台线程解析，当前线程同时收集顶层声明的签名
+        c_hat::semantic::AnalysisPipeline analysisPipeline(parser,
+                                                           semanticAnalyzer);
+        program = analysisPipeline.run();
+      } else {
+        program = parser.parseProgram();
+      }
+    }
 
     if (!program) {
       std::println("Error: Failed to parse program");
@@ -165,26 +1055,22 @@ int main(int argc, char *argv[]) {
     std::cout << "Debug: Program parsed successfully, declarations count: "
               << program->declarations.size() << std::endl;
 
-    if (dumpAst) {
+    if (options.dumpAst) {
       std::println("\n=== Abstract Syntax Tree ===");
       for (const auto &decl : program->declarations) {
         std::println("  - {}", decl->toString());
       }
     }
 
-    std::vector<std::string> allModulePaths;
-    if (!stdlibPath.empty()) {
-      allModulePaths.push_back(stdlibPath);
-    }
-    for (const auto &path : modulePaths) {
-      allModulePaths.push_back(path);
+    if (!pipeline) {
+      std::cout << "Debug: Before semantic analysis" << std::endl;
+      if (moduleGraph) {
+        moduleGraph->prefetch(*program);
+      }
+      semanticAnalyzer.analyze(*program);
+      std::cout << "Debug: After semantic analysis" << std::endl;
     }
 
-    c_hat::semantic::SemanticAnalyzer semanticAnalyzer(allModulePaths);
-    std::cout << "Debug: Before semantic analysis" << std::endl;
-    semanticAnalyzer.analyze(*program);
-    std::cout << "Debug: After semantic analysis" << std::endl;
-
     if (semanticAnalyzer.hasError()) {
       std::println("\n✗ Semantic analysis failed!");
       return 1;
@@ -192,6 +1078,11 @@ int main(int argc, char *argv[]) {
 
     std::cout << "\n✓ Parsing and semantic analysis successful!" << std::endl;
 
+    if (options.dumpStats) {
+      std::println("\n=== Statistics ===");
+      semanticAnalyzer.dumpStats(std::cout);
+    }
+
     std::cout << "\nStarting code generation..." << std::endl;
     c_hat::llvm_codegen::LLVMCodeGenerator codeGen("c_hat_module");
     std::cout << "Debug: Before code generation" << std::endl;
@@ -204,7 +1095,7 @@ int main(int argc, char *argv[]) {
       return 1;
     }
 
-    if (dumpIR) {
+    if (options.dumpIR) {
       std::println("\n=== LLVM IR ===");
       codeGen.printIR();
     }
@@ -217,7 +1108,9 @@ int main(int argc, char *argv[]) {
 
       codeGen.addExternalSymbol("printf", (void *)&printf);
 
-      int result = codeGen.runJIT("main");
+      int result = cache ? runIsolated([&] { return codeGen.runJIT("main"); },
+                                       cache->clientConnected)
+                         : codeGen.runJIT("main");
       std::println("\n✓ Program exited with code: {}", result);
       return result;
     }
@@ -226,7 +1119,7 @@ int main(int argc, char *argv[]) {
     std::string exeOutputFile =
         outputFile.empty() ? (baseName + ".exe") : outputFile;
 
-    if (emitLLVM) {
+    if (options.emitLLVM) {
       std::string llvmOutputFile =
           outputFile.empty() ? (baseName + ".ll") : outputFile;
       if (codeGen.writeIRToFile(llvmOutputFile)) {
@@ -234,7 +1127,7 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    if (emitObj) {
+    if (options.emitObj) {
       if (outputFile.empty()) {
         objOutputFile = baseName + ".obj";
       } else {
@@ -245,7 +1138,7 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    if (emitAsm) {
+    if (options.emitAsm) {
       std::string asmOutputFile =
           outputFile.empty() ? (baseName + ".s") : outputFile;
       if (codeGen.emitAssemblyFile(asmOutputFile)) {
@@ -253,90 +1146,11 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    if (!emitLLVM && !emitObj && !emitAsm) {
+    if (!options.emitLLVM && !options.emitObj && !options.emitAsm) {
       if (codeGen.emitObjectFile(objOutputFile)) {
         std::println("\n✓ Object file written to: {}", objOutputFile);
 
-        std::string outArg = std::format("/OUT:{}", exeOutputFile);
-
-        std::vector<std::string> argsStr;
-        argsStr.push_back("lld-link");
-        argsStr.push_back(outArg);
-        argsStr.push_back("/DEFAULTLIB:libcmt");
-        argsStr.push_back("/DEFAULTLIB:oldnames");
-
-        std::vector<std::string> libPaths = {
-            "C:/Program Files/Microsoft Visual "
-            "Studio/2022/Community/VC/Tools/MSVC/14.44.35207/lib/x64",
-            "C:/Program Files (x86)/Windows Kits/10/Lib/10.0.26100.0/ucrt/x64",
-            "C:/Program Files (x86)/Windows Kits/10/Lib/10.0.26100.0/um/x64"};
-
-        if (!cLibPath.empty()) {
-          libPaths.push_back(cLibPath);
-        }
-
-        for (const auto &path : libPaths) {
-          argsStr.push_back("/LIBPATH:" + path);
-        }
-
-        argsStr.push_back(objOutputFile);
-
-        if (!cLibFile.empty()) {
-          argsStr.push_back(cLibFile);
-        }
-
-        for (const auto &lib : libraries) {
-          argsStr.push_back(lib);
-        }
-
-        std::println("\nLinking with LLD...");
-
-#ifdef USE_LLD
-        std::vector<const char *> args;
-        for (const auto &arg : argsStr) {
-          args.push_back(arg.c_str());
-        }
-
-        std::vector<lld::DriverDef> drivers = {
-            {lld::WinLink, &lld::coff::link}};
-
-        lld::Result result =
-            lld::lldMain(llvm::ArrayRef<const char *>(args.data(), args.size()),
-                         llvm::outs(), llvm::errs(), drivers);
-
-        if (result.retCode == 0) {
-          std::println("\n✓ Executable generated: {}", exeOutputFile);
-        } else {
-          std::println("\n✗ Linking failed with code: {}", result.retCode);
-        }
-#else
-        std::string linkCommand = "link.exe";
-        linkCommand += " /OUT:" + exeOutputFile;
-        linkCommand += " /DEFAULTLIB:libcmt";
-        linkCommand += " /DEFAULTLIB:oldnames";
-
-        for (const auto &path : libPaths) {
-          linkCommand += " /LIBPATH:" + path;
-        }
-
-        linkCommand += " " + objOutputFile;
-
-        if (!cLibFile.empty()) {
-          linkCommand += " " + cLibFile;
-        }
-
-        for (const auto &lib : libraries) {
-          linkCommand += " " + lib;
-        }
-
-        int linkResult = std::system(linkCommand.c_str());
-
-        if (linkResult == 0) {
-          std::println("\n✓ Executable generated: {}", exeOutputFile);
-        } else {
-          std::println("\n✗ Linking failed with code: {}", linkResult);
-        }
-#endif
+        linkExecutable({objOutputFile}, exeOutputFile, options);
       }
     }
 
@@ -347,3 +1161,71 @@ int main(int argc, char *argv[]) {
 
   return 0;
 }
+
+// 编译服务器：在套接字上逐个处理客户端转发的编译请求
+// 分析过的模块在请求之间保留；LLVM 目标只初始化一次，目标机器和 JIT
+// 也在进程内复用，小程序的编译运行不再付出进程启动的开销
+static int runServer(const fs::path &socketPath) {
+  ServerCache cache;
+  c_hat::server::CompileServer server(
+      socketPath, [&cache](const c_hat::server::CompileRequest &request) {
+        releaseInternedNames(cache);
+        return compilerMain(request.args, &cache);
+      });
+  cache.clientConnected = [&server] { return server.isClientConnected(); };
+  try {
+    server.listen();
+  } catch (const std::exception &e) {
+    std::println("Error: {}", e.what());
+    return 1;
+  }
+  std::println("chc server listening on {}", socketPath.string());
+  server.run();
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  // 服务器和客户端选项在解析其余参数之前处理，其余参数原样转发
+  bool serverMode = false;
+  bool clientMode = false;
+  fs::path socketPath;
+  std::vector<std::string> args;
+  for (int i = 0; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--server") {
+      serverMode = true;
+    } else if (arg == "--client") {
+      clientMode = true;
+    } else if (arg == "--socket" && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else {
+      args.push_back(std::move(arg));
+    }
+  }
+  if (socketPath.empty()) {
+    socketPath = c_hat::server::defaultSocketPath();
+  }
+
+  if (serverMode) {
+    return runServer(socketPath);
+  }
+  if (clientMode) {
+    // 只有连不上服务器时才在本地编译；请求发出后中断的连接可能已经
+    // 执行了一部分，重新编译会重复程序的输出
+    std::error_code ec;
+    std::optional<int> exitCode;
+    try {
+      exitCode = c_hat::server::forwardRequest(
+          socketPath, {args, fs::current_path(ec).string()});
+    } catch (const std::exception &e) {
+      std::println("Error: {}", e.what());
+      return 1;
+    }
+    if (exitCode) {
+      return *exitCode;
+    }
+    std::println("Note: No compile server on {}, compiling locally",
+                 socketPath.string());
+  }
+  return compilerMain(args, nullptr);
+}
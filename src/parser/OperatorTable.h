@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../ast/expressions/BinaryExpr.h"
+#include "../lexer/TokenType.h"
+#include <array>
+#include <cstddef>
+
+namespace c_hat {
+namespace parser {
+
+// 二元运算符的绑定强度，数值越大结合越紧
+// 层级与 docs/design/运算符优先级.md 一致（文档中的级别号越小越紧）
+enum BinaryPrecedence : int {
+  NotBinaryOperator = 0,
+  PrecedenceLogicOr = 1,         // 13: ||
+  PrecedenceLogicAnd = 2,        // 12: &&
+  PrecedenceEquality = 3,        // 11: == !=
+  PrecedenceRelational = 4,      // 10: < <= > >=
+  PrecedenceBitOr = 5,           // 9: |
+  PrecedenceBitXor = 6,          // 8: ^
+  PrecedenceBitAnd = 7,          // 7: &
+  PrecedenceShift = 8,           // 6: << >>
+  PrecedenceAdditive = 9,        // 5: + -
+  PrecedenceMultiplicative = 10, // 4: * / %
+  LowestBinaryPrecedence = PrecedenceLogicOr,
+};
+
+// 二元运算符表项
+struct BinaryOperatorInfo {
+  int precedence = NotBinaryOperator;
+  ast::BinaryExpr::Op op = ast::BinaryExpr::Op::Add;
+};
+
+inline constexpr size_t TokenTypeCount =
+    static_cast<size_t>(lexer::TokenType::EndOfFile) + 1;
+
+namespace detail {
+constexpr std::array<BinaryOperatorInfo, TokenTypeCount>
+buildBinaryOperatorTable() {
+  std::array<BinaryOperatorInfo, TokenTypeCount> table{};
+  auto set = [&table](lexer::TokenType type, int precedence,
+                      ast::BinaryExpr::Op op) {
+    table[static_cast<size_t>(type)] = BinaryOperatorInfo{precedence, op};
+  };
+
+  using lexer::TokenType;
+  using Op = ast::BinaryExpr::Op;
+  set(TokenType::LogicOr, PrecedenceLogicOr, Op::LogicOr);
+  set(TokenType::LogicAnd, PrecedenceLogicAnd, Op::LogicAnd);
+  set(TokenType::Eq, PrecedenceEquality, Op::Eq);
+  set(TokenType::Ne, PrecedenceEquality, Op::Ne);
+  set(TokenType::Lt, PrecedenceRelational, Op::Lt);
+  set(TokenType::Le, PrecedenceRelational, Op::Le);
+  set(TokenType::Gt, PrecedenceRelational, Op::Gt);
+  set(TokenType::Ge, PrecedenceRelational, Op::Ge);
+  set(TokenType::Or, PrecedenceBitOr, Op::Or);
+  set(TokenType::Xor, PrecedenceBitXor, Op::Xor);
+  set(TokenType::And, PrecedenceBitAnd, Op::And);
+  set(TokenType::Shl, PrecedenceShift, Op::Shl);
+  set(TokenType::Shr, PrecedenceShift, Op::Shr);
+  set(TokenType::Plus, PrecedenceAdditive, Op::Add);
+  set(TokenType::Minus, PrecedenceAdditive, Op::Sub);
+  set(TokenType::Multiply, PrecedenceMultiplicative, Op::Mul);
+  set(TokenType::Divide, PrecedenceMultiplicative, Op::Div);
+  set(TokenType::Modulus, PrecedenceMultiplicative, Op::Mod);
+  return table;
+}
+} // namespace detail
+
+// 按 TokenType 下标直接查表，非二元运算符的优先级为 NotBinaryOperator
+inline constexpr std::array<BinaryOperatorInfo, TokenTypeCount>
+    BinaryOperators = detail::buildBinaryOperatorTable();
+
+// 查询词法单元作为二元运算符的信息
+constexpr const BinaryOperatorInfo &binaryOperatorInfo(lexer::TokenType type) {
+  return BinaryOperators[static_cast<size_t>(type)];
+}
+
+static_assert(binaryOperatorInfo(lexer::TokenType::Identifier).precedence ==
+              NotBinaryOperator);
+static_assert(binaryOperatorInfo(lexer::TokenType::Multiply).precedence >
+              binaryOperatorInfo(lexer::TokenType::Plus).precedence);
+static_assert(binaryOperatorInfo(lexer::TokenType::And).precedence >
+              binaryOperatorInfo(lexer::TokenType::Eq).precedence);
+
+} // namespace parser
+} // namespace c_hat
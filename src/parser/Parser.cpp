@@ -1,4 +1,6 @@
 #include "Parser.h"
+#include "OperatorTable.h"
+#include "../ast/ByteStream.h"
 #include <format>
 #include <iostream>
 #include <stdexcept>
@@ -7,21 +9,139 @@ namespace c_hat {
 namespace parser {
 
 // Parser构造函数
-Parser::Parser(std::string source) : lexer(std::move(source)) { advance(); }
+Parser::Parser(std::string source)
+    : Parser(lexer::SourceBuffer::fromString(std::move(source))) {}
+
+Parser::Parser(std::shared_ptr<const lexer::SourceBuffer> buffer)
+    : lexer(std::move(buffer)) {
+  // 一次性切分全部词法单元，之后的解析只在 tokens 上移动下标
+  TokenList list;
+  while (true) {
+    auto token = lexer.nextToken();
+    bool isEnd = token && token->getType() == lexer::TokenType::EndOfFile;
+    list.push_back(std::move(token));
+    if (isEnd) {
+      break;
+    }
+  }
+  tokens = std::make_shared<const TokenList>(std::move(list));
+  restoreState(ParserState{0});
+}
+
+Parser::Parser(std::shared_ptr<const lexer::SourceBuffer> buffer,
+               std::shared_ptr<const TokenList> tokens, size_t position)
+    : lexer(std::move(buffer)), tokens(std::move(tokens)) {
+  restoreState(ParserState{position});
+}
+
+// 延迟解析的函数体
+class Parser::LazyFunctionBody : public ast::LazyBody {
+public:
+  LazyFunctionBody(std::shared_ptr<const lexer::SourceBuffer> buffer,
+                   std::shared_ptr<const TokenList> tokens, size_t begin,
+                   size_t end, std::weak_ptr<ast::AstArena> arena,
+                   std::shared_ptr<const void> owner = nullptr)
+      : buffer(std::move(buffer)), tokens(std::move(tokens)), begin(begin),
+        end(end), arena(std::move(arena)), owner(std::move(owner)) {}
+
+  std::unique_ptr<ast::Node> parse() override {
+    // 节点分配在函数所属程序的内存池中（内存池已释放时走普通堆）
+    auto lockedArena = arena.lock();
+    ast::AstArena::Scope arenaScope(lockedArena.get());
+    Parser parser(buffer, tokens, begin);
+    return parser.parseCompoundStmt();
+  }
+
+  // 词法单元：u32 个数，每个为 u8 类型 u32 长度加文本 u32 行 u32 列
+  bool writeTokens(ast::ByteWriter &out) const override {
+    out.u32(static_cast<uint32_t>(end - begin));
+    for (size_t i = begin; i < end; ++i) {
+      const auto &token = (*tokens)[i];
+      if (!token) {
+        return false;
+      }
+      out.u8(static_cast<uint8_t>(token->getType()));
+      out.str(token->getValue());
+      out.u32(static_cast<uint32_t>(token->getLine()));
+      out.u32(static_cast<uint32_t>(token->getColumn()));
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<const lexer::SourceBuffer> buffer;
+  std::shared_ptr<const TokenList> tokens;
+  // 函数体在 tokens 中的范围，begin 是 '{' 的下标，end 在 '}' 之后
+  size_t begin;
+  size_t end;
+  std::weak_ptr<ast::AstArena> arena;
+  // 词法单元文本不在 buffer 中时持有文本所在的内存
+  std::shared_ptr<const void> owner;
+};
+
+std::unique_ptr<ast::LazyBody>
+Parser::readSkimmedBody(std::string_view data,
+                        std::shared_ptr<const void> owner,
+                        std::weak_ptr<ast::AstArena> arena) {
+  // 文本直接引用 data，不复制；原来的源码不再需要
+  static const auto emptyBuffer = lexer::SourceBuffer::fromString("");
+  ast::ByteReader in(data);
+  uint32_t count = in.count();
+  TokenList list;
+  list.reserve(count + 1);
+  int line = 1;
+  int column = 1;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto type = in.enumValue(lexer::TokenType::EndOfFile);
+    auto value = in.view(in.u32());
+    line = static_cast<int>(in.u32());
+    column = static_cast<int>(in.u32());
+    list.emplace_back(lexer::Token(type, value, line, column));
+  }
+  if (!in.atEnd() || count == 0 ||
+      list.front()->getType() != lexer::TokenType::LBrace) {
+    throw ast::MalformedData();
+  }
+  // 函数体之后以 EndOfFile 结尾，和完整切分的词法单元列表一致
+  list.emplace_back(
+      lexer::Token(lexer::TokenType::EndOfFile, "", line, column));
+  auto tokens = std::make_shared<const TokenList>(std::move(list));
+  return std::make_unique<LazyFunctionBody>(emptyBuffer, std::move(tokens), 0,
+                                            count, std::move(arena),
+                                            std::move(owner));
+}
 
 // 解析整个程序
 std::unique_ptr<ast::Program> Parser::parseProgram() {
+  return parseProgram(nullptr);
+}
+
+std::unique_ptr<ast::Program>
+Parser::parseProgram(const DeclarationCallback &onDeclaration) {
+  // 整个程序的节点都分配在同一个内存池中，随 Program 一起释放
+  auto arena = useArena ? std::make_shared<ast::AstArena>() : nullptr;
+  programArena = arena;
   std::vector<std::unique_ptr<ast::Declaration>> declarations;
 
-  while (!check(lexer::TokenType::EndOfFile)) {
-    if (auto decl = parseDeclaration()) {
-      declarations.push_back(std::move(decl));
-    } else {
-      advance();
+  {
+    ast::AstArena::Scope arenaScope(arena.get());
+    while (!check(lexer::TokenType::EndOfFile)) {
+      if (auto decl = parseDeclaration()) {
+        declarations.push_back(std::move(decl));
+        if (onDeclaration) {
+          onDeclaration(*declarations.back());
+        }
+      } else {
+        advance();
+      }
     }
   }
 
-  return std::make_unique<ast::Program>(std::move(declarations));
+  // Program 本身走普通堆分配，它持有内存池，不能位于内存池中
+  auto program = std::make_unique<ast::Program>(std::move(declarations),
+                                                std::move(arena));
+  program->source = lexer.getSourceBuffer();
+  return program;
 }
 
 std::unique_ptr<ast::Expression> Parser::parseExpressionOnly() {
@@ -59,7 +179,11 @@ void Parser::error(const std::string &message) {
 // 消费下一个词法单元
 void Parser::advance() {
   previousToken = currentToken;
-  currentToken = lexer.nextToken();
+  // 到达末尾后停留在 EndOfFile 上
+  if (position + 1 < tokens->size()) {
+    position++;
+  }
+  currentToken = (*tokens)[position];
 }
 
 // 检查当前词法单元类型
@@ -134,9 +258,9 @@ std::unique_ptr<ast::Declaration> Parser::parseDeclaration() {
   // 不是 import，恢复状态，让后面的 parse 函数自己处理访问修饰符
   restoreState(state);
 
-  // 直接尝试解析各种声明，用 saveState 和 restoreState
-  // 注意：各 parseXxx 内部可能调用 error() 抛出异常，必须用 try-catch
-  // 确保异常安全
+  // 直接尝试解析各种声明，用 speculate 包装
+  // 注意：各 parseXxx 内部可能调用 error() 抛出异常，speculate 会捕获异常、
+  // 恢复位置，并记录失败的 (规则, 位置)，避免同一位置重复尝试
 
   // 0. 尝试解析扩展声明（直接检查关键字，避免被其他声明干扰）
   if (check(lexer::TokenType::Extension)) {
@@ -148,38 +272,23 @@ std::unique_ptr<ast::Declaration> Parser::parseDeclaration() {
     return attachAttributes(parseFunctionDecl());
   }
 
-  ParserState tryState = saveState();
   // -1. 尝试解析 Getter 声明
-  try {
-    auto getterDecl = parseGetterDecl();
-    if (getterDecl) {
-      return attachAttributes(std::move(getterDecl));
-    }
-  } catch (...) {
+  if (auto getterDecl = speculate(Speculation::GetterDecl,
+                                  [this] { return parseGetterDecl(); })) {
+    return attachAttributes(std::move(getterDecl));
   }
-  restoreState(tryState);
 
-  tryState = saveState();
   // -0.5. 尝试解析 Setter 声明
-  try {
-    auto setterDecl = parseSetterDecl();
-    if (setterDecl) {
-      return attachAttributes(std::move(setterDecl));
-    }
-  } catch (...) {
+  if (auto setterDecl = speculate(Speculation::SetterDecl,
+                                  [this] { return parseSetterDecl(); })) {
+    return attachAttributes(std::move(setterDecl));
   }
-  restoreState(tryState);
 
   // 1. 尝试解析函数声明
-  tryState = saveState();
-  try {
-    auto funcDecl = parseFunctionDecl();
-    if (funcDecl) {
-      return attachAttributes(std::move(funcDecl));
-    }
-  } catch (...) {
+  if (auto funcDecl = speculate(Speculation::FunctionDecl,
+                                [this] { return parseFunctionDecl(); })) {
+    return attachAttributes(std::move(funcDecl));
   }
-  restoreState(tryState);
 
   // 1.5. 尝试解析 concept 声明
   if (check(lexer::TokenType::Concept)) {
@@ -192,70 +301,40 @@ std::unique_ptr<ast::Declaration> Parser::parseDeclaration() {
   }
 
   // 2. 尝试解析命名空间声明
-  tryState = saveState();
-  try {
-    auto namespaceDecl = parseNamespaceDecl();
-    if (namespaceDecl) {
-      return attachAttributes(std::move(namespaceDecl));
-    }
-  } catch (...) {
+  if (auto namespaceDecl = speculate(Speculation::NamespaceDecl,
+                                     [this] { return parseNamespaceDecl(); })) {
+    return attachAttributes(std::move(namespaceDecl));
   }
-  restoreState(tryState);
 
   // 3. 尝试解析类声明
-  tryState = saveState();
-  try {
-    auto classDecl = parseClassDecl();
-    if (classDecl) {
-      return attachAttributes(std::move(classDecl));
-    }
-  } catch (...) {
+  if (auto classDecl = speculate(Speculation::ClassDecl,
+                                 [this] { return parseClassDecl(); })) {
+    return attachAttributes(std::move(classDecl));
   }
-  restoreState(tryState);
 
   // 4. 尝试解析接口声明
-  tryState = saveState();
-  try {
-    auto interfaceDecl = parseInterfaceDecl();
-    if (interfaceDecl) {
-      return attachAttributes(std::move(interfaceDecl));
-    }
-  } catch (...) {
+  if (auto interfaceDecl = speculate(Speculation::InterfaceDecl,
+                                     [this] { return parseInterfaceDecl(); })) {
+    return attachAttributes(std::move(interfaceDecl));
   }
-  restoreState(tryState);
 
   // 5. 尝试解析结构体声明
-  tryState = saveState();
-  try {
-    auto structDecl = parseStructDecl();
-    if (structDecl) {
-      return attachAttributes(std::move(structDecl));
-    }
-  } catch (...) {
+  if (auto structDecl = speculate(Speculation::StructDecl,
+                                  [this] { return parseStructDecl(); })) {
+    return attachAttributes(std::move(structDecl));
   }
-  restoreState(tryState);
 
   // 5. 尝试解析枚举声明
-  tryState = saveState();
-  try {
-    auto enumDecl = parseEnumDecl();
-    if (enumDecl) {
-      return attachAttributes(std::move(enumDecl));
-    }
-  } catch (...) {
+  if (auto enumDecl = speculate(Speculation::EnumDecl,
+                                [this] { return parseEnumDecl(); })) {
+    return attachAttributes(std::move(enumDecl));
   }
-  restoreState(tryState);
 
   // 6. 尝试解析类型别名声明
-  tryState = saveState();
-  try {
-    auto usingDecl = parseTypeAliasDecl();
-    if (usingDecl) {
-      return attachAttributes(std::move(usingDecl));
-    }
-  } catch (...) {
+  if (auto usingDecl = speculate(Speculation::TypeAliasDecl,
+                                 [this] { return parseTypeAliasDecl(); })) {
+    return attachAttributes(std::move(usingDecl));
   }
-  restoreState(tryState);
 
   // 7. 尝试解析 const 声明（编译期常量，类似 constexpr）
   if (check(lexer::TokenType::Const)) {
@@ -279,7 +358,7 @@ std::unique_ptr<ast::Declaration> Parser::parseDeclaration() {
       error("Expected identifier in const declaration");
       return nullptr;
     }
-    std::string name = currentToken->getValue();
+    std::string name(currentToken->getValue());
     advance();
 
     std::unique_ptr<ast::Expression> initializer;
@@ -299,16 +378,11 @@ std::unique_ptr<ast::Declaration> Parser::parseDeclaration() {
   if (check(lexer::TokenType::Public) || check(lexer::TokenType::Private) ||
       check(lexer::TokenType::Protected) || check(lexer::TokenType::Internal) ||
       check(lexer::TokenType::Static) || isTypeStart()) {
-    // 尝试解析类成员方法
-    ParserState methodState = saveState();
-    try {
-      auto funcDecl = parseFunctionDecl();
-      if (funcDecl) {
-        return attachAttributes(std::move(funcDecl));
-      }
-    } catch (...) {
+    // 尝试解析类成员方法（若第 1 步已在同一位置失败，则直接跳过）
+    if (auto funcDecl = speculate(Speculation::FunctionDecl,
+                                  [this] { return parseFunctionDecl(); })) {
+      return attachAttributes(std::move(funcDecl));
     }
-    restoreState(methodState);
   }
 
   // 9. 尝试解析元组解构声明或变量声明
@@ -381,7 +455,7 @@ std::unique_ptr<ast::Declaration> Parser::parseModuleDecl() {
     error("Expected module name");
     return nullptr;
   }
-  modulePath.push_back(currentToken->getValue());
+  modulePath.emplace_back(currentToken->getValue());
   advance();
 
   while (match(lexer::TokenType::Dot)) {
@@ -389,7 +463,7 @@ std::unique_ptr<ast::Declaration> Parser::parseModuleDecl() {
       error("Expected identifier after '.'");
       return nullptr;
     }
-    modulePath.push_back(currentToken->getValue());
+    modulePath.emplace_back(currentToken->getValue());
     advance();
   }
 
@@ -408,7 +482,7 @@ Parser::parseImportDecl(const std::string &specifiers) {
     error("Expected module name");
     return nullptr;
   }
-  modulePath.push_back(currentToken->getValue());
+  modulePath.emplace_back(currentToken->getValue());
   advance();
 
   while (match(lexer::TokenType::Dot)) {
@@ -416,7 +490,7 @@ Parser::parseImportDecl(const std::string &specifiers) {
       error("Expected identifier after '.'");
       return nullptr;
     }
-    modulePath.push_back(currentToken->getValue());
+    modulePath.emplace_back(currentToken->getValue());
     advance();
   }
 
@@ -450,7 +524,7 @@ Parser::parseTupleDestructuringDecl(const std::string &specifiers, bool isLate,
         error("Expected identifier in tuple destructuring");
         return nullptr;
       }
-      names.push_back(currentToken->getValue());
+      names.emplace_back(currentToken->getValue());
       advance();
     } while (match(lexer::TokenType::Comma));
   }
@@ -546,7 +620,7 @@ std::unique_ptr<ast::VariableDecl> Parser::parseVariableDecl() {
   if (!check(lexer::TokenType::Identifier)) {
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   std::unique_ptr<ast::Expression> initializer;
@@ -619,7 +693,7 @@ std::unique_ptr<ast::VariableDecl> Parser::parseVariableDeclForFor() {
   if (!check(lexer::TokenType::Identifier)) {
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   std::unique_ptr<ast::Expression> initializer;
@@ -643,8 +717,9 @@ std::unique_ptr<ast::VariableDecl> Parser::parseVariableDeclForFor() {
 
 // 尝试解析变量声明（失败时返回 nullptr，不抛异常）
 std::unique_ptr<ast::VariableDecl> Parser::tryParseVariableDecl() {
-  ParserState state = saveState();
-  try {
+  // 失败时由 speculate 恢复位置并记录，声明与语句两条路径不会重复尝试
+  using Result = std::unique_ptr<ast::VariableDecl>;
+  return speculate(Speculation::VariableDecl, [this]() -> Result {
     std::string specifiers = "";
 
     // 支持多个修饰符组合（如 public static、static 等）
@@ -693,7 +768,6 @@ std::unique_ptr<ast::VariableDecl> Parser::tryParseVariableDecl() {
 
     // 检查是否是元组解构（接下来是 ( ）
     if (check(lexer::TokenType::LParen)) {
-      restoreState(state);
       return nullptr;
     }
 
@@ -706,10 +780,9 @@ std::unique_ptr<ast::VariableDecl> Parser::tryParseVariableDecl() {
     }
 
     if (!check(lexer::TokenType::Identifier)) {
-      restoreState(state);
       return nullptr;
     }
-    std::string name = currentToken->getValue();
+    std::string name(currentToken->getValue());
     advance();
 
     std::unique_ptr<ast::Expression> initializer;
@@ -725,7 +798,6 @@ std::unique_ptr<ast::VariableDecl> Parser::tryParseVariableDecl() {
     }
 
     if (!check(lexer::TokenType::Semicolon)) {
-      restoreState(state);
       return nullptr;
     }
     advance();
@@ -736,10 +808,7 @@ std::unique_ptr<ast::VariableDecl> Parser::tryParseVariableDecl() {
     return std::make_unique<ast::VariableDecl>(
         specifiers, isLate, kind, std::move(type), name, std::move(initializer),
         false, isStatic);
-  } catch (...) {
-    restoreState(state);
-    return nullptr;
-  }
+  });
 }
 
 // 解析命名空间声明
@@ -752,7 +821,7 @@ std::unique_ptr<ast::NamespaceDecl> Parser::parseNamespaceDecl() {
     error("Expected namespace name");
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   if (!match(lexer::TokenType::LBrace)) {
@@ -977,7 +1046,7 @@ std::unique_ptr<ast::FunctionDecl> Parser::parseFunctionDecl() {
         error("Expected identifier after '~' for destructor");
         return nullptr;
       }
-      name = "~" + currentToken->getValue();
+      name = "~" + std::string(currentToken->getValue());
       advance();
     }
     // 情况2.5: 操作符重载（无 func 关键字，直接 operator）
@@ -1179,11 +1248,16 @@ std::unique_ptr<ast::FunctionDecl> Parser::parseFunctionDecl() {
     }
   }
 
+  std::unique_ptr<ast::LazyBody> lazyBody;
   if (match(lexer::TokenType::FatArrow)) {
     arrowExpr = parseExpression();
     expect(lexer::TokenType::Semicolon, "Expected ';' after arrow expression");
   } else if (check(lexer::TokenType::LBrace)) {
-    body = parseCompoundStmt();
+    if (skimFunctionBodies) {
+      lazyBody = skimFunctionBody();
+    } else {
+      body = parseCompoundStmt();
+    }
   } else {
     expect(lexer::TokenType::Semicolon,
            "Expected ';' after function declaration");
@@ -1203,11 +1277,33 @@ std::unique_ptr<ast::FunctionDecl> Parser::parseFunctionDecl() {
   // 检查是否是静态函数
   bool isStatic = specifiers.find("static") != std::string::npos;
 
-  return std::make_unique<ast::FunctionDecl>(
+  auto funcDecl = std::make_unique<ast::FunctionDecl>(
       specifiers, name, std::move(templateParams), std::move(params),
       std::move(returnType), std::move(whereClause), std::move(requiresClause),
       std::move(body), std::move(arrowExpr), isImmutable, std::move(superCall),
       isVariadic, isStatic);
+  funcDecl->lazyBody = std::move(lazyBody);
+  return funcDecl;
+}
+
+// 略读函数体：只做花括号配对，记录函数体 '{' 的位置
+std::unique_ptr<ast::LazyBody> Parser::skimFunctionBody() {
+  size_t begin = position;
+  int depth = 0;
+  do {
+    if (check(lexer::TokenType::EndOfFile)) {
+      error("Expected '}' at end of function body");
+    }
+    if (check(lexer::TokenType::LBrace)) {
+      depth++;
+    } else if (check(lexer::TokenType::RBrace)) {
+      depth--;
+    }
+    advance();
+  } while (depth > 0);
+
+  return std::make_unique<LazyFunctionBody>(lexer.getSourceBuffer(), tokens,
+                                            begin, position, programArena);
 }
 
 // 解析类声明
@@ -1241,7 +1337,7 @@ std::unique_ptr<ast::ClassDecl> Parser::parseClassDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   // 解析模板参数
@@ -1267,7 +1363,7 @@ std::unique_ptr<ast::ClassDecl> Parser::parseClassDecl() {
         return nullptr;
       }
 
-      std::string name = currentToken->getValue();
+      std::string name(currentToken->getValue());
       advance();
 
       // 检查是否是第一个基类
@@ -1373,7 +1469,7 @@ std::unique_ptr<ast::InterfaceDecl> Parser::parseInterfaceDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   // 解析父接口列表
@@ -1386,7 +1482,7 @@ std::unique_ptr<ast::InterfaceDecl> Parser::parseInterfaceDecl() {
         return nullptr;
       }
 
-      std::string baseName = currentToken->getValue();
+      std::string baseName(currentToken->getValue());
       advance();
       baseInterfaces.push_back(baseName);
     } while (match(lexer::TokenType::Comma));
@@ -1422,7 +1518,7 @@ std::unique_ptr<ast::ConceptDecl> Parser::parseConceptDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   // 解析模板参数 <T, U, ...>
@@ -1433,7 +1529,7 @@ std::unique_ptr<ast::ConceptDecl> Parser::parseConceptDecl() {
         error("Expected template parameter name");
         return nullptr;
       }
-      std::string paramName = currentToken->getValue();
+      std::string paramName(currentToken->getValue());
       advance();
       templateParams.push_back(
           std::make_unique<ast::TemplateParameter>(paramName));
@@ -1486,7 +1582,7 @@ std::unique_ptr<ast::AttributeDecl> Parser::parseAttributeDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   auto attrDecl = std::make_unique<ast::AttributeDecl>(name);
@@ -1503,7 +1599,7 @@ std::unique_ptr<ast::AttributeDecl> Parser::parseAttributeDecl() {
       return nullptr;
     }
 
-    std::string fieldName = currentToken->getValue();
+    std::string fieldName(currentToken->getValue());
     advance();
 
     std::unique_ptr<ast::Type> fieldType;
@@ -1552,7 +1648,7 @@ std::unique_ptr<ast::AttributeApplication> Parser::parseAttributeApplication() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   auto attrApp = std::make_unique<ast::AttributeApplication>(name);
@@ -1566,7 +1662,7 @@ std::unique_ptr<ast::AttributeApplication> Parser::parseAttributeApplication() {
 
       // 检查是否是命名参数 (name = value)
       if (check(lexer::TokenType::Identifier)) {
-        std::string potentialName = currentToken->getValue();
+        std::string potentialName(currentToken->getValue());
         advance();
         if (match(lexer::TokenType::Assign)) {
           argName = potentialName;
@@ -1628,7 +1724,7 @@ std::unique_ptr<ast::StructDecl> Parser::parseStructDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   expect(lexer::TokenType::LBrace, "Expected '{' after struct declaration");
@@ -1669,7 +1765,7 @@ std::unique_ptr<ast::EnumDecl> Parser::parseEnumDecl() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   expect(lexer::TokenType::LBrace, "Expected '{' after enum declaration");
@@ -1695,7 +1791,7 @@ std::unique_ptr<ast::EnumMember> Parser::parseEnumMember() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   std::unique_ptr<ast::Expression> value;
@@ -1771,7 +1867,7 @@ std::unique_ptr<ast::GetterDecl> Parser::parseGetterDecl() {
   if (!check(lexer::TokenType::Identifier)) {
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   // Getter 必须带返回类型：通过 '->' 指定类型
@@ -1842,7 +1938,7 @@ std::unique_ptr<ast::SetterDecl> Parser::parseSetterDecl() {
     error("Expected setter name");
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   // 解析参数
@@ -1902,7 +1998,7 @@ std::unique_ptr<ast::TypeAliasDecl> Parser::parseTypeAliasDecl() {
     error("Expected type alias name");
     return nullptr;
   }
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   expect(lexer::TokenType::Assign, "Expected '=' after type alias name");
@@ -1942,7 +2038,7 @@ std::unique_ptr<ast::Statement> Parser::parseStatement() {
     ParserState state = saveState();
     advance(); // 消费 [
     if (check(lexer::TokenType::Identifier)) {
-      std::string name = currentToken->getValue();
+      std::string name(currentToken->getValue());
       advance();
       // 如果后面是 ] 或 (，则是属性应用
       if (check(lexer::TokenType::RBracket) ||
@@ -1998,7 +2094,7 @@ std::unique_ptr<ast::Statement> Parser::parseStatement() {
       error("Expected label name after goto");
       return nullptr;
     }
-    std::string label = currentToken->getValue();
+    std::string label(currentToken->getValue());
     advance();
     expect(lexer::TokenType::Semicolon, "Expected ';' after goto label");
     return attachAttributes(std::make_unique<ast::GotoStmt>(std::move(label)));
@@ -2033,7 +2129,7 @@ std::unique_ptr<ast::Statement> Parser::parseStatement() {
       error("Expected identifier in const declaration");
       return nullptr;
     }
-    std::string name = currentToken->getValue();
+    std::string name(currentToken->getValue());
     advance();
 
     std::unique_ptr<ast::Expression> initializer;
@@ -2054,7 +2150,7 @@ std::unique_ptr<ast::Statement> Parser::parseStatement() {
   } else if (check(lexer::TokenType::Identifier)) {
     // 检查是否是标签（后面跟着冒号）
     auto state = saveState();
-    std::string label = currentToken->getValue();
+    std::string label(currentToken->getValue());
     advance();
     if (match(lexer::TokenType::Colon)) {
       return attachAttributes(
@@ -2204,7 +2300,7 @@ std::unique_ptr<ast::ForStmt> Parser::parseForStmt() {
         (previousToken->getType() == lexer::TokenType::Var) ? "var" : "let";
 
     if (check(lexer::TokenType::Identifier)) {
-      std::string varName = currentToken->getValue();
+      std::string varName(currentToken->getValue());
       advance(); // 消费变量名
       if (check(lexer::TokenType::Colon)) {
         // 确认是 foreach
@@ -2266,7 +2362,7 @@ std::unique_ptr<ast::VariableDecl> Parser::parseForeachVariableDecl() {
     return nullptr;
   }
 
-  std::string varName = currentToken->getValue();
+  std::string varName(currentToken->getValue());
   advance();
 
   return std::make_unique<ast::VariableDecl>(
@@ -2359,7 +2455,7 @@ std::unique_ptr<ast::Expression> Parser::parseAssignmentExpr() {
 
 // 解析条件表达式
 std::unique_ptr<ast::Expression> Parser::parseConditionalExpr() {
-  auto condition = parseLogicalOrExpr();
+  auto condition = parseBinaryExpr(LowestBinaryPrecedence);
 
   if (match(lexer::TokenType::Question)) {
     auto thenExpr = parseExpression();
@@ -2373,186 +2469,23 @@ std::unique_ptr<ast::Expression> Parser::parseConditionalExpr() {
   return condition;
 }
 
-// 解析逻辑或表达式
-std::unique_ptr<ast::Expression> Parser::parseLogicalOrExpr() {
-  auto left = parseLogicalAndExpr();
-
-  while (match(lexer::TokenType::LogicOr)) {
-    auto op = ast::BinaryExpr::Op::LogicOr;
-    auto right = parseLogicalAndExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析逻辑与表达式
-std::unique_ptr<ast::Expression> Parser::parseLogicalAndExpr() {
-  auto left = parseInclusiveOrExpr();
-
-  while (match(lexer::TokenType::LogicAnd)) {
-    auto op = ast::BinaryExpr::Op::LogicAnd;
-    auto right = parseInclusiveOrExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析包含或表达式
-std::unique_ptr<ast::Expression> Parser::parseInclusiveOrExpr() {
-  auto left = parseExclusiveOrExpr();
-
-  while (match(lexer::TokenType::Or)) {
-    auto op = ast::BinaryExpr::Op::Or;
-    auto right = parseExclusiveOrExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析排他或表达式
-std::unique_ptr<ast::Expression> Parser::parseExclusiveOrExpr() {
-  auto left = parseAndExpr();
-
-  while (match(lexer::TokenType::Xor)) {
-    auto op = ast::BinaryExpr::Op::Xor;
-    auto right = parseAndExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析与表达式
-std::unique_ptr<ast::Expression> Parser::parseAndExpr() {
-  auto left = parseEqualityExpr();
-
-  while (match(lexer::TokenType::And)) {
-    auto op = ast::BinaryExpr::Op::And;
-    auto right = parseEqualityExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析相等表达式
-std::unique_ptr<ast::Expression> Parser::parseEqualityExpr() {
-  auto left = parseRelationalExpr();
-
-  while (true) {
-    ast::BinaryExpr::Op op;
-    if (match(lexer::TokenType::Eq)) {
-      op = ast::BinaryExpr::Op::Eq;
-    } else if (match(lexer::TokenType::Ne)) {
-      op = ast::BinaryExpr::Op::Ne;
-    } else {
-      break;
-    }
-
-    auto right = parseRelationalExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析关系表达式
-std::unique_ptr<ast::Expression> Parser::parseRelationalExpr() {
-  auto left = parseShiftExpr();
-
-  while (true) {
-    ast::BinaryExpr::Op op;
-    if (match(lexer::TokenType::Lt)) {
-      op = ast::BinaryExpr::Op::Lt;
-    } else if (match(lexer::TokenType::Le)) {
-      op = ast::BinaryExpr::Op::Le;
-    } else if (match(lexer::TokenType::Gt)) {
-      op = ast::BinaryExpr::Op::Gt;
-    } else if (match(lexer::TokenType::Ge)) {
-      op = ast::BinaryExpr::Op::Ge;
-    } else {
-      break;
-    }
-
-    auto right = parseShiftExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析移位表达式
-std::unique_ptr<ast::Expression> Parser::parseShiftExpr() {
-  auto left = parseAdditiveExpr();
-
-  while (true) {
-    ast::BinaryExpr::Op op;
-    if (match(lexer::TokenType::Shl)) {
-      op = ast::BinaryExpr::Op::Shl;
-    } else if (match(lexer::TokenType::Shr)) {
-      op = ast::BinaryExpr::Op::Shr;
-    } else {
-      break;
-    }
-
-    auto right = parseAdditiveExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析加法表达式
-std::unique_ptr<ast::Expression> Parser::parseAdditiveExpr() {
-  auto left = parseMultiplicativeExpr();
-
-  while (true) {
-    ast::BinaryExpr::Op op;
-    if (match(lexer::TokenType::Plus)) {
-      op = ast::BinaryExpr::Op::Add;
-    } else if (match(lexer::TokenType::Minus)) {
-      op = ast::BinaryExpr::Op::Sub;
-    } else {
-      break;
-    }
-
-    auto right = parseMultiplicativeExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
-                                             std::move(right));
-  }
-
-  return left;
-}
-
-// 解析乘法表达式
-std::unique_ptr<ast::Expression> Parser::parseMultiplicativeExpr() {
+// 解析二元运算表达式（优先级爬升）
+// 运算符的优先级与对应的 AST 运算符统一由 OperatorTable.h 中的表给出，
+// 每个操作数只调用一次 parseUnaryExpr，不再逐层下降。
+std::unique_ptr<ast::Expression> Parser::parseBinaryExpr(int minPrecedence) {
   auto left = parseUnaryExpr();
 
-  while (true) {
-    ast::BinaryExpr::Op op;
-    if (match(lexer::TokenType::Multiply)) {
-      op = ast::BinaryExpr::Op::Mul;
-    } else if (match(lexer::TokenType::Divide)) {
-      op = ast::BinaryExpr::Op::Div;
-    } else if (match(lexer::TokenType::Modulus)) {
-      op = ast::BinaryExpr::Op::Mod;
-    } else {
+  while (currentToken) {
+    const auto &info = binaryOperatorInfo(currentToken->getType());
+    if (info.precedence == NotBinaryOperator ||
+        info.precedence < minPrecedence) {
       break;
     }
+    advance();
 
-    auto right = parseUnaryExpr();
-    left = std::make_unique<ast::BinaryExpr>(std::move(left), op,
+    // 二元运算符均为左结合，右操作数只吸收优先级更高的运算符
+    auto right = parseBinaryExpr(info.precedence + 1);
+    left = std::make_unique<ast::BinaryExpr>(std::move(left), info.op,
                                              std::move(right));
   }
 
@@ -2662,7 +2595,7 @@ std::unique_ptr<ast::Expression> Parser::parsePrimaryExpr() {
   } else if (match(lexer::TokenType::Super)) {
     expr = std::make_unique<ast::Identifier>("super");
   } else if (match(lexer::TokenType::BuiltinVar)) {
-    std::string name = previousToken->getValue();
+    std::string name(previousToken->getValue());
     expr = std::make_unique<ast::BuiltinVarExpr>(name);
   } else if (check(lexer::TokenType::LBrace)) {
     expr = parseStructInit();
@@ -2674,7 +2607,7 @@ std::unique_ptr<ast::Expression> Parser::parsePrimaryExpr() {
     } else {
       restoreState(state);
       if (match(lexer::TokenType::Identifier)) {
-        std::string name = previousToken->getValue();
+        std::string name(previousToken->getValue());
 
         // 检查是否是Lambda短语法：identifier => ...
         if (check(lexer::TokenType::FatArrow)) {
@@ -2703,20 +2636,20 @@ std::unique_ptr<ast::Expression> Parser::parsePrimaryExpr() {
       }
     }
   } else if (match(lexer::TokenType::IntegerLiteral)) {
-    std::string value = previousToken->getValue();
+    std::string value(previousToken->getValue());
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Integer, value);
   } else if (match(lexer::TokenType::FloatingLiteral)) {
-    std::string value = previousToken->getValue();
+    std::string value(previousToken->getValue());
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Floating, value);
   } else if (match(lexer::TokenType::StringLiteral)) {
-    std::string value = previousToken->getValue();
+    std::string value(previousToken->getValue());
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::String, value);
   } else if (match(lexer::TokenType::True)) {
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Boolean, "true");
   } else if (match(lexer::TokenType::False)) {
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Boolean, "false");
   } else if (match(lexer::TokenType::CharacterLiteral)) {
-    std::string value = previousToken->getValue();
+    std::string value(previousToken->getValue());
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Character, value);
   } else if (match(lexer::TokenType::Null)) {
     expr = std::make_unique<ast::Literal>(ast::Literal::Type::Null, "null");
@@ -2872,7 +2805,7 @@ Parser::parseMemberExpr(std::unique_ptr<ast::Expression> object) {
     error("Expected identifier after '.'");
     return nullptr;
   }
-  std::string member = currentToken->getValue();
+  std::string member(currentToken->getValue());
   advance();
   return std::make_unique<ast::MemberExpr>(std::move(object), member, false);
 }
@@ -2884,7 +2817,7 @@ Parser::parsePointerMemberExpr(std::unique_ptr<ast::Expression> object) {
     error("Expected identifier after '->'");
     return nullptr;
   }
-  std::string member = currentToken->getValue();
+  std::string member(currentToken->getValue());
   advance();
   return std::make_unique<ast::MemberExpr>(std::move(object), member, true);
 }
@@ -2896,7 +2829,7 @@ Parser::parseNamespaceAccessExpr(std::unique_ptr<ast::Expression> object) {
     error("Expected identifier after '::'");
     return nullptr;
   }
-  std::string member = currentToken->getValue();
+  std::string member(currentToken->getValue());
   advance();
   return std::make_unique<ast::MemberExpr>(std::move(object), member, false);
 }
@@ -3048,7 +2981,7 @@ std::vector<ast::Capture> Parser::parseLambdaCaptures() {
     }
 
     if (check(lexer::TokenType::Identifier)) {
-      std::string name = currentToken->getValue();
+      std::string name(currentToken->getValue());
       advance();
       captures.push_back(ast::Capture(name, byRef, isMove));
     }
@@ -3177,7 +3110,7 @@ std::unique_ptr<ast::Type> Parser::parseBasicType() {
                                                std::move(returnType));
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   std::unique_ptr<ast::Type> type;
@@ -3491,7 +3424,7 @@ std::unique_ptr<ast::Node> Parser::parseParameterPack() {
     return nullptr;
   }
 
-  std::string name = currentToken->getValue();
+  std::string name(currentToken->getValue());
   advance();
 
   return std::make_unique<ast::TemplateParameter>(name, nullptr, true);
@@ -3509,7 +3442,7 @@ Parser::parseTemplateParameters() {
         return params;
       }
 
-      std::string name = currentToken->getValue();
+      std::string name(currentToken->getValue());
       advance();
 
       std::unique_ptr<ast::Node> constraint;
@@ -3750,7 +3683,7 @@ std::unique_ptr<ast::MatchArm> Parser::parseMatchArm() {
 std::unique_ptr<ast::Pattern> Parser::parsePattern() {
   // 检查 _ 作为 default pattern
   if (check(lexer::TokenType::Identifier)) {
-    std::string val = currentToken->getValue();
+    std::string val(currentToken->getValue());
     if (val == "_") {
       advance();
       auto pattern = std::make_unique<ast::Pattern>();
@@ -3843,15 +3776,13 @@ std::unique_ptr<ast::ExpansionExpr> Parser::parseExpansionExpr() {
 }
 
 // 保存解析器状态
-Parser::ParserState Parser::saveState() {
-  return ParserState{currentToken, previousToken, lexer.saveState()};
-}
+Parser::ParserState Parser::saveState() { return ParserState{position}; }
 
 // 解析外部声明块
 std::unique_ptr<ast::Declaration> Parser::parseExternDecl() {
   expect(lexer::TokenType::StringLiteral,
          "Expected string literal after 'extern'");
-  std::string abi = previousToken->getValue();
+  std::string abi(previousToken->getValue());
 
   // 去掉字符串字面量的引号
   if (abi.size() >= 2 && abi.front() == '"' && abi.back() == '"') {
@@ -3919,9 +3850,10 @@ std::unique_ptr<ast::Expression> Parser::parseDeleteExpr() {
 
 // 恢复解析器状态
 void Parser::restoreState(const ParserState &state) {
-  currentToken = state.currentToken;
-  previousToken = state.previousToken;
-  lexer.restoreState(state.lexerState);
+  position = state.position;
+  currentToken = (*tokens)[position];
+  previousToken =
+      position > 0 ? (*tokens)[position - 1] : std::optional<lexer::Token>();
 }
 
 } // namespace parser
@@ -2,9 +2,12 @@
 
 #include "../ast/AstNodes.h"
 #include "../lexer/Lexer.h"
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <unordered_set>
 #include <vector>
 
 namespace c_hat {
@@ -15,9 +18,19 @@ class Parser {
 public:
   Parser(std::string source);
 
+  // 解析源码缓冲区（如内存映射的文件），解析结果持有该缓冲区
+  explicit Parser(std::shared_ptr<const lexer::SourceBuffer> buffer);
+
+  // 每解析完一个顶层声明时的回调（声明已归入 Program，之后不再被修改）
+  using DeclarationCallback = std::function<void(ast::Declaration &)>;
+
   // 解析整个程序
   std::unique_ptr<ast::Program> parseProgram();
 
+  // 解析整个程序，并在每个顶层声明解析完成后立即交给 onDeclaration
+  std::unique_ptr<ast::Program>
+  parseProgram(const DeclarationCallback &onDeclaration);
+
   // 解析单个表达式（用于单元测试）
   std::unique_ptr<ast::Expression> parseExpressionOnly();
 
@@ -27,10 +40,49 @@ public:
   // 解析单个声明（用于单元测试）
   std::unique_ptr<ast::Declaration> parseDeclarationOnly();
 
+  // 设置 parseProgram 是否使用 AstArena 分配节点（默认启用）
+  void setUseArena(bool value) { useArena = value; }
+
+  // 设置略读模式：函数体只做括号配对并记录词法单元范围，
+  // 在语义分析或代码生成真正需要时才解析（用于导入的模块）
+  void setSkimFunctionBodies(bool value) { skimFunctionBodies = value; }
+
+  // 读回略读的函数体写出的词法单元（见 ast::LazyBody::writeTokens），
+  // 用作 AstSerializer::deserialize 的 readSkimmedBody
+  static std::unique_ptr<ast::LazyBody>
+  readSkimmedBody(std::string_view data, std::shared_ptr<const void> owner,
+                  std::weak_ptr<ast::AstArena> arena);
+
 private:
-  // 词法分析器
+  using TokenList = std::vector<std::optional<lexer::Token>>;
+
+  // 延迟解析的函数体，持有词法单元列表，解析时从函数体的 '{' 开始
+  class LazyFunctionBody;
+
+  // 在已切分的词法单元上从 position 处开始解析（用于延迟解析函数体）
+  Parser(std::shared_ptr<const lexer::SourceBuffer> buffer,
+         std::shared_ptr<const TokenList> tokens, size_t position);
+
+  // 词法分析器（持有源码，tokens 中的词法单元是它的视图）
   lexer::Lexer lexer;
 
+  // 构造时一次性切分出的全部词法单元（以 EndOfFile 结尾），
+  // 前瞻和回溯只需移动下标，不会重新扫描源码；
+  // 延迟解析的函数体共享同一份列表
+  std::shared_ptr<const TokenList> tokens;
+
+  // 当前词法单元在 tokens 中的下标
+  size_t position = 0;
+
+  // parseProgram 是否使用内存池分配节点
+  bool useArena = true;
+
+  // 是否略读函数体
+  bool skimFunctionBodies = false;
+
+  // parseProgram 正在使用的内存池，延迟解析的函数体也分配在其中
+  std::weak_ptr<ast::AstArena> programArena;
+
   // 当前词法单元
   std::optional<lexer::Token> currentToken;
   // 前一个词法单元
@@ -74,6 +126,9 @@ private:
   // 解析函数声明
   std::unique_ptr<ast::FunctionDecl> parseFunctionDecl();
 
+  // 略读函数体：跳过配对的花括号，返回可延迟解析的函数体
+  std::unique_ptr<ast::LazyBody> skimFunctionBody();
+
   // 解析类声明
   std::unique_ptr<ast::ClassDecl> parseClassDecl();
 
@@ -186,35 +241,8 @@ private:
   // 解析条件表达式
   std::unique_ptr<ast::Expression> parseConditionalExpr();
 
-  // 解析逻辑或表达式
-  std::unique_ptr<ast::Expression> parseLogicalOrExpr();
-
-  // 解析逻辑与表达式
-  std::unique_ptr<ast::Expression> parseLogicalAndExpr();
-
-  // 解析包含或表达式
-  std::unique_ptr<ast::Expression> parseInclusiveOrExpr();
-
-  // 解析排他或表达式
-  std::unique_ptr<ast::Expression> parseExclusiveOrExpr();
-
-  // 解析与表达式
-  std::unique_ptr<ast::Expression> parseAndExpr();
-
-  // 解析相等表达式
-  std::unique_ptr<ast::Expression> parseEqualityExpr();
-
-  // 解析关系表达式
-  std::unique_ptr<ast::Expression> parseRelationalExpr();
-
-  // 解析移位表达式
-  std::unique_ptr<ast::Expression> parseShiftExpr();
-
-  // 解析加法表达式
-  std::unique_ptr<ast::Expression> parseAdditiveExpr();
-
-  // 解析乘法表达式
-  std::unique_ptr<ast::Expression> parseMultiplicativeExpr();
+  // 解析二元运算表达式，只接受优先级不低于 minPrecedence 的运算符
+  std::unique_ptr<ast::Expression> parseBinaryExpr(int minPrecedence);
 
   // 解析一元表达式
   std::unique_ptr<ast::Expression> parseUnaryExpr();
@@ -351,15 +379,53 @@ private:
   // 检查当前token是否为类型关键字
   bool isTypeKeyword() const;
 
-  // 保存和恢复解析状态（用于尝试解析）
+  // 保存和恢复解析状态（用于尝试解析），状态即 tokens 中的下标
   struct ParserState {
-    std::optional<lexer::Token> currentToken;
-    std::optional<lexer::Token> previousToken;
-    lexer::Lexer::LexerState lexerState;
+    size_t position;
   };
 
   ParserState saveState();
   void restoreState(const ParserState &state);
+
+  // 推测解析的规则
+  enum class Speculation : uint8_t {
+    GetterDecl,
+    SetterDecl,
+    FunctionDecl,
+    NamespaceDecl,
+    ClassDecl,
+    InterfaceDecl,
+    StructDecl,
+    EnumDecl,
+    TypeAliasDecl,
+    VariableDecl
+  };
+
+  // 已失败的推测解析，键为 (起始下标 << 8 | 规则)
+  // 解析结果只取决于起始位置，失败过的组合无需再次尝试
+  std::unordered_set<uint64_t> failedSpeculations;
+
+  // 在当前位置按指定规则尝试解析：成功时返回结果；返回空或抛出异常时
+  // 恢复位置并记录失败，之后同一位置的同一规则直接返回空
+  template <typename ParseFn>
+  auto speculate(Speculation rule, ParseFn parse) -> decltype(parse()) {
+    uint64_t key =
+        (static_cast<uint64_t>(position) << 8) | static_cast<uint64_t>(rule);
+    if (failedSpeculations.contains(key)) {
+      return nullptr;
+    }
+
+    ParserState state = saveState();
+    try {
+      if (auto result = parse()) {
+        return result;
+      }
+    } catch (...) {
+    }
+    restoreState(state);
+    failedSpeculations.insert(key);
+    return nullptr;
+  }
 };
 
 } // namespace parser
@@ -0,0 +1,56 @@
+#include "AnalysisPipeline.h"
+#include "BoundedQueue.h"
+#include <exception>
+#include <thread>
+
+namespace c_hat {
+namespace semantic {
+
+AnalysisPipeline::AnalysisPipeline(parser::Parser &parser,
+                                   SemanticAnalyzer &analyzer,
+                                   size_t queueCapacity)
+    : parser_(parser), analyzer_(analyzer), queueCapacity_(queueCapacity) {}
+
+std::unique_ptr<ast::Program> AnalysisPipeline::run() {
+  // 声明归 Program 所有，队列中只传递指针；
+  // 声明放入队列后语法分析线程不再访问它
+  BoundedQueue<ast::Declaration *> queue(queueCapacity_);
+  std::unique_ptr<ast::Program> program;
+  std::exception_ptr parseError;
+
+  std::thread parserThread([this, &queue, &program, &parseError] {
+    try {
+      program = parser_.parseProgram(
+          [&queue](ast::Declaration &decl) { queue.push(&decl); });
+    } catch (...) {
+      parseError = std::current_exception();
+    }
+    queue.close();
+  });
+
+  // 调用线程一边等待语法分析，一边收集顶层声明的签名
+  std::exception_ptr analyzeError;
+  try {
+    while (auto decl = queue.pop()) {
+      analyzer_.collectTopLevelDeclaration(*decl);
+    }
+  } catch (...) {
+    analyzeError = std::current_exception();
+    // 关闭队列，语法分析线程不再阻塞在已满的队列上
+    queue.close();
+  }
+  parserThread.join();
+
+  if (parseError) {
+    std::rethrow_exception(parseError);
+  }
+  if (analyzeError) {
+    std::rethrow_exception(analyzeError);
+  }
+
+  analyzer_.finishAnalysis(*program);
+  return program;
+}
+
+} // namespace semantic
+} // namespace c_hat
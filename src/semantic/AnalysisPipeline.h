@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../parser/Parser.h"
+#include "SemanticAnalyzer.h"
+#include <cstddef>
+#include <memory>
+
+namespace c_hat {
+namespace semantic {
+
+// 流水线式的语法分析与语义分析
+// 语法分析在后台线程进行，每解析完一个顶层声明就放入有界队列；
+// 调用线程同时从队列取出声明并收集签名。类成员和函数体可能引用后面的
+// 声明，因此在全部声明到齐后才分析。
+class AnalysisPipeline {
+public:
+  static constexpr size_t DefaultQueueCapacity = 64;
+
+  AnalysisPipeline(parser::Parser &parser, SemanticAnalyzer &analyzer,
+                   size_t queueCapacity = DefaultQueueCapacity);
+
+  // 运行流水线，返回解析出的程序
+  // 语法错误在调用线程中重新抛出；语义错误通过 analyzer.hasError() 报告
+  std::unique_ptr<ast::Program> run();
+
+private:
+  parser::Parser &parser_;
+  SemanticAnalyzer &analyzer_;
+  size_t queueCapacity_;
+};
+
+} // namespace semantic
+} // namespace c_hat
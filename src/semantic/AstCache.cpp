@@ -0,0 +1,185 @@
+#include "AstCache.h"
+#include "../ast/AstSerializer.h"
+#include "../ast/ByteStream.h"
+#include "../lexer/SourceBuffer.h"
+#include "../parser/Parser.h"
+#include "ModuleInterface.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 构建系统传入项目版本，未传入时视为开发版本
+#ifndef C_HAT_VERSION
+#define C_HAT_VERSION "dev"
+#endif
+
+namespace c_hat {
+namespace semantic {
+
+namespace {
+
+// 缓存项格式：
+//   "CHA\0" u64 源码哈希 编译器版本 AstSerializer 数据
+constexpr char Magic[4] = {'C', 'H', 'A', '\0'};
+
+constexpr const char *EntryExtension = ".cha";
+
+} // namespace
+
+AstCache::AstCache(std::filesystem::path directory)
+    : directory_(std::move(directory)) {}
+
+const char *AstCache::compilerVersion() { return C_HAT_VERSION; }
+
+bool AstCache::trustedDirectory(bool create) const {
+  std::error_code ec;
+  if (create && std::filesystem::create_directories(directory_, ec)) {
+    std::filesystem::permissions(directory_,
+                                 std::filesystem::perms::owner_all,
+                                 std::filesystem::perm_options::replace, ec);
+  }
+  if (ec) {
+    return false;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  // 与编译服务器检查套接字目录相同，但不接受粘滞位：其他用户在粘滞
+  // 目录中不能替换已有的缓存项，却可以放入尚未写出的缓存项
+  struct stat status;
+  if (::lstat(directory_.c_str(), &status) < 0 || !S_ISDIR(status.st_mode)) {
+    return false;
+  }
+  bool trustedOwner = status.st_uid == ::getuid() || status.st_uid == 0;
+  return trustedOwner && (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#else
+  return std::filesystem::is_directory(directory_, ec);
+#endif
+}
+
+std::filesystem::path AstCache::entryPath(uint64_t sourceHash) const {
+  // 键由源码哈希、编译器版本和格式版本组成，任一变化都落到新的缓存项
+  ast::ByteWriter key;
+  key.u64(sourceHash);
+  key.str(compilerVersion());
+  key.u32(ast::AstSerializer::SchemaVersion);
+
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(hashSourceContent(key.data())));
+  return directory_ / (std::string(name) + EntryExtension);
+}
+
+std::unique_ptr<ast::Program> AstCache::load(uint64_t sourceHash) const {
+  auto path = entryPath(sourceHash);
+  std::error_code ec;
+  if (!trustedDirectory(false) || !std::filesystem::exists(path, ec)) {
+    return nullptr;
+  }
+  std::shared_ptr<const lexer::SourceBuffer> buffer =
+      lexer::SourceBuffer::fromFile(path);
+  if (!buffer) {
+    return nullptr;
+  }
+
+  // 键只有 64 位，再核对头部，避免哈希碰撞时误用其他模块的 AST
+  std::string_view data = buffer->getText();
+  try {
+    ast::ByteReader in(data);
+    for (char c : Magic) {
+      if (in.u8() != static_cast<uint8_t>(c)) {
+        return nullptr;
+      }
+    }
+    if (in.u64() != sourceHash || in.str() != compilerVersion()) {
+      return nullptr;
+    }
+    // 函数体延迟解码，映射随 Program 一直保留
+    auto program = ast::AstSerializer::deserialize(
+        data.substr(in.position()), buffer, parser::Parser::readSkimmedBody);
+    if (program) {
+      // 更新修改时间，prune 时最近用过的缓存项最后删除
+      std::filesystem::last_write_time(
+          path, std::filesystem::file_time_type::clock::now(), ec);
+    }
+    return program;
+  } catch (const ast::MalformedData &) {
+    return nullptr;
+  }
+}
+
+bool AstCache::store(uint64_t sourceHash,
+                     const ast::Program &program) const {
+  std::string payload;
+  try {
+    payload = ast::AstSerializer::serialize(program);
+  } catch (const std::exception &) {
+    // 无法写出词法单元的函数体有语法错误，留给用到它的时候报告
+    return false;
+  }
+  if (payload.empty()) {
+    return false;
+  }
+
+  // 缓存项反序列化后直接使用，目录只允许当前用户访问
+  if (!trustedDirectory(true)) {
+    return false;
+  }
+
+  ast::ByteWriter out;
+  out.bytes(std::string_view(Magic, sizeof(Magic)));
+  out.u64(sourceHash);
+  out.str(compilerVersion());
+  out.bytes(payload);
+  return writeFileAtomically(entryPath(sourceHash), out.data());
+}
+
+void AstCache::prune(uintmax_t maxBytes) const {
+  struct Entry {
+    std::filesystem::path path;
+    std::filesystem::file_time_type time;
+    uintmax_t size;
+  };
+  if (!trustedDirectory(false)) {
+    return;
+  }
+  std::vector<Entry> entries;
+  uintmax_t total = 0;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(directory_, ec), end;
+       !ec && it != end; it.increment(ec)) {
+    if (it->path().extension() != EntryExtension ||
+        !it->is_regular_file(ec)) {
+      continue;
+    }
+    std::error_code entryError;
+    auto size = it->file_size(entryError);
+    auto time = it->last_write_time(entryError);
+    if (entryError) {
+      continue;
+    }
+    entries.push_back({it->path(), time, size});
+    total += size;
+  }
+  if (total <= maxBytes) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.time < b.time; });
+  for (const auto &entry : entries) {
+    if (total <= maxBytes) {
+      break;
+    }
+    std::error_code removeError;
+    if (std::filesystem::remove(entry.path, removeError)) {
+      total -= entry.size;
+    }
+  }
+}
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../ast/others/Program.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace c_hat {
+namespace semantic {
+
+// 以内容寻址的 AST 缓存
+// 缓存项以源码内容哈希、编译器版本和 AST 格式版本共同决定的键命名，
+// 源码未变化的模块直接映射缓存项反序列化，不再词法和语法分析。
+// 缓存目录由调用方指定（通常在构建目录下），不存在时以 0700 权限创建。
+// 缓存项反序列化后直接使用，每次读写前检查目录属于当前用户（或 root）
+// 且组和其他用户不能写入，检查不通过时不使用缓存（读取总是未命中，
+// 写入和清理什么也不做）。
+class AstCache {
+public:
+  // prune 默认保留的缓存项总大小
+  static constexpr uintmax_t DefaultMaxBytes = 256 * 1024 * 1024;
+
+  explicit AstCache(std::filesystem::path directory);
+
+  // 编译器版本，不同版本写出的缓存项互不复用
+  static const char *compilerVersion();
+
+  const std::filesystem::path &getDirectory() const { return directory_; }
+
+  // 源码内容哈希对应的缓存项路径
+  std::filesystem::path entryPath(uint64_t sourceHash) const;
+
+  // 读取缓存项，未命中或缓存项损坏时返回 nullptr
+  std::unique_ptr<ast::Program> load(uint64_t sourceHash) const;
+
+  // 写入缓存项（先写临时文件再改名），失败时返回 false
+  bool store(uint64_t sourceHash, const ast::Program &program) const;
+
+  // 缓存项总大小超过 maxBytes 时，按最近使用时间从旧到新删除缓存项
+  void prune(uintmax_t maxBytes = DefaultMaxBytes) const;
+
+private:
+  std::filesystem::path directory_;
+
+  // 缓存目录是否可以信任，create 为 true 时先创建不存在的目录
+  bool trustedDirectory(bool create) const;
+};
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace c_hat {
+namespace semantic {
+
+// 有界阻塞队列
+// 队列满时 push 阻塞，生产者最多领先消费者 capacity 个元素；
+// close 之后 push 直接返回 false，pop 取完剩余元素后返回 std::nullopt。
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1) {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  // 放入元素，队列已关闭时返回 false
+  bool push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock,
+                  [this] { return closed_ || items_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(value));
+    notEmpty_.notify_one();
+    return true;
+  }
+
+  // 取出元素，队列已关闭且为空时返回 std::nullopt
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    T value = std::move(items_.front());
+    items_.pop_front();
+    notFull_.notify_one();
+    return value;
+  }
+
+  // 关闭队列，唤醒所有等待的生产者和消费者
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    notFull_.notify_all();
+    notEmpty_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable notFull_;
+  std::condition_variable notEmpty_;
+  std::deque<T> items_;
+  size_t capacity_;
+  bool closed_ = false;
+};
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,139 @@
+#include "BuildDatabase.h"
+#include "../ast/ByteStream.h"
+#include "../lexer/SourceBuffer.h"
+#include "ModuleInterface.h"
+#include <algorithm>
+
+namespace c_hat {
+namespace semantic {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 文件格式：
+//   "CHB\0" u32 格式版本
+//   u32 单元数 { 名称 u64 源码哈希 u64 接口哈希 u8 有 main
+//               u32 导入数 { 模块名 u64 接口哈希 } }
+constexpr char Magic[4] = {'C', 'H', 'B', '\0'};
+
+} // namespace
+
+BuildDatabase::BuildDatabase(fs::path file) : file_(std::move(file)) {
+  std::error_code ec;
+  if (!fs::exists(file_, ec)) {
+    return;
+  }
+  auto buffer = lexer::SourceBuffer::fromFile(file_);
+  if (!buffer) {
+    return;
+  }
+
+  try {
+    ast::ByteReader in(buffer->getText());
+    for (char c : Magic) {
+      if (in.u8() != static_cast<uint8_t>(c)) {
+        return;
+      }
+    }
+    if (in.u32() != FormatVersion) {
+      return;
+    }
+
+    std::unordered_map<std::string, Entry> entries;
+    for (uint32_t i = 0, n = in.count(); i < n; ++i) {
+      std::string name = in.str();
+      Entry entry;
+      entry.sourceHash = in.u64();
+      entry.interfaceHash = in.u64();
+      entry.hasMain = in.boolean();
+      for (uint32_t j = 0, m = in.count(); j < m; ++j) {
+        std::string moduleName = in.str();
+        entry.imports.emplace_back(std::move(moduleName), in.u64());
+      }
+      entries.emplace(std::move(name), std::move(entry));
+    }
+    if (in.atEnd()) {
+      entries_ = std::move(entries);
+    }
+  } catch (const ast::MalformedData &) {
+    // 损坏的记录等同于没有记录，全部重新构建
+  }
+}
+
+bool BuildDatabase::find(const std::string &name, Entry &entry) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(name);
+  if (it == entries_.end()) {
+    return false;
+  }
+  entry = it->second;
+  return true;
+}
+
+std::string BuildDatabase::checkOutdated(const std::string &name,
+                                         const Entry &current) const {
+  Entry previous;
+  if (!find(name, previous)) {
+    return "not built before";
+  }
+  if (previous.sourceHash != current.sourceHash) {
+    return "source changed";
+  }
+  for (const auto &[moduleName, interfaceHash] : current.imports) {
+    auto it = std::find_if(
+        previous.imports.begin(), previous.imports.end(),
+        [&](const auto &import) { return import.first == moduleName; });
+    if (it == previous.imports.end()) {
+      return "new import " + moduleName;
+    }
+    if (it->second != interfaceHash) {
+      return "interface of " + moduleName + " changed";
+    }
+  }
+  if (previous.imports.size() != current.imports.size()) {
+    return "imports changed";
+  }
+  return {};
+}
+
+void BuildDatabase::record(const std::string &name, Entry entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_[name] = std::move(entry);
+}
+
+void BuildDatabase::addRebuild(const std::string &name,
+                               const std::string &reason) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rebuilds_.push_back({name, reason});
+}
+
+std::vector<BuildDatabase::Rebuild> BuildDatabase::getRebuilds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rebuilds_;
+}
+
+bool BuildDatabase::save() const {
+  ast::ByteWriter out;
+  out.bytes(std::string_view(Magic, sizeof(Magic)));
+  out.u32(FormatVersion);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  out.u32(static_cast<uint32_t>(entries_.size()));
+  for (const auto &[name, entry] : entries_) {
+    out.str(name);
+    out.u64(entry.sourceHash);
+    out.u64(entry.interfaceHash);
+    out.u8(entry.hasMain);
+    out.u32(static_cast<uint32_t>(entry.imports.size()));
+    for (const auto &[moduleName, interfaceHash] : entry.imports) {
+      out.str(moduleName);
+      out.u64(interfaceHash);
+    }
+  }
+
+  return writeFileAtomically(file_, out.data());
+}
+
+} // namespace semantic
+} // namespace c_hat
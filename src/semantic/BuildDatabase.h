@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 增量构建数据库
+// 为每个模块和翻译单元记录源码哈希和它导入的模块的接口哈希。重新构建时
+// 只有源码变化、或导入的接口变化的单元需要重新分析（翻译单元还需重新
+// 生成代码）；只改函数体不改变模块接口，导入它的单元保持最新。
+// 多个线程可以同时查询和记录。
+class BuildDatabase {
+public:
+  // 文件格式版本，格式变化时递增，旧文件随之失效
+  static constexpr uint32_t FormatVersion = 1;
+
+  struct Entry {
+    uint64_t sourceHash = 0;
+
+    // 模块接口的哈希（含其依赖的接口哈希），翻译单元为 0
+    uint64_t interfaceHash = 0;
+
+    // 直接导入的模块名及当时的接口哈希，按导入顺序排列
+    std::vector<std::pair<std::string, uint64_t>> imports;
+
+    // 翻译单元定义了 main 函数
+    bool hasMain = false;
+  };
+
+  // 一次重新构建的单元及原因
+  struct Rebuild {
+    std::string name;
+    std::string reason;
+  };
+
+  // 读取 file 中保存的记录，文件不存在、损坏或版本不匹配时从空记录开始
+  explicit BuildDatabase(std::filesystem::path file);
+
+  const std::filesystem::path &getFile() const { return file_; }
+
+  // 上次构建的记录，没有记录时返回 false
+  bool find(const std::string &name, Entry &entry) const;
+
+  // 与上次构建的记录比较（不比较 interfaceHash），返回需要重新构建的原因，
+  // 已是最新时返回空字符串
+  std::string checkOutdated(const std::string &name,
+                            const Entry &current) const;
+
+  // 记录单元本次构建的结果
+  void record(const std::string &name, Entry entry);
+
+  // 记录本次重新构建的单元及原因
+  void addRebuild(const std::string &name, const std::string &reason);
+
+  // 本次重新构建的单元，按完成顺序排列
+  std::vector<Rebuild> getRebuilds() const;
+
+  // 保存记录（先写临时文件再改名），失败时返回 false
+  bool save() const;
+
+private:
+  std::filesystem::path file_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::vector<Rebuild> rebuilds_;
+};
+
+} // namespace semantic
+} // namespace c_hat
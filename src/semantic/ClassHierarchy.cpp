@@ -0,0 +1,135 @@
+#include "ClassHierarchy.h"
+
+namespace c_hat {
+namespace semantic {
+
+bool ClassHierarchy::isSubclassOf(const types::ClassType *derived,
+                                  const types::ClassType *base) {
+  if (!derived || !base) {
+    return false;
+  }
+  ++stats_.queries;
+  size_t derivedIndex = registerClass(derived);
+  size_t baseIndex = registerClass(base);
+  if (!numbered_) {
+    renumber();
+  }
+
+  if (inInterval(derivedIndex, baseIndex)) {
+    ++stats_.intervalHits;
+    return true;
+  }
+  if (!nodes_[derivedIndex].multiple) {
+    ++stats_.intervalHits;
+    return false;
+  }
+  auto it = memo_.find(memoKey(derivedIndex, baseIndex));
+  if (it != memo_.end()) {
+    ++stats_.memoHits;
+    return it->second;
+  }
+  return search(derivedIndex, baseIndex);
+}
+
+void ClassHierarchy::invalidate() {
+  nodes_.clear();
+  indices_.clear();
+  memo_.clear();
+  numbered_ = false;
+}
+
+size_t ClassHierarchy::registerClass(const types::ClassType *classType) {
+  auto [it, inserted] = indices_.try_emplace(classType->getName(), 0);
+  if (!inserted) {
+    return it->second;
+  }
+  // 先登记自己再登记基类，成环的继承不会无限递归
+  size_t index = nodes_.size();
+  it->second = index;
+  nodes_.emplace_back();
+  numbered_ = false;
+
+  std::vector<size_t> bases;
+  bool multiple = classType->getBaseClasses().size() > 1;
+  for (const auto &baseClass : classType->getBaseClasses()) {
+    if (!baseClass) {
+      continue;
+    }
+    size_t baseIndex = registerClass(baseClass.get());
+    bases.push_back(baseIndex);
+    multiple = multiple || nodes_[baseIndex].multiple;
+  }
+  nodes_[index].bases = std::move(bases);
+  nodes_[index].multiple = multiple;
+  return index;
+}
+
+void ClassHierarchy::renumber() {
+  ++stats_.renumbers;
+  for (auto &node : nodes_) {
+    node.children.clear();
+    node.enter = node.exit = 0;
+  }
+  std::vector<size_t> roots;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i].bases.empty()) {
+      roots.push_back(i);
+    } else {
+      nodes_[nodes_[i].bases.front()].children.push_back(i);
+    }
+  }
+
+  // 用显式的栈遍历，继承链很深时也不会栈溢出
+  uint32_t counter = 0;
+  std::vector<std::pair<size_t, size_t>> stack;
+  for (size_t root : roots) {
+    nodes_[root].enter = ++counter;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+      auto &[index, next] = stack.back();
+      Node &node = nodes_[index];
+      if (next < node.children.size()) {
+        size_t child = node.children[next++];
+        nodes_[child].enter = ++counter;
+        stack.emplace_back(child, 0);
+      } else {
+        node.exit = counter + 1;
+        stack.pop_back();
+      }
+    }
+  }
+  numbered_ = true;
+}
+
+bool ClassHierarchy::inInterval(size_t derived, size_t base) const {
+  const Node &derivedNode = nodes_[derived];
+  const Node &baseNode = nodes_[base];
+  return derivedNode.enter && baseNode.enter < derivedNode.enter &&
+         derivedNode.enter < baseNode.exit;
+}
+
+bool ClassHierarchy::search(size_t derived, size_t base) {
+  if (inInterval(derived, base)) {
+    return true;
+  }
+  if (!nodes_[derived].multiple) {
+    return false;
+  }
+  auto [it, inserted] = memo_.try_emplace(memoKey(derived, base), false);
+  if (!inserted) {
+    return it->second;
+  }
+  // 先记为 false，成环的继承查找回到自己时结束
+  bool result = false;
+  for (size_t baseClass : nodes_[derived].bases) {
+    if (baseClass == base || search(baseClass, base)) {
+      result = true;
+      break;
+    }
+  }
+  memo_[memoKey(derived, base)] = result;
+  return result;
+}
+
+} // namespace semantic
+} // namespace c_hat
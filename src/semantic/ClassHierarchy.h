@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../types/ClassType.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 类层次结构
+// 以每个类的第一个基类为父节点构成森林，深度优先遍历给类编号：沿第一个
+// 基类派生的类的编号都落在祖先的区间 (enter, exit) 内，判断继承关系只需
+// 比较编号。多继承的其余基类不在森林中，祖先中有多继承的类在区间判断
+// 失败后逐层查找基类，结果记在表中。
+// 类按名称区分（与按名称比较基类的规则一致）。类在第一次查询时连同全部
+// 祖先一起登记，登记新类后在下一次查询前重新编号；类添加基类后要调用
+// invalidate()。
+class ClassHierarchy {
+public:
+  struct Stats {
+    // 查询次数
+    size_t queries = 0;
+    // 由区间编号直接得出结果的次数
+    size_t intervalHits = 0;
+    // 由多继承查找结果表得出结果的次数
+    size_t memoHits = 0;
+    // 重新编号的次数
+    size_t renumbers = 0;
+
+    // 不需要查找基类就得出结果的比例，没有查询时为 0
+    double hitRate() const {
+      return queries ? static_cast<double>(intervalHits + memoHits) / queries
+                     : 0.0;
+    }
+  };
+
+  // derived 是否直接或间接继承自 base（同一个类不算）
+  bool isSubclassOf(const types::ClassType *derived,
+                    const types::ClassType *base);
+
+  // 清除登记的类和查找结果
+  void invalidate();
+
+  const Stats &getStats() const { return stats_; }
+
+private:
+  struct Node {
+    // 基类，第一个是森林中的父节点
+    std::vector<size_t> bases;
+    std::vector<size_t> children;
+    // 子树中的类（不含自己）的编号在 (enter, exit) 内，0 表示没有编号
+    // （第一个基类成环的类不在森林中）
+    uint32_t enter = 0;
+    uint32_t exit = 0;
+    // 自己或祖先有多个基类
+    bool multiple = false;
+  };
+
+  std::vector<Node> nodes_;
+  std::unordered_map<std::string, size_t> indices_;
+  // (派生类, 基类) -> 多继承时逐层查找的结果
+  std::unordered_map<uint64_t, bool> memo_;
+  bool numbered_ = false;
+  Stats stats_;
+
+  // 登记类和它的全部祖先，返回类的节点
+  size_t registerClass(const types::ClassType *classType);
+
+  void renumber();
+
+  // derived 是否在 base 的区间内（沿第一个基类继承）
+  bool inInterval(size_t derived, size_t base) const;
+
+  // 逐层查找基类，结果记在表中
+  bool search(size_t derived, size_t base);
+
+  static uint64_t memoKey(size_t derived, size_t base) {
+    return (static_cast<uint64_t>(derived) << 32) | base;
+  }
+};
+
+} // namespace semantic
+} // namespace c_hat
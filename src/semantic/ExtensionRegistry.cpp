@@ -11,14 +11,12 @@ namespace semantic {
 
 void ExtensionRegistry::addExtension(std::shared_ptr<types::Type> extendedType,
                                      ast::ExtensionDecl *extension) {
-  std::string key = getTypeKey(extendedType);
-  extensions_[key].push_back(extension);
+  extensions_[getTypeKey(extendedType)].push_back(extension);
 }
 
 std::vector<ast::ExtensionDecl *> ExtensionRegistry::getExtensionsForType(
     std::shared_ptr<types::Type> type) const {
-  std::string key = getTypeKey(type);
-  auto it = extensions_.find(key);
+  auto it = extensions_.find(getTypeKey(type));
   if (it != extensions_.end()) {
     return it->second;
   }
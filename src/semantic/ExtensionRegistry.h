@@ -26,8 +26,16 @@ public:
 
   void clear();
 
+  // 全部扩展声明，以类型键为键（用于导出模块接口）
+  const std::unordered_map<std::string, std::vector<ast::ExtensionDecl *>> &
+  getAllExtensions() const {
+    return extensions_;
+  }
+
 private:
-  std::unordered_map<std::string, std::vector<ast::ExtensionDecl *>> extensions_;
+  // 以类型键索引扩展声明
+  std::unordered_map<std::string, std::vector<ast::ExtensionDecl *>>
+      extensions_;
 
   std::string getTypeKey(std::shared_ptr<types::Type> type) const;
 };
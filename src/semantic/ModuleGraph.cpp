@@ -0,0 +1,385 @@
+#include "ModuleGraph.h"
+#include "../ast/AstNodes.h"
+#include "../ast/ByteStream.h"
+#include "SemanticAnalyzer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace c_hat {
+namespace semantic {
+
+namespace {
+
+void addEdge(std::vector<ModuleGraph::Module *> &edges,
+             ModuleGraph::Module *module) {
+  if (std::find(edges.begin(), edges.end(), module) == edges.end()) {
+    edges.push_back(module);
+  }
+}
+
+// 收集节点中的导入，语法上导入还可以出现在命名空间、类、结构体、接口和
+// 扩展的成员中
+void collectImports(const ast::Node *node,
+                    std::vector<std::vector<std::string>> &imports) {
+  if (auto *importDecl = dynamic_cast<const ast::ImportDecl *>(node)) {
+    if (std::find(imports.begin(), imports.end(), importDecl->modulePath) ==
+        imports.end()) {
+      imports.push_back(importDecl->modulePath);
+    }
+    return;
+  }
+
+  const std::vector<std::unique_ptr<ast::Node>> *members = nullptr;
+  if (auto *namespaceDecl = dynamic_cast<const ast::NamespaceDecl *>(node)) {
+    members = &namespaceDecl->members;
+  } else if (auto *classDecl = dynamic_cast<const ast::ClassDecl *>(node)) {
+    members = &classDecl->members;
+  } else if (auto *structDecl = dynamic_cast<const ast::StructDecl *>(node)) {
+    members = &structDecl->members;
+  } else if (auto *interfaceDecl =
+                 dynamic_cast<const ast::InterfaceDecl *>(node)) {
+    members = &interfaceDecl->members;
+  } else if (auto *extensionDecl =
+                 dynamic_cast<const ast::ExtensionDecl *>(node)) {
+    members = &extensionDecl->members;
+  }
+  if (members) {
+    for (const auto &member : *members) {
+      collectImports(member.get(), imports);
+    }
+  }
+}
+
+std::vector<std::vector<std::string>>
+collectImports(const ast::Program &program) {
+  std::vector<std::vector<std::string>> imports;
+  for (const auto &decl : program.declarations) {
+    collectImports(decl.get(), imports);
+  }
+  return imports;
+}
+
+// 接口记录的导入模块接口哈希与导入模块当前的不一致时返回原因，
+// 依赖已经全部解析
+std::string checkImportHashes(const ModuleGraph::Module &module) {
+  const auto &imports = module.interface->getImports();
+  const auto &hashes = module.interface->getImportHashes();
+  for (size_t i = 0; i < imports.size(); ++i) {
+    for (const auto *dependency : module.dependencies) {
+      if (dependency->path == imports[i] &&
+          dependency->interfaceHash != hashes[i]) {
+        return "interface of " + dependency->name + " changed";
+      }
+    }
+  }
+  return std::string();
+}
+
+} // namespace
+
+ModuleGraph::Module::Module(std::vector<std::string> path, std::string name)
+    : path(std::move(path)), name(std::move(name)) {}
+
+ModuleGraph::Module::~Module() = default;
+
+ModuleGraph::ModuleGraph(std::unique_ptr<ModuleLoader> loader)
+    : loader_(std::move(loader)) {}
+
+ModuleGraph::~ModuleGraph() = default;
+
+std::vector<std::vector<std::string>>
+ModuleGraph::scanImports(const ast::Program &program) {
+  return collectImports(program);
+}
+
+void ModuleGraph::prefetch(const ast::Program &program) {
+  prefetch(std::vector<const ast::Program *>{&program});
+}
+
+void ModuleGraph::prefetch(const std::vector<const ast::Program *> &programs) {
+  if (jobs_ <= 1) {
+    return;
+  }
+
+  ThreadPool pool(jobs_);
+  std::mutex fetchedMutex;
+  std::vector<Module *> fetched;
+
+  // 第一步：并行读取模块的接口或源码，扫描出的导入继续提交
+  std::function<void(const std::vector<std::string> &)> submitFetch =
+      [&](const std::vector<std::string> &modulePath) {
+        Module *module = addModule(modulePath);
+        if (!module) {
+          return;
+        }
+        module->prefetched = true;
+        {
+          std::lock_guard<std::mutex> lock(fetchedMutex);
+          fetched.push_back(module);
+        }
+        pool.submit([&, module] {
+          try {
+            fetch(*module);
+          } catch (...) {
+            module->error = std::current_exception();
+            return;
+          }
+          for (const auto &dependency : module->imports) {
+            submitFetch(dependency);
+          }
+        });
+      };
+  for (const auto *program : programs) {
+    for (const auto &modulePath : collectImports(*program)) {
+      submitFetch(modulePath);
+    }
+  }
+  pool.wait();
+
+  // 第二步：依赖都分析完的模块进入线程池，分析完成后检查依赖它的模块
+  std::unordered_map<Module *, std::vector<Module *>> dependents;
+  std::unordered_map<Module *, size_t> waiting;
+  std::vector<Module *> ready;
+  for (Module *module : fetched) {
+    size_t count = 0;
+    for (const auto &modulePath : module->imports) {
+      Module *dependency = findModule(modulePath);
+      if (dependency && dependency->loading) {
+        dependents[dependency].push_back(module);
+        ++count;
+      }
+    }
+    waiting[module] = count;
+    if (count == 0) {
+      ready.push_back(module);
+    }
+  }
+
+  std::mutex waitingMutex;
+  std::function<void(Module *)> submitResolve = [&](Module *module) {
+    pool.submit([&, module] {
+      // 依赖加载失败时跳过该模块，留给首次导入时按顺序加载，
+      // 报告的错误与逐个加载时相同
+      bool dependenciesLoaded = true;
+      for (const auto &modulePath : module->imports) {
+        Module *dependency = findModule(modulePath);
+        if (dependency && dependency->loading) {
+          dependenciesLoaded = false;
+          break;
+        }
+      }
+      if (dependenciesLoaded && !module->error) {
+        try {
+          resolve(*module);
+        } catch (...) {
+          module->error = std::current_exception();
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(waitingMutex);
+      for (Module *dependent : dependents[module]) {
+        if (--waiting[dependent] == 0) {
+          submitResolve(dependent);
+        }
+      }
+    });
+  };
+  for (Module *module : ready) {
+    submitResolve(module);
+  }
+  pool.wait();
+}
+
+ModuleGraph::Module *
+ModuleGraph::import(Module *importer,
+                    const std::vector<std::string> &modulePath) {
+  Module *module = findModule(modulePath);
+  if (!module || module->loading) {
+    std::lock_guard<std::recursive_mutex> loadLock(loadMutex_);
+    // 等锁期间其他线程可能已经加载了该模块
+    module = findModule(modulePath);
+    if (!module) {
+      module = load(modulePath);
+    } else if (module->prefetched || module->error) {
+      complete(*module);
+    } else if (module->loading) {
+      throw std::runtime_error("Circular dependency detected in module: " +
+                               module->name);
+    }
+  }
+
+  if (importer) {
+    // 导入方模块只在分析它的线程中修改
+    addEdge(importer->dependencies, module);
+  } else {
+    std::lock_guard<std::mutex> lock(mutex_);
+    addEdge(roots_, module);
+  }
+  return module;
+}
+
+ModuleGraph::Module *
+ModuleGraph::findModule(const std::vector<std::string> &modulePath) const {
+  std::string name = loader_->modulePathToString(modulePath);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = modules_.find(name);
+  return it != modules_.end() ? it->second.get() : nullptr;
+}
+
+size_t ModuleGraph::getModuleCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return modules_.size();
+}
+
+void ModuleGraph::dropFailedModules() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::erase_if(modules_, [this](const auto &entry) {
+    if (!entry.second->error) {
+      return false;
+    }
+    // 加载器记得读取过的模块，不忘记就不会重新读取源码
+    loader_->unloadModule(entry.second->path);
+    return true;
+  });
+}
+
+void ModuleGraph::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &[name, module] : modules_) {
+    loader_->unloadModule(module->path);
+  }
+  modules_.clear();
+  roots_.clear();
+}
+
+ModuleGraph::Module *
+ModuleGraph::addModule(const std::vector<std::string> &modulePath) {
+  std::string name = loader_->modulePathToString(modulePath);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto [it, inserted] =
+      modules_.emplace(name, std::make_unique<Module>(modulePath, name));
+  return inserted ? it->second.get() : nullptr;
+}
+
+ModuleGraph::Module *
+ModuleGraph::load(const std::vector<std::string> &modulePath) {
+  Module *module = addModule(modulePath);
+  complete(*module);
+  return module;
+}
+
+void ModuleGraph::complete(Module &module) {
+  try {
+    if (module.error) {
+      std::rethrow_exception(module.error);
+    }
+    if (!module.prefetched) {
+      fetch(module);
+    }
+    resolve(module);
+  } catch (...) {
+    // 依赖它的模块随异常一起失败，同样记下异常
+    module.error = std::current_exception();
+    throw;
+  }
+}
+
+void ModuleGraph::fetch(Module &module) {
+  if (auto interface = loader_->loadInterface(module.path)) {
+    module.imports = interface->getImports();
+    module.interface = std::move(interface);
+  } else {
+    module.program = loader_->loadModule(module.path);
+    if (module.program) {
+      module.imports = collectImports(*module.program);
+    }
+  }
+}
+
+void ModuleGraph::resolve(Module &module) {
+  // 此后再导入该模块说明存在循环依赖
+  module.prefetched = false;
+
+  if (module.interface) {
+    // 接口记录了模块的依赖，同样加入模块图
+    for (const auto &dependency : module.imports) {
+      import(&module, dependency);
+    }
+    // 依赖的接口变化后，按源码哈希仍然有效的接口也可能过期
+    std::string reason =
+        buildDatabase_
+            ? buildDatabase_->checkOutdated(module.name, buildEntry(module))
+            : std::string();
+    if (reason.empty()) {
+      reason = checkImportHashes(module);
+    }
+    if (!reason.empty()) {
+      module.interface.reset();
+      module.program = loader_->reloadModule(module.path);
+      analyze(module);
+      if (buildDatabase_) {
+        buildDatabase_->addRebuild(module.name, reason);
+      }
+    }
+  } else {
+    analyze(module);
+    if (buildDatabase_) {
+      std::string reason =
+          buildDatabase_->checkOutdated(module.name, buildEntry(module));
+      buildDatabase_->addRebuild(
+          module.name, reason.empty() ? "interface file missing" : reason);
+    }
+  }
+
+  ast::ByteWriter hashInput;
+  hashInput.u64(module.interface ? module.interface->getInterfaceHash() : 0);
+  for (const auto *dependency : module.dependencies) {
+    hashInput.u64(dependency->interfaceHash);
+  }
+  module.interfaceHash = hashSourceContent(hashInput.data());
+  if (buildDatabase_) {
+    buildDatabase_->record(module.name, buildEntry(module));
+  }
+  module.loading = false;
+}
+
+void ModuleGraph::analyze(Module &module) {
+  if (!module.program) {
+    return;
+  }
+
+  // 模块自己的导入通过同一个模块图解析
+  module.analyzer.reset(new SemanticAnalyzer(*this, module));
+  auto &analyzer = *module.analyzer;
+  auto builtins = analyzer.getSymbolTable().getGlobalSymbols();
+  analyzer.analyze(*module.program);
+  ++analyzedCount_;
+
+  auto interface = ModuleInterface::collect(
+      module.path, loader_->getSourceHash(module.path),
+      analyzer.getSymbolTable(), builtins, analyzer.getExtensionRegistry());
+  for (const auto *dependency : module.dependencies) {
+    interface->addImport(dependency->path, dependency->interfaceHash);
+  }
+  interface->updateInterfaceHash();
+  // 有错误的模块不写出接口，下次仍然从源码分析并报告错误
+  if (!analyzer.hasError()) {
+    loader_->saveInterface(*interface);
+  }
+  module.interface = std::move(interface);
+}
+
+BuildDatabase::Entry ModuleGraph::buildEntry(const Module &module) const {
+  BuildDatabase::Entry entry;
+  entry.sourceHash = loader_->getSourceHash(module.path);
+  entry.interfaceHash = module.interfaceHash;
+  for (const auto *dependency : module.dependencies) {
+    entry.imports.emplace_back(dependency->name, dependency->interfaceHash);
+  }
+  return entry;
+}
+
+} // namespace semantic
+} // namespace c_hat
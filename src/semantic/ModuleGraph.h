@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../ast/others/Program.h"
+#include "BuildDatabase.h"
+#include "ModuleInterface.h"
+#include "ModuleLoader.h"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+class SemanticAnalyzer;
+
+// 模块图
+// 每个模块只加载、分析一次，分析结果由所有导入方共享，导入关系记录为
+// 显式的依赖边。菱形导入（A→C、B→C）中 C 只分析一次，分析次数不再随
+// 导入路径的数量增长。
+// 设置了多个线程时，prefetch 先读取全部可达模块、扫描出导入图，再在
+// 线程池中按拓扑顺序同时分析互不依赖的模块。多个入口程序（并行编译的
+// 翻译单元）可以共享一个模块图，在各自的线程中同时导入模块。
+// 设置了构建数据库时，从预编译接口加载的模块还要检查它导入的接口是否
+// 变化，变化了就重新分析源码；重新分析的模块和原因记录在数据库中。
+class ModuleGraph {
+public:
+  struct Module {
+    Module(std::vector<std::string> path, std::string name);
+    ~Module();
+
+    std::vector<std::string> path;
+    std::string name;
+
+    // 从源码分析时的语法树和分析器（分析器持有模块的符号表和扩展注册表，
+    // 扩展注册表引用语法树，因此语法树声明在前、最后析构）；
+    // 从预编译接口加载时二者为空
+    std::unique_ptr<ast::Program> program;
+    std::unique_ptr<SemanticAnalyzer> analyzer;
+
+    // 模块导出的接口
+    std::shared_ptr<const ModuleInterface> interface;
+
+    // 接口哈希，包含依赖模块的接口哈希，依赖的接口变化时随之变化
+    uint64_t interfaceHash = 0;
+
+    // 直接依赖的模块，按导入顺序排列
+    std::vector<Module *> dependencies;
+
+    // 源码（或接口记录）中的直接导入，按出现顺序排列，在分析之前确定
+    std::vector<std::vector<std::string>> imports;
+
+    // 正在加载，再次导入说明存在循环依赖；加载失败的模块一直为 true。
+    // 已加载完的模块不经过 loadMutex_ 导入，因此是原子变量
+    std::atomic<bool> loading = true;
+
+    // prefetch 已读取源码或接口但没有分析（导入链有环，或依赖加载失败），
+    // 首次导入时按顺序完成加载。prefetched 和 error 只在持有 loadMutex_
+    // 或 prefetch 独占模块图时访问
+    bool prefetched = false;
+
+    // 加载或分析失败的异常，之后每次导入都重新抛出
+    std::exception_ptr error;
+  };
+
+  explicit ModuleGraph(std::unique_ptr<ModuleLoader> loader);
+  ~ModuleGraph();
+
+  ModuleGraph(const ModuleGraph &) = delete;
+  ModuleGraph &operator=(const ModuleGraph &) = delete;
+
+  ModuleLoader &getLoader() { return *loader_; }
+
+  // 并行加载模块使用的线程数，默认为 1（逐个加载）
+  void setJobs(size_t jobs) { jobs_ = jobs > 0 ? jobs : 1; }
+  size_t getJobs() const { return jobs_; }
+
+  // 增量构建使用的构建数据库，为 nullptr 时只按源码哈希使用预编译接口
+  // 数据库由调用方持有，须在导入模块之前设置
+  void setBuildDatabase(BuildDatabase *buildDatabase) {
+    buildDatabase_ = buildDatabase;
+  }
+  BuildDatabase *getBuildDatabase() const { return buildDatabase_; }
+
+  // 程序中的全部导入（含命名空间、类等成员中的导入），按出现顺序去重
+  static std::vector<std::vector<std::string>>
+  scanImports(const ast::Program &program);
+
+  // 预取入口程序（传递）导入的全部模块，线程数为 1 时什么也不做
+  // 之后的 import 直接取用分析好的模块；导入边、错误和循环依赖的报告
+  // 与逐个加载时相同。预取时不能有其他线程在导入模块
+  void prefetch(const ast::Program &program);
+  void prefetch(const std::vector<const ast::Program *> &programs);
+
+  // 导入模块：首次导入时加载并分析，之后直接返回同一个模块
+  // importer 为导入方模块，入口程序为 nullptr。存在循环依赖时抛出
+  // std::runtime_error
+  Module *import(Module *importer, const std::vector<std::string> &modulePath);
+
+  // 查找已导入的模块，未导入时返回 nullptr
+  Module *findModule(const std::vector<std::string> &modulePath) const;
+
+  // 入口程序直接导入的模块
+  const std::vector<Module *> &getRoots() const { return roots_; }
+
+  // 已导入的模块数，含加载失败的模块
+  size_t getModuleCount() const;
+
+  // 移出加载失败的模块，之后的导入重新加载它们（缺少的模块可能已经
+  // 创建）。失败的模块没有被其他模块依赖，但其他线程可能持有它的
+  // 指针，因此不能与导入同时调用
+  void dropFailedModules();
+
+  // 移出全部模块，之后的导入从源码（或 AST 缓存）重新加载。不能与导入
+  // 同时调用，也不能还有分析器在使用已导入模块的符号
+  void clear();
+
+  // 从源码分析过的模块数
+  size_t getAnalyzedCount() const { return analyzedCount_; }
+
+private:
+  // 创建模块节点并按顺序加载
+  Module *load(const std::vector<std::string> &modulePath);
+
+  // 创建模块节点，已存在时返回 nullptr
+  Module *addModule(const std::vector<std::string> &modulePath);
+
+  // 按顺序完成模块的加载，失败时记下异常并重新抛出。失败的模块不移出
+  // 模块图：其他线程可能已经取得它的指针
+  void complete(Module &module);
+
+  // 读取模块的预编译接口，没有可用接口时解析源码，并记录直接导入
+  void fetch(Module &module);
+
+  // 导入接口记录的依赖，或分析源码并保存接口
+  void resolve(Module &module);
+
+  void analyze(Module &module);
+
+  // 模块在构建数据库中的记录
+  BuildDatabase::Entry buildEntry(const Module &module) const;
+
+  std::unique_ptr<ModuleLoader> loader_;
+  size_t jobs_ = 1;
+  BuildDatabase *buildDatabase_ = nullptr;
+
+  // 保护 modules_ 和 roots_（多个线程同时查找和添加模块）
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Module>> modules_;
+  std::vector<Module *> roots_;
+
+  // 需要加载模块的导入逐个进行，已加载完的模块不经过这把锁；
+  // 加载时递归导入依赖，因此是递归锁
+  std::recursive_mutex loadMutex_;
+  std::atomic<size_t> analyzedCount_ = 0;
+};
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,274 @@
+#include "ModuleIndex.h"
+#include "../ast/ByteStream.h"
+#include "../lexer/SourceBuffer.h"
+#include "ModuleInterface.h"
+#include <map>
+#include <mutex>
+
+namespace c_hat {
+namespace semantic {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 文件格式：
+//   "CHX\0" u32 格式版本 搜索路径列表 排除的目录列表
+//   u32 目录数 { 路径 u64 修改时间 }
+//   u32 模块数 { 模块名 文件路径 u64 修改时间 }
+constexpr char Magic[4] = {'C', 'H', 'X', '\0'};
+
+// 不存在的目录记为最小时间，之后创建时索引随之过期
+fs::file_time_type modifiedTime(const fs::path &path) {
+  std::error_code ec;
+  auto time = fs::last_write_time(path, ec);
+  return ec ? fs::file_time_type::min() : time;
+}
+
+uint64_t encodeTime(fs::file_time_type time) {
+  return static_cast<uint64_t>(time.time_since_epoch().count());
+}
+
+fs::file_time_type decodeTime(uint64_t value) {
+  return fs::file_time_type(fs::file_time_type::duration(
+      static_cast<fs::file_time_type::rep>(value)));
+}
+
+// 比较目录时使用的规范路径，不存在的部分保持原样
+fs::path canonicalPath(const fs::path &path) {
+  std::error_code ec;
+  auto canonical = fs::weakly_canonical(path, ec);
+  return ec ? path.lexically_normal() : canonical;
+}
+
+} // namespace
+
+ModuleIndex::ModuleIndex(std::vector<fs::path> roots,
+                         std::set<fs::path> excluded)
+    : roots_(std::move(roots)), excluded_(std::move(excluded)) {
+  for (const auto &root : roots_) {
+    scanRoot(root);
+  }
+}
+
+std::shared_ptr<const ModuleIndex>
+ModuleIndex::get(const std::vector<fs::path> &roots, const fs::path &indexFile,
+                 const std::set<fs::path> &excluded) {
+  static std::mutex mutex;
+  static std::map<std::pair<std::vector<fs::path>, std::set<fs::path>>,
+                  std::shared_ptr<const ModuleIndex>>
+      cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &index = cache[{roots, excluded}];
+  if (index && index->isUpToDate()) {
+    return index;
+  }
+
+  if (!indexFile.empty()) {
+    auto saved = readFile(indexFile);
+    if (saved && saved->roots_ == roots && saved->excluded_ == excluded &&
+        saved->isUpToDate()) {
+      index = std::move(saved);
+      return index;
+    }
+    // 索引文件的目录在扫描之前创建，它位于搜索路径中时不会让刚建立的
+    // 索引过期
+    std::error_code ec;
+    fs::create_directories(indexFile.parent_path(), ec);
+  }
+
+  auto scanned = std::make_shared<const ModuleIndex>(roots, excluded);
+  if (!indexFile.empty()) {
+    // 写入失败只影响下次启动的速度
+    scanned->writeFile(indexFile);
+  }
+  index = std::move(scanned);
+  return index;
+}
+
+const ModuleIndex::Entry *
+ModuleIndex::find(const std::string &moduleName) const {
+  auto it = modules_.find(moduleName);
+  return it != modules_.end() ? &it->second : nullptr;
+}
+
+bool ModuleIndex::isUpToDate() const {
+  for (const auto &[directory, time] : directories_) {
+    if (modifiedTime(directory) != time) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ModuleIndex::scanRoot(const fs::path &root) {
+  directories_.emplace_back(root, modifiedTime(root));
+  std::error_code ec;
+  if (!fs::is_directory(root, ec)) {
+    return;
+  }
+
+  // 排除的目录按规范路径比较，搜索路径中的目录由规范化的搜索路径拼接
+  // 相对路径得到，不必逐个规范化
+  auto canonicalRoot = canonicalPath(root);
+  std::set<fs::path> excluded;
+  for (const auto &directory : excluded_) {
+    excluded.insert(canonicalPath(directory));
+  }
+
+  // 同一搜索路径中 X.ch 优先于 X/mod.ch，先分开收集再合并
+  std::unordered_map<std::string, Entry> files;
+  std::unordered_map<std::string, Entry> directoryModules;
+  // 遍历时记下子目录的修改时间，扫描完成后只保留含有模块的目录；
+  // 在遍历时取得时间，扫描期间新增的文件也会让索引过期
+  std::map<fs::path, fs::file_time_type> subdirectories;
+  std::set<fs::path> moduleDirectories;
+
+  fs::recursive_directory_iterator it(
+      root, fs::directory_options::skip_permission_denied, ec);
+  for (; !ec && it != fs::recursive_directory_iterator();
+       it.increment(ec)) {
+    const auto &path = it->path();
+    std::string filename = path.filename().string();
+    if (it->is_directory(ec)) {
+      // 隐藏目录（.git 等）不可能是模块，缓存和构建目录不含源码
+      if ((!filename.empty() && filename[0] == '.') ||
+          excluded.count(canonicalRoot / path.lexically_relative(root))) {
+        it.disable_recursion_pending();
+      } else {
+        subdirectories.emplace(path, modifiedTime(path));
+      }
+      continue;
+    }
+    if (path.extension() != ".ch" || !it->is_regular_file(ec)) {
+      continue;
+    }
+
+    auto relative = path.lexically_relative(root);
+    relative.replace_extension();
+    bool isModFile = relative.filename() == "mod";
+    if (isModFile) {
+      relative = relative.parent_path();
+    }
+
+    // 模块名的各段对应目录名和文件名，含 '.' 的文件名无法被导入
+    std::string moduleName;
+    bool importable = true;
+    for (const auto &part : relative) {
+      std::string segment = part.string();
+      if (segment.find('.') != std::string::npos) {
+        importable = false;
+        break;
+      }
+      if (!moduleName.empty()) {
+        moduleName += ".";
+      }
+      moduleName += segment;
+    }
+    if (!importable || moduleName.empty()) {
+      continue;
+    }
+
+    Entry entry{path, it->last_write_time(ec)};
+    (isModFile ? directoryModules : files).emplace(moduleName, entry);
+    for (auto directory = path.parent_path();
+         directory != root && moduleDirectories.insert(directory).second;
+         directory = directory.parent_path()) {
+    }
+  }
+
+  for (const auto &[directory, time] : subdirectories) {
+    if (moduleDirectories.count(directory)) {
+      directories_.emplace_back(directory, time);
+    }
+  }
+
+  // 靠前的搜索路径已经收录的模块不被覆盖
+  modules_.insert(files.begin(), files.end());
+  modules_.insert(directoryModules.begin(), directoryModules.end());
+}
+
+std::shared_ptr<ModuleIndex> ModuleIndex::readFile(const fs::path &path) {
+  std::error_code ec;
+  if (!fs::exists(path, ec)) {
+    return nullptr;
+  }
+  auto buffer = lexer::SourceBuffer::fromFile(path);
+  if (!buffer) {
+    return nullptr;
+  }
+
+  try {
+    ast::ByteReader in(buffer->getText());
+    for (char c : Magic) {
+      if (in.u8() != static_cast<uint8_t>(c)) {
+        return nullptr;
+      }
+    }
+    if (in.u32() != FormatVersion) {
+      return nullptr;
+    }
+
+    std::shared_ptr<ModuleIndex> index(new ModuleIndex());
+    for (auto &root : in.strings()) {
+      index->roots_.emplace_back(std::move(root));
+    }
+    for (auto &directory : in.strings()) {
+      index->excluded_.emplace(std::move(directory));
+    }
+    for (uint32_t i = 0, n = in.count(); i < n; ++i) {
+      fs::path directory = in.str();
+      index->directories_.emplace_back(std::move(directory),
+                                       decodeTime(in.u64()));
+    }
+    for (uint32_t i = 0, n = in.count(); i < n; ++i) {
+      std::string moduleName = in.str();
+      Entry entry;
+      entry.file = in.str();
+      entry.modifiedTime = decodeTime(in.u64());
+      index->modules_.emplace(std::move(moduleName), std::move(entry));
+    }
+    if (!in.atEnd()) {
+      return nullptr;
+    }
+    return index;
+  } catch (const ast::MalformedData &) {
+    return nullptr;
+  }
+}
+
+bool ModuleIndex::writeFile(const fs::path &path) const {
+  ast::ByteWriter out;
+  out.bytes(std::string_view(Magic, sizeof(Magic)));
+  out.u32(FormatVersion);
+
+  std::vector<std::string> roots;
+  for (const auto &root : roots_) {
+    roots.push_back(root.string());
+  }
+  out.strings(roots);
+
+  std::vector<std::string> excluded;
+  for (const auto &directory : excluded_) {
+    excluded.push_back(directory.string());
+  }
+  out.strings(excluded);
+
+  out.u32(static_cast<uint32_t>(directories_.size()));
+  for (const auto &[directory, time] : directories_) {
+    out.str(directory.string());
+    out.u64(encodeTime(time));
+  }
+
+  out.u32(static_cast<uint32_t>(modules_.size()));
+  for (const auto &[moduleName, entry] : modules_) {
+    out.str(moduleName);
+    out.str(entry.file.string());
+    out.u64(encodeTime(entry.modifiedTime));
+  }
+  return writeFileAtomically(path, out.data());
+}
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 模块搜索路径索引
+// 一次扫描全部搜索路径，记下模块名到源文件的映射，解析导入只需一次哈希
+// 查找，不再为每个导入在每个搜索路径上探测 X.ch 和 X/mod.ch。优先级与
+// 逐个探测相同：靠前的搜索路径优先，同一搜索路径中 X.ch 优先于
+// X/mod.ch。索引同时记下搜索路径本身、含有模块的目录及其上级目录的修改
+// 时间，这些目录中增删文件后 isUpToDate() 返回 false。不含模块的目录
+// 不记录，构建时写入的缓存和输出不会让索引过期；这类目录中新增的模块
+// 由 ModuleLoader 逐个探测找到。排除的目录（缓存目录、构建目录）不扫描。
+class ModuleIndex {
+public:
+  // 文件格式版本，格式变化时递增，旧文件随之失效
+  static constexpr uint32_t FormatVersion = 2;
+
+  struct Entry {
+    std::filesystem::path file;
+    std::filesystem::file_time_type modifiedTime;
+  };
+
+  // 扫描搜索路径建立索引，跳过 excluded 中的目录
+  explicit ModuleIndex(std::vector<std::filesystem::path> roots,
+                       std::set<std::filesystem::path> excluded = {});
+
+  // 取得搜索路径的索引
+  // 依次使用进程内缓存、indexFile 中保存的索引（indexFile 为空时不使用），
+  // 都已过期时重新扫描，并在 indexFile 非空时写回
+  static std::shared_ptr<const ModuleIndex>
+  get(const std::vector<std::filesystem::path> &roots,
+      const std::filesystem::path &indexFile = {},
+      const std::set<std::filesystem::path> &excluded = {});
+
+  const std::vector<std::filesystem::path> &getRoots() const { return roots_; }
+
+  const std::set<std::filesystem::path> &getExcluded() const {
+    return excluded_;
+  }
+
+  // 记录了修改时间的目录数
+  size_t getDirectoryCount() const { return directories_.size(); }
+
+  // 查找模块（如 "std.io"），不存在时返回 nullptr
+  const Entry *find(const std::string &moduleName) const;
+
+  size_t size() const { return modules_.size(); }
+
+  // 扫描过的目录都没有被修改（增删文件会改变目录的修改时间）
+  bool isUpToDate() const;
+
+  // 读取保存的索引，文件不存在、损坏或版本不匹配时返回 nullptr
+  static std::shared_ptr<ModuleIndex>
+  readFile(const std::filesystem::path &path);
+
+  // 保存索引（先写临时文件再改名），失败时返回 false
+  bool writeFile(const std::filesystem::path &path) const;
+
+private:
+  ModuleIndex() = default;
+
+  void scanRoot(const std::filesystem::path &root);
+
+  std::vector<std::filesystem::path> roots_;
+  std::set<std::filesystem::path> excluded_;
+
+  // 搜索路径（含不存在的）、含有模块的目录及其上级目录的修改时间
+  std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>
+      directories_;
+
+  std::unordered_map<std::string, Entry> modules_;
+};
+
+} // namespace semantic
+} // namespace c_hat
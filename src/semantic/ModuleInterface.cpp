@@ -0,0 +1,878 @@
+#include "ModuleInterface.h"
+#include "../ast/ByteStream.h"
+#include "../ast/declarations/FunctionDecl.h"
+#include "../ast/declarations/GetterDecl.h"
+#include "../ast/declarations/SetterDecl.h"
+#include "../ast/declarations/VariableDecl.h"
+#include "../lexer/SourceBuffer.h"
+#include "../types/InterfaceType.h"
+#include "../types/TypeFactory.h"
+#include "ModuleSymbol.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#include <atomic>
+#include <process.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <stdlib.h>
+#include <unistd.h>
+#define C_HAT_HAS_MKSTEMP 1
+#endif
+
+namespace c_hat {
+namespace semantic {
+
+uint64_t hashSourceContent(std::string_view text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool writeFileAtomically(const std::filesystem::path &path,
+                         std::string_view data) {
+  std::error_code ec;
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
+
+  // 先写临时文件再改名，读取方不会看到写了一半的文件。临时文件在目标
+  // 目录中以唯一的名字新建，多个进程或线程同时写同一项时互不干扰
+#if defined(C_HAT_HAS_MKSTEMP)
+  std::string tempName = path.string() + ".tmpXXXXXX";
+  int fd = ::mkstemp(tempName.data());
+  if (fd < 0) {
+    return false;
+  }
+  std::filesystem::path tempPath = tempName;
+  bool ok = true;
+  for (size_t written = 0; written < data.size();) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ok = false;
+      break;
+    }
+    written += static_cast<size_t>(n);
+  }
+  if (::close(fd) != 0) {
+    ok = false;
+  }
+  if (!ok) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+#else
+  static std::atomic<uint64_t> counter{0};
+  auto tempPath = path;
+  tempPath += ".tmp" + std::to_string(_getpid()) + "." +
+              std::to_string(std::hash<std::thread::id>{}(
+                  std::this_thread::get_id())) +
+              "." + std::to_string(counter++);
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return false;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      file.close();
+      std::filesystem::remove(tempPath, ec);
+      return false;
+    }
+  }
+#endif
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+namespace {
+
+// .chi 文件格式（整数均为小端序，字符串为 u32 长度加字节）：
+//   "CHI\0" u32 版本 u64 源码哈希 模块路径
+//   导入：u32 个数、各模块路径及其接口哈希（u64）
+//   类型表：u32 条目数、各条目；u32 类体数、各类体
+//   符号：u32 个数、各符号
+//   扩展：u32 个数、各扩展
+constexpr char Magic[4] = {'C', 'H', 'I', '\0'};
+// 文件头（标识、版本和源码哈希）之后是接口内容
+constexpr size_t HeaderSize = sizeof(Magic) + 4 + 8;
+constexpr uint32_t NullTypeIndex = 0xFFFFFFFF;
+
+enum class TypeTag : uint8_t {
+  Primitive,
+  Array,
+  Slice,
+  RectangularArray,
+  RectangularSlice,
+  Pointer,
+  Function,
+  Class,
+  Interface,
+  Generic,
+  Tuple,
+  LiteralView,
+  Readonly,
+  Reference,
+  Nullable,
+};
+
+// 模块接口无法表示的类型
+struct UnsupportedType {};
+
+using ast::ByteReader;
+using ast::ByteWriter;
+
+// .chi 数据损坏
+using MalformedInterface = ast::MalformedData;
+
+template <typename Map> std::vector<std::string> sortedKeys(const Map &map) {
+  std::vector<std::string> keys;
+  for (const auto &entry : map) {
+    keys.push_back(entry.first);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+// 类型表写入器
+// 类型按首次引用的顺序编号，组成类型先于被组成的类型写出。类和接口先写
+// 只含名称的条目，成员在全部条目之后作为类体补写，这样自引用和相互引用
+// 的类也能恢复。
+class TypeTableWriter {
+public:
+  uint32_t ref(const std::shared_ptr<types::Type> &type) {
+    if (!type) {
+      return NullTypeIndex;
+    }
+    auto it = indices_.find(type.get());
+    if (it != indices_.end()) {
+      return it->second;
+    }
+
+    const types::Type *t = type.get();
+    if (auto *classType = dynamic_cast<const types::ClassType *>(t)) {
+      ByteWriter entry;
+      entry.u8(static_cast<uint8_t>(TypeTag::Class));
+      entry.str(classType->getName());
+      entry.strings(classType->getTypeParameters());
+      return addWithBody(t, entry);
+    }
+    if (auto *interfaceType = dynamic_cast<const types::InterfaceType *>(t)) {
+      ByteWriter entry;
+      entry.u8(static_cast<uint8_t>(TypeTag::Interface));
+      entry.str(interfaceType->getName());
+      entry.strings(interfaceType->getTypeParameters());
+      return addWithBody(t, entry);
+    }
+
+    ByteWriter entry;
+    if (auto *primitive = dynamic_cast<const types::PrimitiveType *>(t)) {
+      entry.u8(static_cast<uint8_t>(TypeTag::Primitive));
+      entry.u8(static_cast<uint8_t>(primitive->getKind()));
+    } else if (auto *array = dynamic_cast<const types::ArrayType *>(t)) {
+      uint32_t element = ref(array->getElementType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Array));
+      entry.u32(element);
+      entry.u64(array->getSize());
+    } else if (auto *slice = dynamic_cast<const types::SliceType *>(t)) {
+      uint32_t element = ref(slice->getElementType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Slice));
+      entry.u32(element);
+    } else if (auto *rectArray =
+                   dynamic_cast<const types::RectangularArrayType *>(t)) {
+      uint32_t element = ref(rectArray->getElementType());
+      entry.u8(static_cast<uint8_t>(TypeTag::RectangularArray));
+      entry.u32(element);
+      entry.u32(static_cast<uint32_t>(rectArray->getSizes().size()));
+      for (size_t size : rectArray->getSizes()) {
+        entry.u64(size);
+      }
+    } else if (auto *rectSlice =
+                   dynamic_cast<const types::RectangularSliceType *>(t)) {
+      uint32_t element = ref(rectSlice->getElementType());
+      entry.u8(static_cast<uint8_t>(TypeTag::RectangularSlice));
+      entry.u32(element);
+      entry.u32(static_cast<uint32_t>(rectSlice->getRank()));
+    } else if (auto *pointer = dynamic_cast<const types::PointerType *>(t)) {
+      uint32_t pointee = ref(pointer->getPointeeType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Pointer));
+      entry.u32(pointee);
+      entry.u8(pointer->isNullable());
+    } else if (auto *function = dynamic_cast<const types::FunctionType *>(t)) {
+      uint32_t returnType = ref(function->getReturnType());
+      auto params = refs(function->getParameterTypes());
+      entry.u8(static_cast<uint8_t>(TypeTag::Function));
+      entry.u32(returnType);
+      writeRefs(entry, params);
+    } else if (auto *generic = dynamic_cast<const types::GenericType *>(t)) {
+      auto args = refs(generic->getTypeArguments());
+      entry.u8(static_cast<uint8_t>(TypeTag::Generic));
+      entry.str(generic->getName());
+      writeRefs(entry, args);
+    } else if (auto *tuple = dynamic_cast<const types::TupleType *>(t)) {
+      auto elements = refs(tuple->getElementTypes());
+      entry.u8(static_cast<uint8_t>(TypeTag::Tuple));
+      writeRefs(entry, elements);
+    } else if (dynamic_cast<const types::LiteralViewType *>(t)) {
+      entry.u8(static_cast<uint8_t>(TypeTag::LiteralView));
+    } else if (auto *readonly = dynamic_cast<const types::ReadonlyType *>(t)) {
+      uint32_t base = ref(readonly->getBaseType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Readonly));
+      entry.u32(base);
+    } else if (auto *reference =
+                   dynamic_cast<const types::ReferenceType *>(t)) {
+      uint32_t base = ref(reference->getBaseType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Reference));
+      entry.u32(base);
+    } else if (auto *nullable = dynamic_cast<const types::NullableType *>(t)) {
+      uint32_t base = ref(nullable->getBaseType());
+      entry.u8(static_cast<uint8_t>(TypeTag::Nullable));
+      entry.u32(base);
+    } else {
+      throw UnsupportedType{};
+    }
+    return add(t, entry);
+  }
+
+  // 写出类型表，之后不能再引用新的类型
+  void finish(ByteWriter &out) {
+    ByteWriter bodies;
+    // 写类体时可能引用新的类，pendingBodies_ 会继续增长
+    for (size_t i = 0; i < pendingBodies_.size(); ++i) {
+      writeBody(bodies, pendingBodies_[i]);
+    }
+    out.u32(count_);
+    out.append(entries_);
+    out.u32(static_cast<uint32_t>(pendingBodies_.size()));
+    out.append(bodies);
+  }
+
+private:
+  uint32_t add(const types::Type *type, ByteWriter &entry) {
+    uint32_t index = count_++;
+    indices_[type] = index;
+    entries_.append(entry);
+    return index;
+  }
+
+  uint32_t addWithBody(const types::Type *type, ByteWriter &entry) {
+    uint32_t index = add(type, entry);
+    pendingBodies_.push_back(type);
+    return index;
+  }
+
+  template <typename T>
+  std::vector<uint32_t> refs(const std::vector<std::shared_ptr<T>> &types) {
+    std::vector<uint32_t> result;
+    for (const auto &type : types) {
+      result.push_back(ref(type));
+    }
+    return result;
+  }
+
+  static void writeRefs(ByteWriter &out, const std::vector<uint32_t> &refs) {
+    out.u32(static_cast<uint32_t>(refs.size()));
+    for (uint32_t index : refs) {
+      out.u32(index);
+    }
+  }
+
+  void writeBody(ByteWriter &out, const types::Type *type) {
+    // 先收集引用再写入，引用过程中可能追加新的类型条目
+    ByteWriter body;
+    if (auto *classType = dynamic_cast<const types::ClassType *>(type)) {
+      writeRefs(body, refs(classType->getTypeArguments()));
+      writeRefs(body, refs(classType->getBaseClasses()));
+      writeRefs(body, refs(classType->getInterfaces()));
+
+      const auto &methods = classType->getMethods();
+      body.u32(static_cast<uint32_t>(methods.size()));
+      for (const auto &name : sortedKeys(methods)) {
+        const auto &method = methods.at(name);
+        body.str(method.name);
+        body.u32(ref(method.returnType));
+        writeRefs(body, refs(method.paramTypes));
+        body.u8(method.isVirtual);
+        body.u8(method.isOverride);
+        body.u8(method.isStatic);
+        body.u8(static_cast<uint8_t>(method.access));
+      }
+
+      const auto &fields = classType->getFields();
+      body.u32(static_cast<uint32_t>(fields.size()));
+      for (const auto &name : sortedKeys(fields)) {
+        const auto &field = fields.at(name);
+        body.str(field.name);
+        body.u32(ref(field.type));
+        body.u8(static_cast<uint8_t>(field.access));
+        body.u8(field.isStatic);
+      }
+
+      const auto &properties = classType->getProperties();
+      body.u32(static_cast<uint32_t>(properties.size()));
+      for (const auto &name : sortedKeys(properties)) {
+        const auto &property = properties.at(name);
+        body.str(property.name);
+        body.u32(ref(property.type));
+        body.u8(static_cast<uint8_t>(property.access));
+        body.u8(property.hasGetter);
+        body.u8(property.hasSetter);
+      }
+      body.u8(classType->isAbstract());
+    } else {
+      auto *interfaceType = static_cast<const types::InterfaceType *>(type);
+      writeRefs(body, refs(interfaceType->getBaseInterfaces()));
+
+      const auto &methods = interfaceType->getMethods();
+      body.u32(static_cast<uint32_t>(methods.size()));
+      for (const auto &name : sortedKeys(methods)) {
+        const auto &method = methods.at(name);
+        body.str(method.name);
+        body.u32(ref(method.returnType));
+        writeRefs(body, refs(method.paramTypes));
+        body.u8(method.hasDefaultImplementation);
+        body.u8(static_cast<uint8_t>(method.access));
+      }
+    }
+    out.u32(indices_.at(type));
+    out.append(body);
+  }
+
+  ByteWriter entries_;
+  uint32_t count_ = 0;
+  std::unordered_map<const types::Type *, uint32_t> indices_;
+  std::vector<const types::Type *> pendingBodies_;
+};
+
+// 类型表读取器
+class TypeTableReader {
+public:
+  void read(ByteReader &in) {
+    uint32_t count = in.count();
+    for (uint32_t i = 0; i < count; ++i) {
+      types_.push_back(readEntry(in));
+    }
+    uint32_t bodyCount = in.count();
+    for (uint32_t i = 0; i < bodyCount; ++i) {
+      readBody(in);
+    }
+  }
+
+  std::shared_ptr<types::Type> get(uint32_t index) const {
+    if (index == NullTypeIndex) {
+      return nullptr;
+    }
+    if (index >= types_.size()) {
+      throw MalformedInterface();
+    }
+    return types_[index];
+  }
+
+  template <typename T> std::shared_ptr<T> getAs(uint32_t index) const {
+    auto type = get(index);
+    auto result = std::dynamic_pointer_cast<T>(type);
+    if (type && !result) {
+      throw MalformedInterface();
+    }
+    return result;
+  }
+
+private:
+  std::vector<std::shared_ptr<types::Type>>
+  readRefs(ByteReader &in) const {
+    uint32_t count = in.count();
+    std::vector<std::shared_ptr<types::Type>> result;
+    for (uint32_t i = 0; i < count; ++i) {
+      result.push_back(get(in.u32()));
+    }
+    return result;
+  }
+
+  static types::AccessModifier readAccess(ByteReader &in) {
+    uint8_t access = in.u8();
+    if (access > static_cast<uint8_t>(types::AccessModifier::Protected)) {
+      throw MalformedInterface();
+    }
+    return static_cast<types::AccessModifier>(access);
+  }
+
+  std::shared_ptr<types::Type> readEntry(ByteReader &in) const {
+    auto tag = static_cast<TypeTag>(in.u8());
+    switch (tag) {
+    case TypeTag::Primitive: {
+      uint8_t kind = in.u8();
+      if (kind > static_cast<uint8_t>(types::PrimitiveType::Kind::Char)) {
+        throw MalformedInterface();
+      }
+      return types::TypeFactory::getPrimitiveType(
+          static_cast<types::PrimitiveType::Kind>(kind));
+    }
+    case TypeTag::Array: {
+      auto element = get(in.u32());
+      return types::TypeFactory::getArrayType(element, in.u64());
+    }
+    case TypeTag::Slice:
+      return types::TypeFactory::getSliceType(get(in.u32()));
+    case TypeTag::RectangularArray: {
+      auto element = get(in.u32());
+      uint32_t rank = in.count();
+      std::vector<size_t> sizes;
+      for (uint32_t i = 0; i < rank; ++i) {
+        sizes.push_back(static_cast<size_t>(in.u64()));
+      }
+      return types::TypeFactory::getRectangularArrayType(element,
+                                                         std::move(sizes));
+    }
+    case TypeTag::RectangularSlice: {
+      auto element = get(in.u32());
+      return types::TypeFactory::getRectangularSliceType(
+          element, static_cast<int>(in.u32()));
+    }
+    case TypeTag::Pointer: {
+      auto pointee = get(in.u32());
+      return types::TypeFactory::getPointerType(pointee, in.boolean());
+    }
+    case TypeTag::Function: {
+      auto returnType = get(in.u32());
+      return types::TypeFactory::getFunctionType(returnType, readRefs(in));
+    }
+    case TypeTag::Class: {
+      auto name = in.str();
+      return std::make_shared<types::ClassType>(std::move(name), in.strings());
+    }
+    case TypeTag::Interface: {
+      auto name = in.str();
+      return std::make_shared<types::InterfaceType>(std::move(name),
+                                                    in.strings());
+    }
+    case TypeTag::Generic: {
+      auto name = in.str();
+      return types::TypeFactory::getGenericType(name, readRefs(in));
+    }
+    case TypeTag::Tuple:
+      return types::TypeFactory::getTupleType(readRefs(in));
+    case TypeTag::LiteralView:
+      return types::TypeFactory::getLiteralViewType();
+    case TypeTag::Readonly:
+      return types::TypeFactory::getReadonlyType(get(in.u32()));
+    case TypeTag::Reference:
+      return types::TypeFactory::getReferenceType(get(in.u32()));
+    case TypeTag::Nullable:
+      return types::TypeFactory::getNullableType(get(in.u32()));
+    }
+    throw MalformedInterface();
+  }
+
+  void readBody(ByteReader &in) const {
+    auto type = get(in.u32());
+    if (auto classType = std::dynamic_pointer_cast<types::ClassType>(type)) {
+      classType->setTypeArguments(readRefs(in));
+      for (auto &base : readRefs(in)) {
+        auto baseClass = std::dynamic_pointer_cast<types::ClassType>(base);
+        if (!baseClass) {
+          throw MalformedInterface();
+        }
+        classType->addBaseClass(baseClass);
+      }
+      for (auto &interface : readRefs(in)) {
+        auto interfaceType =
+            std::dynamic_pointer_cast<types::InterfaceType>(interface);
+        if (!interfaceType) {
+          throw MalformedInterface();
+        }
+        classType->addInterface(interfaceType);
+      }
+
+      uint32_t methodCount = in.count();
+      for (uint32_t i = 0; i < methodCount; ++i) {
+        types::ClassMethod method;
+        method.name = in.str();
+        method.returnType = get(in.u32());
+        method.paramTypes = readRefs(in);
+        method.isVirtual = in.boolean();
+        method.isOverride = in.boolean();
+        method.isStatic = in.boolean();
+        method.access = readAccess(in);
+        classType->addMethod(method);
+      }
+
+      uint32_t fieldCount = in.count();
+      for (uint32_t i = 0; i < fieldCount; ++i) {
+        types::ClassField field;
+        field.name = in.str();
+        field.type = get(in.u32());
+        field.access = readAccess(in);
+        field.isStatic = in.boolean();
+        classType->addField(field);
+      }
+
+      uint32_t propertyCount = in.count();
+      for (uint32_t i = 0; i < propertyCount; ++i) {
+        types::ClassProperty property;
+        property.name = in.str();
+        property.type = get(in.u32());
+        property.access = readAccess(in);
+        property.hasGetter = in.boolean();
+        property.hasSetter = in.boolean();
+        classType->addProperty(property);
+      }
+      classType->setAbstract(in.boolean());
+    } else if (auto interfaceType =
+                   std::dynamic_pointer_cast<types::InterfaceType>(type)) {
+      for (auto &base : readRefs(in)) {
+        auto baseInterface =
+            std::dynamic_pointer_cast<types::InterfaceType>(base);
+        if (!baseInterface) {
+          throw MalformedInterface();
+        }
+        interfaceType->addBaseInterface(baseInterface);
+      }
+
+      uint32_t methodCount = in.count();
+      for (uint32_t i = 0; i < methodCount; ++i) {
+        types::InterfaceMethod method;
+        method.name = in.str();
+        method.returnType = get(in.u32());
+        method.paramTypes = readRefs(in);
+        method.hasDefaultImplementation = in.boolean();
+        method.access = readAccess(in);
+        interfaceType->addMethod(method);
+      }
+    } else {
+      throw MalformedInterface();
+    }
+  }
+
+  std::vector<std::shared_ptr<types::Type>> types_;
+};
+
+void writeSymbol(ByteWriter &out, TypeTableWriter &types,
+                 const Symbol &symbol) {
+  out.u8(static_cast<uint8_t>(symbol.getType()));
+  out.str(symbol.getName());
+  out.u8(static_cast<uint8_t>(symbol.getVisibility()));
+
+  switch (symbol.getType()) {
+  case SymbolType::Variable: {
+    const auto &variable = static_cast<const VariableSymbol &>(symbol);
+    out.u32(types.ref(variable.getType()));
+    out.u8(static_cast<uint8_t>(variable.getKind()));
+    out.u8(variable.isConst());
+    break;
+  }
+  case SymbolType::Function: {
+    const auto &function = static_cast<const FunctionSymbol &>(symbol);
+    out.u32(types.ref(function.getType()));
+    out.u8(function.isImmutableMethod());
+    out.u8(function.isExternFunction());
+    out.u8(function.isVariadicFunction());
+    out.u8(function.isInherited());
+    out.u8(function.isTemplate());
+    out.strings(function.getTemplateParamNames());
+    out.str(function.getAbi());
+    break;
+  }
+  case SymbolType::Class:
+    out.u32(types.ref(static_cast<const ClassSymbol &>(symbol).getType()));
+    break;
+  case SymbolType::Struct:
+    out.u32(types.ref(static_cast<const StructSymbol &>(symbol).getType()));
+    break;
+  case SymbolType::Enum:
+    out.u32(types.ref(static_cast<const EnumSymbol &>(symbol).getType()));
+    break;
+  case SymbolType::TypeAlias: {
+    const auto &alias = static_cast<const TypeAliasSymbol &>(symbol);
+    out.u32(types.ref(alias.getType()));
+    out.u8(alias.isTypeSetAlias());
+    break;
+  }
+  case SymbolType::Module:
+    out.strings(static_cast<const ModuleSymbol &>(symbol).modulePath);
+    break;
+  default:
+    // Interface 和 Union 没有对应的符号类，不会出现在符号表中
+    throw UnsupportedType{};
+  }
+}
+
+std::shared_ptr<Symbol> readSymbol(ByteReader &in,
+                                   const TypeTableReader &types) {
+  uint8_t kind = in.u8();
+  std::string name = in.str();
+  uint8_t visibilityValue = in.u8();
+  if (visibilityValue > static_cast<uint8_t>(Visibility::Internal)) {
+    throw MalformedInterface();
+  }
+  auto visibility = static_cast<Visibility>(visibilityValue);
+
+  switch (static_cast<SymbolType>(kind)) {
+  case SymbolType::Variable: {
+    auto type = types.get(in.u32());
+    uint8_t variableKind = in.u8();
+    if (variableKind > static_cast<uint8_t>(ast::VariableKind::Explicit)) {
+      throw MalformedInterface();
+    }
+    bool isConst = in.boolean();
+    return std::make_shared<VariableSymbol>(
+        name, type, static_cast<ast::VariableKind>(variableKind), isConst,
+        visibility);
+  }
+  case SymbolType::Function: {
+    auto type = types.getAs<types::FunctionType>(in.u32());
+    bool isImmutable = in.boolean();
+    bool isExtern = in.boolean();
+    bool isVariadic = in.boolean();
+    bool isInherited = in.boolean();
+    bool isTemplate = in.boolean();
+    auto function = std::make_shared<FunctionSymbol>(
+        name, type, visibility, isImmutable, isVariadic);
+    function->setExtern(isExtern);
+    function->setInherited(isInherited);
+    function->setTemplate(isTemplate);
+    function->setTemplateParamNames(in.strings());
+    function->setAbi(in.str());
+    return function;
+  }
+  case SymbolType::Class:
+    return std::make_shared<ClassSymbol>(name, types.get(in.u32()),
+                                         visibility);
+  case SymbolType::Struct:
+    return std::make_shared<StructSymbol>(name, types.get(in.u32()),
+                                          visibility);
+  case SymbolType::Enum:
+    return std::make_shared<EnumSymbol>(name, types.get(in.u32()),
+                                        visibility);
+  case SymbolType::TypeAlias: {
+    auto type = types.get(in.u32());
+    bool isTypeSet = in.boolean();
+    return std::make_shared<TypeAliasSymbol>(name, type, visibility,
+                                             isTypeSet);
+  }
+  case SymbolType::Module: {
+    auto module = std::make_shared<ModuleSymbol>(name, visibility);
+    module->modulePath = in.strings();
+    return module;
+  }
+  default:
+    throw MalformedInterface();
+  }
+}
+
+bool hasStaticSpecifier(const std::string &specifiers) {
+  return specifiers.find("static") != std::string::npos;
+}
+
+} // namespace
+
+ModuleInterface::ModuleInterface(std::vector<std::string> modulePath,
+                                 uint64_t sourceHash)
+    : modulePath_(std::move(modulePath)), sourceHash_(sourceHash) {}
+
+std::shared_ptr<ModuleInterface> ModuleInterface::collect(
+    std::vector<std::string> modulePath, uint64_t sourceHash,
+    const SymbolTable &symbolTable,
+    const std::vector<std::shared_ptr<Symbol>> &builtins,
+    const ExtensionRegistry &extensionRegistry) {
+  auto interface =
+      std::make_shared<ModuleInterface>(std::move(modulePath), sourceHash);
+
+  std::unordered_set<const Symbol *> builtinSet;
+  for (const auto &symbol : builtins) {
+    builtinSet.insert(symbol.get());
+  }
+  auto symbols = symbolTable.getGlobalSymbols();
+  // 按名称排序，同一源码总是生成相同的 .chi 文件
+  std::stable_sort(symbols.begin(), symbols.end(),
+                   [](const auto &a, const auto &b) {
+                     return a->getName() < b->getName();
+                   });
+  for (auto &symbol : symbols) {
+    if (symbol->getVisibility() == Visibility::Public &&
+        !builtinSet.count(symbol.get())) {
+      interface->addSymbol(std::move(symbol));
+    }
+  }
+
+  for (const auto &[key, decls] : extensionRegistry.getAllExtensions()) {
+    Extension extension;
+    extension.typeKey = key;
+    for (auto *decl : decls) {
+      for (const auto &member : decl->members) {
+        ExtensionMember info;
+        if (auto *funcDecl =
+                dynamic_cast<ast::FunctionDecl *>(member.get())) {
+          info = {funcDecl->name, MemberKind::Function, funcDecl->isStatic};
+        } else if (auto *getterDecl =
+                       dynamic_cast<ast::GetterDecl *>(member.get())) {
+          info = {getterDecl->name, MemberKind::Getter,
+                  hasStaticSpecifier(getterDecl->specifiers)};
+        } else if (auto *setterDecl =
+                       dynamic_cast<ast::SetterDecl *>(member.get())) {
+          info = {setterDecl->name, MemberKind::Setter, false};
+        } else if (auto *varDecl =
+                       dynamic_cast<ast::VariableDecl *>(member.get())) {
+          info = {varDecl->name, MemberKind::Variable,
+                  hasStaticSpecifier(varDecl->specifiers)};
+        } else {
+          continue;
+        }
+        extension.members.push_back(std::move(info));
+      }
+    }
+    interface->addExtension(std::move(extension));
+  }
+  std::sort(interface->extensions_.begin(), interface->extensions_.end(),
+            [](const Extension &a, const Extension &b) {
+              return a.typeKey < b.typeKey;
+            });
+
+  return interface;
+}
+
+void ModuleInterface::updateInterfaceHash() {
+  // 无法序列化的接口以源码哈希代替，源码的任何修改都视为接口变化
+  std::string data = serialize();
+  std::string_view content = std::string_view(data).substr(
+      std::min(data.size(), HeaderSize));
+  interfaceHash_ = data.empty() ? sourceHash_ : hashSourceContent(content);
+}
+
+std::string ModuleInterface::serialize() const {
+  try {
+    // 符号和扩展先写入单独的缓冲区，收集到的类型表放在它们前面
+    TypeTableWriter types;
+    ByteWriter symbols;
+    symbols.u32(static_cast<uint32_t>(symbols_.size()));
+    for (const auto &symbol : symbols_) {
+      writeSymbol(symbols, types, *symbol);
+    }
+
+    ByteWriter extensions;
+    extensions.u32(static_cast<uint32_t>(extensions_.size()));
+    for (const auto &extension : extensions_) {
+      extensions.str(extension.typeKey);
+      extensions.u32(static_cast<uint32_t>(extension.members.size()));
+      for (const auto &member : extension.members) {
+        extensions.str(member.name);
+        extensions.u8(static_cast<uint8_t>(member.kind));
+        extensions.u8(member.isStatic);
+      }
+    }
+
+    ByteWriter out;
+    out.data().append(Magic, sizeof(Magic));
+    out.u32(FormatVersion);
+    out.u64(sourceHash_);
+    out.strings(modulePath_);
+    out.u32(static_cast<uint32_t>(imports_.size()));
+    for (size_t i = 0; i < imports_.size(); ++i) {
+      out.strings(imports_[i]);
+      out.u64(importHashes_[i]);
+    }
+    types.finish(out);
+    out.append(symbols);
+    out.append(extensions);
+    return std::move(out.data());
+  } catch (const UnsupportedType &) {
+    return {};
+  }
+}
+
+std::shared_ptr<ModuleInterface>
+ModuleInterface::deserialize(std::string_view data,
+                             uint64_t expectedSourceHash) {
+  try {
+    ByteReader in(data);
+    for (char c : Magic) {
+      if (in.u8() != static_cast<uint8_t>(c)) {
+        return nullptr;
+      }
+    }
+    if (in.u32() != FormatVersion || in.u64() != expectedSourceHash) {
+      return nullptr;
+    }
+
+    auto interface =
+        std::make_shared<ModuleInterface>(in.strings(), expectedSourceHash);
+    interface->interfaceHash_ = hashSourceContent(data.substr(HeaderSize));
+    uint32_t importCount = in.count();
+    for (uint32_t i = 0; i < importCount; ++i) {
+      auto modulePath = in.strings();
+      interface->addImport(std::move(modulePath), in.u64());
+    }
+    TypeTableReader types;
+    types.read(in);
+
+    uint32_t symbolCount = in.count();
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+      interface->addSymbol(readSymbol(in, types));
+    }
+
+    uint32_t extensionCount = in.count();
+    for (uint32_t i = 0; i < extensionCount; ++i) {
+      Extension extension;
+      extension.typeKey = in.str();
+      uint32_t memberCount = in.count();
+      for (uint32_t j = 0; j < memberCount; ++j) {
+        ExtensionMember member;
+        member.name = in.str();
+        uint8_t kind = in.u8();
+        if (kind > static_cast<uint8_t>(MemberKind::Variable)) {
+          throw MalformedInterface();
+        }
+        member.kind = static_cast<MemberKind>(kind);
+        member.isStatic = in.boolean();
+        extension.members.push_back(std::move(member));
+      }
+      interface->addExtension(std::move(extension));
+    }
+
+    if (!in.atEnd()) {
+      return nullptr;
+    }
+    return interface;
+  } catch (const MalformedInterface &) {
+    return nullptr;
+  }
+}
+
+bool ModuleInterface::writeFile(const std::filesystem::path &path) const {
+  std::string data = serialize();
+  if (data.empty()) {
+    return false;
+  }
+  return writeFileAtomically(path, data);
+}
+
+std::shared_ptr<ModuleInterface>
+ModuleInterface::readFile(const std::filesystem::path &path,
+                          uint64_t expectedSourceHash) {
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return nullptr;
+  }
+  auto buffer = lexer::SourceBuffer::fromFile(path);
+  if (!buffer) {
+    return nullptr;
+  }
+  return deserialize(buffer->getText(), expectedSourceHash);
+}
+
+} // namespace semantic
+} // namespace c_hat
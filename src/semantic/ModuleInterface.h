@@ -0,0 +1,119 @@
+#pragma once
+
+#include "ExtensionRegistry.h"
+#include "SymbolTable.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 源码内容哈希（64 位 FNV-1a），用于判断模块接口是否过期
+uint64_t hashSourceContent(std::string_view text);
+
+// 写入缓存文件（先写临时文件再改名），失败时返回 false
+bool writeFileAtomically(const std::filesystem::path &path,
+                         std::string_view data);
+
+// 预编译的模块接口（.chi 文件）
+// 保存模块导出的公共符号、符号引用到的类型（含泛型模板的类型参数）以及
+// 扩展声明的成员。导入模块时若存在与源码内容哈希一致的 .chi 文件，
+// 直接映射它恢复符号，跳过该模块的词法、语法和语义分析。
+class ModuleInterface {
+public:
+  // 文件格式版本，格式变化时递增，旧文件随之失效
+  static constexpr uint32_t FormatVersion = 3;
+
+  // 扩展成员的种类
+  enum class MemberKind : uint8_t { Function, Getter, Setter, Variable };
+
+  // 扩展声明中的成员
+  struct ExtensionMember {
+    std::string name;
+    MemberKind kind = MemberKind::Function;
+    bool isStatic = false;
+  };
+
+  // 扩展声明，以被扩展类型的类型键标识
+  struct Extension {
+    std::string typeKey;
+    std::vector<ExtensionMember> members;
+  };
+
+  ModuleInterface(std::vector<std::string> modulePath, uint64_t sourceHash);
+
+  // 从分析完成的全局作用域收集公共符号和扩展
+  // builtins 是分析前已存在的内置符号，它们不属于模块接口
+  static std::shared_ptr<ModuleInterface>
+  collect(std::vector<std::string> modulePath, uint64_t sourceHash,
+          const SymbolTable &symbolTable,
+          const std::vector<std::shared_ptr<Symbol>> &builtins,
+          const ExtensionRegistry &extensionRegistry);
+
+  const std::vector<std::string> &getModulePath() const { return modulePath_; }
+  uint64_t getSourceHash() const { return sourceHash_; }
+
+  // 接口内容（不含源码哈希）的哈希，只改函数体时保持不变
+  // 从文件读取时随之确定，收集的接口在添加完导入后调用
+  // updateInterfaceHash() 计算
+  uint64_t getInterfaceHash() const { return interfaceHash_; }
+  void updateInterfaceHash();
+
+  // 导出的符号，同名重载函数各占一项
+  const std::vector<std::shared_ptr<Symbol>> &getSymbols() const {
+    return symbols_;
+  }
+  const std::vector<Extension> &getExtensions() const { return extensions_; }
+
+  // 模块直接导入的其他模块，按导入顺序排列
+  const std::vector<std::vector<std::string>> &getImports() const {
+    return imports_;
+  }
+
+  // 写出接口时各导入模块的接口哈希（ModuleGraph::Module::interfaceHash），
+  // 与 getImports() 一一对应；加载时与依赖当前的哈希不一致说明接口已过期
+  const std::vector<uint64_t> &getImportHashes() const {
+    return importHashes_;
+  }
+
+  void addSymbol(std::shared_ptr<Symbol> symbol) {
+    symbols_.push_back(std::move(symbol));
+  }
+  void addExtension(Extension extension) {
+    extensions_.push_back(std::move(extension));
+  }
+  void addImport(std::vector<std::string> modulePath, uint64_t interfaceHash) {
+    imports_.push_back(std::move(modulePath));
+    importHashes_.push_back(interfaceHash);
+  }
+
+  // 序列化为二进制格式，包含无法序列化的类型时返回空字符串
+  std::string serialize() const;
+
+  // 从二进制数据恢复，数据损坏、版本或源码哈希不匹配时返回 nullptr
+  static std::shared_ptr<ModuleInterface>
+  deserialize(std::string_view data, uint64_t expectedSourceHash);
+
+  // 写入文件（先写临时文件再改名），失败时返回 false
+  bool writeFile(const std::filesystem::path &path) const;
+
+  // 以内存映射方式读取文件，文件不存在或已过期时返回 nullptr
+  static std::shared_ptr<ModuleInterface>
+  readFile(const std::filesystem::path &path, uint64_t expectedSourceHash);
+
+private:
+  std::vector<std::string> modulePath_;
+  uint64_t sourceHash_;
+  uint64_t interfaceHash_ = 0;
+  std::vector<std::shared_ptr<Symbol>> symbols_;
+  std::vector<Extension> extensions_;
+  std::vector<std::vector<std::string>> imports_;
+  std::vector<uint64_t> importHashes_;
+};
+
+} // namespace semantic
+} // namespace c_hat
@@ -1,7 +1,7 @@
 
 #include "ModuleLoader.h"
+#include "../lexer/SourceBuffer.h"
 #include "../parser/Parser.h"
-#include <fstream>
 #include <print>
 #include <stdexcept>
 
@@ -21,19 +21,45 @@ std::string ModuleLoader::modulePathToString(
   return result;
 }
 
-fs::path
-ModuleLoader::modulePathToFilePath(const std::vector<std::string> &modulePath) {
-  std::vector<fs::path> searchPaths;
+std::shared_ptr<const ModuleIndex> ModuleLoader::getModuleIndex() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!moduleIndex_) {
+    std::vector<fs::path> searchPaths;
+    if (!modulePaths_.empty()) {
+      for (const auto &p : modulePaths_) {
+        searchPaths.push_back(fs::path(p));
+      }
+    } else {
+      searchPaths.push_back(fs::path("stdlib"));
+    }
+    moduleIndex_ =
+        ModuleIndex::get(searchPaths, moduleIndexFile_, indexExcludedDirs());
+  }
+  return moduleIndex_;
+}
 
-  if (!modulePaths_.empty()) {
-    for (const auto &p : modulePaths_) {
-      searchPaths.push_back(fs::path(p));
+std::set<fs::path> ModuleLoader::indexExcludedDirs() const {
+  std::set<fs::path> excluded;
+  for (const auto &dir : {interfaceCacheDir_, astCacheDir_, buildDir_}) {
+    if (!dir.empty()) {
+      excluded.insert(fs::path(dir));
     }
-  } else {
-    searchPaths.push_back(fs::path("stdlib"));
   }
+  if (fs::path(moduleIndexFile_).has_parent_path()) {
+    excluded.insert(fs::path(moduleIndexFile_).parent_path());
+  }
+  return excluded;
+}
 
-  for (const auto &basePath : searchPaths) {
+fs::path
+ModuleLoader::modulePathToFilePath(const std::vector<std::string> &modulePath) {
+  auto index = getModuleIndex();
+  if (const auto *entry = index->find(modulePathToString(modulePath))) {
+    return entry->file;
+  }
+
+  // 索引建立之后才出现的模块，逐个搜索路径探测
+  for (const auto &basePath : index->getRoots()) {
     fs::path moduleBase = basePath;
     for (const auto &part : modulePath) {
       moduleBase /= part;
@@ -66,21 +92,81 @@ ModuleLoader::modulePathToFilePath(const std::vector<std::string> &modulePath) {
   return defaultPath;
 }
 
-std::unique_ptr<ast::Program>
-ModuleLoader::parseFile(const fs::path &filePath) {
-  std::ifstream file(filePath);
-  if (!file.is_open()) {
-    throw std::runtime_error("Could not open module file: " +
-                             filePath.string());
+fs::path ModuleLoader::interfaceFilePath(
+    const std::vector<std::string> &modulePath) const {
+  return fs::path(interfaceCacheDir_) /
+         (modulePathToString(modulePath) + ".chi");
+}
+
+std::shared_ptr<ModuleInterface>
+ModuleLoader::loadInterface(const std::vector<std::string> &modulePath) {
+  std::string moduleName = modulePathToString(modulePath);
+  if (isModuleLoaded(modulePath)) {
+    return nullptr;
+  }
+
+  auto filePath = modulePathToFilePath(modulePath);
+  auto source = lexer::SourceBuffer::fromFile(filePath);
+  if (!source) {
+    return nullptr;
+  }
+  uint64_t sourceHash = hashSourceContent(source->getText());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sourceHashes_[moduleName] = sourceHash;
+    sourceFiles_[moduleName] = filePath;
+  }
+  // 没有缓存目录时不使用模块接口
+  if (interfaceCacheDir_.empty()) {
+    return nullptr;
+  }
+
+  auto interface =
+      ModuleInterface::readFile(interfaceFilePath(modulePath), sourceHash);
+  if (interface) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loadedModules_.insert(moduleName);
   }
+  return interface;
+}
 
-  std::string source((std::istreambuf_iterator<char>(file)),
-                     std::istreambuf_iterator<char>());
-  file.close();
+bool ModuleLoader::saveInterface(const ModuleInterface &interface) {
+  if (interfaceCacheDir_.empty()) {
+    return false;
+  }
+  return interface.writeFile(interfaceFilePath(interface.getModulePath()));
+}
 
-  c_hat::parser::Parser parser(source);
+uint64_t ModuleLoader::getSourceHash(
+    const std::vector<std::string> &modulePath) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sourceHashes_.find(modulePathToString(modulePath));
+  return it != sourceHashes_.end() ? it->second : 0;
+}
+
+std::unique_ptr<ast::Program>
+ModuleLoader::parseFile(std::shared_ptr<const lexer::SourceBuffer> source,
+                        uint64_t sourceHash) {
+  bool useAstCache = astCacheEnabled_ && !astCacheDir_.empty();
+  AstCache astCache{fs::path(astCacheDir_)};
+  if (useAstCache) {
+    if (auto program = astCache.load(sourceHash)) {
+      program->source = std::move(source);
+      return program;
+    }
+  }
+
+  // 导入方只需要模块的接口，函数体略读；导入的模块不生成代码，函数体在
+  // 模块作为翻译单元编译时才完整解析和分析
+  c_hat::parser::Parser parser(std::move(source));
+  parser.setSkimFunctionBodies(true);
   auto program = parser.parseProgram();
 
+  // 缓存写入失败只影响下次编译的速度
+  if (useAstCache) {
+    astCache.store(sourceHash, *program);
+    std::call_once(astCachePruned_, [&] { astCache.prune(); });
+  }
   return program;
 }
 
@@ -88,29 +174,107 @@ std::unique_ptr<ast::Program>
 ModuleLoader::loadModule(const std::vector<std::string> &modulePath) {
   std::string moduleName = modulePathToString(modulePath);
 
-  if (loadedModules_.find(moduleName) != loadedModules_.end()) {
-    return nullptr;
-  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loadedModules_.find(moduleName) != loadedModules_.end()) {
+      return nullptr;
+    }
 
-  if (loadingModules_.find(moduleName) != loadingModules_.end()) {
-    throw std::runtime_error("Circular dependency detected in module: " +
-                             moduleName);
-  }
+    if (loadingModules_.find(moduleName) != loadingModules_.end()) {
+      throw std::runtime_error("Circular dependency detected in module: " +
+                               moduleName);
+    }
 
-  loadingModules_.insert(moduleName);
+    loadingModules_.insert(moduleName);
+  }
 
-  auto filePath = modulePathToFilePath(modulePath);
-  auto program = parseFile(filePath);
+  std::unique_ptr<ast::Program> program;
+  try {
+    auto filePath = modulePathToFilePath(modulePath);
+    auto source = lexer::SourceBuffer::fromFile(filePath);
+    if (!source) {
+      throw std::runtime_error("Could not open module file: " +
+                               filePath.string());
+    }
+    uint64_t sourceHash = hashSourceContent(source->getText());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sourceHashes_[moduleName] = sourceHash;
+      sourceFiles_[moduleName] = filePath;
+    }
+    program = parseFile(std::move(source), sourceHash);
+  } catch (...) {
+    // 加载失败不算正在加载，之后重新导入时报告同样的错误而不是循环依赖
+    std::lock_guard<std::mutex> lock(mutex_);
+    loadingModules_.erase(moduleName);
+    throw;
+  }
 
+  std::lock_guard<std::mutex> lock(mutex_);
   loadingModules_.erase(moduleName);
   loadedModules_.insert(moduleName);
 
   return program;
 }
 
+std::unique_ptr<ast::Program>
+ModuleLoader::reloadModule(const std::vector<std::string> &modulePath) {
+  unloadModule(modulePath);
+  return loadModule(modulePath);
+}
+
+void ModuleLoader::unloadModule(const std::vector<std::string> &modulePath) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  loadedModules_.erase(modulePathToString(modulePath));
+}
+
+bool ModuleLoader::isUpToDate() const {
+  std::shared_ptr<const ModuleIndex> moduleIndex;
+  std::unordered_map<std::string, uint64_t> sourceHashes;
+  std::unordered_map<std::string, fs::path> sourceFiles;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    moduleIndex = moduleIndex_;
+    sourceHashes = sourceHashes_;
+    sourceFiles = sourceFiles_;
+  }
+
+  // 目录有变化（新增模块文件，或在源码旁写入接口）时重新建立索引，
+  // 已加载的模块仍须解析到同一个文件，新增的文件可能遮蔽它们
+  std::shared_ptr<const ModuleIndex> currentIndex;
+  if (moduleIndex && !moduleIndex->isUpToDate()) {
+    currentIndex = ModuleIndex::get(moduleIndex->getRoots(), moduleIndexFile_,
+                                    moduleIndex->getExcluded());
+  }
+  for (const auto &[moduleName, sourceHash] : sourceHashes) {
+    if (currentIndex) {
+      const auto *entry = currentIndex->find(moduleName);
+      if (!entry || entry->file != sourceFiles[moduleName]) {
+        return false;
+      }
+    }
+    auto source = lexer::SourceBuffer::fromFile(sourceFiles[moduleName]);
+    if (!source || hashSourceContent(source->getText()) != sourceHash) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<fs::path> ModuleLoader::getSourceFiles() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<fs::path> files;
+  files.reserve(sourceFiles_.size());
+  for (const auto &[moduleName, file] : sourceFiles_) {
+    files.push_back(file);
+  }
+  return files;
+}
+
 bool ModuleLoader::isModuleLoaded(
     const std::vector<std::string> &modulePath) const {
   std::string moduleName = modulePathToString(modulePath);
+  std::lock_guard<std::mutex> lock(mutex_);
   return loadedModules_.find(moduleName) != loadedModules_.end();
 }
 
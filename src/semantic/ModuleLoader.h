@@ -2,12 +2,20 @@
 #pragma once
 
 #include "../ast/AstNodes.h"
+#include "../lexer/SourceBuffer.h"
+#include "AstCache.h"
+#include "ModuleIndex.h"
+#include "ModuleInterface.h"
 #include "ModuleSymbol.h"
 #include "SymbolTable.h"
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -16,6 +24,10 @@ namespace semantic {
 
 namespace fs = std::filesystem;
 
+// 模块加载器
+// 搜索路径和缓存设置需在加载前配置好；配置完成后 loadInterface、
+// loadModule、saveInterface 可以在多个线程中同时调用（并行加载模块），
+// 已加载模块的记录由互斥锁保护，读文件和解析在锁外进行。
 class ModuleLoader {
 public:
   ModuleLoader(const std::string &stdlibPath) : stdlibPath_(stdlibPath) {
@@ -33,13 +45,71 @@ public:
 
   void addModulePath(const std::string &path) {
     modulePaths_.push_back(path);
+    moduleIndex_.reset();
   }
 
+  // 设置保存搜索路径索引的文件，为空时只在进程内缓存索引
+  void setModuleIndexFile(const std::string &path) {
+    moduleIndexFile_ = path;
+    moduleIndex_.reset();
+  }
+
+  // 搜索路径的索引，首次使用时建立
+  std::shared_ptr<const ModuleIndex> getModuleIndex();
+
+  // 设置模块接口（.chi 文件）的缓存目录，为空时不读写模块接口
+  void setInterfaceCacheDir(const std::string &dir) {
+    interfaceCacheDir_ = dir;
+    moduleIndex_.reset();
+  }
+
+  // 启用或关闭 AST 缓存，默认启用（仍需设置缓存目录）
+  void setAstCacheEnabled(bool enabled) { astCacheEnabled_ = enabled; }
+
+  // 设置 AST 缓存目录，为空时不使用 AST 缓存
+  void setAstCacheDir(const std::string &dir) {
+    astCacheDir_ = dir;
+    moduleIndex_.reset();
+  }
+
+  // 设置构建目录；它和各个缓存目录位于搜索路径中时，建立索引时跳过
+  void setBuildDir(const std::string &dir) {
+    buildDir_ = dir;
+    moduleIndex_.reset();
+  }
+
+  // 加载与模块源码内容一致的模块接口，成功时模块标记为已加载；
+  // 接口不存在、已过期或没有缓存目录时返回 nullptr，调用方改用
+  // loadModule 分析源码
+  std::shared_ptr<ModuleInterface>
+  loadInterface(const std::vector<std::string> &modulePath);
+
+  // 保存分析模块源码得到的接口，写入失败或没有缓存目录时返回 false
+  bool saveInterface(const ModuleInterface &interface);
+
   std::unique_ptr<ast::Program>
   loadModule(const std::vector<std::string> &modulePath);
 
+  // 重新解析已从接口加载的模块（接口依赖的模块接口变化，需要重新分析）
+  std::unique_ptr<ast::Program>
+  reloadModule(const std::vector<std::string> &modulePath);
+
+  // 忘记模块已经加载，之后可以重新加载（模块图移出了加载失败的模块）
+  void unloadModule(const std::vector<std::string> &modulePath);
+
+  // 最近一次读取的模块源码的内容哈希
+  uint64_t getSourceHash(const std::vector<std::string> &modulePath) const;
+
   bool isModuleLoaded(const std::vector<std::string> &modulePath) const;
 
+  // 读取过的模块源码都没有变化，并且仍然解析到同一个文件
+  // 长期运行的进程（编译服务器）据此判断能否继续使用已分析的模块
+  bool isUpToDate() const;
+
+  // 读取过的模块源码文件（监视模式据此决定监视哪些文件）
+  std::vector<fs::path> getSourceFiles() const;
+
+  // 返回的引用不受锁保护，只在没有并行加载时使用
   const std::unordered_set<std::string> &getLoadedModules() const {
     return loadedModules_;
   }
@@ -50,12 +120,35 @@ public:
 private:
   std::string stdlibPath_;
   std::vector<std::string> modulePaths_;
+
+  std::string moduleIndexFile_;
+
+  // 保护 moduleIndex_、loadedModules_、loadingModules_、sourceHashes_ 和
+  // sourceFiles_
+  mutable std::mutex mutex_;
+  std::shared_ptr<const ModuleIndex> moduleIndex_;
   std::unordered_set<std::string> loadedModules_;
   std::unordered_set<std::string> loadingModules_;
+  std::string interfaceCacheDir_;
+  std::unordered_map<std::string, uint64_t> sourceHashes_;
+  std::unordered_map<std::string, fs::path> sourceFiles_;
+  bool astCacheEnabled_ = true;
+  std::string astCacheDir_;
+  std::string buildDir_;
+  // 每个加载器只在首次写入 AST 缓存时清理一次缓存目录
+  std::once_flag astCachePruned_;
 
   fs::path modulePathToFilePath(const std::vector<std::string> &modulePath);
 
-  std::unique_ptr<ast::Program> parseFile(const fs::path &filePath);
+  // 建立索引时跳过的目录：缓存目录和构建目录
+  std::set<fs::path> indexExcludedDirs() const;
+
+  fs::path interfaceFilePath(const std::vector<std::string> &modulePath) const;
+
+  // 解析模块源码，源码未变化时从 AST 缓存恢复
+  std::unique_ptr<ast::Program>
+  parseFile(std::shared_ptr<const lexer::SourceBuffer> source,
+            uint64_t sourceHash);
 };
 
 } // namespace semantic
@@ -0,0 +1,59 @@
+#include "OverloadCache.h"
+#include <functional>
+
+namespace c_hat {
+namespace semantic {
+
+bool OverloadCache::isCacheable(
+    const std::vector<std::shared_ptr<types::Type>> &argTypes) {
+  for (const auto &type : argTypes) {
+    if (!type ||
+        !(type->isCanonical() || type->isClass() || type->isInterface())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t OverloadCache::KeyHash::operator()(const Key &key) const {
+  size_t hash = std::hash<uint64_t>()(key.overloadSetId);
+  for (const auto *type : key.argTypes) {
+    hash ^= std::hash<const types::Type *>()(type) + 0x9e3779b97f4a7c15ULL +
+            (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+OverloadCache::Key OverloadCache::makeKey(
+    uint64_t overloadSetId,
+    const std::vector<std::shared_ptr<types::Type>> &argTypes) {
+  Key key{overloadSetId, {}};
+  key.argTypes.reserve(argTypes.size());
+  for (const auto &type : argTypes) {
+    key.argTypes.push_back(type.get());
+  }
+  return key;
+}
+
+std::optional<OverloadCache::Resolution>
+OverloadCache::find(uint64_t overloadSetId,
+                    const std::vector<std::shared_ptr<types::Type>> &argTypes) {
+  auto it = entries.find(makeKey(overloadSetId, argTypes));
+  if (it == entries.end()) {
+    ++stats.misses;
+    return std::nullopt;
+  }
+  ++stats.hits;
+  return it->second.resolution;
+}
+
+void OverloadCache::insert(
+    uint64_t overloadSetId,
+    const std::vector<std::shared_ptr<types::Type>> &argTypes,
+    Resolution resolution) {
+  entries.insert_or_assign(makeKey(overloadSetId, argTypes),
+                           Entry{argTypes, std::move(resolution)});
+}
+
+} // namespace semantic
+} // namespace c_hat
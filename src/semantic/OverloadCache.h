@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../types/Type.h"
+#include "FunctionSymbol.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 重载决议缓存
+// 按 (重载集合编号, 实参类型) 记住决议结果，在调用处之间复用。实参类型按
+// 地址比较，只缓存地址稳定的类型：驻留的规范类型，以及类和接口类型（由
+// 符号持有）；每次分析都新建的类型（例如指向类的指针）不缓存。缓存持有
+// 键中的类型，地址不会被复用。类的继承关系变化后要调用 clear()。
+class OverloadCache {
+public:
+  struct Resolution {
+    enum class Kind { Selected, Ambiguous, NoMatch };
+
+    Kind kind = Kind::NoMatch;
+    // kind 为 Selected 时选中的函数
+    std::shared_ptr<FunctionSymbol> function;
+  };
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  // 实参类型是否都可以作为缓存的键
+  static bool
+  isCacheable(const std::vector<std::shared_ptr<types::Type>> &argTypes);
+
+  // 查找记住的决议结果，没有时返回空（并计为一次未命中）
+  std::optional<Resolution>
+  find(uint64_t overloadSetId,
+       const std::vector<std::shared_ptr<types::Type>> &argTypes);
+
+  void insert(uint64_t overloadSetId,
+              const std::vector<std::shared_ptr<types::Type>> &argTypes,
+              Resolution resolution);
+
+  // 清除记住的结果（不清除统计）
+  void clear() { entries.clear(); }
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  struct Key {
+    uint64_t overloadSetId;
+    std::vector<const types::Type *> argTypes;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  struct Entry {
+    std::vector<std::shared_ptr<types::Type>> argTypes;
+    Resolution resolution;
+  };
+
+  std::unordered_map<Key, Entry, KeyHash> entries;
+  Stats stats;
+
+  static Key makeKey(uint64_t overloadSetId,
+                     const std::vector<std::shared_ptr<types::Type>> &argTypes);
+};
+
+} // namespace semantic
+} // namespace c_hat
@@ -4,6 +4,7 @@
 #include "../types/InterfaceType.h"
 #include "../types/TypeFactory.h"
 #include "ModuleSymbol.h"
+#include <format>
 #include <iostream>
 #include <map>
 #include <set>
@@ -16,7 +17,9 @@ SemanticAnalyzer::SemanticAnalyzer(const std::string &stdlibPath,
                                    bool requireMainFunction) {
   requireMainFunction_ = requireMainFunction;
   if (!stdlibPath.empty()) {
-    moduleLoader_ = std::make_unique<ModuleLoader>(stdlibPath);
+    ownedModuleGraph_ = std::make_unique<ModuleGraph>(
+        std::make_unique<ModuleLoader>(stdlibPath));
+    moduleGraph_ = ownedModuleGraph_.get();
   }
   initializeBuiltinSymbols();
 }
@@ -25,72 +28,96 @@ SemanticAnalyzer::SemanticAnalyzer(const std::vector<std::string> &modulePaths,
                                    bool requireMainFunction) {
   requireMainFunction_ = requireMainFunction;
   if (!modulePaths.empty()) {
-    moduleLoader_ = std::make_unique<ModuleLoader>(modulePaths);
+    ownedModuleGraph_ = std::make_unique<ModuleGraph>(
+        std::make_unique<ModuleLoader>(modulePaths));
+    moduleGraph_ = ownedModuleGraph_.get();
   }
   initializeBuiltinSymbols();
 }
 
+SemanticAnalyzer::SemanticAnalyzer(ModuleGraph &moduleGraph,
+                                   bool requireMainFunction)
+    : moduleGraph_(&moduleGraph) {
+  requireMainFunction_ = requireMainFunction;
+  initializeBuiltinSymbols();
+}
+
+SemanticAnalyzer::SemanticAnalyzer(ModuleGraph &moduleGraph,
+                                   ModuleGraph::Module &module)
+    : moduleGraph_(&moduleGraph), currentModule_(&module) {
+  requireMainFunction_ = false;
+  currentModulePath_ = module.path;
+  initializeBuiltinSymbols();
+}
+
 void SemanticAnalyzer::analyze(ast::Program &program) {
-  currentProgram_ = &program;
+  // 入口程序先并行加载全部导入的模块
+  if (ownedModuleGraph_) {
+    moduleGraph_->prefetch(program);
+  }
 
   // 第一遍：收集所有顶级声明，创建它们的符号并添加到全局符号表中
   for (auto &decl : program.declarations) {
-    if (auto *classDecl = dynamic_cast<ast::ClassDecl *>(decl.get())) {
-      auto classType = std::make_shared<types::ClassType>(classDecl->name);
+    collectTopLevelDeclaration(decl.get());
+  }
 
-      std::vector<std::string> specifierList;
-      std::istringstream iss(classDecl->specifiers);
-      std::string spec;
-      while (iss >> spec) {
-        specifierList.push_back(spec);
-      }
-      Visibility vis = parseVisibility(specifierList);
+  finishAnalysis(program);
+}
 
-      auto classSymbol =
-          std::make_shared<ClassSymbol>(classDecl->name, classType);
-      classSymbol->setVisibility(vis);
-      symbolTable.addSymbol(classSymbol);
-    } else if (auto *funcDecl = dynamic_cast<ast::FunctionDecl *>(decl.get())) {
-      // 第一遍只注册顶层函数签名，函数体放到类成员注册完成后再分析
-      analyzeFunctionDecl(funcDecl, nullptr, false);
-    } else if (auto *varDecl = dynamic_cast<ast::VariableDecl *>(decl.get())) {
-      // 分析顶级变量声明（包括 static 变量）
-      analyzeVariableDecl(varDecl);
-    } else if (auto *interfaceDecl =
-                   dynamic_cast<ast::InterfaceDecl *>(decl.get())) {
-      analyzeInterfaceDecl(interfaceDecl);
-    } else if (auto *conceptDecl =
-                   dynamic_cast<ast::ConceptDecl *>(decl.get())) {
-      analyzeConceptDecl(conceptDecl);
-    } else if (auto *structDecl = dynamic_cast<ast::StructDecl *>(decl.get())) {
-      analyzeStructDecl(structDecl);
-    } else if (auto *enumDecl = dynamic_cast<ast::EnumDecl *>(decl.get())) {
-      analyzeEnumDecl(enumDecl);
-    } else if (auto *typeAliasDecl =
-                   dynamic_cast<ast::TypeAliasDecl *>(decl.get())) {
-      analyzeTypeAliasDecl(typeAliasDecl);
-    } else if (auto *moduleDecl = dynamic_cast<ast::ModuleDecl *>(decl.get())) {
-      analyzeModuleDecl(moduleDecl);
-    } else if (auto *importDecl = dynamic_cast<ast::ImportDecl *>(decl.get())) {
-      analyzeImportDecl(importDecl);
-    } else if (auto *externDecl = dynamic_cast<ast::ExternDecl *>(decl.get())) {
-      analyzeExternDecl(externDecl);
-    }
-  }
-
-  // 第二遍：分析类成员（使用 analyzeClassDecl 方法）
+void SemanticAnalyzer::collectTopLevelDeclaration(ast::Declaration *decl) {
+  if (auto *classDecl = dynamic_cast<ast::ClassDecl *>(decl)) {
+    auto classType = std::make_shared<types::ClassType>(classDecl->name);
+
+    std::vector<std::string> specifierList;
+    std::istringstream iss(classDecl->specifiers);
+    std::string spec;
+    while (iss >> spec) {
+      specifierList.push_back(spec);
+    }
+    Visibility vis = parseVisibility(specifierList);
+
+    auto classSymbol =
+        std::make_shared<ClassSymbol>(classDecl->name, classType);
+    classSymbol->setVisibility(vis);
+    symbolTable.addSymbol(classSymbol);
+  } else if (auto *funcDecl = dynamic_cast<ast::FunctionDecl *>(decl)) {
+    // 第一遍只注册顶层函数签名，函数体放到类成员注册完成后再分析
+    analyzeFunctionDecl(funcDecl, nullptr, false);
+  } else if (auto *varDecl = dynamic_cast<ast::VariableDecl *>(decl)) {
+    // 分析顶级变量声明（包括 static 变量）
+    analyzeVariableDecl(varDecl);
+  } else if (auto *interfaceDecl = dynamic_cast<ast::InterfaceDecl *>(decl)) {
+    analyzeInterfaceDecl(interfaceDecl);
+  } else if (auto *conceptDecl = dynamic_cast<ast::ConceptDecl *>(decl)) {
+    analyzeConceptDecl(conceptDecl);
+  } else if (auto *structDecl = dynamic_cast<ast::StructDecl *>(decl)) {
+    analyzeStructDecl(structDecl);
+  } else if (auto *enumDecl = dynamic_cast<ast::EnumDecl *>(decl)) {
+    analyzeEnumDecl(enumDecl);
+  } else if (auto *typeAliasDecl = dynamic_cast<ast::TypeAliasDecl *>(decl)) {
+    analyzeTypeAliasDecl(typeAliasDecl);
+  } else if (auto *moduleDecl = dynamic_cast<ast::ModuleDecl *>(decl)) {
+    analyzeModuleDecl(moduleDecl);
+  } else if (auto *importDecl = dynamic_cast<ast::ImportDecl *>(decl)) {
+    analyzeImportDecl(importDecl);
+  } else if (auto *externDecl = dynamic_cast<ast::ExternDecl *>(decl)) {
+    analyzeExternDecl(externDecl);
+  } else if (auto *extensionDecl = dynamic_cast<ast::ExtensionDecl *>(decl)) {
+    analyzeExtensionDecl(extensionDecl);
+  }
+}
+
+void SemanticAnalyzer::finishAnalysis(ast::Program &program) {
+  currentProgram_ = &program;
+
+  // 第二遍：分析类成员
   for (auto &decl : program.declarations) {
-    if (auto *classDecl = dynamic_cast<ast::ClassDecl *>(decl.get())) {
-      // 分析类声明，包括类成员
-      analyzeClassDecl(classDecl);
-    }
+    analyzeTopLevelMembers(decl.get());
   }
 
   // 第三遍：分析顶层函数体
   for (auto &decl : program.declarations) {
-    if (auto *funcDecl = dynamic_cast<ast::FunctionDecl *>(decl.get())) {
-      analyzeFunctionDecl(funcDecl);
-    }
+    analyzeTopLevelBody(decl.get());
   }
 
   // 第四遍：类的方法体和属性方法体已经在 analyzeClassDecl 中分析过
@@ -109,6 +136,19 @@ void SemanticAnalyzer::analyze(ast::Program &program) {
   }
 }
 
+void SemanticAnalyzer::analyzeTopLevelMembers(ast::Declaration *decl) {
+  if (auto *classDecl = dynamic_cast<ast::ClassDecl *>(decl)) {
+    // 分析类声明，包括类成员
+    analyzeClassDecl(classDecl);
+  }
+}
+
+void SemanticAnalyzer::analyzeTopLevelBody(ast::Declaration *decl) {
+  if (auto *funcDecl = dynamic_cast<ast::FunctionDecl *>(decl)) {
+    analyzeFunctionDecl(funcDecl);
+  }
+}
+
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeExpressionOnly(ast::Expression *expression) {
   return analyzeExpression(expression);
@@ -236,7 +276,7 @@ void SemanticAnalyzer::initializeBuiltinSymbols() {
 
   // 添加反射内置类型
   // literalview - 编译期字符串视图
-  auto literalViewType = std::make_shared<types::LiteralViewType>();
+  auto literalViewType = types::TypeFactory::getLiteralViewType();
   auto literalViewSymbol = std::make_shared<TypeAliasSymbol>(
       "literalview", literalViewType, Visibility::Public, false);
   symbolTable.addSymbol(literalViewSymbol);
@@ -625,7 +665,8 @@ void SemanticAnalyzer::analyzeFunctionDecl(
   }
 
   // 创建函数类型
-  auto funcType = std::make_shared<types::FunctionType>(returnType, paramTypes);
+  auto funcType = std::static_pointer_cast<types::FunctionType>(
+      types::TypeFactory::getFunctionType(returnType, paramTypes));
 
   // 注册阶段才添加函数符号，避免顶层函数在第三遍分析函数体时重复注册
   if (!analyzeBody || currentClassType != nullptr) {
@@ -641,7 +682,7 @@ void SemanticAnalyzer::analyzeFunctionDecl(
       bool sameSignature = true;
       for (size_t i = 0; i < paramTypes.size(); ++i) {
         if (!existingParams[i] || !paramTypes[i] ||
-            existingParams[i]->toString() != paramTypes[i]->toString()) {
+            !types::isSameType(*existingParams[i], *paramTypes[i])) {
           sameSignature = false;
           break;
         }
@@ -736,6 +777,10 @@ void SemanticAnalyzer::analyzeFunctionDecl(
     // TODO: 实现完整的约束检查
   }
 
+  // 略读模式跳过的函数体不在这里解析也不分析：只有导入的模块略读，导入方
+  // 只需要函数签名，不为导入的模块生成代码。模块的函数体在它作为翻译单元
+  // 编译时完整解析和分析（包括协程检测），错误在那时报告
+
   // 检测函数是否是协程（包含 await 或 yield）
   bool previousIsCoroutine = currentFunctionIsCoroutine_;
   currentFunctionIsCoroutine_ = false;
@@ -938,6 +983,7 @@ void SemanticAnalyzer::analyzeClassDecl(ast::ClassDecl *classDecl) {
                 *classDecl);
         } else {
           classType->addBaseClass(baseClassType);
+          invalidateTypeRelations();
           std::cerr << "Debug: Added base class: " << classDecl->baseClass
                     << std::endl;
         }
@@ -946,6 +992,7 @@ void SemanticAnalyzer::analyzeClassDecl(ast::ClassDecl *classDecl) {
         auto interface =
             std::dynamic_pointer_cast<types::InterfaceType>(baseType);
         classType->addInterface(interface);
+        invalidateTypeRelations();
       } else {
         error("Base class or interface not found: " + classDecl->baseClass,
               *classDecl);
@@ -975,12 +1022,14 @@ void SemanticAnalyzer::analyzeClassDecl(ast::ClassDecl *classDecl) {
               *classDecl);
       } else {
         classType->addBaseClass(baseClassType);
+        invalidateTypeRelations();
       }
     } else if (baseType && baseType->isInterface()) {
       // 接口也可以出现在继承列表中
       auto interface =
           std::dynamic_pointer_cast<types::InterfaceType>(baseType);
       classType->addInterface(interface);
+      invalidateTypeRelations();
     } else {
       error("Base class or interface not found: " + baseClassName, *classDecl);
     }
@@ -993,6 +1042,7 @@ void SemanticAnalyzer::analyzeClassDecl(ast::ClassDecl *classDecl) {
       auto interface =
           std::dynamic_pointer_cast<types::InterfaceType>(interfaceType);
       classType->addInterface(interface);
+      invalidateTypeRelations();
     } else {
       error("Interface not found: " + interfaceName, *classDecl);
     }
@@ -1046,8 +1096,9 @@ void SemanticAnalyzer::analyzeClassDecl(ast::ClassDecl *classDecl) {
       const auto &method = methodPair.second;
       if (method.access == types::AccessModifier::Protected ||
           method.access == types::AccessModifier::Public) {
-        auto methodType = std::make_shared<types::FunctionType>(
-            method.returnType, method.paramTypes);
+        auto methodType = std::static_pointer_cast<types::FunctionType>(
+            types::TypeFactory::getFunctionType(method.returnType,
+                                                method.paramTypes));
         auto methodSymbol = std::make_shared<FunctionSymbol>(
             method.name, methodType, Visibility::Default);
         methodSymbol->setInherited(true);
@@ -1297,6 +1348,7 @@ void SemanticAnalyzer::analyzeInterfaceDecl(ast::InterfaceDecl *interfaceDecl) {
       auto baseInterfaceType =
           std::dynamic_pointer_cast<types::InterfaceType>(baseType);
       interfaceType->addBaseInterface(baseInterfaceType);
+      invalidateTypeRelations();
     } else {
       error("Base interface not found: " + baseInterfaceName, *interfaceDecl);
     }
@@ -1335,7 +1387,7 @@ void SemanticAnalyzer::analyzeInterfaceDecl(ast::InterfaceDecl *interfaceDecl) {
       }
 
       // 检查是否有方法体（默认实现）
-      bool hasDefaultImpl = (funcDecl->body != nullptr);
+      bool hasDefaultImpl = funcDecl->hasBody();
 
       // 解析访问控制修饰符
       auto visibility = parseVisibility({funcDecl->specifiers});
@@ -1428,41 +1480,12 @@ void SemanticAnalyzer::analyzeImportDecl(ast::ImportDecl *importDecl) {
                                             : importDecl->modulePath.back())
           : importDecl->alias;
 
-  if (moduleLoader_) {
-    auto loadedProgram = moduleLoader_->loadModule(importDecl->modulePath);
-    if (loadedProgram) {
-      SymbolTable importedSymbolTable;
-      {
-        SemanticAnalyzer importedAnalyzer(
-            moduleLoader_->getLoadedModules().empty() ? "" : "", false);
-        importedAnalyzer.currentModulePath_ = importDecl->modulePath;
-        importedAnalyzer.analyze(*loadedProgram);
-        importedSymbolTable = std::move(importedAnalyzer.symbolTable);
-      }
-
-      auto symbols = importedSymbolTable.getAllSymbols();
-      for (const auto &[name, symbol] : symbols) {
-        if (symbol->getVisibility() == Visibility::Public) {
-          auto importedSymbol = symbol;
-          if (!importDecl->alias.empty()) {
-            auto aliasModule =
-                std::make_shared<ModuleSymbol>(importDecl->alias);
-            aliasModule->modulePath = importDecl->modulePath;
-            if (isPublic) {
-              aliasModule->setVisibility(Visibility::Public);
-            }
-            symbolTable.addSymbol(aliasModule);
-          } else {
-            auto moduleSym = std::make_shared<ModuleSymbol>(importedName);
-            moduleSym->modulePath = importDecl->modulePath;
-            if (isPublic) {
-              moduleSym->setVisibility(Visibility::Public);
-            }
-            symbolTable.addSymbol(moduleSym);
-          }
-          break;
-        }
-      }
+  if (moduleGraph_) {
+    // 模块图中每个模块只加载、分析一次，所有导入方共享同一份结果。
+    // 模块接口只用于判断模块是否需要重新分析，导入的名称不经由它解析
+    if (moduleGraph_->import(currentModule_, importDecl->modulePath)) {
+      // 导入的类可能与已编号的类同名
+      invalidateTypeRelations();
     }
   }
 
@@ -2514,9 +2537,9 @@ SemanticAnalyzer::analyzeUnaryExpr(ast::UnaryExpr *unaryExpr) {
     }
     // 如果操作数是 const 变量，包装类型为 ReadonlyType
     if (isConstVar) {
-      operandType = std::make_shared<types::ReadonlyType>(operandType);
+      operandType = types::TypeFactory::getReadonlyType(operandType);
     }
-    return std::make_shared<types::PointerType>(operandType);
+    return types::TypeFactory::getPointerType(operandType);
   }
   case ast::UnaryExpr::Op::Ref: {
     auto operandType = analyzeExpression(unaryExpr->expr.get());
@@ -2526,7 +2549,7 @@ SemanticAnalyzer::analyzeUnaryExpr(ast::UnaryExpr *unaryExpr) {
     if (operandType->isReference()) {
       return operandType;
     }
-    return std::make_shared<types::ReferenceType>(operandType);
+    return types::TypeFactory::getReferenceType(operandType);
   }
   case ast::UnaryExpr::Op::Dereference: {
     auto operandType = analyzeExpression(unaryExpr->expr.get());
@@ -2793,8 +2816,8 @@ SemanticAnalyzer::analyzeCallExpr(ast::CallExpr *callExpr) {
   if (auto *identifier =
           dynamic_cast<ast::Identifier *>(callExpr->callee.get())) {
     // 从符号表中查找所有同名函数
-    auto functionSymbols = symbolTable.lookupFunctionSymbols(identifier->name);
-    if (functionSymbols.empty()) {
+    auto overloads = symbolTable.lookupOverloadSet(identifier->name);
+    if (overloads->functions.empty()) {
       // 检查是否是构造函数调用（类名作为函数名）
       auto classSymbol = std::dynamic_pointer_cast<ClassSymbol>(
           symbolTable.lookupSymbol(identifier->name));
@@ -2814,7 +2837,7 @@ SemanticAnalyzer::analyzeCallExpr(ast::CallExpr *callExpr) {
               }
             }
             // 创建实例化的类类型
-            return classType->instantiate(typeArgs);
+            return instantiateTemplateType(classType, typeArgs);
           }
           return classType;
         }
@@ -2826,154 +2849,26 @@ SemanticAnalyzer::analyzeCallExpr(ast::CallExpr *callExpr) {
     // 检查是否有显式模板参数
     bool hasExplicitTemplateArgs = !identifier->templateArgs.empty();
 
-    // 收集所有可能的匹配
-    std::vector<std::shared_ptr<FunctionSymbol>> viableCandidates;
-    std::vector<std::shared_ptr<FunctionSymbol>> exactCandidates;
-
-    for (const auto &funcSymbol : functionSymbols) {
-      // 如果有显式模板参数，只考虑泛型函数
-      if (hasExplicitTemplateArgs && !funcSymbol->isTemplate()) {
-        continue;
-      }
-
-      auto funcType = funcSymbol->getType();
-
-      // 如果有显式模板参数，需要替换模板类型
-      std::vector<std::shared_ptr<types::Type>> effectiveParamTypes;
-      if (hasExplicitTemplateArgs && funcSymbol->isTemplate()) {
-        // 构建模板参数名称到实际类型的映射
-        const auto &templateParamNames = funcSymbol->getTemplateParamNames();
-        std::map<std::string, std::shared_ptr<types::Type>> typeSubstitution;
-        for (size_t i = 0; i < templateParamNames.size() &&
-                           i < identifier->templateArgs.size();
-             ++i) {
-          if (auto *typeNode = dynamic_cast<ast::Type *>(
-                  identifier->templateArgs[i].get())) {
-            auto actualType = analyzeType(typeNode);
-            if (actualType) {
-              typeSubstitution[templateParamNames[i]] = actualType;
-            }
-          }
-        }
-        // 替换参数类型
-        for (const auto &paramType : funcType->getParameterTypes()) {
-          if (paramType) {
-            // 检查是否是模板类型参数
-            bool isTemplateParam = false;
-            for (const auto &[name, actualType] : typeSubstitution) {
-              if (paramType->toString() == name) {
-                effectiveParamTypes.push_back(actualType);
-                isTemplateParam = true;
-                break;
-              }
-            }
-            if (!isTemplateParam) {
-              effectiveParamTypes.push_back(paramType);
-            }
-          }
-        }
-      } else {
-        effectiveParamTypes = funcType->getParameterTypes();
-      }
-
-      size_t paramCount = effectiveParamTypes.size();
-      bool isVariadic = funcSymbol->isVariadicFunction();
-
-      // 检查参数数量是否匹配
-      // 对于可变参数函数，参数数量可以大于等于声明的参数数量
-      if (isVariadic) {
-        if (argTypes.size() < paramCount) {
-          continue;
-        }
-      } else {
-        if (paramCount != argTypes.size()) {
-          continue;
-        }
-      }
-
-      // 检查每个参数是否兼容
-      // 对于可变参数函数，只检查固定参数部分
-      bool isViable = true;
-      bool isExact = true;
-      size_t checkCount = isVariadic ? paramCount : argTypes.size();
-      for (size_t i = 0; i < checkCount; ++i) {
-        const auto &paramType = effectiveParamTypes[i];
-        const auto &argType = argTypes[i];
-
-        if (paramType && paramType->isReference()) {
-          auto refParamType =
-              std::dynamic_pointer_cast<types::ReferenceType>(paramType);
-          auto refBaseType =
-              refParamType ? refParamType->getBaseType() : nullptr;
-          if (!refBaseType) {
-            isViable = false;
-            break;
-          }
-
-          bool paramReadonly = refBaseType->isReadonly();
-          auto unwrappedParamBase = types::unwrapReadonly(refBaseType);
-
-          if (paramReadonly) {
-            if (argType->isReference()) {
-              auto argRefType =
-                  std::dynamic_pointer_cast<types::ReferenceType>(argType);
-              auto argBaseType =
-                  argRefType ? argRefType->getBaseType() : nullptr;
-              if (!argBaseType ||
-                  !isTypeCompatible(unwrappedParamBase, argBaseType)) {
-                isViable = false;
-                break;
-              }
-            } else {
-              if (!isTypeCompatible(unwrappedParamBase, argType)) {
-                isViable = false;
-                break;
-              }
-            }
-          } else {
-            if (!argType->isReference()) {
-              isViable = false;
-              break;
-            }
-            auto argRefType =
-                std::dynamic_pointer_cast<types::ReferenceType>(argType);
-            auto argBaseType = argRefType ? argRefType->getBaseType() : nullptr;
-            if (!argBaseType || !isTypeCompatible(refBaseType, argBaseType)) {
-              isViable = false;
-              break;
-            }
-          }
-
-          if (paramType->toString() != argType->toString()) {
-            isExact = false;
-          }
-          continue;
-        }
-
-        if (!isTypeCompatible(paramType, argType)) {
-          isViable = false;
-          break;
-        }
-
-        if (paramType->toString() != argType->toString()) {
-          isExact = false;
-        }
-      }
-
-      if (isViable) {
-        viableCandidates.push_back(funcSymbol);
-        if (isExact) {
-          exactCandidates.push_back(funcSymbol);
-        }
+    // 没有显式模板参数时，决议结果只取决于重载集合和实参类型，
+    // 在调用处之间复用
+    bool memoizable =
+        !hasExplicitTemplateArgs && OverloadCache::isCacheable(argTypes);
+    std::optional<OverloadCache::Resolution> resolution;
+    if (memoizable) {
+      resolution = overloadCache_.find(overloads->id, argTypes);
+    }
+    if (!resolution) {
+      resolution = resolveOverload(overloads->functions, argTypes, identifier);
+      if (memoizable) {
+        overloadCache_.insert(overloads->id, argTypes, *resolution);
       }
     }
 
-    // 根据规则选择
-    if (exactCandidates.size() == 1) {
-      // 规则 1：精确匹配优先
-      auto selectedFunc = exactCandidates[0];
-      if (hasExplicitTemplateArgs && !identifier->templateArgs.empty() &&
-          selectedFunc->isTemplate()) {
+    using ResolutionKind = OverloadCache::Resolution::Kind;
+    if (resolution->kind == ResolutionKind::Selected) {
+      // 规则 1、2：唯一的精确匹配或唯一的隐式转换路径
+      auto selectedFunc = resolution->function;
+      if (hasExplicitTemplateArgs && selectedFunc->isTemplate()) {
         // 替换返回类型中的模板参数
         auto retType = selectedFunc->getType()->getReturnType();
         const auto &templateParamNames = selectedFunc->getTemplateParamNames();
@@ -2993,31 +2888,7 @@ SemanticAnalyzer::analyzeCallExpr(ast::CallExpr *callExpr) {
         return retType;
       }
       return selectedFunc->getType()->getReturnType();
-    } else if (viableCandidates.size() == 1) {
-      // 规则 2：单一隐式转换路径
-      auto selectedFunc = viableCandidates[0];
-      // 如果有显式模板参数，返回替换后的返回类型
-      if (hasExplicitTemplateArgs && !identifier->templateArgs.empty() &&
-          selectedFunc->isTemplate()) {
-        auto retType = selectedFunc->getType()->getReturnType();
-        const auto &templateParamNames = selectedFunc->getTemplateParamNames();
-        for (size_t i = 0; i < templateParamNames.size() &&
-                           i < identifier->templateArgs.size();
-             ++i) {
-          if (retType->toString() == templateParamNames[i]) {
-            if (auto *typeNode = dynamic_cast<ast::Type *>(
-                    identifier->templateArgs[i].get())) {
-              auto actualType = analyzeType(typeNode);
-              if (actualType) {
-                return actualType;
-              }
-            }
-          }
-        }
-        return retType;
-      }
-      return selectedFunc->getType()->getReturnType();
-    } else if (viableCandidates.size() > 1) {
+    } else if (resolution->kind == ResolutionKind::Ambiguous) {
       // 规则 3：歧义时报错
       error("Ambiguous function call: " + identifier->name, *callExpr);
       return nullptr;
@@ -3039,6 +2910,166 @@ SemanticAnalyzer::analyzeCallExpr(ast::CallExpr *callExpr) {
   // 暂时返回 void 类型
   return types::TypeFactory::getPrimitiveType(types::PrimitiveType::Kind::Void);
 }
+OverloadCache::Resolution SemanticAnalyzer::resolveOverload(
+    const std::vector<std::shared_ptr<FunctionSymbol>> &functionSymbols,
+    const std::vector<std::shared_ptr<types::Type>> &argTypes,
+    ast::Identifier *identifier) {
+  bool hasExplicitTemplateArgs = !identifier->templateArgs.empty();
+
+  // 收集所有可能的匹配
+  std::vector<std::shared_ptr<FunctionSymbol>> viableCandidates;
+  std::vector<std::shared_ptr<FunctionSymbol>> exactCandidates;
+
+  for (const auto &funcSymbol : functionSymbols) {
+    // 如果有显式模板参数，只考虑泛型函数
+    if (hasExplicitTemplateArgs && !funcSymbol->isTemplate()) {
+      continue;
+    }
+
+    auto funcType = funcSymbol->getType();
+
+    // 如果有显式模板参数，需要替换模板类型
+    std::vector<std::shared_ptr<types::Type>> effectiveParamTypes;
+    if (hasExplicitTemplateArgs && funcSymbol->isTemplate()) {
+      // 构建模板参数名称到实际类型的映射
+      const auto &templateParamNames = funcSymbol->getTemplateParamNames();
+      std::map<std::string, std::shared_ptr<types::Type>> typeSubstitution;
+      for (size_t i = 0; i < templateParamNames.size() &&
+                         i < identifier->templateArgs.size();
+           ++i) {
+        if (auto *typeNode = dynamic_cast<ast::Type *>(
+                identifier->templateArgs[i].get())) {
+          auto actualType = analyzeType(typeNode);
+          if (actualType) {
+            typeSubstitution[templateParamNames[i]] = actualType;
+          }
+        }
+      }
+      // 替换参数类型
+      for (const auto &paramType : funcType->getParameterTypes()) {
+        if (paramType) {
+          // 检查是否是模板类型参数
+          bool isTemplateParam = false;
+          for (const auto &[name, actualType] : typeSubstitution) {
+            if (paramType->toString() == name) {
+              effectiveParamTypes.push_back(actualType);
+              isTemplateParam = true;
+              break;
+            }
+          }
+          if (!isTemplateParam) {
+            effectiveParamTypes.push_back(paramType);
+          }
+        }
+      }
+    } else {
+      effectiveParamTypes = funcType->getParameterTypes();
+    }
+
+    size_t paramCount = effectiveParamTypes.size();
+    bool isVariadic = funcSymbol->isVariadicFunction();
+
+    // 检查参数数量是否匹配
+    // 对于可变参数函数，参数数量可以大于等于声明的参数数量
+    if (isVariadic) {
+      if (argTypes.size() < paramCount) {
+        continue;
+      }
+    } else {
+      if (paramCount != argTypes.size()) {
+        continue;
+      }
+    }
+
+    // 检查每个参数是否兼容
+    // 对于可变参数函数，只检查固定参数部分
+    bool isViable = true;
+    bool isExact = true;
+    size_t checkCount = isVariadic ? paramCount : argTypes.size();
+    for (size_t i = 0; i < checkCount; ++i) {
+      const auto &paramType = effectiveParamTypes[i];
+      const auto &argType = argTypes[i];
+
+      if (paramType && paramType->isReference()) {
+        auto refParamType =
+            std::dynamic_pointer_cast<types::ReferenceType>(paramType);
+        auto refBaseType = refParamType ? refParamType->getBaseType() : nullptr;
+        if (!refBaseType) {
+          isViable = false;
+          break;
+        }
+
+        bool paramReadonly = refBaseType->isReadonly();
+        auto unwrappedParamBase = types::unwrapReadonly(refBaseType);
+
+        if (paramReadonly) {
+          if (argType->isReference()) {
+            auto argRefType =
+                std::dynamic_pointer_cast<types::ReferenceType>(argType);
+            auto argBaseType = argRefType ? argRefType->getBaseType() : nullptr;
+            if (!argBaseType ||
+                !isTypeCompatible(unwrappedParamBase, argBaseType)) {
+              isViable = false;
+              break;
+            }
+          } else {
+            if (!isTypeCompatible(unwrappedParamBase, argType)) {
+              isViable = false;
+              break;
+            }
+          }
+        } else {
+          if (!argType->isReference()) {
+            isViable = false;
+            break;
+          }
+          auto argRefType =
+              std::dynamic_pointer_cast<types::ReferenceType>(argType);
+          auto argBaseType = argRefType ? argRefType->getBaseType() : nullptr;
+          if (!argBaseType || !isTypeCompatible(refBaseType, argBaseType)) {
+            isViable = false;
+            break;
+          }
+        }
+
+        if (!types::isSameType(*paramType, *argType)) {
+          isExact = false;
+        }
+        continue;
+      }
+
+      if (!isTypeCompatible(paramType, argType)) {
+        isViable = false;
+        break;
+      }
+
+      if (!types::isSameType(*paramType, *argType)) {
+        isExact = false;
+      }
+    }
+
+    if (isViable) {
+      viableCandidates.push_back(funcSymbol);
+      if (isExact) {
+        exactCandidates.push_back(funcSymbol);
+      }
+    }
+  }
+
+  // 根据规则选择
+  using Kind = OverloadCache::Resolution::Kind;
+  if (exactCandidates.size() == 1) {
+    // 规则 1：精确匹配优先
+    return {Kind::Selected, exactCandidates[0]};
+  } else if (viableCandidates.size() == 1) {
+    // 规则 2：单一隐式转换路径
+    return {Kind::Selected, viableCandidates[0]};
+  } else if (viableCandidates.size() > 1) {
+    // 规则 3：歧义
+    return {Kind::Ambiguous, nullptr};
+  }
+  return {Kind::NoMatch, nullptr};
+}
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeMemberExpr(ast::MemberExpr *memberExpr) {
   // 分析对象表达式
@@ -3069,7 +3100,7 @@ SemanticAnalyzer::analyzeMemberExpr(ast::MemberExpr *memberExpr) {
     // 数组的 ptr 属性
     if (memberExpr->member == "ptr") {
       auto elementType = arrayType->getElementType();
-      return std::make_shared<types::PointerType>(elementType);
+      return types::TypeFactory::getPointerType(elementType);
     }
 
     error("Member not found in array: " + memberExpr->member, *memberExpr);
@@ -3089,7 +3120,7 @@ SemanticAnalyzer::analyzeMemberExpr(ast::MemberExpr *memberExpr) {
     // 切片的 ptr 属性
     if (memberExpr->member == "ptr") {
       auto elementType = sliceType->getElementType();
-      return std::make_shared<types::PointerType>(elementType);
+      return types::TypeFactory::getPointerType(elementType);
     }
 
     error("Member not found in slice: " + memberExpr->member, *memberExpr);
@@ -3276,19 +3307,19 @@ SemanticAnalyzer::analyzeSubscriptExpr(ast::SubscriptExpr *subscriptExpr) {
   // 检查是否是数组类型
   if (arrayType->isArray()) {
     auto array = std::dynamic_pointer_cast<types::ArrayType>(arrayType);
-    return std::make_shared<types::ReferenceType>(array->getElementType());
+    return types::TypeFactory::getReferenceType(array->getElementType());
   }
 
   // 检查是否是切片类型
   if (arrayType->isSlice()) {
     auto slice = std::dynamic_pointer_cast<types::SliceType>(arrayType);
-    return std::make_shared<types::ReferenceType>(slice->getElementType());
+    return types::TypeFactory::getReferenceType(slice->getElementType());
   }
 
   // 检查是否是指针类型
   if (arrayType->isPointer()) {
     auto pointer = std::dynamic_pointer_cast<types::PointerType>(arrayType);
-    return std::make_shared<types::ReferenceType>(pointer->getPointeeType());
+    return types::TypeFactory::getReferenceType(pointer->getPointeeType());
   }
 
   error("Subscript can only be used with arrays, slices, or pointers",
@@ -3353,8 +3384,8 @@ SemanticAnalyzer::analyzeArrayInitExpr(ast::ArrayInitExpr *arrayInitExpr) {
   }
 
   // 创建数组类型
-  return std::make_shared<types::ArrayType>(elementType,
-                                            arrayInitExpr->elements.size());
+  return types::TypeFactory::getArrayType(elementType,
+                                          arrayInitExpr->elements.size());
 }
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeStructInitExpr(ast::StructInitExpr *structInitExpr) {
@@ -3370,7 +3401,7 @@ SemanticAnalyzer::analyzeTupleExpr(ast::TupleExpr *tupleExpr) {
     }
     elementTypes.push_back(elemType);
   }
-  return std::make_shared<types::TupleType>(elementTypes);
+  return types::TypeFactory::getTupleType(elementTypes);
 }
 
 std::shared_ptr<types::Type>
@@ -3517,7 +3548,7 @@ SemanticAnalyzer::analyzePointerType(const ast::PointerType *pointerType) {
   }
 
   // 创建指针类型
-  return std::make_shared<types::PointerType>(elementType);
+  return types::TypeFactory::getPointerType(elementType);
 }
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeArrayType(const ast::ArrayType *arrayType) {
@@ -3547,7 +3578,7 @@ SemanticAnalyzer::analyzeArrayType(const ast::ArrayType *arrayType) {
   }
 
   // 创建数组类型
-  return std::make_shared<types::ArrayType>(elementType, arraySize);
+  return types::TypeFactory::getArrayType(elementType, arraySize);
 }
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeSliceType(const ast::SliceType *sliceType) {
@@ -3565,7 +3596,7 @@ SemanticAnalyzer::analyzeSliceType(const ast::SliceType *sliceType) {
   }
 
   // 创建切片类型
-  return std::make_shared<types::SliceType>(elementType);
+  return types::TypeFactory::getSliceType(elementType);
 }
 std::shared_ptr<types::Type> SemanticAnalyzer::analyzeReferenceType(
     const ast::ReferenceType *referenceType) {
@@ -3578,7 +3609,7 @@ std::shared_ptr<types::Type> SemanticAnalyzer::analyzeReferenceType(
     return nullptr;
   }
 
-  return std::make_shared<types::ReferenceType>(baseType);
+  return types::TypeFactory::getReferenceType(baseType);
 }
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeFunctionType(const ast::FunctionType *functionType) {
@@ -3599,7 +3630,7 @@ SemanticAnalyzer::analyzeFunctionType(const ast::FunctionType *functionType) {
         types::TypeFactory::getPrimitiveType(types::PrimitiveType::Kind::Void);
   }
 
-  return std::make_shared<types::FunctionType>(returnType, paramTypes);
+  return types::TypeFactory::getFunctionType(returnType, paramTypes);
 }
 std::shared_ptr<types::Type>
 SemanticAnalyzer::analyzeNamedType(const ast::NamedType *namedType) {
@@ -3615,7 +3646,7 @@ SemanticAnalyzer::analyzeTupleType(const ast::TupleType *tupleType) {
     }
     elementTypes.push_back(type);
   }
-  return std::make_shared<types::TupleType>(elementTypes);
+  return types::TypeFactory::getTupleType(elementTypes);
 }
 
 std::shared_ptr<types::Type>
@@ -3641,7 +3672,7 @@ SemanticAnalyzer::analyzeGenericType(const ast::GenericType *genericType) {
   if (baseType->isClass()) {
     auto classType = std::dynamic_pointer_cast<types::ClassType>(baseType);
     if (classType && !typeArgs.empty()) {
-      return classType->instantiate(typeArgs);
+      return instantiateTemplateType(classType, typeArgs);
     }
     return classType;
   }
@@ -3708,6 +3739,20 @@ bool SemanticAnalyzer::isTypeCompatible(
     return false;
   }
 
+  using Relation = types::RelationCache::Relation;
+  if (auto cached = relationCache_.find(Relation::Assignable, expected.get(),
+                                        actual.get())) {
+    return *cached;
+  }
+  bool result = checkTypeCompatible(expected, actual);
+  relationCache_.insert(Relation::Assignable, expected, actual, result);
+  return result;
+}
+
+bool SemanticAnalyzer::checkTypeCompatible(
+    const std::shared_ptr<types::Type> &expected,
+    const std::shared_ptr<types::Type> &actual) {
+
   // null 字面量（void 类型）可以赋给任何可空类型
   if (actual->isPrimitive()) {
     auto actualPrim = std::dynamic_pointer_cast<types::PrimitiveType>(actual);
@@ -3749,7 +3794,7 @@ bool SemanticAnalyzer::isTypeCompatible(
   }
 
   // 精确匹配
-  if (expected->toString() == actual->toString()) {
+  if (types::isSameType(*expected, *actual)) {
     return true;
   }
 
@@ -3825,8 +3870,8 @@ bool SemanticAnalyzer::isTypeCompatible(
     }
 
     // 检查指向类型是否完全相同（指针不支持隐式类型转换）
-    // 使用 toString() 比较来避免隐式数值转换
-    if (expectedPointee->toString() == actualPointee->toString()) {
+    // 按类型是否相同比较来避免隐式数值转换
+    if (types::isSameType(*expectedPointee, *actualPointee)) {
       return true;
     }
 
@@ -3897,7 +3942,7 @@ bool SemanticAnalyzer::isTypeCompatible(
   }
 
   // 检查子类型关系
-  if (actual->isSubtypeOf(*expected)) {
+  if (relationCache_.isSubtype(actual, expected)) {
     return true;
   }
 
@@ -4090,13 +4135,17 @@ SemanticAnalyzer::parseVisibility(const std::vector<std::string> &specifiers) {
 
 void SemanticAnalyzer::error(const std::string &message,
                              const ast::Node &node) {
-  hasError_ = true;
-  std::cerr << "Semantic Error: " << message << std::endl;
+  error(message);
 }
 
 void SemanticAnalyzer::error(const std::string &message) {
   hasError_ = true;
-  std::cerr << "Semantic Error: " << message << std::endl;
+  if (diagnosticHandler_) {
+    diagnosticHandler_(message);
+    return;
+  }
+  // 并行分析模块时整行一次写出，不同模块的诊断不会交错
+  std::cerr << ("Semantic Error: " + message + "\n") << std::flush;
 }
 
 // 检查访问控制
@@ -4136,39 +4185,42 @@ bool SemanticAnalyzer::checkAccessControl(types::AccessModifier access,
 
 bool SemanticAnalyzer::isSubclassOf(const types::ClassType *derived,
                                     const types::ClassType *base) {
-  if (!derived || !base) {
-    return false;
-  }
-
-  for (const auto &baseClass : derived->getBaseClasses()) {
-    if (!baseClass) {
-      continue;
-    }
-    if (baseClass->getName() == base->getName()) {
-      return true;
-    }
-    if (isSubclassOf(baseClass.get(), base)) {
-      return true;
-    }
-  }
-
-  return false;
+  return classHierarchy_.isSubclassOf(derived, base);
 }
 
 // 检查循环继承
 bool SemanticAnalyzer::checkCircularInheritance(const types::ClassType *derived,
                                                 const types::ClassType *base) {
   // 检查基类是否继承自派生类（直接或间接）
-  for (const auto &baseBase : base->getBaseClasses()) {
-    if (baseBase->toString() == derived->toString()) {
-      return true; // 发现循环继承
-    }
-    // 递归检查基类的基类
-    if (checkCircularInheritance(derived, baseBase.get())) {
-      return true;
-    }
-  }
-  return false;
+  return classHierarchy_.isSubclassOf(base, derived);
+}
+
+void SemanticAnalyzer::invalidateTypeRelations() {
+  relationCache_.clear();
+  classHierarchy_.invalidate();
+  overloadCache_.clear();
+}
+
+void SemanticAnalyzer::dumpStats(std::ostream &out) const {
+  const auto &relations = relationCache_.getStats();
+  out << std::format("Relation cache: {} hits, {} misses ({:.1f}% hit rate)\n",
+                     relations.hits, relations.misses,
+                     relations.hitRate() * 100);
+  const auto &hierarchy = classHierarchy_.getStats();
+  out << std::format("Class hierarchy: {} queries, {} interval hits, "
+                     "{} memo hits, {} renumbers\n",
+                     hierarchy.queries, hierarchy.intervalHits,
+                     hierarchy.memoHits, hierarchy.renumbers);
+  const auto &overloads = overloadCache_.getStats();
+  out << std::format("Overload cache: {} hits, {} misses\n", overloads.hits,
+                     overloads.misses);
+  const auto &instantiations = instantiations_.getStats();
+  out << std::format("Generic instantiations: {} created ({} after the "
+                     "template changed), {} reused ({:.1f}% reuse), "
+                     "{} distinct\n",
+                     instantiations.created, instantiations.refreshed,
+                     instantiations.reused, instantiations.reuseRate() * 100,
+                     instantiations_.size());
 }
 
 // 检查类是否实现了所有接口方法
@@ -4264,7 +4316,7 @@ std::shared_ptr<types::Type> SemanticAnalyzer::instantiateTemplateType(
   if (templateType->isClass()) {
     auto classType = std::dynamic_pointer_cast<types::ClassType>(templateType);
     if (classType) {
-      return classType->instantiate(typeArguments);
+      return instantiations_.instantiate(classType, typeArguments);
     }
   }
 
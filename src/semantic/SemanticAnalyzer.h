@@ -1,10 +1,16 @@
 #pragma once
 
 #include "../ast/AstNodes.h"
+#include "../types/InstantiationTable.h"
+#include "../types/RelationCache.h"
 #include "../types/Type.h"
+#include "ClassHierarchy.h"
 #include "ExtensionRegistry.h"
-#include "ModuleLoader.h"
+#include "ModuleGraph.h"
+#include "OverloadCache.h"
 #include "SymbolTable.h"
+#include <functional>
+#include <iosfwd>
 #include <memory>
 #include <set>
 #include <string>
@@ -22,9 +28,34 @@ public:
   SemanticAnalyzer(const std::vector<std::string> &modulePaths,
                    bool requireMainFunction = true);
 
+  // 与其他入口程序共享模块图（并行编译多个翻译单元），导入的模块只分析
+  // 一次。共享的模块图不会自动预取，由调用方对全部入口程序调用
+  // ModuleGraph::prefetch
+  explicit SemanticAnalyzer(ModuleGraph &moduleGraph,
+                            bool requireMainFunction = true);
+
   // 分析整个程序
   void analyze(ast::Program &program);
 
+  // 分步分析（供流水线模式使用）：每解析出一个顶层声明就调用
+  // collectTopLevelDeclaration 收集其签名，全部声明到齐后调用 finishAnalysis
+  // 分析类成员和函数体。两步合起来与 analyze 等价。
+  void collectTopLevelDeclaration(ast::Declaration *decl);
+  void finishAnalysis(ast::Program &program);
+
+  // finishAnalysis 的两遍，按声明单独调用（供语言服务器增量分析使用）：
+  // 全部顶层声明收集完后，先对每个声明调用 analyzeTopLevelMembers 分析类
+  // 成员，再调用 analyzeTopLevelBody 分析顶层函数体。签名不变时，修改过的
+  // 顶层函数可以只对它重新调用 analyzeTopLevelBody
+  void analyzeTopLevelMembers(ast::Declaration *decl);
+  void analyzeTopLevelBody(ast::Declaration *decl);
+
+  // 诊断信息的接收函数，设置后错误交给它而不再打印到标准错误
+  using DiagnosticHandler = std::function<void(const std::string &)>;
+  void setDiagnosticHandler(DiagnosticHandler handler) {
+    diagnosticHandler_ = std::move(handler);
+  }
+
   // 分析单个表达式（用于单元测试）
   std::shared_ptr<types::Type>
   analyzeExpressionOnly(ast::Expression *expression);
@@ -38,19 +69,106 @@ public:
   // 获取符号表
   SymbolTable &getSymbolTable() { return symbolTable; }
 
+  // 获取扩展注册表
+  const ExtensionRegistry &getExtensionRegistry() const {
+    return extensionRegistry_;
+  }
+
+  // 导入模块共享的模块图（未设置模块搜索路径时为 nullptr）
+  ModuleGraph *getModuleGraph() { return moduleGraph_; }
+
+  // 设置导入模块的接口（.chi 文件）缓存目录，为空时不使用模块接口
+  void setModuleInterfaceCacheDir(const std::string &dir) {
+    if (moduleGraph_) {
+      moduleGraph_->getLoader().setInterfaceCacheDir(dir);
+    }
+  }
+
+  // 启用或关闭导入模块的 AST 缓存
+  void setAstCacheEnabled(bool enabled) {
+    if (moduleGraph_) {
+      moduleGraph_->getLoader().setAstCacheEnabled(enabled);
+    }
+  }
+
+  // 设置 AST 缓存目录，为空时使用系统临时目录
+  void setAstCacheDir(const std::string &dir) {
+    if (moduleGraph_) {
+      moduleGraph_->getLoader().setAstCacheDir(dir);
+    }
+  }
+
+  // 设置保存模块搜索路径索引的文件，为空时只在进程内缓存索引
+  void setModuleIndexFile(const std::string &path) {
+    if (moduleGraph_) {
+      moduleGraph_->getLoader().setModuleIndexFile(path);
+    }
+  }
+
+  // 设置并行加载导入模块的线程数，1 表示逐个加载
+  void setModuleJobs(size_t jobs) {
+    if (moduleGraph_) {
+      moduleGraph_->setJobs(jobs);
+    }
+  }
+
   // 检查是否有错误
   bool hasError() const { return hasError_; }
 
+  // 类型关系缓存的统计
+  const types::RelationCache::Stats &getRelationCacheStats() const {
+    return relationCache_.getStats();
+  }
+
+  // 类层次结构查询的统计
+  const ClassHierarchy::Stats &getClassHierarchyStats() const {
+    return classHierarchy_.getStats();
+  }
+
+  // 重载决议缓存的统计
+  const OverloadCache::Stats &getOverloadCacheStats() const {
+    return overloadCache_.getStats();
+  }
+
+  // 泛型类实例化的统计
+  const types::InstantiationTable::Stats &getInstantiationStats() const {
+    return instantiations_.getStats();
+  }
+
+  // 输出各个缓存的统计（--dump-stats）
+  void dumpStats(std::ostream &out) const;
+
 private:
+  friend class ModuleGraph;
+
+  // 分析被导入的模块，模块自己的导入通过同一个模块图解析
+  SemanticAnalyzer(ModuleGraph &moduleGraph, ModuleGraph::Module &module);
+
   // 符号表
   SymbolTable symbolTable;
 
-  // 模块加载器
-  std::unique_ptr<ModuleLoader> moduleLoader_;
+  // 入口程序的分析器持有模块图，被导入模块的分析器共享它
+  std::unique_ptr<ModuleGraph> ownedModuleGraph_;
+  ModuleGraph *moduleGraph_ = nullptr;
+
+  // 正在分析的被导入模块，入口程序为 nullptr
+  ModuleGraph::Module *currentModule_ = nullptr;
 
   // 扩展注册表
   ExtensionRegistry extensionRegistry_;
 
+  // 类型兼容和子类型关系的缓存
+  types::RelationCache relationCache_;
+
+  // 类继承关系的区间编号
+  ClassHierarchy classHierarchy_;
+
+  // 按 (重载集合, 实参类型) 记住的重载决议结果
+  OverloadCache overloadCache_;
+
+  // 泛型类的实例，同一模板和实参只实例化一次（只在本分析器中共享）
+  types::InstantiationTable instantiations_;
+
   // 当前分析的程序
   ast::Program *currentProgram_ = nullptr;
 
@@ -195,6 +313,12 @@ private:
   // 分析函数调用表达式
   std::shared_ptr<types::Type> analyzeCallExpr(ast::CallExpr *callExpr);
 
+  // 在同名函数中选择与实参匹配的重载（不报告错误）
+  OverloadCache::Resolution resolveOverload(
+      const std::vector<std::shared_ptr<FunctionSymbol>> &functionSymbols,
+      const std::vector<std::shared_ptr<types::Type>> &argTypes,
+      ast::Identifier *identifier);
+
   // 分析成员访问表达式
   std::shared_ptr<types::Type> analyzeMemberExpr(ast::MemberExpr *memberExpr);
 
@@ -288,10 +412,17 @@ private:
   // 检查表达式是否为左值
   bool isLValue(const ast::Expression &expr) const;
 
-  // 检查类型是否兼容
+  // 检查类型是否兼容（结果记在关系缓存中）
   bool isTypeCompatible(const std::shared_ptr<types::Type> &expected,
                         const std::shared_ptr<types::Type> &actual);
 
+  // isTypeCompatible 的实际检查
+  bool checkTypeCompatible(const std::shared_ptr<types::Type> &expected,
+                           const std::shared_ptr<types::Type> &actual);
+
+  // 类或接口的继承关系变化后清除关系缓存、类层次结构和重载决议缓存
+  void invalidateTypeRelations();
+
   // 尝试进行隐式类型转换
   std::shared_ptr<types::Type>
   tryImplicitConversion(const std::shared_ptr<types::Type> &expected,
@@ -331,7 +462,7 @@ private:
   std::vector<std::shared_ptr<types::Type>>
   analyzeTemplateArguments(const std::vector<std::unique_ptr<ast::Node>> &args);
 
-  // 实例化模板类型
+  // 实例化模板类型（类的实例记在实例化表中）
   std::shared_ptr<types::Type> instantiateTemplateType(
       const std::shared_ptr<types::Type> &templateType,
       const std::vector<std::shared_ptr<types::Type>> &typeArguments);
@@ -339,16 +470,15 @@ private:
   // 是否有错误
   bool hasError_ = false;
 
+  // 诊断信息的接收函数，为空时打印到标准错误
+  DiagnosticHandler diagnosticHandler_;
+
   // 是否需要 main 函数
   bool requireMainFunction_ = true;
 
   // 当前模块路径
   std::vector<std::string> currentModulePath_;
 
-  // 已加载的模块符号表（模块路径 -> 符号表）
-  std::unordered_map<std::string, std::unique_ptr<SymbolTable>>
-      loadedModuleSymbols_;
-
   // 当前函数的返回类型
   std::shared_ptr<types::Type> currentFunctionReturnType_;
 
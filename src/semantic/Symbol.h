@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../lexer/NameInterner.h"
 #include <string>
 
 namespace c_hat {
@@ -35,6 +36,9 @@ public:
   // 获取符号名称
   const std::string &getName() const { return name; }
 
+  // 获取符号名称的驻留编号
+  lexer::NameId getNameId() const { return nameId; }
+
   // 获取符号类型
   SymbolType getType() const { return type; }
 
@@ -53,10 +57,12 @@ public:
 protected:
   Symbol(const std::string &name, SymbolType type,
          Visibility visibility = Visibility::Default)
-      : name(name), type(type), scopeLevel(0), visibility(visibility) {}
+      : name(name), nameId(lexer::NameInterner::global().intern(name)),
+        type(type), scopeLevel(0), visibility(visibility) {}
 
 private:
   std::string name;
+  lexer::NameId nameId;
   SymbolType type;
   int scopeLevel;
   Visibility visibility;
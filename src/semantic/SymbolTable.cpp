@@ -3,24 +3,112 @@
 namespace c_hat {
 namespace semantic {
 
+namespace {
+
+// 初始槽数（2 的幂）
+constexpr size_t InitialSlotCount = 64;
+
+// 名称编号的低位记录驻留表分片，用乘法散列打散
+size_t slotIndex(lexer::NameId nameId, size_t mask) {
+  return (static_cast<uint64_t>(nameId) * 0x9e3779b97f4a7c15ULL >> 32) & mask;
+}
+
+} // namespace
+
 // SymbolTable 构造函数
 SymbolTable::SymbolTable() : currentScopeLevel(0) {
   // 初始化全局作用域
-  scopes.emplace_back();
+  slots.resize(InitialSlotCount);
 }
 
 // 进入一个新的作用域
 void SymbolTable::enterScope() {
   currentScopeLevel++;
-  scopes.emplace_back();
+  scopeMarks.push_back({static_cast<uint32_t>(bindings.size()),
+                        static_cast<uint32_t>(undoLog.size())});
 }
 
 // 退出当前作用域
 void SymbolTable::exitScope() {
-  if (currentScopeLevel > 0) {
-    currentScopeLevel--;
-    scopes.pop_back();
+  if (currentScopeLevel == 0) {
+    return;
+  }
+  // 本作用域的绑定都在链的开头，跳过它们恢复外层的链头
+  ScopeMark mark = scopeMarks.back();
+  for (size_t i = mark.undo; i < undoLog.size(); ++i) {
+    Slot *slot = findSlot(undoLog[i]);
+    slot->overloads.reset();
+    slot->tail = NoBinding;
+    while (slot->head != NoBinding &&
+           bindings[slot->head].level == currentScopeLevel) {
+      slot->head = bindings[slot->head].next;
+    }
   }
+  undoLog.resize(mark.undo);
+  bindings.resize(mark.bindings);
+  scopeMarks.pop_back();
+  currentScopeLevel--;
+}
+
+const SymbolTable::Slot *SymbolTable::findSlot(lexer::NameId nameId) const {
+  // 空槽的编号是 InvalidNameId
+  if (nameId == lexer::InvalidNameId) {
+    return nullptr;
+  }
+  size_t mask = slots.size() - 1;
+  for (size_t i = slotIndex(nameId, mask);; i = (i + 1) & mask) {
+    if (slots[i].nameId == nameId) {
+      return &slots[i];
+    }
+    if (slots[i].nameId == lexer::InvalidNameId) {
+      return nullptr;
+    }
+  }
+}
+
+SymbolTable::Slot *SymbolTable::findSlot(lexer::NameId nameId) {
+  return const_cast<Slot *>(std::as_const(*this).findSlot(nameId));
+}
+
+SymbolTable::Slot &SymbolTable::insertSlot(lexer::NameId nameId) {
+  // 装载因子不超过 3/4
+  if ((usedSlots + 1) * 4 > slots.size() * 3) {
+    grow();
+  }
+  size_t mask = slots.size() - 1;
+  size_t i = slotIndex(nameId, mask);
+  while (slots[i].nameId != nameId) {
+    if (slots[i].nameId == lexer::InvalidNameId) {
+      slots[i].nameId = nameId;
+      usedSlots++;
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return slots[i];
+}
+
+void SymbolTable::grow() {
+  std::vector<Slot> old(slots.size() * 2);
+  old.swap(slots);
+  size_t mask = slots.size() - 1;
+  for (const auto &slot : old) {
+    if (slot.nameId == lexer::InvalidNameId) {
+      continue;
+    }
+    size_t i = slotIndex(slot.nameId, mask);
+    while (slots[i].nameId != lexer::InvalidNameId) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+  }
+}
+
+std::pair<size_t, size_t> SymbolTable::scopeRange(int level) const {
+  size_t first = level == 0 ? 0 : scopeMarks[level - 1].bindings;
+  size_t last = level == currentScopeLevel ? bindings.size()
+                                           : scopeMarks[level].bindings;
+  return {first, last};
 }
 
 // 添加符号
@@ -28,79 +116,156 @@ void SymbolTable::addSymbol(std::shared_ptr<Symbol> symbol) {
   // 设置符号所在作用域
   symbol->setScopeLevel(currentScopeLevel);
 
-  // 将符号添加到当前作用域
-  scopes.back()[symbol->getName()].push_back(symbol);
+  lexer::NameId nameId = symbol->getNameId();
+  Slot &slot = insertSlot(nameId);
+  auto index = static_cast<uint32_t>(bindings.size());
+  bindings.push_back({std::move(symbol), NoBinding, currentScopeLevel});
+
+  if (slot.head == NoBinding ||
+      bindings[slot.head].level != currentScopeLevel) {
+    // 名称在本作用域中的第一个绑定成为链头，退出作用域时恢复
+    bindings[index].next = slot.head;
+    slot.head = index;
+    slot.tail = index;
+    slot.overloads.reset();
+    undoLog.push_back(nameId);
+    return;
+  }
+  // 同一作用域中的重载接在本作用域的最后一个绑定之后，保持添加顺序
+  if (slot.tail == NoBinding) {
+    slot.tail = slot.head;
+    while (bindings[slot.tail].next != NoBinding &&
+           bindings[bindings[slot.tail].next].level == currentScopeLevel) {
+      slot.tail = bindings[slot.tail].next;
+    }
+  }
+  uint32_t last = slot.tail;
+  bindings[index].next = bindings[last].next;
+  bindings[last].next = index;
+  slot.tail = index;
+
+  // 外层作用域没有同名绑定时新重载排在集合末尾：追加到已有的集合并
+  // 换一个编号，不必沿整条链重新收集。集合已经交给了调用方时复制一份，
+  // 调用方手中的集合保持不变
+  if (!slot.overloads || bindings[index].next != NoBinding) {
+    slot.overloads.reset();
+    return;
+  }
+  const auto &added = bindings[index].symbol;
+  if (added->getType() != SymbolType::Function) {
+    return;
+  }
+  auto function = std::dynamic_pointer_cast<FunctionSymbol>(added);
+  if (!function) {
+    return;
+  }
+  if (slot.overloads.use_count() > 1) {
+    slot.overloads = std::make_shared<OverloadSet>(*slot.overloads);
+  }
+  slot.overloads->id = nextOverloadSetId++;
+  slot.overloads->functions.push_back(std::move(function));
 }
 
 // 查找符号（从当前作用域开始向上查找）
 std::shared_ptr<Symbol> SymbolTable::lookupSymbol(const std::string &name) {
-  // 从当前作用域开始向上查找
-  for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-    const auto &scope = *it;
-    auto symbolIt = scope.find(name);
-    if (symbolIt != scope.end() && !symbolIt->second.empty()) {
-      // 对于非函数符号，返回第一个找到的
-      // 对于函数符号，这里只返回第一个，函数重载使用lookupFunctionSymbols
-      return symbolIt->second[0];
-    }
+  // 从未驻留过的名称不可能对应任何符号
+  lexer::NameId nameId = lexer::NameInterner::global().lookup(name);
+  if (nameId == lexer::InvalidNameId) {
+    return nullptr;
   }
+  return lookupSymbol(nameId);
+}
 
-  // 未找到符号
-  return nullptr;
+std::shared_ptr<Symbol> SymbolTable::lookupSymbol(lexer::NameId nameId) {
+  // 链头是最内层作用域中第一个添加的符号
+  // 对于函数符号，这里只返回第一个，函数重载使用lookupFunctionSymbols
+  const Slot *slot = findSlot(nameId);
+  if (!slot || slot->head == NoBinding) {
+    return nullptr;
+  }
+  return bindings[slot->head].symbol;
 }
 
 // 查找所有同名函数符号（从当前作用域开始向上查找）
 std::vector<std::shared_ptr<FunctionSymbol>>
 SymbolTable::lookupFunctionSymbols(const std::string &name) {
-  std::vector<std::shared_ptr<FunctionSymbol>> result;
-
-  // 从当前作用域开始向上查找
-  for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-    const auto &scope = *it;
-    auto symbolIt = scope.find(name);
-    if (symbolIt != scope.end()) {
-      for (const auto &symbol : symbolIt->second) {
-        if (symbol->getType() == SymbolType::Function) {
-          auto funcSymbol = std::dynamic_pointer_cast<FunctionSymbol>(symbol);
-          if (funcSymbol) {
-            result.push_back(funcSymbol);
-          }
-        }
+  lexer::NameId nameId = lexer::NameInterner::global().lookup(name);
+  if (nameId == lexer::InvalidNameId) {
+    return {};
+  }
+  return lookupFunctionSymbols(nameId);
+}
+
+std::vector<std::shared_ptr<FunctionSymbol>>
+SymbolTable::lookupFunctionSymbols(lexer::NameId nameId) {
+  return lookupOverloadSet(nameId)->functions;
+}
+
+std::shared_ptr<const OverloadSet>
+SymbolTable::lookupOverloadSet(const std::string &name) {
+  return lookupOverloadSet(lexer::NameInterner::global().lookup(name));
+}
+
+std::shared_ptr<const OverloadSet>
+SymbolTable::lookupOverloadSet(lexer::NameId nameId) {
+  static const auto empty = std::make_shared<const OverloadSet>();
+  Slot *slot = findSlot(nameId);
+  if (!slot) {
+    return empty;
+  }
+  if (slot->overloads) {
+    return slot->overloads;
+  }
+
+  // 沿绑定链从当前作用域向外收集
+  auto overloads = std::make_shared<OverloadSet>();
+  overloads->id = nextOverloadSetId++;
+  for (uint32_t i = slot->head; i != NoBinding; i = bindings[i].next) {
+    const auto &symbol = bindings[i].symbol;
+    if (symbol->getType() == SymbolType::Function) {
+      auto funcSymbol = std::dynamic_pointer_cast<FunctionSymbol>(symbol);
+      if (funcSymbol) {
+        overloads->functions.push_back(funcSymbol);
       }
     }
   }
-
-  return result;
+  slot->overloads = overloads;
+  return overloads;
 }
 
 // 检查当前作用域是否已存在该符号
 bool SymbolTable::hasSymbolInCurrentScope(const std::string &name) const {
-  if (scopes.empty()) {
+  lexer::NameId nameId = lexer::NameInterner::global().lookup(name);
+  if (nameId == lexer::InvalidNameId) {
     return false;
   }
+  return hasSymbolInCurrentScope(nameId);
+}
 
-  const auto &currentScope = scopes.back();
-  auto symbolIt = currentScope.find(name);
-  return symbolIt != currentScope.end() && !symbolIt->second.empty();
+bool SymbolTable::hasSymbolInCurrentScope(lexer::NameId nameId) const {
+  const Slot *slot = findSlot(nameId);
+  return slot && slot->head != NoBinding &&
+         bindings[slot->head].level == currentScopeLevel;
 }
 
 // 移除符号（用于方法重写时移除继承的方法）
 void SymbolTable::removeSymbol(const std::string &name,
                                 std::shared_ptr<Symbol> symbol) {
-  for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-    auto &scope = *it;
-    auto symbolIt = scope.find(name);
-    if (symbolIt != scope.end()) {
-      auto &symbols = symbolIt->second;
-      for (auto vecIt = symbols.begin(); vecIt != symbols.end(); ++vecIt) {
-        if (*vecIt == symbol) {
-          symbols.erase(vecIt);
-          if (symbols.empty()) {
-            scope.erase(symbolIt);
-          }
-          return;
-        }
-      }
+  lexer::NameId nameId = lexer::NameInterner::global().lookup(name);
+  Slot *slot = findSlot(nameId);
+  if (!slot) {
+    return;
+  }
+  // 从链中摘除，绑定留在数组中（符号置空），作用域退出时一起截断
+  slot->overloads.reset();
+  slot->tail = NoBinding;
+  for (uint32_t *link = &slot->head; *link != NoBinding;
+       link = &bindings[*link].next) {
+    Binding &binding = bindings[*link];
+    if (binding.symbol == symbol) {
+      *link = binding.next;
+      binding.symbol.reset();
+      return;
     }
   }
 }
@@ -110,13 +275,11 @@ std::vector<std::shared_ptr<Symbol>> SymbolTable::getSymbolsInParentScope() cons
   std::vector<std::shared_ptr<Symbol>> result;
 
   // 检查是否有上一级作用域
-  if (scopes.size() > 1) {
-    const auto &parentScope = scopes[scopes.size() - 2];
-
-    // 遍历上一级作用域中的所有符号
-    for (const auto &entry : parentScope) {
-      for (const auto &symbol : entry.second) {
-        result.push_back(symbol);
+  if (currentScopeLevel > 0) {
+    auto [first, last] = scopeRange(currentScopeLevel - 1);
+    for (size_t i = first; i < last; ++i) {
+      if (bindings[i].symbol) {
+        result.push_back(bindings[i].symbol);
       }
     }
   }
@@ -128,17 +291,33 @@ std::vector<std::shared_ptr<Symbol>> SymbolTable::getSymbolsInParentScope() cons
 std::unordered_map<std::string, std::shared_ptr<Symbol>> SymbolTable::getAllSymbols() const {
   std::unordered_map<std::string, std::shared_ptr<Symbol>> result;
 
-  // 从全局作用域开始收集符号
-  for (const auto &scope : scopes) {
-    for (const auto &entry : scope) {
-      if (!entry.second.empty()) {
-        result[entry.first] = entry.second[0];
+  // 同名时取最内层作用域中第一个添加的符号
+  for (int level = 0; level <= currentScopeLevel; ++level) {
+    std::unordered_map<std::string, std::shared_ptr<Symbol>> scope;
+    auto [first, last] = scopeRange(level);
+    for (size_t i = first; i < last; ++i) {
+      if (bindings[i].symbol) {
+        scope.try_emplace(bindings[i].symbol->getName(), bindings[i].symbol);
       }
     }
+    for (auto &entry : scope) {
+      result[entry.first] = std::move(entry.second);
+    }
   }
 
   return result;
 }
 
+std::vector<std::shared_ptr<Symbol>> SymbolTable::getGlobalSymbols() const {
+  std::vector<std::shared_ptr<Symbol>> result;
+  auto [first, last] = scopeRange(0);
+  for (size_t i = first; i < last; ++i) {
+    if (bindings[i].symbol) {
+      result.push_back(bindings[i].symbol);
+    }
+  }
+  return result;
+}
+
 } // namespace semantic
 } // namespace c_hat
@@ -7,15 +7,29 @@
 #include "Symbol.h"
 #include "TypeAliasSymbol.h"
 #include "VariableSymbol.h"
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace c_hat {
 namespace semantic {
 
+// 同名函数的重载集合（从当前作用域向外，同一作用域内按声明顺序）
+// 名称的绑定变化后查找会得到编号不同的新集合，编号可以作为缓存的键
+struct OverloadSet {
+  uint64_t id = 0;
+  std::vector<std::shared_ptr<FunctionSymbol>> functions;
+};
+
 // 符号表类
+// 所有作用域共用一张开放寻址的哈希表，以名称驻留编号为键，每个名称对应
+// 一条绑定链（由内层作用域到外层，同一作用域内按添加顺序），查找只需一次
+// 探查，与嵌套深度无关。绑定按添加顺序存放在一个数组中：作用域退出时
+// 按撤销日志恢复本作用域绑定过的名称的链头，再把数组截断到进入作用域时的
+// 长度，不需要为每个作用域分配哈希表。
 class SymbolTable {
 public:
   // 构造函数
@@ -35,12 +49,20 @@ public:
 
   // 查找符号（从当前作用域开始向上查找）
   std::shared_ptr<Symbol> lookupSymbol(const std::string &name);
+  std::shared_ptr<Symbol> lookupSymbol(lexer::NameId nameId);
 
   // 查找所有同名函数符号（从当前作用域开始向上查找）
   std::vector<std::shared_ptr<FunctionSymbol>> lookupFunctionSymbols(const std::string &name);
+  std::vector<std::shared_ptr<FunctionSymbol>> lookupFunctionSymbols(lexer::NameId nameId);
+
+  // 查找同名函数的重载集合，名称的绑定不变时返回同一个集合
+  // 没有同名函数时返回空集合
+  std::shared_ptr<const OverloadSet> lookupOverloadSet(const std::string &name);
+  std::shared_ptr<const OverloadSet> lookupOverloadSet(lexer::NameId nameId);
 
   // 检查当前作用域是否已存在该符号
   bool hasSymbolInCurrentScope(const std::string &name) const;
+  bool hasSymbolInCurrentScope(lexer::NameId nameId) const;
 
   // 移除符号（用于方法重写时移除继承的方法）
   void removeSymbol(const std::string &name, std::shared_ptr<Symbol> symbol);
@@ -51,12 +73,68 @@ public:
   // 获取所有符号（用于模块导入）
   std::unordered_map<std::string, std::shared_ptr<Symbol>> getAllSymbols() const;
 
+  // 获取全局作用域中的所有符号，包括同名的重载函数
+  std::vector<std::shared_ptr<Symbol>> getGlobalSymbols() const;
+
 private:
+  static constexpr uint32_t NoBinding = UINT32_MAX;
+
+  // 一次绑定：名称在某个作用域中对应的一个符号
+  struct Binding {
+    // 被移除的绑定为空
+    std::shared_ptr<Symbol> symbol;
+    // 链中的下一个绑定（同一作用域中后添加的，或外层作用域中的）
+    uint32_t next;
+    int level;
+  };
+
+  // 哈希表的槽：名称、它的绑定链的链头和重载集合（绑定变化时清除或
+  // 替换为追加了新重载的集合）
+  struct Slot {
+    lexer::NameId nameId = lexer::InvalidNameId;
+    uint32_t head = NoBinding;
+    // 链头所在作用域的最后一个绑定，同一作用域的重载接在它之后；
+    // 退出作用域或移除符号后为 NoBinding，下次添加时沿链重新查找
+    uint32_t tail = NoBinding;
+    std::shared_ptr<OverloadSet> overloads;
+  };
+
+  // 进入作用域时绑定数组和撤销日志的长度
+  struct ScopeMark {
+    uint32_t bindings;
+    uint32_t undo;
+  };
+
   // 当前作用域级别
   int currentScopeLevel;
 
-  // 符号表栈，每个作用域对应一个符号表
-  std::vector<std::unordered_map<std::string, std::vector<std::shared_ptr<Symbol>>>> scopes;
+  // 开放寻址（线性探查）的哈希表，容量是 2 的幂
+  std::vector<Slot> slots;
+  size_t usedSlots = 0;
+
+  // 所有绑定，按添加顺序
+  std::vector<Binding> bindings;
+
+  // 撤销日志：每个作用域中成为链头的名称
+  std::vector<lexer::NameId> undoLog;
+
+  // 每个打开的非全局作用域一项
+  std::vector<ScopeMark> scopeMarks;
+
+  // 下一个重载集合的编号
+  uint64_t nextOverloadSetId = 1;
+
+  // 查找名称的槽，不存在时返回 nullptr
+  const Slot *findSlot(lexer::NameId nameId) const;
+  Slot *findSlot(lexer::NameId nameId);
+
+  // 查找名称的槽，不存在时插入
+  Slot &insertSlot(lexer::NameId nameId);
+
+  void grow();
+
+  // 第 level 层作用域的绑定在数组中的范围 [first, last)
+  std::pair<size_t, size_t> scopeRange(int level) const;
 };
 
 } // namespace semantic
@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+
+namespace c_hat {
+namespace semantic {
+
+ThreadPool::ThreadPool(size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.emplace_back([this] { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  taskAvailable_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::defaultThreadCount() {
+  unsigned count = std::thread::hardware_concurrency();
+  return count > 0 ? count : 1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    ++pending_;
+  }
+  taskAvailable_.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ThreadPool::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    taskAvailable_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      return;
+    }
+
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+
+    if (--pending_ == 0) {
+      idle_.notify_all();
+    }
+  }
+}
+
+} // namespace semantic
+} // namespace c_hat
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace c_hat {
+namespace semantic {
+
+// 固定大小的线程池
+// 任务执行过程中可以继续提交任务；wait 阻塞到所有已提交的任务（包括执行
+// 过程中提交的任务）都完成为止。任务不应抛出异常，需要报告的错误由任务
+// 自己保存。
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threadCount);
+
+  // 等待剩余任务完成后结束全部工作线程
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // 默认线程数（硬件线程数，无法获取时为 1）
+  static size_t defaultThreadCount();
+
+  size_t getThreadCount() const { return workers_.size(); }
+
+  void submit(std::function<void()> task);
+
+  void wait();
+
+private:
+  void workerLoop();
+
+  std::mutex mutex_;
+  std::condition_variable taskAvailable_;
+  std::condition_variable idle_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> workers_;
+
+  // 已提交但尚未完成的任务数（排队中和执行中）
+  size_t pending_ = 0;
+  bool stopping_ = false;
+};
+
+} // namespace semantic
+} // namespace c_hat
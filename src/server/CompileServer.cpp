@@ -0,0 +1,508 @@
+#include "CompileServer.h"
+#include "../ast/ByteStream.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <stdio_ext.h>
+#endif
+#endif
+
+namespace c_hat {
+namespace server {
+
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+
+namespace {
+
+// 请求格式：
+//   连接后先发送 u32 请求长度，同一条消息以 SCM_RIGHTS 附带客户端的
+//   标准输入、标准输出和错误输出
+//   请求："CHS\0" u32 协议版本 参数列表 工作目录
+// 响应：u32 退出码
+constexpr char Magic[4] = {'C', 'H', 'S', '\0'};
+constexpr uint32_t ProtocolVersion = 2;
+constexpr size_t FdCount = 3;
+// 请求只含命令行参数，超过上限的长度视为数据损坏
+constexpr uint32_t MaxRequestSize = 16 * 1024 * 1024;
+
+bool writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+bool readAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t received = ::recv(fd, data, size, 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      return false;
+    }
+    data += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+uint32_t decodeU32(const char *data) {
+  return static_cast<uint32_t>(static_cast<uint8_t>(data[0])) |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 16 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[3])) << 24;
+}
+
+sockaddr_un socketAddress(const fs::path &socketPath) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::string path = socketPath.string();
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path is too long: " + path);
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// 连接服务器，失败时返回 -1
+int connectSocket(const fs::path &socketPath) {
+  sockaddr_un address;
+  try {
+    address = socketAddress(socketPath);
+  } catch (const std::runtime_error &) {
+    return -1;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) <
+      0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// 取得对端进程的用户
+bool peerUser(int connection, uid_t &uid) {
+#ifdef SO_PEERCRED
+  ucred credentials{};
+  socklen_t length = sizeof(credentials);
+  if (::getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials,
+                   &length) < 0) {
+    return false;
+  }
+  uid = credentials.uid;
+  return true;
+#else
+  gid_t gid;
+  return ::getpeereid(connection, &uid, &gid) == 0;
+#endif
+}
+
+// 对端和自己是否是同一用户。请求在服务器进程中以服务器的权限执行，
+// 客户端也不能把输出交给其他用户的服务器
+bool sameUser(int connection) {
+  uid_t uid;
+  return peerUser(connection, uid) && uid == ::getuid();
+}
+
+// 路径是否是当前用户的套接字文件
+bool ownedSocket(const fs::path &socketPath) {
+  struct stat status;
+  return ::lstat(socketPath.c_str(), &status) == 0 &&
+         S_ISSOCK(status.st_mode) && status.st_uid == ::getuid();
+}
+
+// 套接字所在目录不存在时创建为只有当前用户可以访问。已有的目录必须
+// 属于当前用户或 root，且其他用户不能在其中替换文件（带粘滞位的目录
+// 除外，如 /tmp）
+void prepareSocketDirectory(const fs::path &directory) {
+  if (::mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+    throw std::runtime_error("Could not create " + directory.string() + ": " +
+                             std::strerror(errno));
+  }
+  struct stat status;
+  if (::lstat(directory.c_str(), &status) < 0 || !S_ISDIR(status.st_mode)) {
+    throw std::runtime_error(directory.string() + " is not a directory");
+  }
+  bool trustedOwner = status.st_uid == ::getuid() || status.st_uid == 0;
+  bool writableByOthers = (status.st_mode & (S_IWGRP | S_IWOTH)) != 0 &&
+                          (status.st_mode & S_ISVTX) == 0;
+  if (!trustedOwner || writableByOthers) {
+    throw std::runtime_error("Socket directory " + directory.string() +
+                             " can be modified by other users");
+  }
+}
+
+// 读取请求长度和附带的文件描述符
+bool receiveHeader(int connection, uint32_t &size, int fds[FdCount]) {
+  char header[4];
+  iovec iov{header, sizeof(header)};
+  alignas(cmsghdr) char control[CMSG_SPACE(FdCount * sizeof(int))];
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t received;
+  do {
+    received = ::recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+  if (received != sizeof(header)) {
+    return false;
+  }
+
+  cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(FdCount * sizeof(int))) {
+    return false;
+  }
+  std::memcpy(fds, CMSG_DATA(cmsg), FdCount * sizeof(int));
+  size = decodeU32(header);
+  return true;
+}
+
+bool sendHeader(int connection, uint32_t size, const int fds[FdCount]) {
+  ast::ByteWriter header;
+  header.u32(size);
+  iovec iov{header.data().data(), header.size()};
+  alignas(cmsghdr) char control[CMSG_SPACE(FdCount * sizeof(int))] = {};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(FdCount * sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), fds, FdCount * sizeof(int));
+
+  ssize_t sent;
+  do {
+    sent = ::sendmsg(connection, &message, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  return sent == static_cast<ssize_t>(header.size());
+}
+
+bool parseRequest(std::string_view data, CompileRequest &request) {
+  try {
+    ast::ByteReader in(data);
+    for (char c : Magic) {
+      if (in.u8() != static_cast<uint8_t>(c)) {
+        return false;
+      }
+    }
+    if (in.u32() != ProtocolVersion) {
+      return false;
+    }
+    request.args = in.strings();
+    request.workingDirectory = in.str();
+    return in.atEnd();
+  } catch (const ast::MalformedData &) {
+    return false;
+  }
+}
+
+void flushOutput() {
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(stdout);
+  std::fflush(stderr);
+}
+
+// 丢弃标准输入中缓冲的数据，它们属于上一个描述符
+void resetInput() {
+  std::cin.clear();
+  std::clearerr(stdin);
+#ifdef __GLIBC__
+  __fpurge(stdin);
+#endif
+}
+
+void closeAll(const int fds[FdCount]) {
+  for (size_t i = 0; i < FdCount; ++i) {
+    ::close(fds[i]);
+  }
+}
+
+} // namespace
+
+fs::path defaultSocketPath() {
+  // XDG_RUNTIME_DIR 只有当前用户可以访问；没有时用临时目录下当前用户
+  // 自己的目录，由 listen() 创建
+  const char *runtimeDirectory = std::getenv("XDG_RUNTIME_DIR");
+  if (runtimeDirectory && fs::path(runtimeDirectory).is_absolute()) {
+    return fs::path(runtimeDirectory) / "chc.sock";
+  }
+  return fs::temp_directory_path() / ("chc-" + std::to_string(::getuid())) /
+         "chc.sock";
+}
+
+CompileServer::CompileServer(fs::path socketPath, RequestHandler handler)
+    : socketPath_(std::move(socketPath)), handler_(std::move(handler)) {}
+
+CompileServer::~CompileServer() {
+  if (listenFd_ >= 0) {
+    ::close(listenFd_);
+    std::error_code ec;
+    fs::remove(socketPath_, ec);
+  }
+}
+
+void CompileServer::listen() {
+  auto address = socketAddress(socketPath_);
+  auto directory = socketPath_.parent_path();
+  prepareSocketDirectory(directory.empty() ? fs::path(".") : directory);
+
+  std::error_code ec;
+  if (fs::exists(fs::symlink_status(socketPath_, ec))) {
+    // 只替换自己的套接字：能连上说明服务器还在运行，否则是上次异常退出
+    // 留下的文件
+    if (!ownedSocket(socketPath_)) {
+      throw std::runtime_error(socketPath_.string() +
+                               " exists and is not a socket of this user");
+    }
+    int probe = connectSocket(socketPath_);
+    if (probe >= 0) {
+      ::close(probe);
+      throw std::runtime_error("A compile server is already listening on " +
+                               socketPath_.string());
+    }
+    fs::remove(socketPath_, ec);
+  }
+
+  // 套接字文件只有当前用户可以连接。bind 按 umask 创建文件，之后再
+  // chmod 会留下其他用户可以连接的窗口
+  listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  mode_t savedMask = ::umask(0177);
+  bool bound = listenFd_ >= 0 &&
+               ::bind(listenFd_, reinterpret_cast<sockaddr *>(&address),
+                      sizeof(address)) == 0;
+  int bindError = errno;
+  ::umask(savedMask);
+  errno = bindError;
+  if (!bound || ::listen(listenFd_, 16) < 0) {
+    std::string error = std::strerror(errno);
+    if (listenFd_ >= 0) {
+      ::close(listenFd_);
+      listenFd_ = -1;
+    }
+    throw std::runtime_error("Could not listen on " + socketPath_.string() +
+                             ": " + error);
+  }
+
+  // 客户端提前退出时，写它的输出不能结束服务器进程
+  std::signal(SIGPIPE, SIG_IGN);
+}
+
+void CompileServer::run() {
+  while (!stopping_) {
+    int connection = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+    handleConnection(connection);
+    ::close(connection);
+  }
+}
+
+void CompileServer::stop() {
+  stopping_ = true;
+  if (listenFd_ >= 0) {
+    // 唤醒阻塞在 accept 中的 run()
+    ::shutdown(listenFd_, SHUT_RDWR);
+  }
+}
+
+bool CompileServer::isClientConnected() const {
+  int connection = connection_;
+  if (connection < 0) {
+    return false;
+  }
+  // 客户端发出请求后只等待响应，连接可读说明客户端已经关闭
+  pollfd poller{connection, POLLIN, 0};
+  if (::poll(&poller, 1, 0) <= 0) {
+    return true;
+  }
+  char byte;
+  return ::recv(connection, &byte, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+}
+
+void CompileServer::handleConnection(int connection) {
+  if (!sameUser(connection)) {
+    return;
+  }
+
+  // 读写请求和响应都有时限，停滞的客户端被断开
+  timeval timeout{};
+  timeout.tv_sec = static_cast<time_t>(requestTimeout_.count() / 1000);
+  timeout.tv_usec = static_cast<suseconds_t>(requestTimeout_.count() % 1000 *
+                                             1000);
+  ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  uint32_t size = 0;
+  int fds[FdCount] = {-1, -1, -1};
+  if (!receiveHeader(connection, size, fds)) {
+    return;
+  }
+  if (size > MaxRequestSize) {
+    closeAll(fds);
+    return;
+  }
+
+  std::string data(size, '\0');
+  CompileRequest request;
+  if (!readAll(connection, data.data(), data.size()) ||
+      !parseRequest(data, request)) {
+    closeAll(fds);
+    return;
+  }
+
+  // 处理期间换成客户端的输入输出和工作目录
+  flushOutput();
+  int savedInput = ::dup(0);
+  int savedOutput = ::dup(1);
+  int savedError = ::dup(2);
+  for (size_t i = 0; i < FdCount; ++i) {
+    ::dup2(fds[i], static_cast<int>(i));
+  }
+  closeAll(fds);
+  resetInput();
+  std::error_code ec;
+  auto savedDirectory = fs::current_path(ec);
+
+  int exitCode = 1;
+  fs::current_path(request.workingDirectory, ec);
+  if (ec) {
+    std::cerr << "Error: Could not change to directory: "
+              << request.workingDirectory << std::endl;
+  } else {
+    connection_ = connection;
+    try {
+      exitCode = handler_(request);
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+    }
+    connection_ = -1;
+  }
+
+  flushOutput();
+  fs::current_path(savedDirectory, ec);
+  ::dup2(savedInput, 0);
+  ::dup2(savedOutput, 1);
+  ::dup2(savedError, 2);
+  ::close(savedInput);
+  ::close(savedOutput);
+  ::close(savedError);
+  resetInput();
+  ++requestCount_;
+
+  ast::ByteWriter response;
+  response.u32(static_cast<uint32_t>(exitCode));
+  writeAll(connection, response.data().data(), response.size());
+}
+
+std::optional<int> forwardRequest(const fs::path &socketPath,
+                                  const CompileRequest &request, int outputFd,
+                                  int errorFd, int inputFd) {
+  // 不连接其他用户的套接字，它可能是伪装的服务器
+  if (!ownedSocket(socketPath)) {
+    return std::nullopt;
+  }
+  int connection = connectSocket(socketPath);
+  if (connection < 0) {
+    return std::nullopt;
+  }
+  if (!sameUser(connection)) {
+    ::close(connection);
+    return std::nullopt;
+  }
+
+  ast::ByteWriter payload;
+  payload.bytes(std::string_view(Magic, sizeof(Magic)));
+  payload.u32(ProtocolVersion);
+  payload.strings(request.args);
+  payload.str(request.workingDirectory);
+
+  // 连接之后服务器可能已经开始处理请求，中断时不能当作没有服务器
+  int fds[FdCount] = {inputFd, outputFd, errorFd};
+  char response[4];
+  bool completed =
+      sendHeader(connection, static_cast<uint32_t>(payload.size()), fds) &&
+      writeAll(connection, payload.data().data(), payload.size()) &&
+      readAll(connection, response, sizeof(response));
+  ::close(connection);
+  if (!completed) {
+    throw std::runtime_error("Lost connection to the compile server on " +
+                             socketPath.string());
+  }
+  return static_cast<int>(decodeU32(response));
+}
+
+#else
+
+fs::path defaultSocketPath() {
+  return fs::temp_directory_path() / "chc.sock";
+}
+
+CompileServer::CompileServer(fs::path socketPath, RequestHandler handler)
+    : socketPath_(std::move(socketPath)), handler_(std::move(handler)) {}
+
+CompileServer::~CompileServer() = default;
+
+void CompileServer::listen() {
+  throw std::runtime_error(
+      "The compile server requires Unix domain sockets with descriptor "
+      "passing, which this platform does not support");
+}
+
+void CompileServer::run() {}
+
+void CompileServer::stop() { stopping_ = true; }
+
+bool CompileServer::isClientConnected() const { return false; }
+
+void CompileServer::handleConnection(int) {}
+
+std::optional<int> forwardRequest(const fs::path &, const CompileRequest &,
+                                  int, int, int) {
+  return std::nullopt;
+}
+
+#endif
+
+} // namespace server
+} // namespace c_hat
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace c_hat {
+namespace server {
+
+// 编译请求：客户端的命令行参数和工作目录
+struct CompileRequest {
+  std::vector<std::string> args;
+  std::string workingDirectory;
+};
+
+// 处理请求，返回客户端进程的退出码
+using RequestHandler = std::function<int(const CompileRequest &)>;
+
+// 默认的套接字路径：$XDG_RUNTIME_DIR/chc.sock，没有设置时为系统临时
+// 目录下的 chc-<用户>/chc.sock
+std::filesystem::path defaultSocketPath();
+
+// 编译服务器
+// 在本地 Unix 套接字上逐个处理请求。客户端把自己的标准输入、输出和错误
+// 输出随请求传给服务器，处理请求期间服务器进程的标准输入输出和工作目录
+// 换成客户端的，处理函数直接读写即可，结束后恢复。因此请求不能并发
+// 处理；服务器在请求之间保留的状态（分析过的模块、目标机器、JIT）由处理
+// 函数自己管理。套接字只允许当前用户连接，其他用户的连接直接关闭。
+// 不支持 Unix 套接字的平台上 listen() 抛出异常。
+class CompileServer {
+public:
+  CompileServer(std::filesystem::path socketPath, RequestHandler handler);
+  ~CompileServer();
+
+  CompileServer(const CompileServer &) = delete;
+  CompileServer &operator=(const CompileServer &) = delete;
+
+  const std::filesystem::path &getSocketPath() const { return socketPath_; }
+
+  // 开始监听；套接字文件已被运行中的服务器占用、不是当前用户的套接字、
+  // 所在目录可被其他用户修改或无法创建时抛出 std::runtime_error，
+  // 残留的套接字文件被替换
+  void listen();
+
+  // 逐个处理请求，直到 stop() 被调用
+  void run();
+
+  // 停止 run()，可以在其他线程中调用
+  void stop();
+
+  // 已处理的请求数
+  size_t getRequestCount() const { return requestCount_; }
+
+  // 接收请求的时限，连接后迟迟不发送请求的客户端被断开，
+  // 不会让其他客户端一直等待
+  void setRequestTimeout(std::chrono::milliseconds timeout) {
+    requestTimeout_ = timeout;
+  }
+
+  // 当前请求的客户端是否仍然连接，没有在处理请求时返回 false
+  // 处理函数据此结束已经没有人等待的工作
+  bool isClientConnected() const;
+
+private:
+  void handleConnection(int connection);
+
+  std::filesystem::path socketPath_;
+  RequestHandler handler_;
+  std::chrono::milliseconds requestTimeout_ = std::chrono::seconds(10);
+  int listenFd_ = -1;
+  std::atomic<int> connection_ = -1;
+  std::atomic<bool> stopping_ = false;
+  std::atomic<size_t> requestCount_ = 0;
+};
+
+// 把请求转发给服务器，服务器直接读取 inputFd，写入 outputFd 和 errorFd
+// 返回请求的退出码；没有当前用户的服务器在监听时返回 std::nullopt，
+// 请求发出后连接中断时抛出 std::runtime_error
+std::optional<int> forwardRequest(const std::filesystem::path &socketPath,
+                                  const CompileRequest &request,
+                                  int outputFd = 1, int errorFd = 2,
+                                  int inputFd = 0);
+
+} // namespace server
+} // namespace c_hat
@@ -0,0 +1,224 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <set>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace c_hat {
+namespace server {
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+namespace {
+
+// 最后一次修改后等待的时间，编辑器保存一个文件通常会产生好几个事件
+constexpr milliseconds SettleDelay(50);
+// 不支持 inotify 时轮询的间隔
+constexpr milliseconds PollInterval(200);
+
+fs::path absolutePath(const fs::path &file) {
+  std::error_code ec;
+  auto path = fs::weakly_canonical(file, ec);
+  return ec ? fs::absolute(file) : path;
+}
+
+} // namespace
+
+FileWatcher::FileState FileWatcher::fileState(const fs::path &file) {
+  std::error_code ec;
+  auto time = fs::last_write_time(file, ec);
+  if (ec) {
+    return {fs::file_time_type::min(), 0};
+  }
+  auto size = fs::file_size(file, ec);
+  return {time, ec ? 0 : size};
+}
+
+std::map<fs::path, FileWatcher::FileState>
+FileWatcher::watchedStates(const std::vector<fs::path> &files) const {
+  std::map<fs::path, FileState> states;
+  for (const auto &file : files) {
+    auto path = absolutePath(file);
+    auto it = files_.find(path);
+    states[path] = it != files_.end() ? it->second : fileState(path);
+  }
+  return states;
+}
+
+std::vector<fs::path> FileWatcher::pollChanges() {
+  std::vector<fs::path> changed;
+  for (auto &[file, state] : files_) {
+    auto current = fileState(file);
+    if (current != state) {
+      state = current;
+      changed.push_back(file);
+    }
+  }
+  return changed;
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+    : inotifyFd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+FileWatcher::~FileWatcher() {
+  if (inotifyFd_ >= 0) {
+    ::close(inotifyFd_);
+  }
+}
+
+void FileWatcher::setFiles(const std::vector<fs::path> &files) {
+  files_ = watchedStates(files);
+  std::set<fs::path> directories;
+  for (const auto &[file, state] : files_) {
+    directories.insert(file.parent_path());
+  }
+  if (inotifyFd_ < 0) {
+    return;
+  }
+
+  for (auto it = directories_.begin(); it != directories_.end();) {
+    if (directories.count(it->first)) {
+      ++it;
+    } else {
+      ::inotify_rm_watch(inotifyFd_, it->second);
+      it = directories_.erase(it);
+    }
+  }
+  for (const auto &directory : directories) {
+    if (directories_.count(directory)) {
+      continue;
+    }
+    int wd = ::inotify_add_watch(inotifyFd_, directory.c_str(),
+                                 IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO |
+                                     IN_CREATE | IN_DELETE | IN_ATTRIB);
+    // 监视失败的目录（已删除、超出监视数上限）中的修改只在被其他事件唤醒
+    // 或超时后才能发现
+    if (wd >= 0) {
+      directories_[directory] = wd;
+    }
+  }
+}
+
+void FileWatcher::waitForEvents(std::optional<milliseconds> timeout,
+                                std::set<fs::path> &touched) {
+  auto readEvents = [&](int waitMs) {
+    pollfd descriptor{inotifyFd_, POLLIN, 0};
+    if (::poll(&descriptor, 1, waitMs) <= 0) {
+      return false;
+    }
+    alignas(inotify_event) char buffer[4096];
+    ssize_t size;
+    while ((size = ::read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+      for (ssize_t offset = 0; offset < size;) {
+        auto *event = reinterpret_cast<inotify_event *>(buffer + offset);
+        offset += sizeof(inotify_event) + event->len;
+        if (event->len == 0) {
+          continue;
+        }
+        auto directory = std::find_if(
+            directories_.begin(), directories_.end(),
+            [&](const auto &entry) { return entry.second == event->wd; });
+        if (directory == directories_.end()) {
+          continue;
+        }
+        // 同一目录中其他文件的事件忽略
+        auto file = directory->first / event->name;
+        if (files_.count(file)) {
+          touched.insert(file);
+        }
+      }
+    }
+    return true;
+  };
+
+  int waitMs = timeout ? static_cast<int>(timeout->count()) : -1;
+  if (!readEvents(waitMs)) {
+    return;
+  }
+  while (readEvents(static_cast<int>(SettleDelay.count()))) {
+  }
+}
+
+std::vector<fs::path>
+FileWatcher::wait(std::optional<milliseconds> timeout) {
+  auto deadline = timeout ? std::optional(steady_clock::now() + *timeout)
+                          : std::nullopt;
+  // 一个目录都没有监视成功时退回到轮询
+  bool useEvents = inotifyFd_ >= 0 && !directories_.empty();
+  while (true) {
+    std::optional<milliseconds> left;
+    if (deadline) {
+      left = std::max(
+          duration_cast<milliseconds>(*deadline - steady_clock::now()),
+          milliseconds(0));
+    }
+    // 两次写入落在同一个时间戳精度内时文件状态可能不变，有事件的文件
+    // 直接视为变化
+    std::set<fs::path> touched;
+    if (useEvents) {
+      waitForEvents(left, touched);
+    } else {
+      std::this_thread::sleep_for(left ? std::min(*left, PollInterval)
+                                       : PollInterval);
+    }
+
+    auto changed = pollChanges();
+    for (const auto &file : touched) {
+      if (std::find(changed.begin(), changed.end(), file) == changed.end()) {
+        files_[file] = fileState(file);
+        changed.push_back(file);
+      }
+    }
+    if (!changed.empty()) {
+      return changed;
+    }
+    if (deadline && steady_clock::now() >= *deadline) {
+      return {};
+    }
+  }
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() = default;
+
+void FileWatcher::setFiles(const std::vector<fs::path> &files) {
+  files_ = watchedStates(files);
+}
+
+std::vector<fs::path>
+FileWatcher::wait(std::optional<milliseconds> timeout) {
+  auto deadline = timeout ? std::optional(steady_clock::now() + *timeout)
+                          : std::nullopt;
+  while (true) {
+    auto interval = PollInterval;
+    if (deadline) {
+      auto left = duration_cast<milliseconds>(*deadline - steady_clock::now());
+      interval = std::clamp(left, milliseconds(0), PollInterval);
+    }
+    std::this_thread::sleep_for(interval);
+
+    auto changed = pollChanges();
+    if (!changed.empty()) {
+      return changed;
+    }
+    if (deadline && steady_clock::now() >= *deadline) {
+      return {};
+    }
+  }
+}
+
+#endif
+
+} // namespace server
+} // namespace c_hat
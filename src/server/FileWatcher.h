@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace c_hat {
+namespace server {
+
+// 文件监视器
+// Linux 上以 inotify 监视文件所在的目录（编辑器常以写临时文件再改名的
+// 方式保存，监视文件本身会丢失之后的修改），其他平台按修改时间轮询。
+// 短时间内的多次修改合并为一次返回。
+class FileWatcher {
+public:
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  // 替换监视的文件；已在监视的文件保留记录的状态，上次 wait() 之后的
+  // 修改在下次 wait() 时报告
+  void setFiles(const std::vector<std::filesystem::path> &files);
+
+  // 等待文件变化，返回变化了的文件；timeout 为空时一直等待，超时返回空列表
+  std::vector<std::filesystem::path>
+  wait(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+private:
+  // 文件的修改时间和大小，文件不存在时为最小时间
+  using FileState = std::pair<std::filesystem::file_time_type, uintmax_t>;
+
+  static FileState fileState(const std::filesystem::path &file);
+
+  // 新的监视列表的状态，已在监视的文件沿用记录的状态
+  std::map<std::filesystem::path, FileState>
+  watchedStates(const std::vector<std::filesystem::path> &files) const;
+
+  // 找出状态变化了的文件，并更新记录的状态
+  std::vector<std::filesystem::path> pollChanges();
+
+  std::map<std::filesystem::path, FileState> files_;
+
+#ifdef __linux__
+  // 等待 inotify 事件，事件停止一小段时间后返回，有事件的被监视文件加入
+  // touched
+  void waitForEvents(std::optional<std::chrono::milliseconds> timeout,
+                     std::set<std::filesystem::path> &touched);
+
+  int inotifyFd_ = -1;
+  // 监视中的目录及其 inotify 监视描述符
+  std::map<std::filesystem::path, int> directories_;
+#endif
+};
+
+} // namespace server
+} // namespace c_hat
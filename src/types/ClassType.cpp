@@ -24,22 +24,27 @@ std::string ClassType::toString() const {
 
 void ClassType::addBaseClass(std::shared_ptr<ClassType> baseClass) {
   baseClasses.push_back(baseClass);
+  ++revision;
 }
 
 void ClassType::addInterface(std::shared_ptr<InterfaceType> interface) {
   interfaces.push_back(interface);
+  ++revision;
 }
 
 void ClassType::addMethod(const ClassMethod &method) {
   methods[method.name] = method;
+  ++revision;
 }
 
 void ClassType::addField(const ClassField &field) {
   fields[field.name] = field;
+  ++revision;
 }
 
 void ClassType::addProperty(const ClassProperty &property) {
   properties[property.name] = property;
+  ++revision;
 }
 
 std::shared_ptr<ClassType> ClassType::instantiate(
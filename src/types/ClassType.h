@@ -2,6 +2,7 @@
 
 #include "InterfaceType.h"
 #include "Type.h"
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -95,6 +96,7 @@ public:
   }
   void setTypeParameters(const std::vector<std::string> &params) {
     typeParameters = params;
+    ++revision;
   }
   bool isGeneric() const { return !typeParameters.empty(); }
 
@@ -110,6 +112,10 @@ public:
   std::shared_ptr<ClassType>
   instantiate(const std::vector<std::shared_ptr<Type>> &typeArguments) const;
 
+  // 修订号：泛型参数、基类、接口或成员每次变化时加一
+  // 实例化复制这些信息，修订号不变时已有的实例仍然有效
+  uint64_t getRevision() const { return revision; }
+
   // 添加基类
   void addBaseClass(std::shared_ptr<ClassType> baseClass);
 
@@ -201,6 +207,7 @@ private:
   std::unordered_map<std::string, ClassField> fields;        // 字段列表
   std::unordered_map<std::string, ClassProperty> properties; // 属性列表
   bool isAbstract_ = false;                                  // 是否为抽象类
+  uint64_t revision = 0;                                     // 修订号
 };
 
 } // namespace types
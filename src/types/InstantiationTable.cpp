@@ -0,0 +1,162 @@
+#include "InstantiationTable.h"
+#include "TypeFactory.h"
+#include <functional>
+
+namespace c_hat {
+namespace types {
+
+namespace {
+
+// 结构标识键中的种类标记
+enum class IdentityTag : char {
+  Address,
+  Array,
+  Slice,
+  RectangularArray,
+  RectangularSlice,
+  Pointer,
+  Function,
+  Generic,
+  Tuple,
+  Readonly,
+  Reference,
+  Nullable,
+};
+
+// 把值的字节追加到键
+template <typename T> void appendKey(std::string &key, const T &value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendIdentity(std::string &key, const Type *type);
+
+void appendIdentity(std::string &key, IdentityTag tag,
+                    const std::vector<std::shared_ptr<Type>> &components) {
+  key += static_cast<char>(tag);
+  appendKey(key, components.size());
+  for (const auto &component : components) {
+    appendIdentity(key, component.get());
+  }
+}
+
+// 追加类型的结构标识：规范类型、类、接口和模板参数等叶子用地址，
+// 复合类型用种类、属性和组成部分的标识。每种标识的长度由自身确定，
+// 拼接后不会有歧义
+void appendIdentity(std::string &key, const Type *type) {
+  auto appendTagged = [&](IdentityTag tag, const Type *component) {
+    key += static_cast<char>(tag);
+    appendIdentity(key, component);
+  };
+  if (!type || type->isCanonical() || type->isClass() ||
+      type->isInterface()) {
+    key += static_cast<char>(IdentityTag::Address);
+    appendKey(key, type);
+  } else if (auto *array = dynamic_cast<const ArrayType *>(type)) {
+    appendTagged(IdentityTag::Array, array->getElementType().get());
+    appendKey(key, array->getSize());
+  } else if (auto *slice = dynamic_cast<const SliceType *>(type)) {
+    appendTagged(IdentityTag::Slice, slice->getElementType().get());
+  } else if (auto *rectangular =
+                 dynamic_cast<const RectangularArrayType *>(type)) {
+    appendTagged(IdentityTag::RectangularArray,
+                 rectangular->getElementType().get());
+    appendKey(key, rectangular->getSizes().size());
+    for (size_t size : rectangular->getSizes()) {
+      appendKey(key, size);
+    }
+  } else if (auto *rectangularSlice =
+                 dynamic_cast<const RectangularSliceType *>(type)) {
+    appendTagged(IdentityTag::RectangularSlice,
+                 rectangularSlice->getElementType().get());
+    appendKey(key, rectangularSlice->getRank());
+  } else if (auto *pointer = dynamic_cast<const PointerType *>(type)) {
+    appendTagged(IdentityTag::Pointer, pointer->getPointeeType().get());
+    appendKey(key, pointer->isNullable());
+  } else if (auto *function = dynamic_cast<const FunctionType *>(type)) {
+    appendIdentity(key, IdentityTag::Function, function->getParameterTypes());
+    appendIdentity(key, function->getReturnType().get());
+  } else if (auto *generic = dynamic_cast<const GenericType *>(type);
+             generic && !generic->getTypeArguments().empty()) {
+    appendIdentity(key, IdentityTag::Generic, generic->getTypeArguments());
+    appendKey(key, generic->getName().size());
+    key += generic->getName();
+  } else if (auto *tuple = dynamic_cast<const TupleType *>(type)) {
+    appendIdentity(key, IdentityTag::Tuple, tuple->getElementTypes());
+  } else if (auto *readonly = dynamic_cast<const ReadonlyType *>(type)) {
+    appendTagged(IdentityTag::Readonly, readonly->getBaseType().get());
+  } else if (auto *reference = dynamic_cast<const ReferenceType *>(type)) {
+    appendTagged(IdentityTag::Reference, reference->getBaseType().get());
+  } else if (auto *nullable = dynamic_cast<const NullableType *>(type)) {
+    appendTagged(IdentityTag::Nullable, nullable->getBaseType().get());
+  } else {
+    // 模板参数属于各自的声明，按地址区分
+    key += static_cast<char>(IdentityTag::Address);
+    appendKey(key, type);
+  }
+}
+
+} // namespace
+
+size_t InstantiationTable::KeyHash::operator()(const Key &key) const {
+  size_t hash = std::hash<const ClassType *>()(key.templateType);
+  for (const auto *type : key.arguments) {
+    hash ^= std::hash<const Type *>()(type) + 0x9e3779b97f4a7c15ULL +
+            (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+const Type *
+InstantiationTable::internArgument(const std::shared_ptr<Type> &type) {
+  if (type->isCanonical() || type->isClass() || type->isInterface()) {
+    return type.get();
+  }
+  std::string key;
+  appendIdentity(key, type.get());
+  auto [it, inserted] = representatives.try_emplace(std::move(key), type);
+  return it->second.get();
+}
+
+std::shared_ptr<ClassType> InstantiationTable::instantiate(
+    const std::shared_ptr<ClassType> &templateType,
+    const std::vector<std::shared_ptr<Type>> &typeArguments) {
+  if (!templateType ||
+      typeArguments.size() != templateType->getTypeParameters().size()) {
+    return nullptr;
+  }
+  Key key{templateType.get(), {}};
+  key.arguments.reserve(typeArguments.size());
+  for (const auto &type : typeArguments) {
+    if (!type) {
+      return nullptr;
+    }
+    key.arguments.push_back(internArgument(type));
+  }
+
+  auto it = entries.find(key);
+  if (it != entries.end() &&
+      it->second.revision == templateType->getRevision()) {
+    ++stats.reused;
+    return it->second.instance;
+  }
+
+  auto instance = templateType->instantiate(typeArguments);
+  ++stats.created;
+  if (it != entries.end()) {
+    ++stats.refreshed;
+    it->second.instance = instance;
+    it->second.revision = templateType->getRevision();
+  } else {
+    entries.emplace(std::move(key), Entry{templateType, typeArguments, instance,
+                                          templateType->getRevision()});
+  }
+  return instance;
+}
+
+void InstantiationTable::clear() {
+  entries.clear();
+  representatives.clear();
+}
+
+} // namespace types
+} // namespace c_hat
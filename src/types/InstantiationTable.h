@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ClassType.h"
+#include "Type.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c_hat {
+namespace types {
+
+// 泛型类的实例化表
+// 按 (模板, 类型实参) 记住实例化得到的类，同一程序中多次写出 List<int>
+// 得到同一个 ClassType，只复制一次方法和字段表。实参按地址比较：驻留的
+// 规范类型、类和接口直接用地址，其他类型（例如指向类的指针，每次分析都
+// 新建）按结构归并到第一次见到的相同类型：结构由种类和组成部分决定，
+// 组成部分中的类、接口和模板参数按地址区分，不同模块中同名的类不会
+// 混同。表持有模板和键中的类型，地址不会被复用。模板的修订号变化后
+// （添加了成员或基类）重新实例化。
+// 每个语义分析器有自己的表，实例只在同一次分析（同一个编译单元及其
+// 分析的模块）中共享；不同编译单元各自实例化，表随分析器释放。
+class InstantiationTable {
+public:
+  struct Stats {
+    // 创建的实例数（包括模板变化后重新创建的）
+    size_t created = 0;
+    // 复用已有实例的次数
+    size_t reused = 0;
+    // 因模板变化而重新创建的次数
+    size_t refreshed = 0;
+
+    // 复用率，没有实例化时为 0
+    double reuseRate() const {
+      size_t total = created + reused;
+      return total ? static_cast<double>(reused) / total : 0.0;
+    }
+  };
+
+  // 用 typeArguments 实例化 templateType，实参数量不匹配时返回 nullptr
+  std::shared_ptr<ClassType>
+  instantiate(const std::shared_ptr<ClassType> &templateType,
+              const std::vector<std::shared_ptr<Type>> &typeArguments);
+
+  // 清除全部实例（不清除统计）
+  void clear();
+
+  // 不同实例的个数
+  size_t size() const { return entries.size(); }
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  struct Key {
+    const ClassType *templateType;
+    std::vector<const Type *> arguments;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  struct Entry {
+    std::shared_ptr<ClassType> templateType;
+    std::vector<std::shared_ptr<Type>> arguments;
+    std::shared_ptr<ClassType> instance;
+    // 实例化时模板的修订号
+    uint64_t revision;
+  };
+
+  std::unordered_map<Key, Entry, KeyHash> entries;
+  // 地址不稳定的实参：结构标识键 -> 第一次见到的类型
+  std::unordered_map<std::string, std::shared_ptr<Type>> representatives;
+  Stats stats;
+
+  // 实参在键中的代表
+  const Type *internArgument(const std::shared_ptr<Type> &type);
+};
+
+} // namespace types
+} // namespace c_hat
@@ -0,0 +1,59 @@
+#include "RelationCache.h"
+#include <functional>
+
+namespace c_hat {
+namespace types {
+
+size_t RelationCache::KeyHash::operator()(const Key &key) const {
+  size_t hash = std::hash<const Type *>()(key.from);
+  hash ^= std::hash<const Type *>()(key.to) + 0x9e3779b97f4a7c15ULL +
+          (hash << 6) + (hash >> 2);
+  return hash ^ static_cast<size_t>(key.relation);
+}
+
+std::optional<bool> RelationCache::find(Relation relation, const Type *from,
+                                        const Type *to) {
+  auto it = entries.find(Key{from, to, relation});
+  if (it == entries.end()) {
+    ++stats.misses;
+    return std::nullopt;
+  }
+  ++stats.hits;
+  return it->second.result;
+}
+
+void RelationCache::insert(Relation relation, std::shared_ptr<Type> from,
+                           std::shared_ptr<Type> to, bool result) {
+  Key key{from.get(), to.get(), relation};
+  entries.insert_or_assign(key, Entry{std::move(from), std::move(to), result});
+}
+
+template <typename Compute>
+bool RelationCache::lookup(Relation relation,
+                           const std::shared_ptr<Type> &from,
+                           const std::shared_ptr<Type> &to, Compute compute) {
+  if (!from || !to) {
+    return false;
+  }
+  if (auto cached = find(relation, from.get(), to.get())) {
+    return *cached;
+  }
+  bool result = compute();
+  insert(relation, from, to, result);
+  return result;
+}
+
+bool RelationCache::isCompatible(const std::shared_ptr<Type> &from,
+                                 const std::shared_ptr<Type> &to) {
+  return lookup(Relation::Compatible, from, to,
+                [&] { return from->isCompatibleWith(*to); });
+}
+
+bool RelationCache::isSubtype(const std::shared_ptr<Type> &from,
+                              const std::shared_ptr<Type> &to) {
+  return lookup(Relation::Subtype, from, to,
+                [&] { return from->isSubtypeOf(*to); });
+}
+
+} // namespace types
+} // namespace c_hat
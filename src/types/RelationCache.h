@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Type.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+namespace c_hat {
+namespace types {
+
+// 类型关系缓存
+// 按 (关系, 类型, 类型) 记住兼容和子类型等关系的判断结果，供一次编译使用。
+// 缓存持有键中的类型，类型的地址在缓存清除前不会被复用。类的关系取决于
+// 继承结构，类添加基类或接口后要调用 clear()。
+class RelationCache {
+public:
+  enum class Relation : uint8_t {
+    // from->isCompatibleWith(*to)
+    Compatible,
+    // from->isSubtypeOf(*to)
+    Subtype,
+    // 由使用者定义的赋值兼容（例如语义分析器的 isTypeCompatible）
+    Assignable,
+  };
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+
+    // 命中率，没有查询时为 0
+    double hitRate() const {
+      size_t total = hits + misses;
+      return total ? static_cast<double>(hits) / total : 0.0;
+    }
+  };
+
+  // 带缓存的 from->isCompatibleWith(*to)，任一类型为空时返回 false
+  bool isCompatible(const std::shared_ptr<Type> &from,
+                    const std::shared_ptr<Type> &to);
+
+  // 带缓存的 from->isSubtypeOf(*to)，任一类型为空时返回 false
+  bool isSubtype(const std::shared_ptr<Type> &from,
+                 const std::shared_ptr<Type> &to);
+
+  // 查找记住的结果，没有时返回空（并计为一次未命中）
+  std::optional<bool> find(Relation relation, const Type *from,
+                           const Type *to);
+
+  // 记住一个结果
+  void insert(Relation relation, std::shared_ptr<Type> from,
+              std::shared_ptr<Type> to, bool result);
+
+  // 清除记住的结果（不清除统计）
+  void clear() { entries.clear(); }
+
+  size_t size() const { return entries.size(); }
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  struct Key {
+    const Type *from;
+    const Type *to;
+    Relation relation;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  struct Entry {
+    std::shared_ptr<Type> from;
+    std::shared_ptr<Type> to;
+    bool result;
+  };
+
+  std::unordered_map<Key, Entry, KeyHash> entries;
+  Stats stats;
+
+  template <typename Compute>
+  bool lookup(Relation relation, const std::shared_ptr<Type> &from,
+              const std::shared_ptr<Type> &to, Compute compute);
+};
+
+} // namespace types
+} // namespace c_hat
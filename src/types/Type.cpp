@@ -7,7 +7,8 @@ namespace types {
 std::shared_ptr<const Type> unwrapReadonly(const Type *type) {
   if (!type)
     return nullptr;
-  std::shared_ptr<const Type> current(type, [](const Type *) {});
+  // 不持有 type，用空的所有者构造，避免分配控制块
+  std::shared_ptr<const Type> current(std::shared_ptr<const Type>(), type);
   while (current && current->isReadonly()) {
     current = current->getBaseType();
   }
@@ -24,6 +25,17 @@ std::shared_ptr<Type> unwrapReadonly(std::shared_ptr<Type> type) {
   return current;
 }
 
+bool isSameType(const Type &a, const Type &b) {
+  if (&a == &b) {
+    return true;
+  }
+  // 结构相同的规范类型是同一个对象
+  if (a.isCanonical() && b.isCanonical()) {
+    return false;
+  }
+  return a.toString() == b.toString();
+}
+
 bool Type::isCompatibleWith(const Type &other) const {
   if (this == &other)
     return true;
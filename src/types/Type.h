@@ -68,17 +68,29 @@ public:
   // 如果是只读类型，获取基础类型（非只读的）
   virtual std::shared_ptr<Type> getBaseType() const { return nullptr; }
 
+  // 是否为 TypeFactory 驻留的规范类型：结构相同的规范类型是同一个对象
+  bool isCanonical() const { return canonical; }
+
 protected:
   // 具体类型的兼容性检查实现（不包含 Readonly 包装处理）
   virtual bool isCompatibleWithImpl(const Type &other) const = 0;
 
   // 具体类型的子类型关系检查实现（不包含 Readonly 包装处理）
   virtual bool isSubtypeOfImpl(const Type &other) const = 0;
+
+private:
+  friend class TypeFactory;
+
+  bool canonical = false;
 };
 
 // 辅助函数：剥除所有 Readonly 包装，返回基础类型
 std::shared_ptr<const Type> unwrapReadonly(const Type *type);
 std::shared_ptr<Type> unwrapReadonly(std::shared_ptr<Type> type);
 
+// 辅助函数：判断两个类型是否相同
+// 两者都是规范类型时只比较地址，否则比较字符串表示
+bool isSameType(const Type &a, const Type &b);
+
 } // namespace types
 } // namespace c_hat
@@ -1,10 +1,139 @@
 #include "TypeFactory.h"
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace c_hat {
 namespace types {
 
+// 驻留类型表
+// 键由类型种类、组成部分的地址和其他属性的字节拼接而成：组成部分都是
+// 规范类型，地址相同即结构相同。单个组成部分的键不超过短字符串的长度，
+// 查找时不分配内存。复合类型持有它的组成部分，复合类型还在使用时组成
+// 部分的地址不会被复用；键中地址已被复用的项一定已经失效。
+class TypeFactory::InternTable {
+public:
+  // 表在进程结束前不释放，避免与其他静态对象的析构顺序问题
+  static InternTable &instance() {
+    static InternTable *table = new InternTable();
+    return *table;
+  }
+
+  // 查找键对应的类型，不存在或已经释放时用 create 创建
+  template <typename Create>
+  std::shared_ptr<Type> intern(const std::string &key, Create create) {
+    {
+      std::shared_lock lock(mutex);
+      auto it = types.find(key);
+      if (it != types.end()) {
+        if (auto type = it->second.lock()) {
+          return type;
+        }
+      }
+    }
+    std::unique_lock lock(mutex);
+    auto &slot = types[key];
+    if (auto type = slot.lock()) {
+      return type;
+    }
+    // 类型和控制块分开分配，类型释放后只有控制块留到表项清理
+    std::shared_ptr<Type> type(create());
+    markCanonical(*type);
+    slot = type;
+    if (types.size() >= pruneThreshold) {
+      prune();
+    }
+    return type;
+  }
+
+private:
+  static constexpr size_t MinPruneThreshold = 1024;
+
+  std::shared_mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<Type>> types;
+  size_t pruneThreshold = MinPruneThreshold;
+
+  // 移除已经释放的类型，下次在表再增长一倍时清理，均摊到每次插入是常数
+  void prune() {
+    std::erase_if(types,
+                  [](const auto &entry) { return entry.second.expired(); });
+    pruneThreshold = std::max(MinPruneThreshold, types.size() * 2);
+  }
+};
+
+namespace {
+
+// 驻留键的种类标记
+enum class InternTag : char {
+  Primitive,
+  Array,
+  Slice,
+  RectangularArray,
+  RectangularSlice,
+  Pointer,
+  Function,
+  Generic,
+  Tuple,
+  LiteralView,
+  Readonly,
+  Reference,
+  Nullable,
+};
+
+// 把值的字节追加到键
+template <typename T> void appendKey(std::string &key, const T &value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+std::string makeKey(InternTag tag, const Type *component) {
+  std::string key(1, static_cast<char>(tag));
+  appendKey(key, component);
+  return key;
+}
+
+std::string makeKey(InternTag tag,
+                    const std::vector<std::shared_ptr<Type>> &components) {
+  std::string key(1, static_cast<char>(tag));
+  appendKey(key, components.size());
+  for (const auto &component : components) {
+    appendKey(key, component.get());
+  }
+  return key;
+}
+
+bool isCanonical(const std::shared_ptr<Type> &type) {
+  return type && type->isCanonical();
+}
+
+bool isCanonical(const std::vector<std::shared_ptr<Type>> &types) {
+  for (const auto &type : types) {
+    if (!isCanonical(type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 std::shared_ptr<Type> TypeFactory::getPrimitiveType(PrimitiveType::Kind kind) {
-  return std::make_shared<PrimitiveType>(kind);
+  // 基本类型的种类固定，按种类直接索引
+  static const auto primitives = [] {
+    std::array<std::shared_ptr<Type>,
+               static_cast<size_t>(PrimitiveType::Kind::Char) + 1>
+        result;
+    for (size_t i = 0; i < result.size(); ++i) {
+      auto kind = static_cast<PrimitiveType::Kind>(i);
+      std::string key(1, static_cast<char>(InternTag::Primitive));
+      appendKey(key, kind);
+      result[i] = InternTable::instance().intern(
+          key, [kind] { return std::make_unique<PrimitiveType>(kind); });
+    }
+    return result;
+  }();
+  return primitives[static_cast<size_t>(kind)];
 }
 
 std::shared_ptr<Type> TypeFactory::getPrimitiveTypeByName(const std::string &name) {
@@ -44,38 +173,84 @@ std::shared_ptr<Type> TypeFactory::getPrimitiveTypeByName(const std::string &nam
 
 std::shared_ptr<Type>
 TypeFactory::getArrayType(std::shared_ptr<Type> elementType, size_t size) {
-  return std::make_shared<ArrayType>(elementType, size);
+  if (!isCanonical(elementType)) {
+    return std::make_shared<ArrayType>(elementType, size);
+  }
+  auto key = makeKey(InternTag::Array, elementType.get());
+  appendKey(key, size);
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<ArrayType>(elementType, size);
+  });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getSliceType(std::shared_ptr<Type> elementType) {
-  return std::make_shared<SliceType>(elementType);
+  if (!isCanonical(elementType)) {
+    return std::make_shared<SliceType>(elementType);
+  }
+  return InternTable::instance().intern(
+      makeKey(InternTag::Slice, elementType.get()),
+      [&] { return std::make_unique<SliceType>(elementType); });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getRectangularArrayType(std::shared_ptr<Type> elementType,
                                      std::vector<size_t> sizes) {
-  return std::make_shared<RectangularArrayType>(elementType, std::move(sizes));
+  if (!isCanonical(elementType)) {
+    return std::make_shared<RectangularArrayType>(elementType,
+                                                  std::move(sizes));
+  }
+  auto key = makeKey(InternTag::RectangularArray, elementType.get());
+  appendKey(key, sizes.size());
+  for (size_t size : sizes) {
+    appendKey(key, size);
+  }
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<RectangularArrayType>(elementType,
+                                                  std::move(sizes));
+  });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getRectangularSliceType(std::shared_ptr<Type> elementType,
                                      int rank) {
-  return std::make_shared<RectangularSliceType>(elementType, rank);
+  if (!isCanonical(elementType)) {
+    return std::make_shared<RectangularSliceType>(elementType, rank);
+  }
+  auto key = makeKey(InternTag::RectangularSlice, elementType.get());
+  appendKey(key, rank);
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<RectangularSliceType>(elementType, rank);
+  });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getPointerType(std::shared_ptr<Type> pointeeType,
                             bool isNullable) {
-  return std::make_shared<PointerType>(pointeeType, isNullable);
+  if (!isCanonical(pointeeType)) {
+    return std::make_shared<PointerType>(pointeeType, isNullable);
+  }
+  auto key = makeKey(InternTag::Pointer, pointeeType.get());
+  appendKey(key, isNullable);
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<PointerType>(pointeeType, isNullable);
+  });
 }
 
 std::shared_ptr<Type> TypeFactory::getFunctionType(
     std::shared_ptr<Type> returnType,
     std::vector<std::shared_ptr<Type>> parameterTypes) {
-  return std::make_shared<FunctionType>(returnType, parameterTypes);
+  if (!isCanonical(returnType) || !isCanonical(parameterTypes)) {
+    return std::make_shared<FunctionType>(returnType, parameterTypes);
+  }
+  auto key = makeKey(InternTag::Function, parameterTypes);
+  appendKey(key, returnType.get());
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<FunctionType>(returnType, parameterTypes);
+  });
 }
 
+// 类和接口按名称区分，分析过程中还会添加成员，每次创建新的对象
 std::shared_ptr<Type> TypeFactory::getClassType(const std::string &name) {
   return std::make_shared<ClassType>(name);
 }
@@ -87,32 +262,64 @@ std::shared_ptr<Type> TypeFactory::getInterfaceType(const std::string &name) {
 std::shared_ptr<Type>
 TypeFactory::getGenericType(const std::string &name,
                             std::vector<std::shared_ptr<Type>> typeArguments) {
-  return std::make_shared<GenericType>(name, typeArguments);
+  // 没有类型实参的是模板参数，属于各自的声明，不驻留
+  if (typeArguments.empty() || !isCanonical(typeArguments)) {
+    return std::make_shared<GenericType>(name, typeArguments);
+  }
+  auto key = makeKey(InternTag::Generic, typeArguments);
+  key += name;
+  return InternTable::instance().intern(key, [&] {
+    return std::make_unique<GenericType>(name, typeArguments);
+  });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getTupleType(std::vector<std::shared_ptr<Type>> elementTypes) {
-  return std::make_shared<TupleType>(std::move(elementTypes));
+  if (!isCanonical(elementTypes)) {
+    return std::make_shared<TupleType>(std::move(elementTypes));
+  }
+  return InternTable::instance().intern(
+      makeKey(InternTag::Tuple, elementTypes), [&] {
+        return std::make_unique<TupleType>(std::move(elementTypes));
+      });
 }
 
 std::shared_ptr<Type> TypeFactory::getLiteralViewType() {
-  static std::shared_ptr<Type> instance = std::make_shared<LiteralViewType>();
+  static const std::shared_ptr<Type> instance =
+      InternTable::instance().intern(
+          std::string(1, static_cast<char>(InternTag::LiteralView)),
+          [] { return std::make_unique<LiteralViewType>(); });
   return instance;
 }
 
 std::shared_ptr<Type>
 TypeFactory::getReadonlyType(std::shared_ptr<Type> baseType) {
-  return std::make_shared<ReadonlyType>(std::move(baseType));
+  if (!isCanonical(baseType)) {
+    return std::make_shared<ReadonlyType>(std::move(baseType));
+  }
+  return InternTable::instance().intern(
+      makeKey(InternTag::Readonly, baseType.get()),
+      [&] { return std::make_unique<ReadonlyType>(std::move(baseType)); });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getReferenceType(std::shared_ptr<Type> baseType) {
-  return std::make_shared<ReferenceType>(std::move(baseType));
+  if (!isCanonical(baseType)) {
+    return std::make_shared<ReferenceType>(std::move(baseType));
+  }
+  return InternTable::instance().intern(
+      makeKey(InternTag::Reference, baseType.get()),
+      [&] { return std::make_unique<ReferenceType>(std::move(baseType)); });
 }
 
 std::shared_ptr<Type>
 TypeFactory::getNullableType(std::shared_ptr<Type> baseType) {
-  return std::make_shared<NullableType>(std::move(baseType));
+  if (!isCanonical(baseType)) {
+    return std::make_shared<NullableType>(std::move(baseType));
+  }
+  return InternTable::instance().intern(
+      makeKey(InternTag::Nullable, baseType.get()),
+      [&] { return std::make_unique<NullableType>(std::move(baseType)); });
 }
 
 } // namespace types
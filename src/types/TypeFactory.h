@@ -22,6 +22,13 @@ namespace c_hat {
 namespace types {
 
 // 类型工厂
+// 组成部分都是规范类型的结构类型（基本、数组、切片、指针、函数、元组、
+// 泛型实例等）被驻留：结构相同时返回同一个对象。驻留的类型是共享的，
+// 不能修改。类和接口类型按名称区分且会添加成员，不驻留。
+// 生命周期：进程级的类型表只持有弱引用，类型由返回的 shared_ptr 持有，
+// 最后一个使用者释放后析构，之后再请求同样的结构时重新创建。表中失效
+// 的项在表增长时清理，长期运行的编译服务器、语言服务器和监视模式中，
+// 表的大小只取决于仍在使用的类型。基本类型在进程结束前一直保留。
 class TypeFactory {
 public:
   // 获取基本类型
@@ -81,6 +88,11 @@ public:
 
   // 获取可空类型
   static std::shared_ptr<Type> getNullableType(std::shared_ptr<Type> baseType);
+
+private:
+  class InternTable;
+
+  static void markCanonical(Type &type) { type.canonical = true; }
 };
 
 } // namespace types
@@ -4,10 +4,12 @@
 #include "ClassType.h"
 #include "FunctionType.h"
 #include "GenericType.h"
+#include "InstantiationTable.h"
 #include "LiteralViewType.h"
 #include "PointerType.h"
 #include "PrimitiveType.h"
 #include "ReadonlyType.h"
+#include "RelationCache.h"
 #include "SliceType.h"
 #include "TupleType.h"
 #include "Type.h"
@@ -0,0 +1,32 @@
+// TestUtils.h - 测试共用的临时目录和文件读写
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+// 每次运行使用不同的临时目录，同时运行的测试进程互不干扰
+inline std::filesystem::path uniqueTempDir(const std::string& name) {
+    std::random_device random;
+    auto dir = std::filesystem::temp_directory_path() /
+               (name + "_" + std::to_string(random()) + std::to_string(random()));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+inline void writeFile(const std::filesystem::path& path, const std::string& content) {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+inline std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
@@ -0,0 +1,121 @@
+// LexerBenchmark.cpp - 词法分析吞吐量基准
+// 运行：./lexer_benchmark "[benchmark]"
+#include "../src/lexer/Lexer.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace c_hat;
+
+// 生成以标识符和关键字为主的源码
+static std::string generateIdentifierHeavy(int count) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format("public static int compute_{}(int alpha, int beta) "
+                          "{{ var result = alpha + beta * value_{}; "
+                          "return result; }}\n",
+                          i, i);
+  }
+  return source;
+}
+
+static size_t countTokens(lexer::Lexer &lex) {
+  size_t count = 0;
+  while (auto token = lex.nextToken()) {
+    if (token->getType() == lexer::TokenType::EndOfFile) {
+      break;
+    }
+    count++;
+  }
+  return count;
+}
+
+static size_t countTokens(const std::string &source) {
+  lexer::Lexer lex(source);
+  return countTokens(lex);
+}
+
+TEST_CASE("Benchmark: Lexer throughput", "[benchmark][lexer]") {
+  std::string identifiers = generateIdentifierHeavy(5000);
+  REQUIRE(countTokens(identifiers) == 5000 * 25);
+
+  BENCHMARK("identifier-heavy source") { return countTokens(identifiers); };
+}
+
+// 生成以文档注释为主的源码（类似标准库文件）
+static std::string generateCommentHeavy(int count) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format(
+        "/**\n"
+        " * Returns the element at the given index.\n"
+        " * The index must be less than the length of the collection,\n"
+        " * otherwise the behaviour is undefined.\n"
+        " */\n"
+        "// helper {}: see the module documentation for details\n"
+        "func get{}(int index) -> string {{ return \"value at index\"; }}\n\n",
+        i, i);
+  }
+  return source;
+}
+
+TEST_CASE("Benchmark: Lexer comment and string scanning",
+          "[benchmark][lexer]") {
+  std::string comments = generateCommentHeavy(5000);
+  REQUIRE(countTokens(comments) == 5000 * 13);
+
+  BENCHMARK("comment-heavy source") { return countTokens(comments); };
+}
+
+// 分块读取文件，与整块映射文件对比
+static size_t countTokensChunked(const std::filesystem::path &path,
+                                 size_t chunkSize) {
+#ifdef _WIN32
+  int fd = _open(path.string().c_str(), _O_RDONLY | _O_BINARY);
+#else
+  int fd = open(path.string().c_str(), O_RDONLY);
+#endif
+  size_t count = 0;
+  {
+    lexer::Lexer lex(lexer::ChunkedInput{fd, chunkSize});
+    count = countTokens(lex);
+  }
+#ifdef _WIN32
+  _close(fd);
+#else
+  close(fd);
+#endif
+  return count;
+}
+
+TEST_CASE("Benchmark: Chunked lexing", "[benchmark][lexer]") {
+  auto path =
+      std::filesystem::temp_directory_path() / "c_hat_chunked_bench.ch";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << generateIdentifierHeavy(20000);
+  }
+  REQUIRE(countTokensChunked(path, 4096) == 20000 * 25);
+
+  BENCHMARK("mapped file") {
+    lexer::Lexer lex(lexer::SourceBuffer::fromFile(path));
+    return countTokens(lex);
+  };
+  BENCHMARK("chunked, 4 KB") { return countTokensChunked(path, 4096); };
+  BENCHMARK("chunked, 256 KB") {
+    return countTokensChunked(path, lexer::ChunkedInput::DefaultChunkSize);
+  };
+
+  std::filesystem::remove(path);
+}
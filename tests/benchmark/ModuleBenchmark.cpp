@@ -0,0 +1,147 @@
+// ModuleBenchmark.cpp - 模块导入基准（源码分析、预编译接口、AST 缓存与并行加载对比）
+// 运行：./module_benchmark "[benchmark]"
+#include "../src/parser/Parser.h"
+#include "../src/semantic/AstCache.h"
+#include "../src/semantic/SemanticAnalyzer.h"
+#include "../src/semantic/ThreadPool.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+
+using namespace c_hat;
+
+// 生成导出大量类和函数的库模块
+static std::string generateLibrary(int count) {
+  std::string source = "module biglib;\n";
+  for (int i = 0; i < count; ++i) {
+    source += std::format("public class C{} {{\n"
+                          "    public int x;\n"
+                          "    public int get() {{ return x + {}; }}\n"
+                          "}}\n"
+                          "public func f{}(int a, int b) -> int {{\n"
+                          "    var x = a * 2 + b - {};\n"
+                          "    return x;\n"
+                          "}}\n",
+                          i, i, i, i);
+  }
+  return source;
+}
+
+static bool importLibrary(const std::filesystem::path &dir) {
+  parser::Parser parser("import biglib;\nfunc main() { }\n");
+  auto program = parser.parseProgram();
+  semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+  analyzer.setModuleInterfaceCacheDir((dir / "cache").string());
+  // 只比较源码分析与接口加载，源码路径每次都重新解析
+  analyzer.setAstCacheEnabled(false);
+  analyzer.analyze(*program);
+  return analyzer.hasError();
+}
+
+TEST_CASE("Benchmark: Importing a module", "[benchmark][module]") {
+  auto dir = std::filesystem::temp_directory_path() / "c_hat_module_bench";
+  std::filesystem::create_directories(dir);
+  {
+    std::ofstream file(dir / "biglib.ch", std::ios::binary);
+    file << generateLibrary(500);
+  }
+  auto interfacePath = dir / "cache" / "biglib.chi";
+
+  BENCHMARK("analyze source and write interface") {
+    std::filesystem::remove(interfacePath);
+    return importLibrary(dir);
+  };
+  REQUIRE(std::filesystem::exists(interfacePath));
+  BENCHMARK("load precompiled interface") { return importLibrary(dir); };
+
+  std::filesystem::remove_all(dir);
+}
+
+// 加载模块 AST 并解析全部函数体，返回函数数量
+static size_t loadLibraryAst(const std::filesystem::path &dir, bool useCache) {
+  semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+  loader.setAstCacheDir((dir / "cache").string());
+  loader.setAstCacheEnabled(useCache);
+  auto program = loader.loadModule({"biglib"});
+  size_t functions = 0;
+  for (auto &decl : program->declarations) {
+    if (auto *func = dynamic_cast<ast::FunctionDecl *>(decl.get())) {
+      func->materializeBody();
+      ++functions;
+    }
+  }
+  return functions;
+}
+
+TEST_CASE("Benchmark: Loading a module AST", "[benchmark][module]") {
+  auto dir = std::filesystem::temp_directory_path() / "c_hat_ast_cache_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::string source = generateLibrary(500);
+  {
+    std::ofstream file(dir / "biglib.ch", std::ios::binary);
+    file << source;
+  }
+
+  BENCHMARK("parse source") { return loadLibraryAst(dir, false); };
+  REQUIRE(loadLibraryAst(dir, true) == 500);
+  semantic::AstCache cache(dir / "cache");
+  REQUIRE(std::filesystem::exists(
+      cache.entryPath(semantic::hashSourceContent(source))));
+  BENCHMARK("deserialize cached AST") { return loadLibraryAst(dir, true); };
+
+  std::filesystem::remove_all(dir);
+}
+
+// 分析导入 count 个互不依赖的模块的入口程序
+static bool importWideProject(const std::filesystem::path &dir, int count,
+                              size_t jobs) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format("import lib{};\n", i);
+  }
+  source += "func main() { }\n";
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+  analyzer.setModuleInterfaceCacheDir((dir / "cache").string());
+  analyzer.setAstCacheEnabled(false);
+  analyzer.setModuleJobs(jobs);
+  analyzer.analyze(*program);
+  return analyzer.hasError();
+}
+
+TEST_CASE("Benchmark: Importing a wide project", "[benchmark][module]") {
+  constexpr int ModuleCount = 32;
+  auto dir = std::filesystem::temp_directory_path() / "c_hat_wide_module_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  for (int i = 0; i < ModuleCount; ++i) {
+    std::ofstream file(dir / std::format("lib{}.ch", i), std::ios::binary);
+    auto source = generateLibrary(100);
+    source.replace(0, std::string("module biglib;").size(),
+                   std::format("module lib{};", i));
+    file << source;
+  }
+
+  // 每次都删除接口文件，比较的是源码分析本身
+  auto removeInterfaces = [&dir] {
+    for (int i = 0; i < ModuleCount; ++i) {
+      std::filesystem::remove(dir / "cache" / std::format("lib{}.chi", i));
+    }
+  };
+  BENCHMARK("analyze sequentially") {
+    removeInterfaces();
+    return importWideProject(dir, ModuleCount, 1);
+  };
+  size_t jobs = semantic::ThreadPool::defaultThreadCount();
+  BENCHMARK("analyze on a thread pool") {
+    removeInterfaces();
+    return importWideProject(dir, ModuleCount, jobs);
+  };
+
+  std::filesystem::remove_all(dir);
+}
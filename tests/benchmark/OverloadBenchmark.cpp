@@ -0,0 +1,52 @@
+// OverloadBenchmark.cpp - 重载决议基准（大量重载和调用的生成代码）
+// 运行：./overload_benchmark "[benchmark]"
+#include "../src/parser/Parser.h"
+#include "../src/semantic/SemanticAnalyzer.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <string>
+
+using namespace c_hat;
+
+// overloads 个同名重载，calls 个函数各调用 8 次
+static std::string generateCalls(int overloads, int calls) {
+  static const char *const Types[] = {"int",  "long",  "float", "double",
+                                      "bool", "short", "char",  "byte"};
+  std::string source;
+  for (int i = 0; i < overloads; ++i) {
+    source += "func f(";
+    for (int j = 0; j <= i / 8; ++j) {
+      source += std::format("{}{} p{}", j ? ", " : "", Types[(i + j) % 8], j);
+    }
+    source += ") -> int { return 0; }\n";
+  }
+  for (int i = 0; i < calls; ++i) {
+    source += std::format("func caller{}(int a, double b) -> int {{\n", i);
+    source += "  var s = 0;\n";
+    for (int j = 0; j < 8; ++j) {
+      source += j % 2 ? "  s = s + f(b);\n" : "  s = s + f(a);\n";
+    }
+    source += "  return s;\n}\n";
+  }
+  return source;
+}
+
+static bool analyzeSource(const std::string &source) {
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  semantic::SemanticAnalyzer analyzer("", false);
+  analyzer.analyze(*program);
+  return !analyzer.hasError();
+}
+
+TEST_CASE("Benchmark: Overload resolution in generated code",
+          "[benchmark][overload]") {
+  auto small = generateCalls(16, 100);
+  auto large = generateCalls(64, 1000);
+  REQUIRE(analyzeSource(small));
+  REQUIRE(analyzeSource(large));
+
+  BENCHMARK("16 overloads, 800 calls") { return analyzeSource(small); };
+  BENCHMARK("64 overloads, 8000 calls") { return analyzeSource(large); };
+}
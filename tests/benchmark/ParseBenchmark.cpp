@@ -0,0 +1,151 @@
+// ParseBenchmark.cpp - 解析吞吐量基准
+// 运行：./parse_benchmark "[benchmark]"
+#include "../src/parser/Parser.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <string>
+
+using namespace c_hat;
+
+// 生成包含大量函数的源码，模拟生成代码的形态
+static std::string generateFunctions(int count) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format("func f{}(int a, int b) -> int {{\n"
+                          "    var x = a * 2 + b - {};\n"
+                          "    if (x > 10) {{\n"
+                          "        x = x - 1;\n"
+                          "    }}\n"
+                          "    while (x < 100) {{\n"
+                          "        x = x + a * (b + 1);\n"
+                          "    }}\n"
+                          "    return x;\n"
+                          "}}\n",
+                          i, i);
+  }
+  return source;
+}
+
+// 生成包含大量类和全局变量的源码，声明解析会走推测解析与回溯路径
+static std::string generateClasses(int count) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format("class C{} {{\n"
+                          "    public int x;\n"
+                          "    public int y;\n"
+                          "    public C{}(int x, int y) {{ }}\n"
+                          "    public int sum() {{ return x + y; }}\n"
+                          "}}\n"
+                          "int g{} = {};\n",
+                          i, i, i, i);
+  }
+  return source;
+}
+
+// 生成大型常量表，每个元素都是一个多层二元表达式
+static std::string generateConstantTable(int count) {
+  std::string source = "var table = [\n";
+  for (int i = 0; i < count; ++i) {
+    source += std::format("    {} * 31 + (7 - {}) % 1024 << 2 & 255 + 1,\n",
+                          i, i);
+  }
+  source += "    0\n];\n";
+  return source;
+}
+
+// 生成数学内核函数，函数体由长算术表达式和比较条件组成
+static std::string generateMathKernels(int count) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format(
+        "func k{}(int a, int b, int c, int d) -> int {{\n"
+        "    var t = a * b + c * d - (a - b) * (c + d) / 3 + {};\n"
+        "    var u = (t << 3) + (t >> 2) - a * a + b * b % 17;\n"
+        "    if (t > u && a + b <= c * d || t == u) {{\n"
+        "        t = t * u - a * b * c * d + {} * (u - t);\n"
+        "    }}\n"
+        "    return t + u * 2 - a / (b + 1) + c % (d + 1);\n"
+        "}}\n",
+        i, i);
+  }
+  return source;
+}
+
+static size_t parseAndDestroy(const std::string &source, bool useArena) {
+  parser::Parser parser(source);
+  parser.setUseArena(useArena);
+  auto program = parser.parseProgram();
+  return program->declarations.size();
+}
+
+TEST_CASE("Benchmark: AST arena allocation", "[benchmark][parser]") {
+  const int functionCount = 2000;
+  std::string source = generateFunctions(functionCount);
+
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  REQUIRE(program->declarations.size() == functionCount);
+  REQUIRE(program->arena != nullptr);
+  REQUIRE(program->arena->getAllocationCount() > functionCount);
+
+  BENCHMARK("parse + destroy (arena)") {
+    return parseAndDestroy(source, true);
+  };
+
+  BENCHMARK("parse + destroy (heap)") {
+    return parseAndDestroy(source, false);
+  };
+}
+
+TEST_CASE("Benchmark: Declaration backtracking", "[benchmark][parser]") {
+  const int classCount = 1000;
+  std::string source = generateClasses(classCount);
+
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  REQUIRE(program->declarations.size() == classCount * 2);
+
+  BENCHMARK("parse classes and globals") {
+    return parseAndDestroy(source, true);
+  };
+}
+
+TEST_CASE("Benchmark: Expression-dense input", "[benchmark][parser]") {
+  const int tableSize = 20000;
+  const int kernelCount = 2000;
+  std::string table = generateConstantTable(tableSize);
+  std::string kernels = generateMathKernels(kernelCount);
+
+  {
+    parser::Parser parser(table);
+    auto program = parser.parseProgram();
+    REQUIRE(program->declarations.size() == 1);
+  }
+  {
+    parser::Parser parser(kernels);
+    auto program = parser.parseProgram();
+    REQUIRE(program->declarations.size() == kernelCount);
+  }
+
+  BENCHMARK("parse constant table") { return parseAndDestroy(table, true); };
+
+  BENCHMARK("parse math kernels") { return parseAndDestroy(kernels, true); };
+}
+
+TEST_CASE("Benchmark: Skimming function bodies", "[benchmark][parser]") {
+  const int functionCount = 2000;
+  std::string source = generateFunctions(functionCount);
+
+  auto parseWithSkim = [&source](bool skim) {
+    parser::Parser parser(source);
+    parser.setSkimFunctionBodies(skim);
+    auto program = parser.parseProgram();
+    return program->declarations.size();
+  };
+  REQUIRE(parseWithSkim(true) == functionCount);
+
+  BENCHMARK("parse full bodies") { return parseWithSkim(false); };
+
+  BENCHMARK("parse interfaces only (skim)") { return parseWithSkim(true); };
+}
@@ -0,0 +1,57 @@
+// PipelineBenchmark.cpp - 语法分析与语义分析流水线基准
+// 运行：./pipeline_benchmark "[benchmark]"
+#include "../src/parser/Parser.h"
+#include "../src/semantic/AnalysisPipeline.h"
+#include "../src/semantic/SemanticAnalyzer.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <string>
+
+using namespace c_hat;
+
+// 生成大量类和函数，模拟大型生成代码文件
+static std::string generateProgram(int count) {
+  std::string source = "func main() -> int { return 0; }\n";
+  for (int i = 0; i < count; ++i) {
+    source += std::format("class C{} {{\n"
+                          "    public int x;\n"
+                          "    public int get() {{ return x + {}; }}\n"
+                          "}}\n"
+                          "func f{}(int a, int b) -> int {{\n"
+                          "    var x = a * 2 + b - {};\n"
+                          "    while (x < 100) {{\n"
+                          "        x = x + a * (b + 1);\n"
+                          "    }}\n"
+                          "    return x;\n"
+                          "}}\n",
+                          i, i, i, i);
+  }
+  return source;
+}
+
+static bool analyzeSequential(const std::string &source) {
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  semantic::SemanticAnalyzer analyzer;
+  analyzer.analyze(*program);
+  return analyzer.hasError();
+}
+
+static bool analyzePipelined(const std::string &source) {
+  parser::Parser parser(source);
+  semantic::SemanticAnalyzer analyzer;
+  semantic::AnalysisPipeline pipeline(parser, analyzer);
+  auto program = pipeline.run();
+  return analyzer.hasError();
+}
+
+TEST_CASE("Benchmark: Pipelined parse and analysis", "[benchmark][pipeline]") {
+  std::string source = generateProgram(1000);
+  REQUIRE_FALSE(analyzeSequential(source));
+  REQUIRE_FALSE(analyzePipelined(source));
+
+  BENCHMARK("parse, then analyze") { return analyzeSequential(source); };
+
+  BENCHMARK("pipelined parse + analyze") { return analyzePipelined(source); };
+}
@@ -0,0 +1,125 @@
+// SymbolTableBenchmark.cpp - 符号表基准（深层嵌套、大量局部变量、函数体分析）
+// 运行：./symbol_table_benchmark "[benchmark]"
+#include "../src/parser/Parser.h"
+#include "../src/semantic/SemanticAnalyzer.h"
+#include "../src/semantic/SymbolTable.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace c_hat;
+
+static std::shared_ptr<semantic::Symbol> makeVariable(const std::string &name) {
+  auto intType =
+      types::TypeFactory::getPrimitiveType(types::PrimitiveType::Kind::Int);
+  return std::make_shared<semantic::VariableSymbol>(name, intType);
+}
+
+// 在 depth 层嵌套作用域中查找全局名称（查找次数与深度无关）
+static size_t lookupAtDepth(int depth, lexer::NameId globalName,
+                            lexer::NameId localName) {
+  semantic::SymbolTable table;
+  table.addSymbol(makeVariable("global_value"));
+  for (int i = 0; i < depth; ++i) {
+    table.enterScope();
+    table.addSymbol(makeVariable("local"));
+  }
+  size_t found = 0;
+  for (int i = 0; i < 10000; ++i) {
+    found += table.lookupSymbol(globalName) != nullptr;
+    found += table.lookupSymbol(localName) != nullptr;
+  }
+  for (int i = 0; i < depth; ++i) {
+    table.exitScope();
+  }
+  return found;
+}
+
+TEST_CASE("Benchmark: Symbol lookup in deeply nested scopes",
+          "[benchmark][symbols]") {
+  auto global = lexer::NameInterner::global().intern("global_value");
+  auto local = lexer::NameInterner::global().intern("local");
+  REQUIRE(lookupAtDepth(256, global, local) == 20000);
+
+  BENCHMARK("depth 1") { return lookupAtDepth(1, global, local); };
+  BENCHMARK("depth 16") { return lookupAtDepth(16, global, local); };
+  BENCHMARK("depth 256") { return lookupAtDepth(256, global, local); };
+}
+
+TEST_CASE("Benchmark: Many locals in one scope", "[benchmark][symbols]") {
+  std::vector<std::shared_ptr<semantic::Symbol>> symbols;
+  std::vector<lexer::NameId> names;
+  for (int i = 0; i < 10000; ++i) {
+    symbols.push_back(makeVariable(std::format("local_{}", i)));
+    names.push_back(symbols.back()->getNameId());
+  }
+
+  BENCHMARK("add, look up and exit 10000 locals") {
+    semantic::SymbolTable table;
+    table.enterScope();
+    for (const auto &symbol : symbols) {
+      table.addSymbol(symbol);
+    }
+    size_t found = 0;
+    for (auto name : names) {
+      found += table.lookupSymbol(name) != nullptr;
+    }
+    table.exitScope();
+    return found;
+  };
+}
+
+TEST_CASE("Benchmark: Many overloads of one name", "[benchmark][symbols]") {
+  auto intType =
+      types::TypeFactory::getPrimitiveType(types::PrimitiveType::Kind::Int);
+  auto funcType = types::TypeFactory::getFunctionType(intType, {});
+  std::vector<std::shared_ptr<semantic::Symbol>> overloads;
+  for (int i = 0; i < 10000; ++i) {
+    overloads.push_back(std::make_shared<semantic::FunctionSymbol>(
+        "overloaded",
+        std::static_pointer_cast<types::FunctionType>(funcType)));
+  }
+
+  // 每添加一个重载查找一次，新重载追加到已有的集合
+  BENCHMARK("add and look up 10000 overloads") {
+    semantic::SymbolTable table;
+    size_t found = 0;
+    for (const auto &symbol : overloads) {
+      table.addSymbol(symbol);
+      found += table.lookupOverloadSet("overloaded")->functions.size();
+    }
+    return found;
+  };
+}
+
+// 生成嵌套代码块很深、局部变量很多的函数
+static std::string generateNestedFunctions(int count, int depth) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    source += std::format("func f{}(int a) -> int {{\n", i);
+    for (int d = 0; d < depth; ++d) {
+      source += std::format("if (a > {}) {{ var v{} = a + {};\n", d, d, d);
+    }
+    for (int d = depth - 1; d >= 0; --d) {
+      source += std::format("a = v{} + a; }}\n", d);
+    }
+    source += "return a;\n}\n";
+  }
+  return source + "func main() { }\n";
+}
+
+TEST_CASE("Benchmark: Analyzing deeply nested function bodies",
+          "[benchmark][symbols]") {
+  std::string source = generateNestedFunctions(200, 32);
+
+  BENCHMARK("200 functions, 32 nested blocks each") {
+    parser::Parser parser(source);
+    auto program = parser.parseProgram();
+    semantic::SemanticAnalyzer analyzer;
+    analyzer.analyze(*program);
+    return analyzer.hasError();
+  };
+}
@@ -1,4 +1,5 @@
 #include "../src/parser/Parser.h"
+#include "../src/semantic/ClassHierarchy.h"
 #include "../src/semantic/SemanticAnalyzer.h"
 #include <catch2/catch_test_macros.hpp>
 #include <string>
@@ -243,3 +244,73 @@ TEST_CASE("Class: Complex inheritance scenarios",
                 "radius; public int getX() { return x + radius; } }") == true);
   }
 }
+
+TEST_CASE("Class: Class hierarchy numbering", "[class][inheritance][cache]") {
+  auto animal = std::make_shared<types::ClassType>("Animal");
+  auto mammal = std::make_shared<types::ClassType>("Mammal");
+  auto bird = std::make_shared<types::ClassType>("Bird");
+  auto bat = std::make_shared<types::ClassType>("Bat");
+  auto rock = std::make_shared<types::ClassType>("Rock");
+  mammal->addBaseClass(animal);
+  bird->addBaseClass(animal);
+  bat->addBaseClass(mammal);
+  bat->addBaseClass(bird);
+
+  semantic::ClassHierarchy hierarchy;
+  SECTION("Single inheritance is answered from the numbering") {
+    CHECK(hierarchy.isSubclassOf(mammal.get(), animal.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(animal.get(), mammal.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(mammal.get(), mammal.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(bird.get(), mammal.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(rock.get(), animal.get()));
+    CHECK(hierarchy.getStats().queries == 5);
+    CHECK(hierarchy.getStats().intervalHits == 5);
+  }
+
+  SECTION("Multiple inheritance falls back to the base classes once") {
+    CHECK(hierarchy.isSubclassOf(bat.get(), animal.get()));
+    CHECK(hierarchy.isSubclassOf(bat.get(), bird.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(bat.get(), rock.get()));
+    CHECK(hierarchy.isSubclassOf(bat.get(), bird.get()));
+    CHECK_FALSE(hierarchy.isSubclassOf(bat.get(), rock.get()));
+    CHECK(hierarchy.getStats().memoHits == 2);
+  }
+
+  SECTION("Adding a base class requires invalidation") {
+    CHECK_FALSE(hierarchy.isSubclassOf(rock.get(), animal.get()));
+    rock->addBaseClass(animal);
+    hierarchy.invalidate();
+    CHECK(hierarchy.isSubclassOf(rock.get(), animal.get()));
+    CHECK(hierarchy.getStats().renumbers == 2);
+  }
+}
+
+TEST_CASE("Class: Relation cache hit rates", "[class][cache]") {
+  std::string source =
+      "class Animal { } class Mammal : Animal { } class Bird : Animal { } "
+      "class Bat : Mammal, Bird { } "
+      "func test() { Bat bat; Animal^ a = ^bat; Mammal^ m = ^bat; "
+      "Bird^ b = ^bat; Bird^ c = ^bat; double x = 1; double y = 2; "
+      "double z = 3; }\n"
+      "func main() { }\n";
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  REQUIRE(program != nullptr);
+  semantic::SemanticAnalyzer analyzer;
+  analyzer.analyze(*program);
+  REQUIRE_FALSE(analyzer.hasError());
+
+  const auto &relations = analyzer.getRelationCacheStats();
+  const auto &hierarchy = analyzer.getClassHierarchyStats();
+  INFO("relation cache: " << relations.hits << " hits, " << relations.misses
+                          << " misses");
+  INFO("class hierarchy: " << hierarchy.queries << " queries, "
+                           << hierarchy.intervalHits << " interval hits, "
+                           << hierarchy.memoHits << " memo hits");
+  // int -> double 只在第一次检查
+  CHECK(relations.hits >= 2);
+  // Bat^ -> Animal^ 由区间编号得出，Bat^ -> Bird^ 第二次由查找结果表得出
+  CHECK(hierarchy.queries >= 4);
+  CHECK(hierarchy.memoHits >= 1);
+  CHECK(hierarchy.hitRate() > 0.5);
+}
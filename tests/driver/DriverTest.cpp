@@ -0,0 +1,90 @@
+// DriverTest.cpp - 多个翻译单元与项目清单的编译
+#include "../TestUtils.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// 运行编译器，输出写入 log，返回是否成功
+static bool runCompiler(const std::string& arguments, const std::filesystem::path& log) {
+    std::string command = std::string("\"") + C_HAT_COMPILER + "\" " + arguments +
+                          " > \"" + log.string() + "\" 2>&1";
+    return std::system(command.c_str()) == 0;
+}
+
+static std::string quoted(const std::filesystem::path& path) {
+    return "\"" + path.string() + "\"";
+}
+
+TEST_CASE("Driver: compiling several files", "[driver]") {
+    auto dir = uniqueTempDir("c_hat_driver_test");
+    auto build = dir / "build";
+    auto log = dir / "log.txt";
+    writeFile(dir / "main.ch", "func main() { }\n");
+    writeFile(dir / "util.ch", "func twice(int x) -> int { return x * 2; }\n");
+    std::string files = quoted(dir / "main.ch") + " " + quoted(dir / "util.ch");
+
+    SECTION("Each file is a translation unit with its own output") {
+        REQUIRE(runCompiler(files + " --emit-llvm -j 2 --build-dir " + quoted(build), log));
+        CHECK(readFile(log).find("Compiling 2 files with 2 jobs") != std::string::npos);
+        CHECK(std::filesystem::exists(build / "main.ll"));
+        CHECK(std::filesystem::exists(build / "util.ll"));
+        CHECK(readFile(build / "util.ll").find("twice") != std::string::npos);
+        CHECK(readFile(build / "main.ll").find("twice") == std::string::npos);
+    }
+
+    SECTION("Unchanged files are not recompiled") {
+        REQUIRE(runCompiler(files + " --emit-llvm --build-dir " + quoted(build), log));
+        writeFile(dir / "util.ch", "func twice(int x) -> int { return x + x; }\n");
+        REQUIRE(runCompiler(files + " --emit-llvm --build-dir " + quoted(build), log));
+        auto output = readFile(log);
+        CHECK(output.find("Up to date: " + (dir / "main.ch").string()) != std::string::npos);
+        CHECK(output.find("Compiled: " + (dir / "util.ch").string()) != std::string::npos);
+    }
+
+    SECTION("Files with the same name get distinct outputs") {
+        writeFile(dir / "other" / "util.ch", "func half(int x) -> int { return x / 2; }\n");
+        REQUIRE(runCompiler(files + " " + quoted(dir / "other" / "util.ch") +
+                                " --emit-llvm --build-dir " + quoted(build),
+                            log));
+        CHECK(readFile(build / "util.ll").find("twice") != std::string::npos);
+        CHECK(readFile(build / "util_1.ll").find("half") != std::string::npos);
+    }
+
+    SECTION("An error in one file fails the build") {
+        writeFile(dir / "util.ch", "func twice(int x) -> int { return missing; }\n");
+        CHECK_FALSE(runCompiler(files + " --emit-llvm --build-dir " + quoted(build), log));
+        CHECK(readFile(log).find((dir / "util.ch").string()) != std::string::npos);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Driver: compiling a project manifest", "[driver]") {
+    auto dir = uniqueTempDir("c_hat_driver_project_test");
+    auto build = dir / "build";
+    auto log = dir / "log.txt";
+    writeFile(dir / "main.ch", "func main() { }\n");
+    writeFile(dir / "src" / "util.ch", "func twice(int x) -> int { return x * 2; }\n");
+
+    SECTION("Listed files are resolved relative to the manifest") {
+        writeFile(dir / "project.txt",
+                  "# 入口\n"
+                  "main.ch\n"
+                  "\n"
+                  "  src/util.ch  # 工具函数\n");
+        REQUIRE(runCompiler("--project " + quoted(dir / "project.txt") +
+                                " --emit-llvm --build-dir " + quoted(build),
+                            log));
+        CHECK(readFile(log).find("Compiling 2 files") != std::string::npos);
+        CHECK(std::filesystem::exists(build / "main.ll"));
+        CHECK(readFile(build / "util.ll").find("twice") != std::string::npos);
+    }
+
+    SECTION("A missing manifest is reported") {
+        CHECK_FALSE(runCompiler("--project " + quoted(dir / "missing.txt"), log));
+        CHECK(readFile(log).find("Could not open project manifest") != std::string::npos);
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -2,6 +2,7 @@
 #include "../src/parser/Parser.h"
 #include "../src/semantic/SemanticAnalyzer.h"
 #include <catch2/catch_test_macros.hpp>
+#include <sstream>
 #include <string>
 
 using namespace c_hat;
@@ -114,3 +115,26 @@ TEST_CASE("Generics: instantiation", "[generics][semantic]") {
             "func main() { Stack<int> s; s.push(1); }") == true);
     }
 }
+
+TEST_CASE("Generics: instantiations are shared", "[generics][semantic]") {
+    parser::Parser p(
+        "class Box<T> { public T value; }\n"
+        "func first(Box<int> a, Box<int> b) -> int { return 0; }\n"
+        "func second(Box<float> c) { }\n"
+        "func main() { Box<int> x; Box<int> y; Box<float> z; }");
+    auto prog = p.parseProgram();
+    REQUIRE(prog);
+    semantic::SemanticAnalyzer analyzer("", false);
+    analyzer.analyze(*prog);
+    REQUIRE_FALSE(analyzer.hasError());
+
+    // Box<int> 和 Box<float> 各实例化一次，其余都复用
+    const auto& stats = analyzer.getInstantiationStats();
+    CHECK(stats.created == 2);
+    CHECK(stats.reused >= 3);
+
+    std::ostringstream out;
+    analyzer.dumpStats(out);
+    CHECK(out.str().find("Generic instantiations: 2 created") !=
+          std::string::npos);
+}
@@ -0,0 +1,114 @@
+// HotReloadTest.cpp - 热重载会话
+#include "../src/llvm/HotReloadSession.h"
+#include <catch2/catch_test_macros.hpp>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace c_hat;
+
+// 把 LLVM IR 文本解析为可以交给会话加载的模块
+static llvm::orc::ThreadSafeModule parseModule(const std::string& ir) {
+    auto context = std::make_unique<llvm::LLVMContext>();
+    llvm::SMDiagnostic diagnostic;
+    auto module = llvm::parseAssemblyString(ir, diagnostic, *context);
+    if (!module) {
+        diagnostic.print("HotReloadTest", llvm::errs());
+    }
+    REQUIRE(module != nullptr);
+    return llvm::orc::ThreadSafeModule(std::move(module), std::move(context));
+}
+
+// main 每次调用把 counter 加上 step 并返回新值
+static std::string counterProgram(int step) {
+    return "@counter = global i32 0\n"
+           "define i32 @main() {\n"
+           "  %old = load i32, ptr @counter\n"
+           "  %new = add i32 %old, " + std::to_string(step) + "\n"
+           "  store i32 %new, ptr @counter\n"
+           "  ret i32 %new\n"
+           "}\n";
+}
+
+TEST_CASE("HotReload: reloading keeps global state", "[hot_reload]") {
+    llvm_codegen::HotReloadSession session;
+    REQUIRE(session.isValid());
+
+    std::vector<std::string> updated;
+    REQUIRE(session.load(parseModule(counterProgram(1)), updated));
+    CHECK(updated == std::vector<std::string>{"main"});
+    CHECK(session.run() == 1);
+    CHECK(session.run() == 2);
+
+    SECTION("Changed functions use the existing storage") {
+        updated.clear();
+        REQUIRE(session.load(parseModule(counterProgram(10)), updated));
+        CHECK(updated == std::vector<std::string>{"main"});
+        CHECK(session.run() == 12);
+        CHECK(session.run() == 22);
+    }
+
+    SECTION("Unchanged versions recompile nothing") {
+        updated.clear();
+        REQUIRE(session.load(parseModule(counterProgram(1)), updated));
+        CHECK(updated.empty());
+        CHECK(session.run() == 3);
+    }
+}
+
+// origin 是字段依次为 1..fieldCount 的结构体，main 返回第 field 个字段
+static std::string pointProgram(int fieldCount, int field) {
+    std::string type;
+    std::string value;
+    for (int i = 0; i < fieldCount; ++i) {
+        type += std::string(i ? ", " : "") + "i32";
+        value += std::string(i ? ", " : "") + "i32 " + std::to_string(i + 1);
+    }
+    return "%Point = type { " + type + " }\n"
+           "@origin = global %Point { " + value + " }\n"
+           "define i32 @main() {\n"
+           "  %field = getelementptr %Point, ptr @origin, i32 0, i32 " +
+           std::to_string(field) + "\n"
+           "  %value = load i32, ptr %field\n"
+           "  ret i32 %value\n"
+           "}\n";
+}
+
+TEST_CASE("HotReload: changed layouts are rejected", "[hot_reload]") {
+    llvm_codegen::HotReloadSession session;
+    REQUIRE(session.isValid());
+
+    std::vector<std::string> updated;
+    REQUIRE(session.load(parseModule(pointProgram(2, 1)), updated));
+    CHECK(session.run() == 2);
+
+    SECTION("A global whose type changed is not reloaded") {
+        updated.clear();
+        CHECK_FALSE(session.load(parseModule(pointProgram(3, 2)), updated));
+        CHECK(updated.empty());
+        // 旧版本继续运行
+        CHECK(session.run() == 2);
+
+        // 布局不变的修改仍然可以加载
+        REQUIRE(session.load(parseModule(pointProgram(2, 0)), updated));
+        CHECK(updated == std::vector<std::string>{"main"});
+        CHECK(session.run() == 1);
+    }
+
+    SECTION("A function whose type changed is not reloaded") {
+        updated.clear();
+        CHECK_FALSE(session.load(parseModule("%Point = type { i32, i32 }\n"
+                                             "@origin = global %Point zeroinitializer\n"
+                                             "define i64 @main() {\n"
+                                             "  ret i64 0\n"
+                                             "}\n"),
+                                 updated));
+        CHECK(updated.empty());
+        CHECK(session.run() == 2);
+    }
+}
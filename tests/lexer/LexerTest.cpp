@@ -0,0 +1,350 @@
+#include "../src/lexer/CharTable.h"
+#include "../src/lexer/KeywordTable.h"
+#include "../src/lexer/Lexer.h"
+#include "../src/lexer/SimdScan.h"
+#include "../src/lexer/SourceBuffer.h"
+#include <filesystem>
+#include <fstream>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace c_hat;
+
+namespace {
+std::vector<lexer::Token> tokenize(lexer::Lexer &lex) {
+  std::vector<lexer::Token> tokens;
+  while (auto token = lex.nextToken()) {
+    if (token->getType() == lexer::TokenType::EndOfFile) {
+      break;
+    }
+    tokens.push_back(*token);
+  }
+  return tokens;
+}
+} // namespace
+
+TEST_CASE("Lexer: Token values view the source buffer", "[lexer]") {
+  lexer::Lexer lex("func add(int a) -> int { return a + 42; } // done");
+  auto tokens = tokenize(lex);
+
+  REQUIRE(tokens.size() == 15);
+  REQUIRE(tokens[0].getType() == lexer::TokenType::Func);
+  REQUIRE(tokens[1].getValue() == "add");
+  REQUIRE(tokens[12].getValue() == "42");
+  REQUIRE(tokens[12].getType() == lexer::TokenType::IntegerLiteral);
+}
+
+TEST_CASE("Lexer: Literal tokens keep their source text", "[lexer]") {
+  lexer::Lexer lex("\"a\\\"b\" 'x' '\\n' 1.5e-3f 7");
+  auto tokens = tokenize(lex);
+
+  REQUIRE(tokens.size() == 5);
+  REQUIRE(tokens[0].getValue() == "\"a\\\"b\"");
+  REQUIRE(tokens[1].getValue() == "'x'");
+  REQUIRE(tokens[2].getValue() == "'\\n'");
+  REQUIRE(tokens[3].getType() == lexer::TokenType::FloatingLiteral);
+  REQUIRE(tokens[3].getValue() == "1.5e-3f");
+  REQUIRE(tokens[4].getValue() == "7");
+}
+
+TEST_CASE("Lexer: Identifiers are interned", "[lexer][interner]") {
+  lexer::Lexer lex("count value count __line__ if");
+  auto tokens = tokenize(lex);
+
+  REQUIRE(tokens.size() == 5);
+  REQUIRE(tokens[0].getNameId() != lexer::InvalidNameId);
+  REQUIRE(tokens[0].getNameId() == tokens[2].getNameId());
+  REQUIRE(tokens[0].getNameId() != tokens[1].getNameId());
+  REQUIRE(tokens[3].getType() == lexer::TokenType::BuiltinVar);
+  REQUIRE(tokens[3].getNameId() != lexer::InvalidNameId);
+  // 关键字不驻留
+  REQUIRE(tokens[4].getNameId() == lexer::InvalidNameId);
+
+  auto &interner = lexer::NameInterner::global();
+  REQUIRE(interner.lookup("count") == tokens[0].getNameId());
+  REQUIRE(interner.getName(tokens[1].getNameId()) == "value");
+}
+
+TEST_CASE("NameInterner: Basic operations", "[lexer][interner]") {
+  lexer::NameInterner interner;
+
+  REQUIRE(interner.lookup("foo") == lexer::InvalidNameId);
+  auto foo = interner.intern("foo");
+  auto bar = interner.intern("bar");
+  REQUIRE(foo != lexer::InvalidNameId);
+  REQUIRE(foo != bar);
+  REQUIRE(interner.intern(std::string("foo")) == foo);
+  REQUIRE(interner.lookup("foo") == foo);
+  REQUIRE(interner.getName(bar) == "bar");
+  REQUIRE(interner.size() == 2);
+}
+
+TEST_CASE("NameInterner: Reset", "[lexer][interner]") {
+  lexer::NameInterner interner;
+  interner.intern("foo");
+  interner.intern("bar");
+
+  interner.reset();
+  REQUIRE(interner.size() == 0);
+  REQUIRE(interner.lookup("foo") == lexer::InvalidNameId);
+
+  // 清空后重新分配编号
+  auto bar = interner.intern("bar");
+  REQUIRE(bar != lexer::InvalidNameId);
+  REQUIRE(interner.getName(bar) == "bar");
+  REQUIRE(interner.size() == 1);
+}
+
+TEST_CASE("NameInterner: Concurrent interning", "[lexer][interner]") {
+  lexer::NameInterner interner;
+  constexpr int ThreadCount = 4;
+  constexpr int NameCount = 2000;
+
+  // 每个线程以不同顺序驻留同一组名称，同一个名称必须得到同一个编号
+  std::vector<std::vector<lexer::NameId>> ids(
+      ThreadCount, std::vector<lexer::NameId>(NameCount));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < ThreadCount; ++t) {
+    threads.emplace_back([&interner, &ids, t] {
+      for (int i = 0; i < NameCount; ++i) {
+        int n = (t % 2 == 0) ? i : NameCount - 1 - i;
+        ids[t][n] = interner.intern("name" + std::to_string(n));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(interner.size() == NameCount);
+  for (int i = 0; i < NameCount; ++i) {
+    for (int t = 1; t < ThreadCount; ++t) {
+      REQUIRE(ids[t][i] == ids[0][i]);
+    }
+    REQUIRE(interner.getName(ids[0][i]) == "name" + std::to_string(i));
+  }
+}
+
+TEST_CASE("Lexer: Keyword recognition", "[lexer][keywords]") {
+  SECTION("Every keyword maps to its token type") {
+    for (const auto &keyword : lexer::Keywords) {
+      lexer::Lexer lex{std::string(keyword.text)};
+      auto token = lex.nextToken();
+      REQUIRE(token.has_value());
+      REQUIRE(token->getType() == keyword.type);
+    }
+  }
+
+  SECTION("Aliases and near misses") {
+    lexer::Lexer lex("int32 uint64 functional fun Func _if if_ interfaces");
+    auto tokens = tokenize(lex);
+
+    REQUIRE(tokens.size() == 8);
+    REQUIRE(tokens[0].getType() == lexer::TokenType::Int);
+    REQUIRE(tokens[1].getType() == lexer::TokenType::ULong);
+    for (size_t i = 2; i < tokens.size(); ++i) {
+      REQUIRE(tokens[i].getType() == lexer::TokenType::Identifier);
+    }
+  }
+}
+
+TEST_CASE("Lexer: Character classification", "[lexer]") {
+  REQUIRE(lexer::isIdentifierStart('_'));
+  REQUIRE(lexer::isIdentifierStart('Z'));
+  REQUIRE_FALSE(lexer::isIdentifierStart('7'));
+  REQUIRE(lexer::isIdentifierContinue('7'));
+  REQUIRE(lexer::isSpaceChar('\v'));
+  REQUIRE_FALSE(lexer::isAlphaChar(static_cast<char>(0xE4)));
+
+  lexer::Lexer lex("abc_1 23\t\r\nx");
+  auto tokens = tokenize(lex);
+  REQUIRE(tokens.size() == 3);
+  REQUIRE(tokens[0].getValue() == "abc_1");
+  REQUIRE(tokens[0].getColumn() == 1);
+  REQUIRE(tokens[1].getColumn() == 7);
+  REQUIRE(tokens[2].getLine() == 2);
+  REQUIRE(tokens[2].getColumn() == 1);
+}
+
+TEST_CASE("SimdScan: Kernels match scalar scanning", "[lexer][simd]") {
+  // 构造跨越多个 16/32 字节块的输入，目标字符出现在块内的不同偏移
+  for (size_t length = 0; length < 100; length += 7) {
+    for (size_t target = 0; target <= length; ++target) {
+      std::string spaces(length, ' ');
+      for (size_t i = 0; i < length; i += 5) {
+        spaces[i] = "\t\n\r\v\f"[i % 5];
+      }
+      if (target < length) {
+        spaces[target] = 'x';
+      }
+      REQUIRE(lexer::simd::skipWhitespace(spaces.data(), 0, length) == target);
+
+      std::string text(length, 'a');
+      if (target < length) {
+        text[target] = '"';
+      }
+      REQUIRE(lexer::simd::findByte(text.data(), 0, length, '"') == target);
+      REQUIRE(lexer::simd::findEitherByte(text.data(), 0, length, '\\', '"') ==
+              target);
+    }
+  }
+
+  std::string lines = "a\nbb\n\nccc" + std::string(70, 'd') + "\ne";
+  auto newlines = lexer::simd::countNewlines(lines.data(), 0, lines.size());
+  REQUIRE(newlines.count == 4);
+  REQUIRE(newlines.lastNewline == lines.size() - 2);
+  REQUIRE(lexer::simd::countNewlines(lines.data(), 6, 70).count == 0);
+}
+
+TEST_CASE("Lexer: Comments and strings keep positions", "[lexer][simd]") {
+  std::string longComment(100, '*');
+  std::string source = "/* block\n comment " + longComment + " */ a\n"
+                       "// line comment " + longComment + "\n"
+                       "  b \"str\\\"ing with \\\\ escapes " + longComment +
+                       "\" c\n"
+                       "\t\t   \n\n      d /* unterminated";
+  lexer::Lexer lex(source);
+  auto tokens = tokenize(lex);
+
+  REQUIRE(tokens.size() == 5);
+  REQUIRE(tokens[0].getValue() == "a");
+  REQUIRE(tokens[0].getLine() == 2);
+  REQUIRE(tokens[0].getColumn() == 114);
+  REQUIRE(tokens[1].getValue() == "b");
+  REQUIRE(tokens[1].getLine() == 4);
+  REQUIRE(tokens[1].getColumn() == 3);
+  REQUIRE(tokens[2].getType() == lexer::TokenType::StringLiteral);
+  REQUIRE(tokens[2].getValue().size() == 127);
+  REQUIRE(tokens[3].getValue() == "c");
+  REQUIRE(tokens[3].getColumn() == 133);
+  REQUIRE(tokens[4].getValue() == "d");
+  REQUIRE(tokens[4].getLine() == 7);
+  REQUIRE(tokens[4].getColumn() == 7);
+}
+
+TEST_CASE("SourceBuffer: Files are mapped without copying", "[lexer][source]") {
+  auto path = std::filesystem::temp_directory_path() / "c_hat_source_test.ch";
+  std::string text = "func main() -> int {\r\n  return 0;\r\n}\r\n";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+  }
+
+  SECTION("Mapped text matches the file byte for byte") {
+    auto buffer = lexer::SourceBuffer::fromFile(path);
+    REQUIRE(buffer != nullptr);
+    REQUIRE(buffer->getText() == text);
+    REQUIRE(buffer->getName() == path.string());
+  }
+
+  SECTION("Tokens view the mapped text") {
+    auto buffer = lexer::SourceBuffer::fromFile(path);
+    lexer::Lexer lex(buffer);
+    auto tokens = tokenize(lex);
+    REQUIRE(lex.getSourceBuffer() == buffer);
+
+    const char *begin = buffer->getText().data();
+    const char *end = begin + buffer->getSize();
+    REQUIRE(tokens.size() == 11);
+    REQUIRE(tokens[1].getValue() == "main");
+    REQUIRE(tokens[1].getValue().data() >= begin);
+    REQUIRE(tokens[1].getValue().data() < end);
+    REQUIRE(tokens[8].getValue() == "0");
+    REQUIRE(tokens[8].getLine() == 2);
+  }
+
+  SECTION("Empty and missing files") {
+    auto emptyPath = path;
+    emptyPath.replace_filename("c_hat_empty_test.ch");
+    { std::ofstream file(emptyPath, std::ios::binary); }
+    auto empty = lexer::SourceBuffer::fromFile(emptyPath);
+    REQUIRE(empty != nullptr);
+    REQUIRE(empty->getSize() == 0);
+    REQUIRE_FALSE(empty->isMapped());
+    std::filesystem::remove(emptyPath);
+
+    REQUIRE(lexer::SourceBuffer::fromFile(path.string() + ".missing") ==
+            nullptr);
+  }
+
+  SECTION("In-memory sources") {
+    auto buffer = lexer::SourceBuffer::fromString("int x;", "<test>");
+    REQUIRE(buffer->getText() == "int x;");
+    REQUIRE(buffer->getName() == "<test>");
+    REQUIRE_FALSE(buffer->isMapped());
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Lexer: Chunked input matches whole-buffer lexing",
+          "[lexer][chunked]") {
+  // 字符串、注释和数字跨越很小的块边界，逐个比较两种模式的结果
+  std::string text;
+  for (int i = 0; i < 200; i++) {
+    text += "// line comment " + std::to_string(i) + "\n";
+    text += "var value" + std::to_string(i) + " = 1.5e3 + 0x1F << 2;\n";
+    text += "/* block comment that is longer than one chunk of input, "
+            "spanning\n several lines */ var s = \"" +
+            std::string(100, 'a') + "\\n\";\n";
+    text += "a <<= b >>= c; x->y ... z != w;\r\n";
+  }
+  auto path = std::filesystem::temp_directory_path() / "c_hat_chunked_test.ch";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+  }
+
+  lexer::Lexer whole(text);
+  auto expected = tokenize(whole);
+  REQUIRE(expected.size() > 1000);
+
+  for (size_t chunkSize : {size_t(1), size_t(16), size_t(64), size_t(4096)}) {
+#ifdef _WIN32
+    int fd = _open(path.string().c_str(), _O_RDONLY | _O_BINARY);
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+#endif
+    REQUIRE(fd >= 0);
+    lexer::Lexer chunked(lexer::ChunkedInput{fd, chunkSize});
+    REQUIRE(chunked.getSourceBuffer() == nullptr);
+
+    // 分块模式下 Token 的文本只在下一次 nextToken 之前有效，逐个比较
+    size_t index = 0;
+    bool matches = true;
+    while (auto token = chunked.nextToken()) {
+      if (token->getType() == lexer::TokenType::EndOfFile) {
+        break;
+      }
+      if (index >= expected.size() ||
+          token->getType() != expected[index].getType() ||
+          token->getValue() != expected[index].getValue() ||
+          token->getLine() != expected[index].getLine() ||
+          token->getColumn() != expected[index].getColumn()) {
+        matches = false;
+        break;
+      }
+      index++;
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    INFO("chunk size " << chunkSize << ", token " << index);
+    REQUIRE(matches);
+    REQUIRE(index == expected.size());
+  }
+
+  std::filesystem::remove(path);
+}
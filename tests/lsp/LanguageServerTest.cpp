@@ -0,0 +1,274 @@
+// LanguageServerTest.cpp - 语言服务器（增量分析、悬停、跳转到定义和协议）
+#include "../src/lsp/Document.h"
+#include "../src/lsp/Json.h"
+#include "../src/lsp/LanguageServer.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+
+using namespace c_hat;
+
+static const std::string Source = "// 两数之和\n"
+                                  "func add(int a, int b) -> int {\n"
+                                  "    return a + b;\n"
+                                  "}\n"
+                                  "\n"
+                                  "func twice(int x) -> int {\n"
+                                  "    return add(x, x);\n"
+                                  "}\n"
+                                  "\n"
+                                  "func other(int n) -> int {\n"
+                                  "    return n;\n"
+                                  "}\n"
+                                  "\n"
+                                  "func main() -> int {\n"
+                                  "    var y = twice(2);\n"
+                                  "    return y;\n"
+                                  "}\n";
+
+// 把 from 替换为 to（from 在文档中第一次出现处）
+static lsp::UpdateStats replace(lsp::Document& document, const std::string& from,
+                                const std::string& to) {
+    size_t offset = document.getText().find(from);
+    REQUIRE(offset != std::string::npos);
+    lsp::Range range{document.positionAt(offset),
+                     document.positionAt(offset + from.size())};
+    document.edit(range, to);
+    return document.update();
+}
+
+// 文本中第一次出现 text 的位置
+static lsp::Position find(const lsp::Document& document, const std::string& text) {
+    size_t offset = document.getText().find(text);
+    REQUIRE(offset != std::string::npos);
+    return document.positionAt(offset);
+}
+
+static std::string frame(const std::string& content) {
+    return "Content-Length: " + std::to_string(content.size()) + "\r\n\r\n" + content;
+}
+
+TEST_CASE("Json: parsing and printing", "[lsp]") {
+    const auto value = lsp::Json::parse(
+        R"({"a": [1, 2.5, "x\né😀", true, null], "b": {"c": -3}})");
+    CHECK(value["a"].asArray().size() == 5);
+    CHECK(value["a"].asArray()[0].asInt() == 1);
+    CHECK(value["a"].asArray()[2].asString() == "x\n\xc3\xa9\xf0\x9f\x98\x80");
+    CHECK(value["b"]["c"].asInt() == -3);
+    CHECK(value["missing"]["deeper"].isNull());
+    CHECK(value.dump() ==
+          "{\"a\":[1,2.5,\"x\\n\xc3\xa9\xf0\x9f\x98\x80\",true,null],\"b\":{\"c\":-3}}");
+    CHECK(lsp::Json::parse(value.dump()) == value);
+    CHECK_THROWS_AS(lsp::Json::parse("{\"a\": }"), lsp::JsonError);
+    CHECK_THROWS_AS(lsp::Json::parse("[1, 2] 3"), lsp::JsonError);
+}
+
+TEST_CASE("Document: incremental analysis", "[lsp]") {
+    lsp::Document document(Source, nullptr);
+    auto stats = document.update();
+    CHECK(stats.declarations == 4);
+    CHECK(stats.reparsed == 4);
+    CHECK(stats.reanalyzed == 4);
+    CHECK(document.getDiagnostics().empty());
+
+    SECTION("Editing a function body re-analyzes only that body") {
+        stats = replace(document, "a + b", "b + a");
+        CHECK(stats.declarations == 4);
+        CHECK(stats.reparsed == 1);
+        CHECK(stats.reanalyzed == 1);
+        CHECK_FALSE(stats.signaturesChanged);
+        CHECK(document.getDiagnostics().empty());
+    }
+
+    SECTION("Changing a signature re-checks only its dependents") {
+        stats = replace(document, "int a, int b", "int a, int b, int c");
+        CHECK(stats.reparsed == 1);
+        CHECK(stats.signaturesChanged);
+        // add 本身和调用它的 twice，other 和 main 不受影响
+        CHECK(stats.reanalyzed == 2);
+    }
+
+    SECTION("Errors are reported at the offending identifier") {
+        replace(document, "return y;", "return z;");
+        auto diagnostics = document.getDiagnostics();
+        REQUIRE(diagnostics.size() == 1);
+        CHECK(diagnostics[0].message.find("z") != std::string::npos);
+        auto position = find(document, "z;");
+        CHECK(diagnostics[0].range.start.line == position.line);
+        CHECK(diagnostics[0].range.start.character == position.character);
+
+        replace(document, "return z;", "return y;");
+        CHECK(document.getDiagnostics().empty());
+    }
+
+    SECTION("Syntax errors are reported relative to the document") {
+        replace(document, "return n;", "return n +;");
+        auto diagnostics = document.getDiagnostics();
+        REQUIRE(diagnostics.size() == 1);
+        CHECK(diagnostics[0].range.start.line == 10);
+        CHECK(diagnostics[0].message.find(" at line ") == std::string::npos);
+
+        stats = replace(document, "return n +;", "return n;");
+        CHECK(stats.reparsed == 1);
+        CHECK(document.getDiagnostics().empty());
+    }
+
+    SECTION("Inserting and removing declarations") {
+        size_t end = document.getText().find("\nfunc main");
+        document.edit(lsp::Range{document.positionAt(end), document.positionAt(end)},
+                      "\nfunc extra() -> int {\n    return other(1);\n}\n");
+        stats = document.update();
+        CHECK(stats.declarations == 5);
+        // main 前的空白归入新的声明，main 的文本不变，沿用原来的解析结果
+        CHECK(stats.reparsed == 1);
+        CHECK(document.getDiagnostics().empty());
+
+        stats = replace(document, "func extra() -> int {\n    return other(1);\n}\n", "");
+        CHECK(stats.declarations == 4);
+        CHECK(document.getDiagnostics().empty());
+    }
+
+    SECTION("Text stays consistent after many small edits") {
+        for (char c : std::string("var t = 1; ")) {
+            size_t offset = document.getText().find("    return y;");
+            auto position = document.positionAt(offset);
+            document.edit(lsp::Range{position, position}, std::string(1, c));
+            document.update();
+        }
+        lsp::Document fresh(document.getText(), nullptr);
+        fresh.update();
+        CHECK(document.getDiagnostics().size() == fresh.getDiagnostics().size());
+        CHECK(document.getDiagnostics().empty());
+    }
+}
+
+TEST_CASE("Document: hover and go to definition", "[lsp]") {
+    lsp::Document document(Source, nullptr);
+    document.update();
+
+    auto call = find(document, "add(x, x)");
+    auto hover = document.hover(call);
+    REQUIRE(hover);
+    CHECK(hover->find("func add(int a, int b) -> int") != std::string::npos);
+    CHECK(hover->find("两数之和") != std::string::npos);
+
+    auto definition = document.definition(call);
+    REQUIRE(definition);
+    CHECK(definition->start.line == 1);
+    CHECK(definition->start.character == 5);
+
+    // 参数
+    auto use = find(document, "x, x)");
+    definition = document.definition(use);
+    REQUIRE(definition);
+    CHECK(definition->start == find(document, "x) -> int"));
+
+    // 局部变量
+    auto local = find(document, "y;");
+    hover = document.hover(local);
+    REQUIRE(hover);
+    CHECK(hover->find("var y = twice(2);") != std::string::npos);
+
+    CHECK_FALSE(document.hover(find(document, "return a")));
+    CHECK_FALSE(document.definition(lsp::Position{0, 3}));
+}
+
+TEST_CASE("Document: UTF-16 positions", "[lsp]") {
+    lsp::Document document("// é😀x\nfunc main() { }\n", nullptr);
+    // é 占一个 UTF-16 码元，😀 占两个
+    CHECK(document.offsetAt(lsp::Position{0, 3}) == 3);
+    CHECK(document.offsetAt(lsp::Position{0, 4}) == 5);
+    CHECK(document.offsetAt(lsp::Position{0, 6}) == 9);
+    CHECK(document.positionAt(9).character == 6);
+    CHECK(document.offsetAt(lsp::Position{0, 100}) == 10);
+    CHECK(document.offsetAt(lsp::Position{1, 0}) == 11);
+    CHECK(document.offsetAt(lsp::Position{5, 0}) == document.getText().size());
+}
+
+TEST_CASE("LanguageServer: protocol session", "[lsp]") {
+    lsp::Json open = lsp::Json::parse(
+        R"({"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":)"
+        R"({"uri":"file:///main.ch","languageId":"c_hat","version":1,"text":""}}})");
+    open["params"]["textDocument"]["text"] = Source;
+
+    std::string input =
+        frame(R"({"jsonrpc":"2.0","id":1,"method":"initialize","params":{}})") +
+        frame(R"({"jsonrpc":"2.0","method":"initialized","params":{}})") +
+        frame(open.dump()) +
+        frame(R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":{)"
+              R"("textDocument":{"uri":"file:///main.ch","version":2},"contentChanges":[)"
+              R"({"range":{"start":{"line":15,"character":11},"end":{"line":15,"character":12}},)"
+              R"("text":"z"}]}})") +
+        frame(R"({"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{)"
+              R"("textDocument":{"uri":"file:///main.ch"},"position":{"line":6,"character":12}}})") +
+        frame(R"({"jsonrpc":"2.0","id":3,"method":"textDocument/definition","params":{)"
+              R"("textDocument":{"uri":"file:///main.ch"},"position":{"line":6,"character":12}}})") +
+        frame(R"({"jsonrpc":"2.0","id":4,"method":"textDocument/unknown","params":{}})") +
+        frame("{not json") +
+        frame(R"({"jsonrpc":"2.0","id":5,"method":"shutdown"})") +
+        frame(R"({"jsonrpc":"2.0","method":"exit"})");
+
+    std::istringstream in(input);
+    std::ostringstream out;
+    lsp::LanguageServer server(in, out, nullptr);
+    CHECK(server.run() == 0);
+
+    // 按 Content-Length 拆分输出的消息
+    std::vector<lsp::Json> messages;
+    std::string output = out.str();
+    size_t position = 0;
+    while (position < output.size()) {
+        size_t header = output.find("\r\n\r\n", position);
+        REQUIRE(header != std::string::npos);
+        size_t length = std::stoul(output.substr(position + 16, header - position - 16));
+        messages.push_back(lsp::Json::parse(output.substr(header + 4, length)));
+        position = header + 4 + length;
+    }
+    REQUIRE(messages.size() == 8);
+
+    CHECK(messages[0]["id"].asInt() == 1);
+    CHECK(messages[0]["result"]["capabilities"]["textDocumentSync"]["change"].asInt() == 2);
+    CHECK(messages[0]["result"]["capabilities"]["hoverProvider"].asBool());
+
+    CHECK(messages[1]["method"].asString() == "textDocument/publishDiagnostics");
+    CHECK(messages[1]["params"]["diagnostics"].asArray().empty());
+    CHECK(messages[2]["params"]["diagnostics"].asArray().size() == 1);
+    CHECK(server.getLastUpdateStats().reparsed == 1);
+
+    CHECK(messages[3]["id"].asInt() == 2);
+    CHECK(messages[3]["result"]["contents"]["value"].asString().find("func add") !=
+          std::string::npos);
+    CHECK(messages[4]["result"]["range"]["start"]["line"].asInt() == 1);
+    CHECK(messages[5]["error"]["code"].asInt() == -32601);
+    CHECK(messages[6]["error"]["code"].asInt() == -32700);
+    CHECK(messages[7]["id"].asInt() == 5);
+    CHECK(messages[7]["result"].isNull());
+}
+
+TEST_CASE("LanguageServer: interned names are released", "[lsp]") {
+    lsp::Json open = lsp::Json::parse(
+        R"({"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":)"
+        R"({"uri":"file:///main.ch","languageId":"c_hat","version":1,"text":""}}})");
+    open["params"]["textDocument"]["text"] = Source;
+    lsp::Json hover = lsp::Json::parse(
+        R"({"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{)"
+        R"("textDocument":{"uri":"file:///main.ch"},"position":{"line":6,"character":12}}})");
+
+    std::istringstream in;
+    std::ostringstream out;
+    lsp::LanguageServer server(in, out, nullptr);
+    // 每条消息之前都清空驻留表，打开的文档重新分析
+    server.setNameResetThreshold(0);
+    CHECK(server.handleMessage(open));
+    auto &interner = lexer::NameInterner::global();
+    size_t names = interner.size();
+    REQUIRE(names > 0);
+
+    out.str("");
+    CHECK(server.handleMessage(hover));
+    CHECK(interner.size() == names);
+    std::string output = out.str();
+    lsp::Json response = lsp::Json::parse(output.substr(output.find("\r\n\r\n") + 4));
+    CHECK(response["result"]["contents"]["value"].asString().find("func add") !=
+          std::string::npos);
+}
@@ -1,8 +1,19 @@
 // ModuleTest.cpp - 模块系统设计 (docs/design/模块系统设计.md)
 #include "../src/parser/Parser.h"
+#include "../src/semantic/AstCache.h"
+#include "../src/semantic/BuildDatabase.h"
+#include "../src/semantic/ModuleIndex.h"
+#include "../src/semantic/ModuleInterface.h"
 #include "../src/semantic/SemanticAnalyzer.h"
+#include "../TestUtils.h"
 #include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace c_hat;
 
@@ -80,3 +91,929 @@ TEST_CASE("Module: public export", "[module][semantic]") {
             "func main() { }") == true);
     }
 }
+
+// ─────────────────────────────────────────────
+// 4. 导入模块的函数体延迟解析
+// ─────────────────────────────────────────────
+TEST_CASE("Module: imported function bodies are parsed lazily", "[module][skim]") {
+    auto dir = uniqueTempDir("c_hat_module_test");
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream file(dir / "mathlib.ch", std::ios::binary);
+        file << "module mathlib;\n"
+                "public func square(int x) -> int { return x * x; }\n"
+                "public class Counter {\n"
+                "    public int n;\n"
+                "    public void tick() { n = n + 1; }\n"
+                "}\n";
+    }
+
+    SECTION("ModuleLoader skims bodies") {
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        auto program = loader.loadModule({"mathlib"});
+        REQUIRE(program != nullptr);
+
+        ast::FunctionDecl* square = nullptr;
+        for (auto& decl : program->declarations) {
+            if (auto* func = dynamic_cast<ast::FunctionDecl*>(decl.get())) {
+                square = func;
+            }
+        }
+        REQUIRE(square != nullptr);
+        REQUIRE(square->hasLazyBody());
+        REQUIRE(square->materializeBody() != nullptr);
+    }
+
+    SECTION("Importing analyzes only the interface") {
+        parser::Parser p("import mathlib;\nfunc main() { }\n");
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.analyze(*prog);
+        CHECK_FALSE(analyzer.hasError());
+    }
+
+    SECTION("Body errors are reported when the module itself is compiled") {
+        {
+            std::ofstream file(dir / "broken.ch", std::ios::binary);
+            file << "module broken;\n"
+                    "public func value() -> int { return missing; }\n";
+        }
+        parser::Parser importer("import broken;\nfunc main() { }\n");
+        auto prog = importer.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.analyze(*prog);
+        CHECK_FALSE(analyzer.hasError());
+
+        parser::Parser unit("module broken;\n"
+                            "public func value() -> int { return missing; }\n");
+        auto module = unit.parseProgram();
+        semantic::SemanticAnalyzer moduleAnalyzer("", false);
+        moduleAnalyzer.analyze(*module);
+        CHECK(moduleAnalyzer.hasError());
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 5. 预编译模块接口
+// ─────────────────────────────────────────────
+// 导入模块，返回导入方得到的模块接口
+static std::shared_ptr<const semantic::ModuleInterface>
+importModule(const std::filesystem::path& dir, const std::string& cacheDir = "") {
+    parser::Parser p("import shapes;\nfunc main() { }\n");
+    auto prog = p.parseProgram();
+    semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+    analyzer.setModuleInterfaceCacheDir(cacheDir);
+    analyzer.analyze(*prog);
+    auto* module = analyzer.getModuleGraph()->findModule({"shapes"});
+    return module ? module->interface : nullptr;
+}
+
+static std::shared_ptr<semantic::Symbol>
+findExported(const semantic::ModuleInterface& interface, const std::string& name) {
+    for (const auto& symbol : interface.getSymbols()) {
+        if (symbol->getName() == name) {
+            return symbol;
+        }
+    }
+    return nullptr;
+}
+
+TEST_CASE("Module: precompiled module interfaces", "[module][interface]") {
+    auto dir = std::filesystem::temp_directory_path() / "c_hat_interface_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string source =
+        "module shapes;\n"
+        "public class Point {\n"
+        "    public int x;\n"
+        "    public Point^ next;\n"
+        "}\n"
+        "public func area(int w, int h) -> int { return w * h; }\n"
+        "public func identity<T>(T x) -> T { return x; }\n"
+        "func helper() -> int { return 1; }\n"
+        "extension int {\n"
+        "    func twice() -> int { return self * 2; }\n"
+        "}\n";
+    {
+        std::ofstream file(dir / "shapes.ch", std::ios::binary);
+        file << source;
+    }
+    auto cacheDir = dir / "cache";
+
+    SECTION("Analyzing a module writes its public interface") {
+        auto interface = importModule(dir, cacheDir.string());
+        REQUIRE(interface != nullptr);
+        REQUIRE(std::filesystem::exists(cacheDir / "shapes.chi"));
+
+        auto loaded = semantic::ModuleInterface::readFile(
+            cacheDir / "shapes.chi", semantic::hashSourceContent(source));
+        REQUIRE(loaded != nullptr);
+        CHECK(loaded->getModulePath() == std::vector<std::string>{"shapes"});
+        CHECK(loaded->getSymbols().size() == interface->getSymbols().size());
+        CHECK(findExported(*loaded, "helper") == nullptr);
+
+        auto area = std::dynamic_pointer_cast<semantic::FunctionSymbol>(
+            findExported(*loaded, "area"));
+        REQUIRE(area != nullptr);
+        REQUIRE(area->getType() != nullptr);
+        CHECK(area->getType()->getParameterTypes().size() == 2);
+        CHECK(area->getType()->getReturnType()->toString() == "int");
+
+        auto identity = std::dynamic_pointer_cast<semantic::FunctionSymbol>(
+            findExported(*loaded, "identity"));
+        REQUIRE(identity != nullptr);
+        CHECK(identity->isTemplate());
+        CHECK(identity->getTemplateParamNames() == std::vector<std::string>{"T"});
+
+        // 自引用的类恢复后仍指向同一个类型对象
+        auto point = std::dynamic_pointer_cast<semantic::ClassSymbol>(
+            findExported(*loaded, "Point"));
+        REQUIRE(point != nullptr);
+        auto pointType = std::dynamic_pointer_cast<types::ClassType>(point->getType());
+        REQUIRE(pointType != nullptr);
+        REQUIRE(pointType->hasField("next"));
+        auto next = std::dynamic_pointer_cast<types::PointerType>(
+            pointType->getFieldType("next"));
+        REQUIRE(next != nullptr);
+        CHECK(next->getPointeeType() == pointType);
+
+        REQUIRE(loaded->getExtensions().size() == 1);
+        CHECK(loaded->getExtensions()[0].members.size() == 1);
+        CHECK(loaded->getExtensions()[0].members[0].name == "twice");
+    }
+
+    SECTION("Later imports load the interface instead of the source") {
+        REQUIRE(importModule(dir, cacheDir.string()) != nullptr);
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setInterfaceCacheDir(cacheDir.string());
+        REQUIRE(loader.loadInterface({"shapes"}) != nullptr);
+        CHECK(loader.isModuleLoaded({"shapes"}));
+
+        auto again = importModule(dir, cacheDir.string());
+        REQUIRE(again != nullptr);
+        CHECK(findExported(*again, "area") != nullptr);
+    }
+
+    SECTION("Editing the source invalidates the interface") {
+        REQUIRE(importModule(dir, cacheDir.string()) != nullptr);
+        {
+            std::ofstream file(dir / "shapes.ch", std::ios::binary | std::ios::app);
+            file << "public func extra() -> int { return 0; }\n";
+        }
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setInterfaceCacheDir(cacheDir.string());
+        CHECK(loader.loadInterface({"shapes"}) == nullptr);
+        CHECK_FALSE(loader.isModuleLoaded({"shapes"}));
+
+        auto updated = importModule(dir, cacheDir.string());
+        REQUIRE(updated != nullptr);
+        CHECK(findExported(*updated, "extra") != nullptr);
+    }
+
+    SECTION("Without a cache directory no interface is written") {
+        REQUIRE(importModule(dir) != nullptr);
+        CHECK_FALSE(std::filesystem::exists(dir / "shapes.chi"));
+        CHECK_FALSE(std::filesystem::exists(cacheDir));
+
+        REQUIRE(importModule(dir, cacheDir.string()) != nullptr);
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        CHECK(loader.loadInterface({"shapes"}) == nullptr);
+    }
+
+    SECTION("Modules with errors do not write an interface") {
+        {
+            std::ofstream file(dir / "faulty.ch", std::ios::binary);
+            file << "module faulty;\n"
+                    "public int value = missing;\n";
+        }
+        parser::Parser p("import faulty;\nfunc main() { }\n");
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.setModuleInterfaceCacheDir(cacheDir.string());
+        analyzer.analyze(*prog);
+        auto* faulty = analyzer.getModuleGraph()->findModule({"faulty"});
+        REQUIRE(faulty != nullptr);
+        CHECK(faulty->interface != nullptr);
+        CHECK_FALSE(std::filesystem::exists(cacheDir / "faulty.chi"));
+    }
+
+    SECTION("Truncated or stale data is rejected") {
+        auto interface = importModule(dir);
+        REQUIRE(interface != nullptr);
+        std::string data = interface->serialize();
+        REQUIRE_FALSE(data.empty());
+        uint64_t hash = interface->getSourceHash();
+        REQUIRE(semantic::ModuleInterface::deserialize(data, hash) != nullptr);
+        CHECK(semantic::ModuleInterface::deserialize(data, hash + 1) == nullptr);
+
+        bool anyAccepted = false;
+        for (size_t size = 0; size < data.size(); ++size) {
+            auto prefix = std::string_view(data).substr(0, size);
+            if (semantic::ModuleInterface::deserialize(prefix, hash)) {
+                anyAccepted = true;
+            }
+        }
+        CHECK_FALSE(anyAccepted);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 6. 导入模块的 AST 缓存
+// ─────────────────────────────────────────────
+static std::string firstFunctionName(const ast::Program& program) {
+    for (const auto& decl : program.declarations) {
+        if (auto* func = dynamic_cast<ast::FunctionDecl*>(decl.get())) {
+            return func->name;
+        }
+    }
+    return "";
+}
+
+TEST_CASE("Module: cached module ASTs", "[module][ast_cache]") {
+    auto dir = uniqueTempDir("c_hat_ast_cache_test");
+    std::filesystem::create_directories(dir);
+    std::string source =
+        "module geometry;\n"
+        "public func area(int w, int h) -> int { return w * h; }\n";
+    {
+        std::ofstream file(dir / "geometry.ch", std::ios::binary);
+        file << source;
+    }
+    auto cacheDir = dir / "cache";
+    semantic::AstCache cache(cacheDir);
+    uint64_t hash = semantic::hashSourceContent(source);
+
+    SECTION("Parsing a module writes a cache entry") {
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setAstCacheDir(cacheDir.string());
+        REQUIRE(loader.loadModule({"geometry"}) != nullptr);
+        REQUIRE(std::filesystem::exists(cache.entryPath(hash)));
+
+        auto cached = cache.load(hash);
+        REQUIRE(cached != nullptr);
+        CHECK(firstFunctionName(*cached) == "area");
+        CHECK(cache.load(hash + 1) == nullptr);
+
+#if defined(__unix__) || defined(__APPLE__)
+        auto perms = std::filesystem::status(cacheDir).permissions();
+        CHECK((perms & std::filesystem::perms::all) ==
+              std::filesystem::perms::owner_all);
+#endif
+    }
+
+    SECTION("Skimmed bodies are stored unparsed and parsed on demand") {
+        // 函数体有语法错误也照样写入缓存，错误留到解析函数体时报告
+        parser::Parser p("func good() -> int { return 1; }\n"
+                         "func bad() -> int { return 1 +; }\n");
+        p.setSkimFunctionBodies(true);
+        auto skimmed = p.parseProgram();
+        REQUIRE(cache.store(hash, *skimmed));
+
+        auto cached = cache.load(hash);
+        REQUIRE(cached != nullptr);
+        REQUIRE(cached->declarations.size() == 2);
+        auto* good =
+            dynamic_cast<ast::FunctionDecl*>(cached->declarations[0].get());
+        auto* bad =
+            dynamic_cast<ast::FunctionDecl*>(cached->declarations[1].get());
+        REQUIRE(good != nullptr);
+        REQUIRE(bad != nullptr);
+        CHECK(good->hasLazyBody());
+        CHECK(bad->hasLazyBody());
+        CHECK(good->materializeBody() != nullptr);
+        CHECK_THROWS(bad->materializeBody());
+    }
+
+    SECTION("Without a cache directory nothing is cached") {
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        REQUIRE(loader.loadModule({"geometry"}) != nullptr);
+        CHECK_FALSE(std::filesystem::exists(cacheDir));
+    }
+
+    SECTION("Pruning removes the least recently used entries") {
+        parser::Parser p("func other() -> int { return 0; }\n");
+        auto other = p.parseProgram();
+        REQUIRE(cache.store(hash, *other));
+        REQUIRE(cache.store(hash + 1, *other));
+        auto old = std::filesystem::file_time_type::clock::now() -
+                   std::chrono::hours(1);
+        std::filesystem::last_write_time(cache.entryPath(hash + 1), old);
+        auto entrySize = std::filesystem::file_size(cache.entryPath(hash));
+
+        cache.prune(entrySize);
+        CHECK(std::filesystem::exists(cache.entryPath(hash)));
+        CHECK_FALSE(std::filesystem::exists(cache.entryPath(hash + 1)));
+
+        cache.prune(0);
+        CHECK_FALSE(std::filesystem::exists(cache.entryPath(hash)));
+    }
+
+    SECTION("Unchanged modules deserialize instead of re-parsing") {
+        // 缓存项只按内容寻址：放入另一棵 AST，命中时得到的就是它
+        parser::Parser p("func other() -> int { return 0; }\n");
+        auto other = p.parseProgram();
+        REQUIRE(cache.store(hash, *other));
+
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setAstCacheDir(cacheDir.string());
+        auto program = loader.loadModule({"geometry"});
+        REQUIRE(program != nullptr);
+        CHECK(firstFunctionName(*program) == "other");
+        auto* func = dynamic_cast<ast::FunctionDecl*>(program->declarations[0].get());
+        REQUIRE(func != nullptr);
+        CHECK(func->hasLazyBody());
+        CHECK(func->materializeBody() != nullptr);
+    }
+
+    SECTION("The cache can be disabled") {
+        parser::Parser p("func other() -> int { return 0; }\n");
+        auto other = p.parseProgram();
+        REQUIRE(cache.store(hash, *other));
+
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setAstCacheDir(cacheDir.string());
+        loader.setAstCacheEnabled(false);
+        auto program = loader.loadModule({"geometry"});
+        REQUIRE(program != nullptr);
+        CHECK(firstFunctionName(*program) == "area");
+    }
+
+    SECTION("Corrupt entries fall back to parsing") {
+        std::filesystem::create_directories(cacheDir);
+        {
+            std::ofstream file(cache.entryPath(hash), std::ios::binary);
+            file << "CHA";
+        }
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setAstCacheDir(cacheDir.string());
+        auto program = loader.loadModule({"geometry"});
+        REQUIRE(program != nullptr);
+        CHECK(firstFunctionName(*program) == "area");
+        CHECK(cache.load(hash) != nullptr);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("A cache directory other users can write to is not used") {
+        parser::Parser p("func other() -> int { return 0; }\n");
+        auto other = p.parseProgram();
+        REQUIRE(cache.store(hash, *other));
+
+        // 组和其他用户可以写入时，读写都跳过缓存
+        std::filesystem::permissions(cacheDir, std::filesystem::perms::group_write,
+                                     std::filesystem::perm_options::add);
+        CHECK(cache.load(hash) == nullptr);
+        CHECK_FALSE(cache.store(hash + 1, *other));
+        CHECK_FALSE(std::filesystem::exists(cache.entryPath(hash + 1)));
+
+        semantic::ModuleLoader loader(std::vector<std::string>{dir.string()});
+        loader.setAstCacheDir(cacheDir.string());
+        auto program = loader.loadModule({"geometry"});
+        REQUIRE(program != nullptr);
+        CHECK(firstFunctionName(*program) == "area");
+
+        std::filesystem::permissions(cacheDir, std::filesystem::perms::owner_all,
+                                     std::filesystem::perm_options::replace);
+        CHECK(cache.load(hash) != nullptr);
+    }
+#endif
+
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 7. 模块图
+// ─────────────────────────────────────────────
+static void writeModule(const std::filesystem::path& dir, const std::string& name,
+                        const std::string& source) {
+    std::ofstream file(dir / (name + ".ch"), std::ios::binary);
+    file << source;
+}
+
+TEST_CASE("Module: shared module graph", "[module][graph]") {
+    auto dir = std::filesystem::temp_directory_path() / "c_hat_module_graph_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // 菱形导入：main → left、right，left → common，right → common
+    writeModule(dir, "common",
+                "module common;\npublic func commonValue() -> int { return 1; }\n");
+    writeModule(dir, "left",
+                "module left;\nimport common;\n"
+                "public func leftValue() -> int { return 2; }\n");
+    writeModule(dir, "right",
+                "module right;\nimport common;\n"
+                "public func rightValue() -> int { return 3; }\n");
+    std::string mainSource = "import left;\nimport right;\nfunc main() { }\n";
+
+    SECTION("Diamond imports analyze each module once") {
+        parser::Parser p(mainSource);
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.analyze(*prog);
+        CHECK_FALSE(analyzer.hasError());
+
+        auto* graph = analyzer.getModuleGraph();
+        REQUIRE(graph != nullptr);
+        CHECK(graph->getModuleCount() == 3);
+        CHECK(graph->getAnalyzedCount() == 3);
+
+        auto* common = graph->findModule({"common"});
+        auto* left = graph->findModule({"left"});
+        auto* right = graph->findModule({"right"});
+        REQUIRE(common != nullptr);
+        REQUIRE(left != nullptr);
+        REQUIRE(right != nullptr);
+        CHECK(graph->getRoots() == std::vector<semantic::ModuleGraph::Module*>{left, right});
+        CHECK(left->dependencies == std::vector<semantic::ModuleGraph::Module*>{common});
+        CHECK(right->dependencies == std::vector<semantic::ModuleGraph::Module*>{common});
+        CHECK(common->dependencies.empty());
+
+        // 模块的语法树、符号表和接口由模块图持有，所有导入方共享
+        REQUIRE(common->program != nullptr);
+        REQUIRE(common->analyzer != nullptr);
+        CHECK(common->analyzer->getSymbolTable().lookupSymbol("commonValue") != nullptr);
+        REQUIRE(common->interface != nullptr);
+        CHECK(findExported(*common->interface, "commonValue") != nullptr);
+        CHECK(left->interface->getImports() ==
+              std::vector<std::vector<std::string>>{{"common"}});
+    }
+
+    SECTION("Dependency edges survive loading precompiled interfaces") {
+        auto cacheDir = (dir / "cache").string();
+        {
+            parser::Parser p(mainSource);
+            auto prog = p.parseProgram();
+            semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+            analyzer.setModuleInterfaceCacheDir(cacheDir);
+            analyzer.analyze(*prog);
+        }
+        parser::Parser p(mainSource);
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.setModuleInterfaceCacheDir(cacheDir);
+        analyzer.analyze(*prog);
+
+        auto* graph = analyzer.getModuleGraph();
+        CHECK(graph->getAnalyzedCount() == 0);
+        CHECK(graph->getModuleCount() == 3);
+        auto* left = graph->findModule({"left"});
+        REQUIRE(left != nullptr);
+        CHECK(left->program == nullptr);
+        REQUIRE(left->dependencies.size() == 1);
+        CHECK(left->dependencies[0] == graph->findModule({"common"}));
+    }
+
+    SECTION("Interfaces of importers are rejected when an import changed") {
+        auto cacheDir = (dir / "cache").string();
+        auto analyzedCount = [&] {
+            parser::Parser p(mainSource);
+            auto prog = p.parseProgram();
+            semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+            analyzer.setModuleInterfaceCacheDir(cacheDir);
+            analyzer.analyze(*prog);
+            CHECK_FALSE(analyzer.hasError());
+            return analyzer.getModuleGraph()->getAnalyzedCount();
+        };
+        REQUIRE(analyzedCount() == 3);
+
+        // 只改函数体：接口哈希不变，导入方的接口仍然有效
+        writeModule(dir, "common",
+                    "module common;\npublic func commonValue() -> int { return 7; }\n");
+        CHECK(analyzedCount() == 1);
+
+        // 改接口：left 和 right 的源码没变，但记录的 common 接口哈希已过期
+        writeModule(dir, "common",
+                    "module common;\npublic func commonValue() -> int { return 7; }\n"
+                    "public func commonOther() -> int { return 8; }\n");
+        CHECK(analyzedCount() == 3);
+        CHECK(analyzedCount() == 0);
+    }
+
+    SECTION("Loaders notice edited module sources") {
+        parser::Parser p(mainSource);
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.analyze(*prog);
+        auto& loader = analyzer.getModuleGraph()->getLoader();
+        CHECK(loader.isUpToDate());
+
+        writeModule(dir, "common",
+                    "module common;\npublic func commonValue() -> int { return 2; }\n");
+        CHECK_FALSE(loader.isUpToDate());
+    }
+
+    SECTION("Circular imports are reported") {
+        writeModule(dir, "ping", "module ping;\nimport pong;\n");
+        writeModule(dir, "pong", "module pong;\nimport ping;\n");
+        parser::Parser p("import ping;\nfunc main() { }\n");
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        CHECK_THROWS(analyzer.analyze(*prog));
+
+        // 失败的模块留在图中，再次导入时重新抛出同一个错误
+        auto* graph = analyzer.getModuleGraph();
+        auto* ping = graph->findModule({"ping"});
+        REQUIRE(ping != nullptr);
+        CHECK(ping->error != nullptr);
+        CHECK_THROWS(graph->import(nullptr, {"ping"}));
+        CHECK(graph->findModule({"ping"}) == ping);
+
+        // 修正之后移出失败的模块，再次导入时重新加载
+        writeModule(dir, "pong", "module pong;\n");
+        graph->dropFailedModules();
+        CHECK(graph->findModule({"ping"}) == nullptr);
+        auto* reloaded = graph->import(nullptr, {"ping"});
+        CHECK(reloaded->program != nullptr);
+        REQUIRE(reloaded->dependencies.size() == 1);
+        CHECK(reloaded->dependencies[0]->name == "pong");
+    }
+
+    SECTION("Clearing the graph reloads every module") {
+        writeModule(dir, "ping", "module ping;\nimport pong;\n");
+        writeModule(dir, "pong", "module pong;\n");
+        semantic::ModuleGraph graph(std::make_unique<semantic::ModuleLoader>(
+            std::vector<std::string>{dir.string()}));
+        REQUIRE(graph.import(nullptr, {"ping"})->program != nullptr);
+        CHECK(graph.getModuleCount() == 2);
+
+        graph.clear();
+        CHECK(graph.getModuleCount() == 0);
+        CHECK(graph.findModule({"ping"}) == nullptr);
+        auto* reloaded = graph.import(nullptr, {"ping"});
+        CHECK(reloaded->program != nullptr);
+        REQUIRE(reloaded->dependencies.size() == 1);
+        CHECK(reloaded->dependencies[0]->name == "pong");
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 8. 并行加载模块
+// ─────────────────────────────────────────────
+static std::unique_ptr<semantic::SemanticAnalyzer>
+analyzeWithJobs(const std::filesystem::path& dir, ast::Program& program, size_t jobs) {
+    auto analyzer = std::make_unique<semantic::SemanticAnalyzer>(
+        std::vector<std::string>{dir.string()});
+    analyzer->setModuleInterfaceCacheDir((dir / "cache").string());
+    analyzer->setAstCacheEnabled(false);
+    analyzer->setModuleJobs(jobs);
+    analyzer->analyze(program);
+    return analyzer;
+}
+
+TEST_CASE("Module: parallel module loading", "[module][graph]") {
+    auto dir = std::filesystem::temp_directory_path() / "c_hat_module_parallel_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // 宽项目：main 导入 m0..m7，每个 mi 导入 common，奇数模块还在类中导入 m0
+    writeModule(dir, "common",
+                "module common;\npublic func commonValue() -> int { return 1; }\n");
+    std::string mainSource;
+    for (int i = 0; i < 8; ++i) {
+        std::string name = "m" + std::to_string(i);
+        std::string source = "module " + name + ";\nimport common;\n";
+        if (i % 2 == 1) {
+            source += "public class C" + name + " {\n    import m0;\n}\n";
+        }
+        source += "public func " + name + "Value() -> int { return " +
+                  std::to_string(i) + "; }\n";
+        writeModule(dir, name, source);
+        mainSource += "import " + name + ";\n";
+    }
+    mainSource += "func main() { }\n";
+
+    SECTION("Independent modules are analyzed once, with the same graph") {
+        parser::Parser p(mainSource);
+        auto prog = p.parseProgram();
+        auto analyzer = analyzeWithJobs(dir, *prog, 4);
+        CHECK_FALSE(analyzer->hasError());
+
+        auto* graph = analyzer->getModuleGraph();
+        CHECK(graph->getModuleCount() == 9);
+        CHECK(graph->getAnalyzedCount() == 9);
+
+        // 导入边与逐个加载时一致
+        auto* common = graph->findModule({"common"});
+        auto* m0 = graph->findModule({"m0"});
+        REQUIRE(graph->getRoots().size() == 8);
+        for (int i = 0; i < 8; ++i) {
+            auto* module = graph->findModule({"m" + std::to_string(i)});
+            REQUIRE(module != nullptr);
+            CHECK(graph->getRoots()[i] == module);
+            CHECK_FALSE(module->loading);
+            REQUIRE(module->interface != nullptr);
+            CHECK(findExported(*module->interface,
+                               "m" + std::to_string(i) + "Value") != nullptr);
+            if (i % 2 == 1) {
+                CHECK(module->dependencies ==
+                      std::vector<semantic::ModuleGraph::Module*>{common, m0});
+            } else {
+                CHECK(module->dependencies ==
+                      std::vector<semantic::ModuleGraph::Module*>{common});
+            }
+        }
+    }
+
+    SECTION("Precompiled interfaces are loaded in parallel") {
+        {
+            parser::Parser p(mainSource);
+            auto prog = p.parseProgram();
+            analyzeWithJobs(dir, *prog, 1);
+        }
+        parser::Parser p(mainSource);
+        auto prog = p.parseProgram();
+        auto analyzer = analyzeWithJobs(dir, *prog, 4);
+        auto* graph = analyzer->getModuleGraph();
+        CHECK(graph->getAnalyzedCount() == 0);
+        CHECK(graph->getModuleCount() == 9);
+        auto* m1 = graph->findModule({"m1"});
+        REQUIRE(m1 != nullptr);
+        CHECK(m1->dependencies.size() == 2);
+    }
+
+    SECTION("Circular imports are reported") {
+        writeModule(dir, "ping", "module ping;\nimport pong;\n");
+        writeModule(dir, "pong", "module pong;\nimport ping;\n");
+        parser::Parser p("import m0;\nimport ping;\nfunc main() { }\n");
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.setModuleJobs(4);
+        CHECK_THROWS(analyzer.analyze(*prog));
+        CHECK(analyzer.getModuleGraph()->findModule({"ping"})->error != nullptr);
+        CHECK(analyzer.getModuleGraph()->findModule({"m0"})->error == nullptr);
+    }
+
+    SECTION("Loading errors propagate to importers") {
+        writeModule(dir, "broken", "module broken;\nimport missing;\n");
+        parser::Parser p("import m1;\nimport broken;\nfunc main() { }\n");
+        auto prog = p.parseProgram();
+        semantic::SemanticAnalyzer analyzer(std::vector<std::string>{dir.string()});
+        analyzer.setModuleJobs(4);
+        CHECK_THROWS(analyzer.analyze(*prog));
+        CHECK(analyzer.getModuleGraph()->findModule({"broken"})->error != nullptr);
+        CHECK(analyzer.getModuleGraph()->findModule({"missing"})->error != nullptr);
+    }
+
+    SECTION("Translation units importing a broken module all see the error") {
+        writeModule(dir, "broken", "module broken;\nimport missing;\n");
+        semantic::ModuleGraph graph(std::make_unique<semantic::ModuleLoader>(
+            std::vector<std::string>{dir.string()}));
+        graph.setJobs(4);
+        std::atomic<int> failures = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&] {
+                try {
+                    graph.import(nullptr, {"broken"});
+                } catch (const std::exception&) {
+                    ++failures;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(failures == 8);
+        CHECK(graph.getModuleCount() == 2);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Module: concurrent atomic writes", "[module][graph]") {
+    auto dir = uniqueTempDir("c_hat_atomic_write_test");
+    auto path = dir / "entry.chi";
+    // 多个写入方同时写同一项，结果是其中某一次的完整内容，不留临时文件
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 8; ++i) {
+        writers.emplace_back([&path, i] {
+            std::string data(4096, static_cast<char>('a' + i));
+            for (int j = 0; j < 50; ++j) {
+                CHECK(semantic::writeFileAtomically(path, data));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    REQUIRE(content.size() == 4096);
+    CHECK(content == std::string(4096, content[0]));
+    size_t files = 0;
+    for ([[maybe_unused]] const auto& entry :
+         std::filesystem::directory_iterator(dir)) {
+        ++files;
+    }
+    CHECK(files == 1);
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 9. 模块搜索路径索引
+// ─────────────────────────────────────────────
+TEST_CASE("Module: search path index", "[module][index]") {
+    auto dir = std::filesystem::temp_directory_path() / "c_hat_module_index_test";
+    std::filesystem::remove_all(dir);
+    auto first = dir / "first";
+    auto second = dir / "second";
+    std::filesystem::create_directories(first / "pkg");
+    std::filesystem::create_directories(first / "both");
+    std::filesystem::create_directories(second / "pkg");
+    std::filesystem::create_directories(first / ".hidden");
+    writeModule(first, "alpha", "module alpha;\n");
+    writeModule(first / "pkg", "mod", "module pkg;\n");
+    writeModule(first / "pkg", "util", "module pkg.util;\n");
+    writeModule(first, "both", "module both;\n");
+    writeModule(first / "both", "mod", "module both;\n");
+    writeModule(first / ".hidden", "secret", "module secret;\n");
+    writeModule(first, "dotted.name", "module dotted;\n");
+    writeModule(second, "alpha", "module alpha;\n");
+    writeModule(second, "beta", "module beta;\n");
+    writeModule(second / "pkg", "extra", "module pkg.extra;\n");
+
+    SECTION("Modules resolve with the probing priority") {
+        semantic::ModuleIndex index({first, second});
+        CHECK(index.size() == 6);
+        REQUIRE(index.find("alpha") != nullptr);
+        CHECK(index.find("alpha")->file == first / "alpha.ch");
+        CHECK(index.find("beta")->file == second / "beta.ch");
+        CHECK(index.find("pkg")->file == first / "pkg" / "mod.ch");
+        CHECK(index.find("pkg.util")->file == first / "pkg" / "util.ch");
+        CHECK(index.find("pkg.extra")->file == second / "pkg" / "extra.ch");
+        CHECK(index.find("both")->file == first / "both.ch");
+        CHECK(index.find("secret") == nullptr);
+        CHECK(index.find("dotted.name") == nullptr);
+        CHECK(index.find("missing") == nullptr);
+        CHECK(index.isUpToDate());
+
+        writeModule(second / "pkg", "added", "module pkg.added;\n");
+        CHECK_FALSE(index.isUpToDate());
+    }
+
+    SECTION("Indexes are cached per process and rebuilt when stale") {
+        auto index = semantic::ModuleIndex::get({first, second});
+        CHECK(semantic::ModuleIndex::get({first, second}) == index);
+
+        writeModule(first, "gamma", "module gamma;\n");
+        auto rebuilt = semantic::ModuleIndex::get({first, second});
+        CHECK(rebuilt != index);
+        CHECK(rebuilt->find("gamma") != nullptr);
+    }
+
+    SECTION("Indexes persist across processes") {
+        auto indexFile = dir / "cache" / "modules.chx";
+        semantic::ModuleIndex index({first, second});
+        REQUIRE(index.writeFile(indexFile));
+
+        auto loaded = semantic::ModuleIndex::readFile(indexFile);
+        REQUIRE(loaded != nullptr);
+        CHECK(loaded->getRoots() == index.getRoots());
+        CHECK(loaded->size() == index.size());
+        CHECK(loaded->find("pkg.util")->file == first / "pkg" / "util.ch");
+        CHECK(loaded->isUpToDate());
+
+        // 损坏的索引文件视为不存在
+        {
+            std::ofstream file(indexFile, std::ios::binary | std::ios::trunc);
+            file << "CHX";
+        }
+        CHECK(semantic::ModuleIndex::readFile(indexFile) == nullptr);
+    }
+
+    SECTION("Writing caches and build output inside a search path does not rescan") {
+        auto cache = first / "cache";
+        auto build = first / "build";
+        std::filesystem::create_directories(build);
+        std::filesystem::create_directories(first / "docs");
+        std::filesystem::create_directories(cache);
+        writeModule(cache, "cached", "module cache.cached;\n");
+        auto indexFile = cache / "modules.chx";
+
+        auto index = semantic::ModuleIndex::get({first, second}, indexFile, {cache, build});
+        CHECK(index->find("cache.cached") == nullptr);
+        CHECK(index->find("pkg.util") != nullptr);
+        // 两个搜索路径和 first/pkg、first/both、second/pkg
+        CHECK(index->getDirectoryCount() == 5);
+
+        // 一次构建写入的接口、AST 缓存和目标文件，以及不含模块的目录中的文件
+        std::filesystem::create_directories(cache / "ast-cache");
+        std::ofstream(cache / "ast-cache" / "entry.cha") << "ast";
+        std::ofstream(cache / "pkg.util.chi") << "interface";
+        std::ofstream(build / "main.o") << "object";
+        std::ofstream(first / "docs" / "notes.txt") << "notes";
+
+        CHECK(index->isUpToDate());
+        CHECK(semantic::ModuleIndex::get({first, second}, indexFile, {cache, build}) == index);
+        auto saved = semantic::ModuleIndex::readFile(indexFile);
+        REQUIRE(saved != nullptr);
+        CHECK(saved->isUpToDate());
+    }
+
+    SECTION("The module loader resolves imports through the index") {
+        semantic::ModuleLoader loader(
+            std::vector<std::string>{first.string(), second.string()});
+        CHECK(loader.getModuleIndex()->find("beta") != nullptr);
+        auto program = loader.loadModule({"pkg", "extra"});
+        REQUIRE(program != nullptr);
+
+        // 索引建立之后新增的模块仍然可以导入
+        writeModule(second, "newcomer", "module newcomer;\n");
+        CHECK(loader.loadModule({"newcomer"}) != nullptr);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// ─────────────────────────────────────────────
+// 10. 增量构建
+// ─────────────────────────────────────────────
+// 用构建数据库分析程序，返回重新分析的模块及原因
+static std::vector<semantic::BuildDatabase::Rebuild>
+buildIncrementally(const std::filesystem::path& dir, const std::string& mainSource) {
+    auto buildDir = dir / "build";
+    semantic::BuildDatabase database(buildDir / "build.chdb");
+    semantic::ModuleGraph graph(std::make_unique<semantic::ModuleLoader>(
+        std::vector<std::string>{dir.string()}));
+    graph.getLoader().setInterfaceCacheDir(buildDir.string());
+    graph.getLoader().setAstCacheEnabled(false);
+    graph.setBuildDatabase(&database);
+
+    parser::Parser p(mainSource);
+    auto prog = p.parseProgram();
+    semantic::SemanticAnalyzer analyzer(graph);
+    analyzer.analyze(*prog);
+    CHECK_FALSE(analyzer.hasError());
+    CHECK(database.save());
+    return database.getRebuilds();
+}
+
+static std::vector<std::string>
+rebuiltNames(const std::vector<semantic::BuildDatabase::Rebuild>& rebuilds) {
+    std::vector<std::string> names;
+    for (const auto& rebuild : rebuilds) {
+        names.push_back(rebuild.name);
+    }
+    return names;
+}
+
+TEST_CASE("Module: incremental builds", "[module][build]") {
+    auto dir = std::filesystem::temp_directory_path() / "c_hat_module_build_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // 导入链：main → app → lib → leaf
+    writeModule(dir, "leaf",
+                "module leaf;\npublic func leafValue() -> int { return 1; }\n");
+    writeModule(dir, "lib",
+                "module lib;\nimport leaf;\n"
+                "public func libValue() -> int { return 2; }\n");
+    writeModule(dir, "app",
+                "module app;\nimport lib;\n"
+                "public func appValue() -> int { return 3; }\n");
+    std::string mainSource = "import app;\nfunc main() { }\n";
+
+    auto first = buildIncrementally(dir, mainSource);
+    REQUIRE(rebuiltNames(first) == std::vector<std::string>{"leaf", "lib", "app"});
+    CHECK(first[0].reason == "not built before");
+
+    SECTION("Unchanged modules are not rebuilt") {
+        CHECK(buildIncrementally(dir, mainSource).empty());
+    }
+
+    SECTION("Body-only edits rebuild only the edited module") {
+        writeModule(dir, "leaf",
+                    "module leaf;\npublic func leafValue() -> int { return 42; }\n");
+        auto rebuilds = buildIncrementally(dir, mainSource);
+        REQUIRE(rebuiltNames(rebuilds) == std::vector<std::string>{"leaf"});
+        CHECK(rebuilds[0].reason == "source changed");
+        CHECK(buildIncrementally(dir, mainSource).empty());
+    }
+
+    SECTION("Interface edits rebuild the importers") {
+        writeModule(dir, "leaf",
+                    "module leaf;\npublic func leafValue() -> int { return 1; }\n"
+                    "public func leafOther() -> int { return 2; }\n");
+        auto rebuilds = buildIncrementally(dir, mainSource);
+        REQUIRE(rebuiltNames(rebuilds) == std::vector<std::string>{"leaf", "lib", "app"});
+        CHECK(rebuilds[0].reason == "source changed");
+        CHECK(rebuilds[1].reason == "interface of leaf changed");
+        CHECK(rebuilds[2].reason == "interface of lib changed");
+    }
+
+    SECTION("A corrupt database rebuilds everything") {
+        {
+            std::ofstream file(dir / "build" / "build.chdb", std::ios::binary);
+            file << "CHB";
+        }
+        auto rebuilds = buildIncrementally(dir, mainSource);
+        CHECK(rebuiltNames(rebuilds) == std::vector<std::string>{"leaf", "lib", "app"});
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -70,6 +70,31 @@ TEST_CASE("Overload: Same signature should error", "[overload][errors]") {
   }
 }
 
+TEST_CASE("Overload: Resolution cache", "[overload][cache]") {
+  // 同一重载集合以相同实参类型调用时复用决议结果
+  parser::Parser parser("func f(int x) -> int { return x; } "
+                        "func f(float x) -> float { return x; } "
+                        "func g(int a, float b) -> int { "
+                        "  var x = f(a); var y = f(b); "
+                        "  var z = f(a); return f(x) + z; "
+                        "}");
+  auto program = parser.parseProgram();
+  REQUIRE(program);
+  semantic::SemanticAnalyzer analyzer("", false);
+  analyzer.analyze(*program);
+  REQUIRE_FALSE(analyzer.hasError());
+  const auto &stats = analyzer.getOverloadCacheStats();
+  CHECK(stats.misses == 2);
+  CHECK(stats.hits == 2);
+
+  SECTION("Remembered failures are still reported at each call site") {
+    CHECK(analyzeSource("func h(long x) { } func h(double x) { } "
+                        "func main() { h(1); }") == false);
+    CHECK(analyzeSource("func h(int x) { } "
+                        "func main() { h(true); h(true); }") == false);
+  }
+}
+
 TEST_CASE("Operator Overload: Parse binary operators", "[operator][parse]") {
   SECTION("Parse operator+") {
     REQUIRE(analyzeSource("class Vector { "
@@ -1,3 +1,4 @@
+#include "../src/ast/AstSerializer.h"
 #include "../src/parser/Parser.h"
 #include <catch2/catch_test_macros.hpp>
 #include <string>
@@ -5,6 +6,67 @@
 
 using namespace c_hat;
 
+namespace {
+// 把二元表达式树还原成带完整括号的形式，便于检查优先级与结合性
+std::string parenthesize(const ast::Expression *expr) {
+  if (auto *binary = dynamic_cast<const ast::BinaryExpr *>(expr)) {
+    std::string op;
+    switch (binary->op) {
+    case ast::BinaryExpr::Op::Add:
+      op = "+";
+      break;
+    case ast::BinaryExpr::Op::Sub:
+      op = "-";
+      break;
+    case ast::BinaryExpr::Op::Mul:
+      op = "*";
+      break;
+    case ast::BinaryExpr::Op::Shl:
+      op = "<<";
+      break;
+    case ast::BinaryExpr::Op::And:
+      op = "&";
+      break;
+    case ast::BinaryExpr::Op::Lt:
+      op = "<";
+      break;
+    case ast::BinaryExpr::Op::Eq:
+      op = "==";
+      break;
+    case ast::BinaryExpr::Op::LogicAnd:
+      op = "&&";
+      break;
+    case ast::BinaryExpr::Op::LogicOr:
+      op = "||";
+      break;
+    case ast::BinaryExpr::Op::Assign:
+      op = "=";
+      break;
+    default:
+      op = "?";
+      break;
+    }
+    return "(" + parenthesize(binary->left.get()) + " " + op + " " +
+           parenthesize(binary->right.get()) + ")";
+  }
+  if (auto *identifier = dynamic_cast<const ast::Identifier *>(expr)) {
+    return identifier->name;
+  }
+  return expr->toString();
+}
+
+// 解析 "var r = <expr>;" 并返回初始化表达式的括号形式
+std::string parseInitializer(const std::string &expr) {
+  parser::Parser parser("var r = " + expr + ";");
+  auto program = parser.parseProgram();
+  auto *decl =
+      dynamic_cast<ast::VariableDecl *>(program->declarations.at(0).get());
+  REQUIRE(decl != nullptr);
+  REQUIRE(decl->initializer != nullptr);
+  return parenthesize(decl->initializer.get());
+}
+} // namespace
+
 TEST_CASE("Parser: Basic type parsing", "[parser][types]") {
   SECTION("Integer types") {
     std::vector<std::string> intTypes = {"int",   "uint",   "long", "ulong",
@@ -233,3 +295,244 @@ TEST_CASE("Parser: Array literals", "[parser][arrays]") {
     REQUIRE(program->declarations.size() == 1);
   }
 }
+
+TEST_CASE("Parser: Speculative parsing and backtracking",
+          "[parser][backtracking]") {
+  SECTION("Class members mixing fields, methods and constructors") {
+    std::string source = R"(
+      class Point {
+        public int x;
+        public int y;
+        public Point(int x, int y) { }
+        public int sum() { return x + y; }
+        private:
+        int scale(int k) { return k * x; }
+      }
+    )";
+    parser::Parser parser(source);
+    auto program = parser.parseProgram();
+    REQUIRE(program != nullptr);
+    REQUIRE(program->declarations.size() == 1);
+  }
+
+  SECTION("Global variables after failed declaration attempts") {
+    std::string source = "int a = 1;\n"
+                         "Box<int> b;\n"
+                         "var c = a < 2;\n"
+                         "func f() -> int { return a; }\n";
+    parser::Parser parser(source);
+    auto program = parser.parseProgram();
+    REQUIRE(program != nullptr);
+    REQUIRE(program->declarations.size() == 4);
+  }
+
+  SECTION("Comparison is not mistaken for generic arguments") {
+    std::string source = "func f(int a, int b) -> bool {\n"
+                         "  var x = a < b;\n"
+                         "  return a < b && b > a;\n"
+                         "}\n";
+    parser::Parser parser(source);
+    auto program = parser.parseProgram();
+    REQUIRE(program != nullptr);
+    REQUIRE(program->declarations.size() == 1);
+  }
+}
+
+TEST_CASE("Parser: Binary operator precedence", "[parser][expressions]") {
+  SECTION("Arithmetic binds tighter than shifts and comparisons") {
+    REQUIRE(parseInitializer("a + b * c") == "(a + (b * c))");
+    REQUIRE(parseInitializer("a * b + c") == "((a * b) + c)");
+    REQUIRE(parseInitializer("a << b + c") == "(a << (b + c))");
+    REQUIRE(parseInitializer("a + b < c * d") == "((a + b) < (c * d))");
+  }
+
+  SECTION("Binary operators are left associative") {
+    REQUIRE(parseInitializer("a - b - c") == "((a - b) - c)");
+    REQUIRE(parseInitializer("a - b + c * d - e") ==
+            "(((a - b) + (c * d)) - e)");
+  }
+
+  SECTION("Bitwise and binds tighter than equality") {
+    REQUIRE(parseInitializer("a & b == c") == "((a & b) == c)");
+    REQUIRE(parseInitializer("a == b & c") == "(a == (b & c))");
+  }
+
+  SECTION("Logical operators bind loosest") {
+    REQUIRE(parseInitializer("a < b && c == d || e") ==
+            "(((a < b) && (c == d)) || e)");
+    REQUIRE(parseInitializer("a || b && c") == "(a || (b && c))");
+  }
+
+  SECTION("Parentheses and assignment") {
+    REQUIRE(parseInitializer("(a + b) * c") == "((a + b) * c)");
+    REQUIRE(parseInitializer("a = b = c + d") == "(a = (b = (c + d)))");
+  }
+}
+
+TEST_CASE("Parser: Skimming function bodies", "[parser][skim]") {
+  std::string source = "func add(int a, int b) -> int {\n"
+                       "  if (a > b) { return a - b; }\n"
+                       "  { var t = a; }\n"
+                       "  return a + b;\n"
+                       "}\n"
+                       "class Box {\n"
+                       "  public int v;\n"
+                       "  public int get() { return v; }\n"
+                       "}\n"
+                       "func twice(int x) -> int => x * 2;\n"
+                       "func decl();\n";
+
+  SECTION("Bodies are recorded and parsed on demand") {
+    parser::Parser parser(source);
+    parser.setSkimFunctionBodies(true);
+    auto program = parser.parseProgram();
+    REQUIRE(program->declarations.size() == 4);
+
+    auto *add =
+        dynamic_cast<ast::FunctionDecl *>(program->declarations[0].get());
+    REQUIRE(add != nullptr);
+    REQUIRE(add->body == nullptr);
+    REQUIRE(add->hasLazyBody());
+    REQUIRE(add->hasBody());
+
+    auto *body = dynamic_cast<ast::CompoundStmt *>(add->materializeBody());
+    REQUIRE(body != nullptr);
+    REQUIRE(body->statements.size() == 3);
+    REQUIRE_FALSE(add->hasLazyBody());
+    REQUIRE(add->materializeBody() == body);
+
+    auto *box = dynamic_cast<ast::ClassDecl *>(program->declarations[1].get());
+    REQUIRE(box != nullptr);
+    auto *get = dynamic_cast<ast::FunctionDecl *>(box->members[1].get());
+    REQUIRE(get != nullptr);
+    REQUIRE(get->hasLazyBody());
+    REQUIRE(get->materializeBody() != nullptr);
+
+    auto *twice =
+        dynamic_cast<ast::FunctionDecl *>(program->declarations[2].get());
+    REQUIRE(twice->arrowExpr != nullptr);
+    REQUIRE_FALSE(twice->hasLazyBody());
+
+    auto *decl =
+        dynamic_cast<ast::FunctionDecl *>(program->declarations[3].get());
+    REQUIRE_FALSE(decl->hasBody());
+  }
+
+  SECTION("Errors inside skimmed bodies surface when parsed") {
+    parser::Parser parser("func f() { return 1 +; }\nfunc g() { }\n");
+    parser.setSkimFunctionBodies(true);
+    auto program = parser.parseProgram();
+    REQUIRE(program->declarations.size() == 2);
+
+    auto *f =
+        dynamic_cast<ast::FunctionDecl *>(program->declarations[0].get());
+    REQUIRE_THROWS(f->materializeBody());
+  }
+
+  SECTION("Unbalanced braces are reported while skimming") {
+    parser::Parser parser("func f() { if (true) { return; }\n");
+    parser.setSkimFunctionBodies(true);
+    REQUIRE_THROWS(parser.parseProgram());
+  }
+}
+
+TEST_CASE("Parser: AST serialization round trip", "[parser][serialize]") {
+  std::string source =
+      "module app.core;\n"
+      "import std.io;\n"
+      "attribute Column { name: literalview, nullable: bool }\n"
+      "[Column(name = \"id\", nullable = true)]\n"
+      "int id = 0;\n"
+      "enum Color { Red, Green = 2 }\n"
+      "struct Point { int x; int y; }\n"
+      "class Node<T> {\n"
+      "  public T value;\n"
+      "  public Node<T>^ next;\n"
+      "  public T get() { return value; }\n"
+      "}\n"
+      "interface Shape { func area() -> double; }\n"
+      "extension int { func twice() -> int => self * 2; }\n"
+      "func identity<T>(T x) -> T { return x; }\n"
+      "func control(int n) -> int {\n"
+      "  var total = 0;\n"
+      "  for (var i = 0; i < n; i++) { total += i; }\n"
+      "  while (total > 100) { total -= 1; }\n"
+      "  if (n == 0) { return -1; } else { total = total * 2; }\n"
+      "  var f = [&total](int a) => a + total;\n"
+      "  match (n) { 1 => { } y => { } };\n"
+      "  try { total = 1; } catch (Error e) { }\n"
+      "  defer total = 0;\n"
+      "  var (p, q) = (1, 2);\n"
+      "  int[3] arr = {1, 2, 3};\n"
+      "  var pt = new Point();\n"
+      "  delete pt;\n"
+      "  goto done;\n"
+      "  done: return total;\n"
+      "}\n";
+
+  parser::Parser parser(source);
+  auto program = parser.parseProgram();
+  auto data = std::make_shared<std::string>(
+      ast::AstSerializer::serialize(*program));
+  REQUIRE_FALSE(data->empty());
+
+  SECTION("Deserialized programs serialize to the same bytes") {
+    auto restored = ast::AstSerializer::deserialize(*data, data);
+    REQUIRE(restored != nullptr);
+    REQUIRE(restored->declarations.size() == program->declarations.size());
+    REQUIRE(ast::AstSerializer::serialize(*restored) == *data);
+
+    // 函数体在用到时才解码
+    auto *control = dynamic_cast<ast::FunctionDecl *>(
+        restored->declarations.back().get());
+    REQUIRE(control != nullptr);
+    REQUIRE(control->hasLazyBody());
+    REQUIRE(control->materializeBody() != nullptr);
+    REQUIRE(control->toString() == program->declarations.back()->toString());
+
+    auto *column = restored->declarations[3].get();
+    REQUIRE(column->attributes.size() == 1);
+    REQUIRE(column->attributes[0]->arguments.size() == 2);
+  }
+
+  SECTION("Skimmed bodies are serialized without being materialized") {
+    parser::Parser skimming(source);
+    skimming.setSkimFunctionBodies(true);
+    auto skimmed = skimming.parseProgram();
+    auto tokens = std::make_shared<std::string>(
+        ast::AstSerializer::serialize(*skimmed));
+    REQUIRE_FALSE(tokens->empty());
+
+    auto *control = dynamic_cast<ast::FunctionDecl *>(
+        skimmed->declarations.back().get());
+    REQUIRE(control->hasLazyBody());
+
+    // 词法单元形式的函数体需要语法分析器读回
+    REQUIRE(ast::AstSerializer::deserialize(*tokens, tokens) == nullptr);
+    auto restored = ast::AstSerializer::deserialize(
+        *tokens, tokens, parser::Parser::readSkimmedBody);
+    REQUIRE(restored != nullptr);
+    REQUIRE(ast::AstSerializer::serialize(*restored) == *tokens);
+
+    auto *restoredControl = dynamic_cast<ast::FunctionDecl *>(
+        restored->declarations.back().get());
+    REQUIRE(restoredControl != nullptr);
+    REQUIRE(restoredControl->hasLazyBody());
+    REQUIRE(restoredControl->materializeBody() != nullptr);
+    REQUIRE(restoredControl->toString() ==
+            program->declarations.back()->toString());
+  }
+
+  SECTION("Truncated or mismatched data is rejected") {
+    for (size_t size : {size_t(0), size_t(3), data->size() / 2,
+                        data->size() - 1}) {
+      REQUIRE(ast::AstSerializer::deserialize(
+                  std::string_view(*data).substr(0, size), data) == nullptr);
+    }
+
+    auto otherVersion = std::make_shared<std::string>(*data);
+    (*otherVersion)[0] ^= 0x7f;
+    REQUIRE(ast::AstSerializer::deserialize(*otherVersion, otherVersion) ==
+            nullptr);
+  }
+}
@@ -1,7 +1,10 @@
 #include "../src/parser/Parser.h"
+#include "../src/semantic/AnalysisPipeline.h"
+#include "../src/semantic/BoundedQueue.h"
 #include "../src/semantic/SemanticAnalyzer.h"
 #include <catch2/catch_test_macros.hpp>
 #include <string>
+#include <thread>
 #include <vector>
 
 
@@ -143,3 +146,167 @@ TEST_CASE("Semantic: Expression type checking", "[semantic][expressions]") {
                           "int { return foo(42); }") == true);
   }
 }
+
+TEST_CASE("BoundedQueue: Producer and consumer threads",
+          "[semantic][pipeline]") {
+  semantic::BoundedQueue<int> queue(4);
+  std::thread producer([&queue] {
+    for (int i = 0; i < 1000; ++i) {
+      queue.push(i);
+    }
+    queue.close();
+  });
+
+  long long sum = 0;
+  int count = 0;
+  while (auto value = queue.pop()) {
+    REQUIRE(*value == count);
+    sum += *value;
+    count++;
+  }
+  producer.join();
+
+  REQUIRE(count == 1000);
+  REQUIRE(sum == 999 * 1000 / 2);
+  REQUIRE_FALSE(queue.push(1));
+}
+
+TEST_CASE("Semantic: Pipelined parse and analysis", "[semantic][pipeline]") {
+  // 函数体引用后面才声明的类和函数，必须等全部签名收集完再分析
+  std::string source = "func main() -> int {\n"
+                       "  Point p;\n"
+                       "  return helper(p.x);\n"
+                       "}\n"
+                       "class Point { public int x; public int y; }\n"
+                       "func helper(int v) -> int { return v + 1; }\n";
+  for (int i = 0; i < 200; ++i) {
+    source += "func f" + std::to_string(i) + "(int a) -> int { return a * " +
+              std::to_string(i) + "; }\n";
+  }
+
+  SECTION("Matches sequential analysis") {
+    parser::Parser parser(source);
+    semantic::SemanticAnalyzer analyzer;
+    semantic::AnalysisPipeline pipeline(parser, analyzer, 2);
+    auto program = pipeline.run();
+
+    REQUIRE(program != nullptr);
+    REQUIRE(program->declarations.size() == 203);
+    REQUIRE_FALSE(analyzer.hasError());
+    REQUIRE(analyzer.getSymbolTable().lookupSymbol("helper") != nullptr);
+    REQUIRE(analyzer.getSymbolTable().lookupSymbol("f199") != nullptr);
+  }
+
+  SECTION("Semantic errors are reported") {
+    parser::Parser parser(source + "func g() -> int { return missing; }\n");
+    semantic::SemanticAnalyzer analyzer;
+    semantic::AnalysisPipeline pipeline(parser, analyzer);
+    auto program = pipeline.run();
+    REQUIRE(analyzer.hasError());
+  }
+
+  SECTION("Syntax errors are rethrown") {
+    parser::Parser parser(source + "func broken( {\n");
+    semantic::SemanticAnalyzer analyzer;
+    semantic::AnalysisPipeline pipeline(parser, analyzer, 1);
+    REQUIRE_THROWS(pipeline.run());
+  }
+}
+
+TEST_CASE("SymbolTable: Scopes, shadowing and overloads",
+          "[semantic][symbols]") {
+  auto intType =
+      types::TypeFactory::getPrimitiveType(types::PrimitiveType::Kind::Int);
+  auto funcType = std::static_pointer_cast<types::FunctionType>(
+      types::TypeFactory::getFunctionType(intType, {}));
+  auto variable = [&](const std::string &name) {
+    return std::make_shared<semantic::VariableSymbol>(name, intType);
+  };
+
+  semantic::SymbolTable table;
+  auto globalX = variable("x");
+  auto f1 = std::make_shared<semantic::FunctionSymbol>("f", funcType);
+  auto f2 = std::make_shared<semantic::FunctionSymbol>("f", funcType);
+  table.addSymbol(globalX);
+  table.addSymbol(f1);
+  table.addSymbol(f2);
+
+  SECTION("Inner scopes shadow outer ones and are undone on exit") {
+    table.enterScope();
+    auto innerX = variable("x");
+    table.addSymbol(innerX);
+    REQUIRE(table.lookupSymbol("x") == innerX);
+    REQUIRE(table.hasSymbolInCurrentScope("x"));
+    REQUIRE_FALSE(table.hasSymbolInCurrentScope("f"));
+    REQUIRE(innerX->getScopeLevel() == 1);
+
+    table.enterScope();
+    table.addSymbol(variable("y"));
+    REQUIRE(table.lookupSymbol("x") == innerX);
+    REQUIRE(table.getSymbolsInParentScope().size() == 1);
+    table.exitScope();
+
+    REQUIRE(table.lookupSymbol("y") == nullptr);
+    table.exitScope();
+    REQUIRE(table.lookupSymbol("x") == globalX);
+    REQUIRE(table.getCurrentScopeLevel() == 0);
+  }
+
+  SECTION("Overloads are returned innermost first in declaration order") {
+    table.enterScope();
+    auto f3 = std::make_shared<semantic::FunctionSymbol>("f", funcType);
+    table.addSymbol(f3);
+    REQUIRE(table.lookupSymbol("f") == f3);
+    auto overloads = table.lookupFunctionSymbols("f");
+    REQUIRE(overloads.size() == 3);
+    REQUIRE(overloads[0] == f3);
+    REQUIRE(overloads[1] == f1);
+    REQUIRE(overloads[2] == f2);
+    table.exitScope();
+    REQUIRE(table.lookupSymbol("f") == f1);
+  }
+
+  SECTION("New overloads are appended to the cached set") {
+    auto before = table.lookupOverloadSet("f");
+    REQUIRE(before->functions.size() == 2);
+    auto f3 = std::make_shared<semantic::FunctionSymbol>("f", funcType);
+    table.addSymbol(f3);
+
+    // 集合换了编号，之前取得的集合保持不变
+    auto after = table.lookupOverloadSet("f");
+    REQUIRE(after->id != before->id);
+    REQUIRE(before->functions.size() == 2);
+    REQUIRE(after->functions ==
+            std::vector<std::shared_ptr<semantic::FunctionSymbol>>{f1, f2, f3});
+
+    // 退出内层作用域后，新重载仍接在全局作用域的最后
+    table.enterScope();
+    table.addSymbol(std::make_shared<semantic::FunctionSymbol>("f", funcType));
+    table.exitScope();
+    auto f4 = std::make_shared<semantic::FunctionSymbol>("f", funcType);
+    table.addSymbol(f4);
+    REQUIRE(table.lookupFunctionSymbols("f") ==
+            std::vector<std::shared_ptr<semantic::FunctionSymbol>>{f1, f2, f3,
+                                                                  f4});
+    table.addSymbol(variable("f"));
+    REQUIRE(table.lookupOverloadSet("f")->functions.size() == 4);
+  }
+
+  SECTION("Removed symbols are no longer visible") {
+    table.removeSymbol("f", f1);
+    REQUIRE(table.lookupSymbol("f") == f2);
+    REQUIRE(table.lookupFunctionSymbols("f").size() == 1);
+    REQUIRE(table.getGlobalSymbols().size() == 2);
+    REQUIRE(table.getAllSymbols().at("f") == f2);
+  }
+
+  SECTION("Many names survive rehashing") {
+    for (int i = 0; i < 1000; ++i) {
+      table.addSymbol(variable("v" + std::to_string(i)));
+    }
+    for (int i = 0; i < 1000; ++i) {
+      REQUIRE(table.lookupSymbol("v" + std::to_string(i)) != nullptr);
+    }
+    REQUIRE(table.lookupSymbol("x") == globalX);
+  }
+}
@@ -0,0 +1,222 @@
+// CompileServerTest.cpp - 编译服务器的请求转发
+#include "../src/server/CompileServer.h"
+#include "../TestUtils.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace c_hat;
+
+#ifndef _WIN32
+
+// 在路径上绑定一个监听套接字，返回它的描述符
+static int bindSocket(const std::filesystem::path& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    REQUIRE(::listen(fd, 1) == 0);
+    return fd;
+}
+
+// 连接路径上的套接字，返回它的描述符
+static int connectSocket(const std::filesystem::path& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+// 在后台线程中运行服务器，析构时停止
+class ServerThread {
+public:
+    explicit ServerThread(server::CompileServer& server) : server_(server) {
+        server_.listen();
+        thread_ = std::thread([this] { server_.run(); });
+    }
+    ~ServerThread() {
+        server_.stop();
+        thread_.join();
+    }
+
+private:
+    server::CompileServer& server_;
+    std::thread thread_;
+};
+
+TEST_CASE("CompileServer: forwarding requests", "[server]") {
+    auto dir = uniqueTempDir("c_hat_server_test");
+    std::filesystem::create_directories(dir / "work");
+    auto socketPath = dir / "chc.sock";
+
+    // 处理函数打印工作目录和参数，以参数个数作为退出码
+    server::CompileServer server(socketPath, [](const server::CompileRequest& request) {
+        std::cout << std::filesystem::current_path().filename().string();
+        for (const auto& arg : request.args) {
+            std::cout << " " << arg;
+        }
+        std::cerr << "done";
+        return static_cast<int>(request.args.size());
+    });
+
+    SECTION("Requests run in the client's directory and write to its output") {
+        ServerThread thread(server);
+        auto outputPath = dir / "out.txt";
+        auto errorPath = dir / "err.txt";
+        int outputFd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int errorFd = ::open(errorPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(outputFd >= 0);
+        REQUIRE(errorFd >= 0);
+
+        server::CompileRequest request{{"chc", "main.ch", "--run"}, (dir / "work").string()};
+        auto exitCode = server::forwardRequest(socketPath, request, outputFd, errorFd);
+        ::close(outputFd);
+        ::close(errorFd);
+
+        REQUIRE(exitCode.has_value());
+        CHECK(*exitCode == 3);
+        CHECK(readFile(outputPath) == "work chc main.ch --run");
+        CHECK(readFile(errorPath) == "done");
+        CHECK(server.getRequestCount() == 1);
+
+        // 服务器恢复了自己的工作目录，可以继续处理请求
+        CHECK(std::filesystem::current_path() != dir / "work");
+        int nullFd = ::open("/dev/null", O_WRONLY);
+        CHECK(server::forwardRequest(socketPath, {{"chc"}, dir.string()}, nullFd, nullFd) == 1);
+        ::close(nullFd);
+        CHECK(server.getRequestCount() == 2);
+    }
+
+    SECTION("Clients that never send a request are dropped") {
+        server.setRequestTimeout(std::chrono::milliseconds(200));
+        ServerThread thread(server);
+        int stalled = connectSocket(socketPath);
+        int nullFd = ::open("/dev/null", O_WRONLY);
+        CHECK(server::forwardRequest(socketPath, {{"chc"}, dir.string()}, nullFd, nullFd) == 1);
+        ::close(nullFd);
+        ::close(stalled);
+        CHECK(server.getRequestCount() == 1);
+    }
+
+    SECTION("Handlers see whether the client is still connected") {
+        bool connected = false;
+        server::CompileServer probe(socketPath, [&](const server::CompileRequest&) {
+            connected = probe.isClientConnected();
+            return 0;
+        });
+        ServerThread thread(probe);
+        int nullFd = ::open("/dev/null", O_WRONLY);
+        CHECK(server::forwardRequest(socketPath, {{"chc"}, dir.string()}, nullFd, nullFd) == 0);
+        ::close(nullFd);
+        CHECK(connected);
+        CHECK_FALSE(probe.isClientConnected());
+    }
+
+    SECTION("Forwarding fails when no server is listening") {
+        CHECK_FALSE(server::forwardRequest(socketPath, {{"chc"}, dir.string()}).has_value());
+    }
+
+    SECTION("A live server is not replaced, a stale socket file is") {
+        {
+            ServerThread thread(server);
+            server::CompileServer second(socketPath, [](const server::CompileRequest&) { return 0; });
+            CHECK_THROWS(second.listen());
+        }
+
+        // 模拟异常退出留下的套接字文件
+        std::filesystem::remove(socketPath);
+        ::close(bindSocket(socketPath));
+        REQUIRE(std::filesystem::is_socket(socketPath));
+        server::CompileServer replacement(socketPath, [](const server::CompileRequest&) { return 7; });
+        ServerThread thread(replacement);
+        int nullFd = ::open("/dev/null", O_WRONLY);
+        CHECK(server::forwardRequest(socketPath, {{"chc"}, dir.string()}, nullFd, nullFd) == 7);
+        ::close(nullFd);
+    }
+
+    SECTION("Requests read the client's input") {
+        server::CompileServer echo(socketPath, [](const server::CompileRequest&) {
+            std::string line;
+            std::getline(std::cin, line);
+            std::cout << line;
+            return 0;
+        });
+        ServerThread thread(echo);
+        auto inputPath = dir / "in.txt";
+        auto outputPath = dir / "out.txt";
+        std::ofstream(inputPath) << "from client\n";
+        int inputFd = ::open(inputPath.c_str(), O_RDONLY);
+        int outputFd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        REQUIRE(inputFd >= 0);
+        REQUIRE(outputFd >= 0);
+
+        auto exitCode = server::forwardRequest(socketPath, {{"chc"}, dir.string()}, outputFd, outputFd, inputFd);
+        ::close(inputFd);
+        ::close(outputFd);
+
+        CHECK(exitCode == 0);
+        CHECK(readFile(outputPath) == "from client");
+    }
+
+    SECTION("The socket only accepts the current user") {
+        ServerThread thread(server);
+        struct stat status;
+        REQUIRE(::lstat(socketPath.c_str(), &status) == 0);
+        CHECK((status.st_mode & 0777) == 0600);
+        CHECK(status.st_uid == ::getuid());
+    }
+
+    SECTION("Files that are not sockets are neither used nor replaced") {
+        std::ofstream(socketPath) << "";
+        CHECK_FALSE(server::forwardRequest(socketPath, {{"chc"}, dir.string()}).has_value());
+        CHECK_THROWS(server.listen());
+        CHECK(std::filesystem::is_regular_file(socketPath));
+    }
+
+    SECTION("Socket directories writable by other users are rejected") {
+        auto shared = dir / "shared";
+        std::filesystem::create_directories(shared);
+        std::filesystem::permissions(shared, std::filesystem::perms::all);
+        server::CompileServer exposed(shared / "chc.sock", [](const server::CompileRequest&) { return 0; });
+        CHECK_THROWS(exposed.listen());
+
+        // 缺少的目录创建为只有当前用户可以访问
+        auto missing = dir / "private";
+        server::CompileServer created(missing / "chc.sock", [](const server::CompileRequest&) { return 0; });
+        created.listen();
+        CHECK(std::filesystem::status(missing).permissions() == std::filesystem::perms::owner_all);
+    }
+
+    SECTION("A connection lost after sending the request is an error") {
+        // 接受连接后立即关闭，不返回退出码
+        int listener = bindSocket(socketPath);
+        std::thread dropper([listener] { ::close(::accept(listener, nullptr, nullptr)); });
+        int nullFd = ::open("/dev/null", O_WRONLY);
+        CHECK_THROWS(server::forwardRequest(socketPath, {{"chc"}, dir.string()}, nullFd, nullFd));
+        ::close(nullFd);
+        dropper.join();
+        ::close(listener);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+#endif
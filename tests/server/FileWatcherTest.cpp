@@ -0,0 +1,63 @@
+// FileWatcherTest.cpp - 文件监视器
+#include "../src/server/FileWatcher.h"
+#include "../TestUtils.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+using namespace c_hat;
+using namespace std::chrono_literals;
+
+TEST_CASE("FileWatcher: detecting changes", "[server]") {
+    auto dir = uniqueTempDir("c_hat_watcher_test");
+    auto watched = dir / "main.ch";
+    auto other = dir / "other.ch";
+    writeFile(watched, "func main() -> int { return 0; }\n");
+    writeFile(other, "");
+
+    server::FileWatcher watcher;
+    watcher.setFiles({watched});
+
+    SECTION("Waiting without changes times out") {
+        CHECK(watcher.wait(100ms).empty());
+    }
+
+    SECTION("Writes to a watched file are reported") {
+        std::thread writer([&] {
+            std::this_thread::sleep_for(50ms);
+            writeFile(watched, "func main() -> int { return 1; }\n");
+        });
+        auto changed = watcher.wait(5s);
+        writer.join();
+        REQUIRE(changed.size() == 1);
+        CHECK(changed[0].filename() == "main.ch");
+        // 已报告的修改不再重复报告
+        CHECK(watcher.wait(100ms).empty());
+    }
+
+    SECTION("Files replaced by a rename are reported") {
+        auto temporary = dir / "main.ch.tmp";
+        writeFile(temporary, "func main() -> int { return 2; }\n");
+        std::filesystem::rename(temporary, watched);
+        auto changed = watcher.wait(5s);
+        REQUIRE(changed.size() == 1);
+        CHECK(changed[0].filename() == "main.ch");
+    }
+
+    SECTION("Replacing the watch list keeps pending changes") {
+        writeFile(watched, "func main() -> int { return 3; }\n");
+        watcher.setFiles({watched, other});
+        auto changed = watcher.wait(5s);
+        REQUIRE(changed.size() == 1);
+        CHECK(changed[0].filename() == "main.ch");
+    }
+
+    SECTION("Changes to other files in the directory are ignored") {
+        writeFile(other, "func helper() -> int { return 0; }\n");
+        CHECK(watcher.wait(200ms).empty());
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -172,3 +172,141 @@ TEST_CASE("Class types", "[types]") {
     REQUIRE(baseClassType->isSubtypeOf(*derivedClassType) == false);
   }
 }
+
+TEST_CASE("Type interning", "[types]") {
+  auto intType = TypeFactory::getPrimitiveType(PrimitiveType::Kind::Int);
+  auto doubleType = TypeFactory::getPrimitiveType(PrimitiveType::Kind::Double);
+
+  SECTION("Structurally equal types are the same object") {
+    REQUIRE(intType == TypeFactory::getPrimitiveTypeByName("int"));
+    REQUIRE(TypeFactory::getPointerType(intType) ==
+            TypeFactory::getPointerType(intType));
+    REQUIRE(TypeFactory::getPointerType(intType) !=
+            TypeFactory::getPointerType(intType, true));
+    REQUIRE(TypeFactory::getArrayType(intType, 10) ==
+            TypeFactory::getArrayType(intType, 10));
+    REQUIRE(TypeFactory::getArrayType(intType, 10) !=
+            TypeFactory::getArrayType(intType, 20));
+    REQUIRE(TypeFactory::getSliceType(TypeFactory::getReadonlyType(intType)) ==
+            TypeFactory::getSliceType(TypeFactory::getReadonlyType(intType)));
+    REQUIRE(TypeFactory::getTupleType({intType, doubleType}) ==
+            TypeFactory::getTupleType({intType, doubleType}));
+    REQUIRE(TypeFactory::getTupleType({intType, doubleType}) !=
+            TypeFactory::getTupleType({doubleType, intType}));
+    REQUIRE(TypeFactory::getFunctionType(intType, {doubleType}) ==
+            TypeFactory::getFunctionType(intType, {doubleType}));
+    REQUIRE(TypeFactory::getGenericType("List", {intType}) ==
+            TypeFactory::getGenericType("List", {intType}));
+    REQUIRE(TypeFactory::getGenericType("List", {intType}) !=
+            TypeFactory::getGenericType("Set", {intType}));
+    REQUIRE(TypeFactory::getRectangularArrayType(intType, {2, 3}) ==
+            TypeFactory::getRectangularArrayType(intType, {2, 3}));
+    REQUIRE(TypeFactory::getLiteralViewType()->isCanonical());
+  }
+
+  SECTION("Interned types are released when no longer used") {
+    std::weak_ptr<Type> released;
+    {
+      auto tupleType =
+          TypeFactory::getTupleType({doubleType, intType, doubleType});
+      released = tupleType;
+      REQUIRE(TypeFactory::getTupleType({doubleType, intType, doubleType}) ==
+              tupleType);
+    }
+    REQUIRE(released.expired());
+    REQUIRE(TypeFactory::getTupleType({doubleType, intType, doubleType})
+                ->isCanonical());
+
+    auto arrayType = std::dynamic_pointer_cast<ArrayType>(
+        TypeFactory::getArrayType(intType, 4));
+    REQUIRE(arrayType != nullptr);
+    REQUIRE(arrayType->getElementType() == intType);
+  }
+
+  SECTION("Types built from class types are not interned") {
+    auto classType = TypeFactory::getClassType("Point");
+    auto pointerType = TypeFactory::getPointerType(classType);
+    REQUIRE_FALSE(classType->isCanonical());
+    REQUIRE_FALSE(pointerType->isCanonical());
+    REQUIRE(pointerType != TypeFactory::getPointerType(classType));
+    // 不是规范类型时按字符串表示比较
+    REQUIRE(isSameType(*pointerType, *TypeFactory::getPointerType(
+                                         TypeFactory::getClassType("Point"))));
+  }
+
+  SECTION("Type equality") {
+    REQUIRE(isSameType(*TypeFactory::getSliceType(intType),
+                       *TypeFactory::getSliceType(intType)));
+    REQUIRE_FALSE(isSameType(*TypeFactory::getSliceType(intType),
+                             *TypeFactory::getSliceType(doubleType)));
+  }
+}
+
+TEST_CASE("Relation cache", "[types]") {
+  auto intType = TypeFactory::getPrimitiveType(PrimitiveType::Kind::Int);
+  auto readonlyInt = TypeFactory::getReadonlyType(intType);
+  auto baseClassType = TypeFactory::getClassType("BaseClass");
+  auto derivedClassType = std::static_pointer_cast<ClassType>(
+      TypeFactory::getClassType("DerivedClass"));
+  derivedClassType->addBaseClass(
+      std::static_pointer_cast<ClassType>(baseClassType));
+
+  RelationCache cache;
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(cache.isCompatible(readonlyInt, intType));
+    REQUIRE(cache.isSubtype(derivedClassType, baseClassType));
+    REQUIRE_FALSE(cache.isSubtype(baseClassType, derivedClassType));
+  }
+  REQUIRE_FALSE(cache.isCompatible(intType, nullptr));
+
+  INFO("hits: " << cache.getStats().hits
+                << ", misses: " << cache.getStats().misses);
+  REQUIRE(cache.size() == 3);
+  REQUIRE(cache.getStats().misses == 3);
+  REQUIRE(cache.getStats().hits == 9);
+  REQUIRE(cache.getStats().hitRate() == 0.75);
+
+  cache.clear();
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cache.isSubtype(derivedClassType, baseClassType));
+  REQUIRE(cache.getStats().misses == 4);
+}
+
+TEST_CASE("Instantiation table", "[types]") {
+  auto intType = TypeFactory::getPrimitiveType(PrimitiveType::Kind::Int);
+  auto floatType = TypeFactory::getPrimitiveType(PrimitiveType::Kind::Float);
+  auto box = std::make_shared<ClassType>("Box", std::vector<std::string>{"T"});
+  box->addField(ClassField("value", intType));
+
+  InstantiationTable table;
+  auto boxInt = table.instantiate(box, {intType});
+  REQUIRE(boxInt);
+  REQUIRE(boxInt->toString() == "Box<int>");
+  REQUIRE(table.instantiate(box, {intType}) == boxInt);
+  REQUIRE(table.instantiate(box, {floatType}) != boxInt);
+  REQUIRE_FALSE(table.instantiate(box, {intType, intType}));
+
+  // 不驻留的实参按结构归并，组成部分中的类按地址区分
+  auto point = std::make_shared<ClassType>("Point");
+  auto first = table.instantiate(box, {std::make_shared<PointerType>(point)});
+  REQUIRE(table.instantiate(box, {std::make_shared<PointerType>(point)}) ==
+          first);
+  auto otherPoint = std::make_shared<ClassType>("Point");
+  auto other =
+      table.instantiate(box, {std::make_shared<PointerType>(otherPoint)});
+  REQUIRE(other != first);
+  REQUIRE(table.instantiate(box, {std::make_shared<PointerType>(point, true)}) !=
+          first);
+
+  REQUIRE(table.size() == 5);
+  REQUIRE(table.getStats().created == 5);
+  REQUIRE(table.getStats().reused == 2);
+
+  // 模板添加成员后重新实例化
+  box->addMethod(ClassMethod("get", intType, {}));
+  auto refreshed = table.instantiate(box, {intType});
+  REQUIRE(refreshed != boxInt);
+  REQUIRE(refreshed->hasMethod("get"));
+  REQUIRE(table.getStats().refreshed == 1);
+  REQUIRE(table.size() == 5);
+}